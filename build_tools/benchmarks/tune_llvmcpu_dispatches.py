@@ -0,0 +1,371 @@
+#!/usr/bin/env python3
+# Copyright 2022 The IREE Authors
+#
+# Licensed under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+"""Tunes the tile sizes of LLVM CPU dispatches on the local CPU.
+
+Takes the executable benchmarks dumped by iree-compile with
+`--iree-hal-dump-executable-benchmarks-to=<dir>` and, for each dispatch,
+compiles and benchmarks candidate lowering configurations derived from the
+default heuristics. The fastest configuration of each dispatch is written to a
+tuning database that iree-compile picks up with
+`--iree-codegen-llvmcpu-tuning-db=<file>`.
+
+Dispatches are identified in the database by the key printed by iree-compile
+with `--iree-codegen-llvmcpu-print-tuning-keys`. The key only depends on the
+target and the structure of the dispatch root op so a database can be reused
+across models as long as the target flags don't change.
+
+Example usage:
+  iree-compile --iree-hal-target-backends=llvm-cpu \
+      --iree-llvm-target-cpu-features=host \
+      --iree-hal-dump-executable-benchmarks-to=/tmp/benchmarks \
+      model.mlir -o /dev/null
+  ./tune_llvmcpu_dispatches.py --tool_dir=/path/to/build/tools \
+      --output=tuning_db.mlir /tmp/benchmarks
+  iree-compile --iree-hal-target-backends=llvm-cpu \
+      --iree-llvm-target-cpu-features=host \
+      --iree-codegen-llvmcpu-tuning-db=tuning_db.mlir \
+      model.mlir -o model.vmfb
+"""
+
+import argparse
+import collections
+import json
+import os
+import re
+import subprocess
+import tempfile
+
+from dataclasses import dataclass
+from typing import Dict, List, Optional, Sequence, TextIO, Tuple
+
+TUNING_DB_ATTR_NAME = "iree_codegen.tuning_db"
+
+# Matches the remarks emitted with --iree-codegen-llvmcpu-print-tuning-keys.
+TUNING_KEY_REMARK_PATTERN = re.compile(
+    r'remark: tuning key "(?P<key>[^"]*)": '
+    r'(?P<info>#iree_codegen\.compilation_info<.*>)\s*$')
+# Matches the entries of a tuning database as written by this script.
+TUNING_DB_ENTRY_PATTERN = re.compile(
+    r'^\s*"(?P<key>[^"]*)" = (?P<info>#iree_codegen\.compilation_info<.*>),?$')
+TILE_SIZES_PATTERN = re.compile(r"tile_sizes = (\[(?:\[[^\]]*\](?:, )?)*\])")
+
+# The default tile sizes of each tiled dimension are scaled by powers of two up
+# to 2**MAX_TILE_SIZE_SCALE_LOG2 in either direction to derive candidates.
+MAX_TILE_SIZE_SCALE_LOG2 = 2
+
+
+@dataclass
+class TuningCandidate:
+  """A compilation info to try for a dispatch and its benchmark time."""
+  compilation_info: str
+  time_ns: Optional[float] = None
+
+
+def parse_tuning_keys(compiler_output: str) -> Dict[str, str]:
+  """Returns the tuning key to default compilation info mapping printed by
+  iree-compile."""
+  tuning_keys = {}
+  for line in compiler_output.splitlines():
+    match = TUNING_KEY_REMARK_PATTERN.search(line)
+    if match:
+      tuning_keys[match.group("key")] = match.group("info")
+  return tuning_keys
+
+
+def get_tile_sizes(compilation_info: str) -> List[List[int]]:
+  match = TILE_SIZES_PATTERN.search(compilation_info)
+  if match is None:
+    raise ValueError(f"No tile sizes in compilation info: {compilation_info}")
+  return json.loads(match.group(1))
+
+
+def set_tile_sizes(compilation_info: str, tile_sizes: List[List[int]]) -> str:
+  tile_sizes_str = "[" + ", ".join(
+      "[" + ", ".join(str(size) for size in level) + "]"
+      for level in tile_sizes) + "]"
+  return TILE_SIZES_PATTERN.sub(f"tile_sizes = {tile_sizes_str}",
+                                compilation_info,
+                                count=1)
+
+
+def _scale_tile_size(size: int, scale: float) -> Optional[int]:
+  scaled = int(size * scale)
+  if scaled < 1 or scaled * 1.0 != size * scale:
+    return None
+  return scaled
+
+
+def generate_candidate_tile_sizes(default_tile_sizes: List[List[int]],
+                                  max_candidates: int) -> List[List[List[int]]]:
+  """Returns candidate tile sizes derived from the defaults, closest first.
+
+  Only the workgroup (first) and the second level tile sizes are varied; the
+  remaining levels are tied to the vector sizes of the target and kept as-is.
+  Candidates are visited breadth-first by doubling or halving one tile size at
+  a time, so they are generated in order of increasing distance (the number of
+  such steps) from the defaults and only as many as needed are visited. The
+  default tile sizes are always the first candidate.
+  """
+  tunable_levels = min(2, len(default_tile_sizes))
+  tiled_dims = [(level, dim)
+                for level in range(tunable_levels)
+                for dim, size in enumerate(default_tile_sizes[level])
+                if size != 0]
+
+  def scale_tile_sizes(
+      scales_log2: Tuple[int, ...]) -> Optional[List[List[int]]]:
+    tile_sizes = [list(level) for level in default_tile_sizes]
+    for (level, dim), scale_log2 in zip(tiled_dims, scales_log2):
+      size = _scale_tile_size(tile_sizes[level][dim], 2.0**scale_log2)
+      if size is None:
+        return None
+      tile_sizes[level][dim] = size
+    return tile_sizes
+
+  def is_valid(tile_sizes: List[List[int]]) -> bool:
+    # Inner tiles have to fit in the outer ones.
+    if tunable_levels < 2:
+      return True
+    return all(inner <= outer or outer == 0
+               for outer, inner in zip(tile_sizes[0], tile_sizes[1]))
+
+  candidates = []
+  start = (0,) * len(tiled_dims)
+  visited = {start}
+  queue = collections.deque([start])
+  while queue and len(candidates) < max_candidates:
+    scales_log2 = queue.popleft()
+    tile_sizes = scale_tile_sizes(scales_log2)
+    # Tile sizes that can't be scaled further are not expanded.
+    if tile_sizes is None:
+      continue
+    if is_valid(tile_sizes):
+      candidates.append(tile_sizes)
+    for i in range(len(tiled_dims)):
+      for step in (1, -1):
+        scale_log2 = scales_log2[i] + step
+        if abs(scale_log2) > MAX_TILE_SIZE_SCALE_LOG2:
+          continue
+        neighbor = scales_log2[:i] + (scale_log2,) + scales_log2[i + 1:]
+        if neighbor not in visited:
+          visited.add(neighbor)
+          queue.append(neighbor)
+  return candidates
+
+
+def read_tuning_db(db_file: TextIO) -> Dict[str, str]:
+  entries = {}
+  for line in db_file:
+    match = TUNING_DB_ENTRY_PATTERN.match(line)
+    if match:
+      entries[match.group("key")] = match.group("info")
+  return entries
+
+
+def write_tuning_db(entries: Dict[str, str], db_file: TextIO):
+  db_file.write(f"module attributes {{\n  {TUNING_DB_ATTR_NAME} = {{\n")
+  db_file.write(",\n".join(f'    "{key}" = {entries[key]}'
+                           for key in sorted(entries)))
+  db_file.write("\n  }\n} {\n}\n")
+
+
+def parse_benchmark_time_ns(benchmark_output: str) -> float:
+  """Returns the total time of all benchmarks in the JSON output of
+  iree-benchmark-module, using the median of repeated runs when available."""
+  benchmarks = json.loads(benchmark_output)["benchmarks"]
+  medians = [b for b in benchmarks if b.get("aggregate_name") == "median"]
+  if medians:
+    benchmarks = medians
+  else:
+    benchmarks = [b for b in benchmarks if b.get("run_type") != "aggregate"]
+  unit_scales = {"ns": 1, "us": 1e3, "ms": 1e6, "s": 1e9}
+  return sum(b["real_time"] * unit_scales[b.get("time_unit", "ns")]
+             for b in benchmarks)
+
+
+class DispatchTuner(object):
+  """Compiles and benchmarks executable benchmark files."""
+
+  def __init__(self, tool_dir: str, compile_flags: Sequence[str],
+               benchmark_flags: Sequence[str], work_dir: str,
+               verbose: bool):
+    self.compile_tool = os.path.join(tool_dir, "iree-compile")
+    self.benchmark_tool = os.path.join(tool_dir, "iree-benchmark-module")
+    self.compile_flags = list(compile_flags)
+    self.benchmark_flags = list(benchmark_flags)
+    self.work_dir = work_dir
+    self.verbose = verbose
+
+  def _run(self, cmd: List[str]) -> subprocess.CompletedProcess:
+    if self.verbose:
+      print(f"cmd: {' '.join(cmd)}")
+    return subprocess.run(cmd,
+                          stdout=subprocess.PIPE,
+                          stderr=subprocess.PIPE,
+                          universal_newlines=True)
+
+  def compile(
+      self, benchmark_file: str,
+      tuning_db: Dict[str, str]) -> Tuple[Optional[str], Dict[str, str]]:
+    """Compiles |benchmark_file| with |tuning_db|.
+
+    Returns the path of the compiled module, or None on failure, and the
+    compilation info selected for each dispatch by tuning key.
+    """
+    module_path = os.path.join(self.work_dir, "benchmark.vmfb")
+    db_path = os.path.join(self.work_dir, "tuning_db.mlir")
+    with open(db_path, "w") as db_file:
+      write_tuning_db(tuning_db, db_file)
+    cmd = [
+        self.compile_tool, benchmark_file, "-o", module_path,
+        f"--iree-codegen-llvmcpu-tuning-db={db_path}",
+        "--iree-codegen-llvmcpu-print-tuning-keys"
+    ] + self.compile_flags
+    result = self._run(cmd)
+    if result.returncode != 0:
+      if self.verbose:
+        print(result.stderr)
+      return None, {}
+    return module_path, parse_tuning_keys(result.stderr)
+
+  def benchmark(self, module_path: str) -> Optional[float]:
+    cmd = [
+        self.benchmark_tool, f"--module_file={module_path}",
+        "--benchmark_format=json"
+    ] + self.benchmark_flags
+    result = self._run(cmd)
+    if result.returncode != 0:
+      if self.verbose:
+        print(result.stderr)
+      return None
+    return parse_benchmark_time_ns(result.stdout)
+
+  def tune(self, benchmark_file: str, max_candidates: int,
+           min_speedup: float) -> Dict[str, str]:
+    """Returns the tuned compilation info of each dispatch in
+    |benchmark_file| that beats the default by at least |min_speedup|."""
+    module_path, default_infos = self.compile(benchmark_file, {})
+    if module_path is None or not default_infos:
+      print(f"Skipping {benchmark_file}: no tunable dispatches")
+      return {}
+    default_time_ns = self.benchmark(module_path)
+    if default_time_ns is None:
+      print(f"Skipping {benchmark_file}: failed to run the benchmark")
+      return {}
+
+    tuned = {}
+    for key, default_info in default_infos.items():
+      try:
+        default_tile_sizes = get_tile_sizes(default_info)
+      except ValueError:
+        continue
+      best = TuningCandidate(default_info, default_time_ns)
+      # The first candidate is the default configuration that was benchmarked
+      # above.
+      for tile_sizes in generate_candidate_tile_sizes(default_tile_sizes,
+                                                      max_candidates)[1:]:
+        candidate = TuningCandidate(set_tile_sizes(default_info, tile_sizes))
+        module_path, _ = self.compile(benchmark_file,
+                                      {key: candidate.compilation_info})
+        if module_path is not None:
+          candidate.time_ns = self.benchmark(module_path)
+        if self.verbose:
+          print(f"{tile_sizes}: {candidate.time_ns} ns")
+        if candidate.time_ns is not None and candidate.time_ns < best.time_ns:
+          best = candidate
+      speedup = default_time_ns / best.time_ns
+      print(f"{key}: {speedup:.3f}x with {best.compilation_info}")
+      if speedup >= min_speedup:
+        tuned[key] = best.compilation_info
+    return tuned
+
+
+def parse_arguments():
+  """Returns an argument parser with common options."""
+
+  def check_dir_path(path):
+    if os.path.isdir(path):
+      return path
+    else:
+      raise argparse.ArgumentTypeError(path)
+
+  parser = argparse.ArgumentParser(
+      description="Tunes LLVM CPU dispatch tile sizes on the local CPU.")
+  parser.add_argument(
+      "benchmark_dir",
+      metavar="<benchmark-dir>",
+      type=check_dir_path,
+      help="Directory with the executable benchmarks dumped by iree-compile "
+      "with --iree-hal-dump-executable-benchmarks-to.")
+  parser.add_argument("--tool_dir",
+                      type=check_dir_path,
+                      required=True,
+                      help="Directory containing iree-compile and "
+                      "iree-benchmark-module.")
+  parser.add_argument("--output",
+                      required=True,
+                      help="Path to the tuning database. Existing entries "
+                      "are kept unless the same dispatch is tuned again.")
+  parser.add_argument("--compile_flag",
+                      action="append",
+                      default=[],
+                      help="Additional flag passed to iree-compile.")
+  parser.add_argument("--device",
+                      default="local-task",
+                      help="Device to run the benchmarks on.")
+  parser.add_argument("--benchmark_repetitions",
+                      type=int,
+                      default=3,
+                      help="Number of times each benchmark is repeated.")
+  parser.add_argument("--max_candidates",
+                      type=int,
+                      default=16,
+                      help="Maximum number of configurations to try for "
+                      "each dispatch, including the default one.")
+  parser.add_argument("--min_speedup",
+                      type=float,
+                      default=1.02,
+                      help="Minimum speedup over the default configuration "
+                      "for a tuned configuration to be recorded.")
+  parser.add_argument("--verbose",
+                      action="store_true",
+                      help="Print internal information during execution.")
+
+  return parser.parse_args()
+
+
+def main(args: argparse.Namespace):
+  tuning_db = {}
+  if os.path.exists(args.output):
+    with open(args.output, "r") as db_file:
+      tuning_db = read_tuning_db(db_file)
+
+  benchmark_flags = [
+      f"--device={args.device}",
+      f"--benchmark_repetitions={args.benchmark_repetitions}"
+  ]
+  with tempfile.TemporaryDirectory() as work_dir:
+    tuner = DispatchTuner(tool_dir=args.tool_dir,
+                          compile_flags=args.compile_flag,
+                          benchmark_flags=benchmark_flags,
+                          work_dir=work_dir,
+                          verbose=args.verbose)
+    for file_name in sorted(os.listdir(args.benchmark_dir)):
+      if not file_name.endswith(".mlir"):
+        continue
+      benchmark_file = os.path.join(args.benchmark_dir, file_name)
+      tuning_db.update(
+          tuner.tune(benchmark_file,
+                     max_candidates=args.max_candidates,
+                     min_speedup=args.min_speedup))
+
+  with open(args.output, "w") as db_file:
+    write_tuning_db(tuning_db, db_file)
+
+
+if __name__ == "__main__":
+  main(parse_arguments())
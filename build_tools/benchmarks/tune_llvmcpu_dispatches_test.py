@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+# Copyright 2022 The IREE Authors
+#
+# Licensed under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+import json
+import math
+import unittest
+
+from io import StringIO
+
+from tune_llvmcpu_dispatches import generate_candidate_tile_sizes, get_tile_sizes, parse_benchmark_time_ns, parse_tuning_keys, read_tuning_db, set_tile_sizes, write_tuning_db
+
+KEY = "x86_64-unknown-linux-gnu||linalg.matmul|tensor<384x512xf32>,tensor<512x128xf32>,tensor<384x128xf32>"
+INFO = ("#iree_codegen.compilation_info<lowering_config = <tile_sizes = "
+        "[[128, 64, 0], [8, 32, 0], [0, 0, 16]]>, translation_info = "
+        "<CPUDoubleTilingPadExpert>>")
+
+
+class TuneLLVMCPUDispatches(unittest.TestCase):
+
+  def test_parse_tuning_keys(self):
+    output = (f'matmul.mlir:5:3: remark: tuning key "{KEY}": {INFO}\n'
+              "  func.func @matmul() {\n"
+              "  ^\n")
+
+    tuning_keys = parse_tuning_keys(output)
+
+    self.assertEqual(tuning_keys, {KEY: INFO})
+
+  def test_get_and_set_tile_sizes(self):
+    tile_sizes = get_tile_sizes(INFO)
+    updated_info = set_tile_sizes(INFO, [[64, 64, 0], [8, 16, 0], [0, 0, 16]])
+
+    self.assertEqual(tile_sizes, [[128, 64, 0], [8, 32, 0], [0, 0, 16]])
+    self.assertEqual(get_tile_sizes(updated_info),
+                     [[64, 64, 0], [8, 16, 0], [0, 0, 16]])
+    self.assertIn("translation_info = <CPUDoubleTilingPadExpert>",
+                  updated_info)
+
+  def test_generate_candidate_tile_sizes(self):
+    default_tile_sizes = [[16, 0], [4, 0], [0, 4]]
+
+    candidates = generate_candidate_tile_sizes(default_tile_sizes,
+                                               max_candidates=100)
+
+    self.assertEqual(candidates[0], default_tile_sizes)
+    self.assertIn([[32, 0], [4, 0], [0, 4]], candidates)
+    self.assertIn([[16, 0], [8, 0], [0, 4]], candidates)
+    # Inner tiles larger than the outer ones are not generated.
+    self.assertNotIn([[4, 0], [8, 0], [0, 4]], candidates)
+    # Vector level tile sizes are not changed.
+    self.assertTrue(all(c[2] == [0, 4] for c in candidates))
+
+  def test_generate_candidate_tile_sizes_max_candidates(self):
+    candidates = generate_candidate_tile_sizes([[128, 64, 0], [8, 32, 0]],
+                                               max_candidates=5)
+
+    self.assertEqual(len(candidates), 5)
+    self.assertEqual(candidates[0], [[128, 64, 0], [8, 32, 0]])
+    # All the other candidates differ from the defaults by a single step.
+    for candidate in candidates[1:]:
+      changed = [(outer, inner)
+                 for outer, inner in zip(candidate[0] + candidate[1],
+                                         [128, 64, 0, 8, 32, 0])
+                 if outer != inner]
+      self.assertEqual(len(changed), 1)
+      outer, inner = changed[0]
+      self.assertIn(outer / inner, [2, 0.5])
+
+  def test_generate_candidate_tile_sizes_increasing_distance(self):
+    default_tile_sizes = [[64, 64, 0], [8, 32, 0]]
+
+    candidates = generate_candidate_tile_sizes(default_tile_sizes,
+                                               max_candidates=1000)
+
+    def distance(candidate):
+      return sum(
+          abs(math.log2(size / default))
+          for size, default in zip(candidate[0] + candidate[1],
+                                   default_tile_sizes[0] +
+                                   default_tile_sizes[1])
+          if default != 0)
+
+    distances = [distance(candidate) for candidate in candidates]
+    self.assertEqual(distances, sorted(distances))
+    self.assertEqual(len(candidates), len(set(map(str, candidates))))
+    self.assertIn([[256, 32, 0], [8, 32, 0]], candidates)
+
+  def test_generate_candidate_tile_sizes_many_dims(self):
+    # Enumerating all the 5**12 combinations would not finish.
+    default_tile_sizes = [[64] * 6, [16] * 6]
+
+    candidates = generate_candidate_tile_sizes(default_tile_sizes,
+                                               max_candidates=10)
+
+    self.assertEqual(len(candidates), 10)
+    self.assertEqual(candidates[0], default_tile_sizes)
+
+  def test_write_and_read_tuning_db(self):
+    db_file = StringIO()
+
+    write_tuning_db({KEY: INFO}, db_file)
+    db_file.seek(0)
+    entries = read_tuning_db(db_file)
+
+    self.assertEqual(entries, {KEY: INFO})
+
+  def test_parse_benchmark_time_ns(self):
+    output = json.dumps({
+        "benchmarks": [
+            {
+                "name": "a",
+                "run_type": "iteration",
+                "real_time": 5,
+                "time_unit": "us"
+            },
+            {
+                "name": "a_median",
+                "run_type": "aggregate",
+                "aggregate_name": "median",
+                "real_time": 4,
+                "time_unit": "us"
+            },
+            {
+                "name": "b_median",
+                "run_type": "aggregate",
+                "aggregate_name": "median",
+                "real_time": 100,
+                "time_unit": "ns"
+            },
+        ]
+    })
+
+    self.assertEqual(parse_benchmark_time_ns(output), 4100)
+
+
+if __name__ == "__main__":
+  unittest.main()
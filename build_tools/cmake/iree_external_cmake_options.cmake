@@ -57,6 +57,10 @@ macro(iree_set_llvm_cmake_options)
   # If we are building LLD, this will be the target. Otherwise, empty.
   set(IREE_LLD_TARGET)
 
+  # If we are building Clang, this will be the target. Otherwise, empty.
+  # Clang compiles the microkernel bitcode embedded into the llvm-cpu backend.
+  set(IREE_CLANG_TARGET)
+
   # Unconditionally enable mlir.
   list(APPEND LLVM_ENABLE_PROJECTS mlir)
 
@@ -70,6 +74,7 @@ macro(iree_set_llvm_cmake_options)
     message(STATUS "  - llvm-cpu")
     list(APPEND LLVM_TARGETS_TO_BUILD "${IREE_DEFAULT_CPU_LLVM_TARGETS}")
     set(IREE_LLD_TARGET lld)
+    set(IREE_CLANG_TARGET clang)
   endif()
   if(IREE_TARGET_BACKEND_LLVM_CPU_WASM)
     message(STATUS "  - llvm-cpu (wasm)")
@@ -96,6 +101,9 @@ macro(iree_set_llvm_cmake_options)
   if(IREE_LLD_TARGET)
     list(APPEND LLVM_ENABLE_PROJECTS lld)
   endif()
+  if(IREE_CLANG_TARGET)
+    list(APPEND LLVM_ENABLE_PROJECTS clang)
+  endif()
 
   list(REMOVE_DUPLICATES LLVM_ENABLE_PROJECTS)
   list(REMOVE_DUPLICATES LLVM_TARGETS_TO_BUILD)
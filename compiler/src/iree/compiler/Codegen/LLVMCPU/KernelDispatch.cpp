@@ -17,6 +17,7 @@
 #include "iree/compiler/Dialect/Flow/IR/FlowOps.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetSelect.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
@@ -26,6 +27,8 @@
 #include "mlir/Dialect/MemRef/Transforms/Passes.h"
 #include "mlir/Dialect/Utils/StaticValueUtils.h"
 #include "mlir/IR/Matchers.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Support/FileUtilities.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 
 namespace mlir {
@@ -86,6 +89,18 @@ llvm::cl::opt<std::string> clCPUCodegenTransformDialectFileName(
         "MLIR file containing a transform dialect specification to apply"),
     llvm::cl::init(""));
 
+static llvm::cl::opt<std::string> clCPUCodegenTuningDatabaseFileName(
+    "iree-codegen-llvmcpu-tuning-db",
+    llvm::cl::desc("MLIR file containing a tuning database with the "
+                   "compilation info to use for matching dispatches"),
+    llvm::cl::init(""));
+
+static llvm::cl::opt<bool> clCPUCodegenPrintTuningKeys(
+    "iree-codegen-llvmcpu-print-tuning-keys",
+    llvm::cl::desc("Emits a remark with the tuning database key and the "
+                   "selected compilation info of each dispatch"),
+    llvm::cl::init(false));
+
 using IREE::Codegen::DispatchLoweringPassPipeline;
 
 // Encodes the pre-processing strategy to be applied on a Linalg operation
@@ -139,9 +154,10 @@ static VectorPreProcStrategy getVectorPreProcStrategy(linalg::LinalgOp op) {
   return VectorPreProcStrategy::None;
 }
 
-/// Looks for the `native_vector_size` attribute in the hal.executable.variant
-/// op.
-static Optional<int64_t> getNativeVectorSizeInBytes(func::FuncOp entryPointFn) {
+/// Looks for the non-zero integer attribute `name` in the configuration of the
+/// hal.executable.variant op.
+static Optional<int64_t> getTargetConfigInt(func::FuncOp entryPointFn,
+                                            StringRef name) {
   auto variantOp =
       entryPointFn->getParentOfType<IREE::HAL::ExecutableVariantOp>();
   if (!variantOp) return llvm::None;
@@ -149,11 +165,27 @@ static Optional<int64_t> getNativeVectorSizeInBytes(func::FuncOp entryPointFn) {
   if (!targetAttr) return llvm::None;
   auto config = targetAttr.getConfiguration();
   if (!config) return llvm::None;
-  auto nativeVectorSizeAttr = config.getAs<IntegerAttr>("native_vector_size");
-  if (!nativeVectorSizeAttr) return llvm::None;
-  int64_t nativeVectorSizeVal = nativeVectorSizeAttr.getInt();
-  if (!nativeVectorSizeVal) return llvm::None;
-  return nativeVectorSizeVal;
+  auto attr = config.getAs<IntegerAttr>(name);
+  if (!attr) return llvm::None;
+  int64_t value = attr.getInt();
+  if (!value) return llvm::None;
+  return value;
+}
+
+/// Looks for the `native_vector_size` attribute in the hal.executable.variant
+/// op.
+static Optional<int64_t> getNativeVectorSizeInBytes(func::FuncOp entryPointFn) {
+  return getTargetConfigInt(entryPointFn, "native_vector_size");
+}
+
+/// Looks for the `l1_cache_size` attribute in the hal.executable.variant op.
+static Optional<int64_t> getL1CacheSizeInBytes(func::FuncOp entryPointFn) {
+  return getTargetConfigInt(entryPointFn, "l1_cache_size");
+}
+
+/// Looks for the `l2_cache_size` attribute in the hal.executable.variant op.
+static Optional<int64_t> getL2CacheSizeInBytes(func::FuncOp entryPointFn) {
+  return getTargetConfigInt(entryPointFn, "l2_cache_size");
 }
 
 /// For a given `shapedType` or (`byteWidth` of element type) return the number
@@ -173,6 +205,85 @@ static int64_t getVectorSize(func::FuncOp entryPointFn, ShapedType shapedType) {
   return getVectorSize(entryPointFn, byteWidth);
 }
 
+/// Returns the number of bytes of the operands accessed by a tile of `op` with
+/// `tileSizes`, where a tile size of 0 means the loop is not tiled. Returns
+/// llvm::None if the footprint is not static.
+static Optional<int64_t> getTileFootprintInBytes(linalg::LinalgOp op,
+                                                 ArrayRef<int64_t> tileSizes) {
+  SmallVector<int64_t> lastIndices;
+  for (auto it : llvm::zip(op.getStaticLoopRanges(), tileSizes)) {
+    int64_t range = std::get<0>(it);
+    int64_t tileSize = std::get<1>(it);
+    if (ShapedType::isDynamic(range)) return llvm::None;
+    lastIndices.push_back((tileSize ? std::min(tileSize, range) : range) - 1);
+  }
+
+  int64_t footprint = 0;
+  for (OpOperand *operand : op.getInputAndOutputOperands()) {
+    auto shapedType = operand->get().getType().dyn_cast<ShapedType>();
+    if (!shapedType) continue;
+    Type elementType = shapedType.getElementType();
+    if (!elementType.isIntOrFloat()) return llvm::None;
+    // The indexing maps of the ops handled here only have non-negative
+    // coefficients so the extent of each operand dimension within a tile is
+    // given by the last index of the loops.
+    int64_t numElements = 1;
+    for (int64_t lastIndex :
+         op.getTiedIndexingMap(operand).compose(lastIndices)) {
+      numElements *= lastIndex + 1;
+    }
+    footprint +=
+        numElements * IREE::Util::getRoundedElementByteWidth(elementType);
+  }
+  return footprint;
+}
+
+/// Shrinks the `tileSizes` of the `tiledDims` of `op` such that the operands
+/// accessed by a tile take at most half of a cache of `cacheSizeInBytes`,
+/// leaving the other half to the data of neighboring tiles. The loops that are
+/// not in `tiledDims` are assumed to be iterated over entirely. The largest
+/// tile size is halved first and tile sizes never go below `minTileSizes`.
+static void fitTileSizesToCache(linalg::LinalgOp op, int64_t cacheSizeInBytes,
+                                ArrayRef<unsigned> tiledDims,
+                                ArrayRef<int64_t> minTileSizes,
+                                SmallVectorImpl<int64_t> &tileSizes) {
+  SmallVector<int64_t> footprintTileSizes(op.getNumLoops(), 0);
+  while (true) {
+    for (unsigned dim : tiledDims) footprintTileSizes[dim] = tileSizes[dim];
+    Optional<int64_t> footprint =
+        getTileFootprintInBytes(op, footprintTileSizes);
+    if (!footprint || *footprint <= cacheSizeInBytes / 2) return;
+
+    Optional<unsigned> largestDim;
+    for (unsigned dim : tiledDims) {
+      if (tileSizes[dim] <= std::max<int64_t>(minTileSizes[dim], 1)) continue;
+      if (!largestDim || tileSizes[dim] > tileSizes[*largestDim]) {
+        largestDim = dim;
+      }
+    }
+    if (!largestDim) return;
+    tileSizes[*largestDim] = std::max<int64_t>(
+        {tileSizes[*largestDim] / 2, minTileSizes[*largestDim], 1});
+  }
+}
+
+/// Limits the `tileSizes` used to distribute `op` to workgroups such that the
+/// operands accessed by a workgroup fit in the L2 cache of the target, if its
+/// size is known. This is applied to the max tile sizes given to the
+/// distribution heuristics and again to the distributed tile sizes they pick,
+/// as reducing the number of workgroups can grow tiles past the max sizes.
+static void limitDistributedTileSizesToL2Cache(
+    func::FuncOp entryPointFn, linalg::LinalgOp op,
+    ArrayRef<int64_t> minTileSizes, SmallVectorImpl<int64_t> &tileSizes) {
+  Optional<int64_t> l2CacheSize = getL2CacheSizeInBytes(entryPointFn);
+  if (!l2CacheSize) return;
+  SmallVector<unsigned> partitionableLoops =
+      cast<PartitionableLoopsInterface>(op.getOperation())
+          .getPartitionableLoops(kNumMaxParallelDims);
+  fitTileSizesToCache(op, *l2CacheSize, partitionableLoops, minTileSizes,
+                      tileSizes);
+}
+
 /// Returns minimum tiling sizes for each dimension. One dimension is possible
 /// to access at different element types. It determines the tiling sizes by
 /// looking into all the operands.
@@ -833,7 +944,6 @@ static LogicalResult setRootConfig(
   // There are hard-coded configurations in DoubleTilingPadExpert, so it only
   // works for linalg.matmul cases. We can relax it once we have better
   // scheduling, e.g., transform dialect.
-  SmallVector<int64_t> flowTileSizes;
   bool usePaddingPipeline =
       getVectorPreProcStrategy(linalgOp) == VectorPreProcStrategy::Padding;
   if (usePaddingPipeline) {
@@ -844,13 +954,14 @@ static LogicalResult setRootConfig(
       maxTileSizes[0] = 192;
       maxTileSizes[1] = 128;
     }
-    flowTileSizes = getDefaultDistributedLevelTileSizes(
-        linalgOp, workgroupTileSizes, maxTileSizes,
-        /*allowIncompleteTile=*/true);
-  } else {
-    flowTileSizes = getDefaultDistributedLevelTileSizes(
-        linalgOp, workgroupTileSizes, maxTileSizes);
   }
+  limitDistributedTileSizesToL2Cache(entryPointFn, linalgOp, workgroupTileSizes,
+                                     maxTileSizes);
+  SmallVector<int64_t> flowTileSizes = getDefaultDistributedLevelTileSizes(
+      linalgOp, workgroupTileSizes, maxTileSizes,
+      /*allowIncompleteTile=*/usePaddingPipeline);
+  limitDistributedTileSizesToL2Cache(entryPointFn, linalgOp, workgroupTileSizes,
+                                     flowTileSizes);
 
   // ARM codgen does not switch to use codegen driver based approach, so we have
   // special logic for it. All the new pipeline is expected to use codegen
@@ -866,9 +977,21 @@ static LogicalResult setRootConfig(
                                   workgroupTileSizes, vectorSize);
   }
   // TODO(hanchung): We should make the tile sizes be related to memory
-  // hierarchy. They are derived from experiments for now.
+  // hierarchy. They are derived from experiments for now unless the L1 cache
+  // size of the target is known.
   if (enableTripleTilingPipeline) {
     SmallVector<int64_t> l1TileSizes = {0, 0, 384};
+    // Tile the reduction loop such that the operands of a vector-level tile
+    // stay in the L1 cache.
+    int64_t K = linalgOp.getStaticLoopRanges().back();
+    Optional<int64_t> l1CacheSize = getL1CacheSizeInBytes(entryPointFn);
+    if (l1CacheSize && !ShapedType::isDynamic(K)) {
+      SmallVector<int64_t> vectorTileSizes = workgroupTileSizes;
+      vectorTileSizes.back() = K;
+      fitTileSizesToCache(linalgOp, *l1CacheSize, /*tiledDims=*/{0, 1, 2},
+                          /*minTileSizes=*/workgroupTileSizes, vectorTileSizes);
+      l1TileSizes.back() = vectorTileSizes.back();
+    }
     TileSizesListType tripleTileSizes = {flowTileSizes, l1TileSizes,
                                          workgroupTileSizes};
     if (isNoPadMultiTilingBeneficial(contractionOp, tripleTileSizes)) {
@@ -896,8 +1019,12 @@ static LogicalResult setRootConfig(func::FuncOp entryPointFn,
     minTileSizes[1] = 4;
     maxTileSizes[0] = 48;
     maxTileSizes[1] = 32;
+    limitDistributedTileSizesToL2Cache(entryPointFn, mmt4dOp, minTileSizes,
+                                       maxTileSizes);
     SmallVector<int64_t> flowTileSizes = getDefaultDistributedLevelTileSizes(
         mmt4dOp, minTileSizes, maxTileSizes);
+    limitDistributedTileSizesToL2Cache(entryPointFn, mmt4dOp, minTileSizes,
+                                       flowTileSizes);
     return flowTileSizes;
   };
 
@@ -1259,10 +1386,15 @@ static LogicalResult setConvRootConfig(func::FuncOp entryPointFn,
   // Give the vector size hint on OC.
   vectorSizeHints[3] = vectorSize;
 
+  limitDistributedTileSizesToL2Cache(entryPointFn, convOp, targetTileSizes,
+                                     maxTileSizes);
+
   // Set the flow level tiling to the default.
   SmallVector<int64_t> flowTileSizes = getDefaultDistributedLevelTileSizes(
       convOp, minTileSizes, maxTileSizes, /*allowIncompleteTile=*/false,
       vectorSizeHints);
+  limitDistributedTileSizesToL2Cache(entryPointFn, convOp, targetTileSizes,
+                                     flowTileSizes);
 
   // Shapes of N, OH, OW, OC, KH, KW, (IC)
   SmallVector<int64_t, 4> shapes = convOp.getStaticLoopRanges();
@@ -1531,23 +1663,152 @@ static LogicalResult setRootConfig(func::FuncOp entryPointFn,
   return success();
 }
 
+/// Name of the module attribute holding the entries of a tuning database.
+static const char kTuningDatabaseAttrName[] = "iree_codegen.tuning_db";
+
+FailureOr<DictionaryAttr> loadCPUTuningDatabase(MLIRContext *context) {
+  if (clCPUCodegenTuningDatabaseFileName.empty()) return DictionaryAttr();
+
+  std::string errorMessage;
+  auto memoryBuffer =
+      openInputFile(clCPUCodegenTuningDatabaseFileName, &errorMessage);
+  if (!memoryBuffer) {
+    emitError(UnknownLoc::get(context))
+        << "failed to open tuning database "
+        << clCPUCodegenTuningDatabaseFileName.getValue() << ": "
+        << errorMessage;
+    return failure();
+  }
+  llvm::SourceMgr sourceMgr;
+  sourceMgr.AddNewSourceBuffer(std::move(memoryBuffer), llvm::SMLoc());
+  OwningOpRef<ModuleOp> databaseOp =
+      parseSourceFile<ModuleOp>(sourceMgr, context);
+  if (!databaseOp) return failure();
+
+  auto entries =
+      (*databaseOp)->getAttrOfType<DictionaryAttr>(kTuningDatabaseAttrName);
+  if (!entries) {
+    databaseOp->emitError() << "expected tuning database entries in a `"
+                            << kTuningDatabaseAttrName << "` attribute";
+    return failure();
+  }
+  for (NamedAttribute entry : entries) {
+    if (!entry.getValue().isa<IREE::Codegen::CompilationInfoAttr>()) {
+      databaseOp->emitError() << "expected tuning database entry "
+                              << entry.getName()
+                              << " to be a compilation_info attribute";
+      return failure();
+    }
+  }
+  return entries;
+}
+
+/// Returns the key of `rootOp` in the tuning database. Keys only depend on the
+/// target and the structure of the operation such that they are stable across
+/// compiler invocations and all dispatches of the same shape share an entry:
+///   <triple>|<cpu features>|<op name>|<operand types>[|<op specific info>]
+static std::string getTuningKey(IREE::HAL::ExecutableVariantOp variantOp,
+                                Operation *rootOp) {
+  std::string key;
+  llvm::raw_string_ostream os(key);
+  DictionaryAttr config = variantOp.getTarget().getConfiguration();
+  for (StringRef name : {"target_triple", "cpu_features"}) {
+    if (auto value = config ? config.getAs<StringAttr>(name) : StringAttr()) {
+      os << value.getValue();
+    }
+    os << "|";
+  }
+  os << rootOp->getName() << "|";
+  llvm::interleave(rootOp->getOperandTypes(), os, ",");
+
+  // Named ops are identified by their name but generic ops need their indexing
+  // maps, iterator types, and body to be told apart.
+  if (auto genericOp = dyn_cast<linalg::GenericOp>(rootOp)) {
+    os << "|" << genericOp.getIndexingMaps() << "|";
+    llvm::interleave(
+        genericOp.getIteratorTypes(), os,
+        [&](Attribute attr) {
+          if (auto str = attr.dyn_cast<StringAttr>()) {
+            os << str.getValue();
+          } else {
+            os << attr;
+          }
+        },
+        ",");
+    os << "|";
+    llvm::interleave(
+        genericOp.getBody()->getOperations(), os,
+        [&](Operation &op) { os << op.getName(); }, ",");
+  }
+  for (StringRef name : {"strides", "dilations"}) {
+    if (auto attr = rootOp->getAttr(name)) os << "|" << name << "=" << attr;
+  }
+  return os.str();
+}
+
+/// Emits a remark on `entryPointFn` with the tuning key of `rootOp` and the
+/// configuration selected for it. Used by the offline tuner to discover the
+/// dispatches to tune and the default configuration to start from.
+static void emitTuningKeyRemark(func::FuncOp entryPointFn, Operation *rootOp,
+                                StringRef tuningKey) {
+  IREE::Codegen::LoweringConfigAttr loweringConfig = getLoweringConfig(rootOp);
+  IREE::Codegen::TranslationInfoAttr translationInfo =
+      getTranslationInfo(entryPointFn);
+  FailureOr<IREE::HAL::ExecutableExportOp> exportOp =
+      getEntryPoint(entryPointFn);
+  if (!loweringConfig || !translationInfo || failed(exportOp)) return;
+  auto compilationInfo = IREE::Codegen::CompilationInfoAttr::get(
+      entryPointFn.getContext(), loweringConfig, translationInfo,
+      getWorkgroupSize(*exportOp));
+  entryPointFn.emitRemark()
+      << "tuning key \"" << tuningKey << "\": " << compilationInfo;
+}
+
 /// Sets the translation information to use for a dispatch region.
 static LogicalResult setTranslationInfoAndRootConfig(
-    func::FuncOp entryPointFn, ArrayRef<Operation *> computeOps) {
+    func::FuncOp entryPointFn, ArrayRef<Operation *> computeOps,
+    DictionaryAttr tuningDatabase) {
   // First check if the operations have a preset pipeline.
+  bool hasUserConfig = false;
   for (auto computeOp : computeOps) {
     if (IREE::Codegen::CompilationInfoAttr compilationInfo =
             getCompilationInfo(computeOp)) {
       if (failed(setUserConfig(entryPointFn, computeOp, compilationInfo)))
         return failure();
+      hasUserConfig = true;
+    }
+  }
+
+  // Then check if the root operation has been tuned offline.
+  std::string tuningKey;
+  FailureOr<Operation *> rootOp = getRootOperation(computeOps);
+  if (!hasUserConfig && succeeded(rootOp) && *rootOp &&
+      (tuningDatabase || clCPUCodegenPrintTuningKeys)) {
+    auto variantOp = getExecutableVariantOp(entryPointFn);
+    assert(succeeded(variantOp) && "ExecutableVariantOp not found");
+    tuningKey = getTuningKey(*variantOp, *rootOp);
+    IREE::Codegen::CompilationInfoAttr compilationInfo;
+    if (tuningDatabase) {
+      compilationInfo =
+          tuningDatabase.getAs<IREE::Codegen::CompilationInfoAttr>(tuningKey);
+    }
+    if (compilationInfo &&
+        failed(setUserConfig(entryPointFn, *rootOp, compilationInfo))) {
+      return failure();
     }
   }
 
   // Next set the configuration of the operations.
-  return setRootConfig(entryPointFn, computeOps);
+  if (failed(setRootConfig(entryPointFn, computeOps))) return failure();
+
+  if (clCPUCodegenPrintTuningKeys && !tuningKey.empty()) {
+    emitTuningKeyRemark(entryPointFn, *rootOp, tuningKey);
+  }
+  return success();
 }
 
-LogicalResult initCPULaunchConfig(ModuleOp moduleOp) {
+LogicalResult initCPULaunchConfig(ModuleOp moduleOp,
+                                  DictionaryAttr tuningDatabase) {
   llvm::StringMap<IREE::HAL::ExecutableExportOp> exportOps =
       getAllEntryPoints(moduleOp);
   for (auto funcOp : moduleOp.getOps<func::FuncOp>()) {
@@ -1572,7 +1833,8 @@ LogicalResult initCPULaunchConfig(ModuleOp moduleOp) {
       return failure();
     }
 
-    if (failed(setTranslationInfoAndRootConfig(funcOp, computeOps))) {
+    if (failed(setTranslationInfoAndRootConfig(funcOp, computeOps,
+                                               tuningDatabase))) {
       return failure();
     }
   }
@@ -51,7 +51,18 @@ enum class TripleTilingLevel : unsigned {
   NumTileLevels
 };
 
-LogicalResult initCPULaunchConfig(ModuleOp moduleOp);
+// Loads the tuning database specified with `iree-codegen-llvmcpu-tuning-db`.
+// The database is an MLIR module carrying a dictionary that maps tuning keys
+// to `#iree_codegen.compilation_info` attributes, such as produced by
+// build_tools/benchmarks/tune_llvmcpu_dispatches.py. Returns a null
+// dictionary if no database is specified.
+FailureOr<DictionaryAttr> loadCPUTuningDatabase(MLIRContext *context);
+
+// Sets the translation info and lowering configs of the entry points in
+// `moduleOp`. Root ops found in `tuningDatabase` (as returned by
+// `loadCPUTuningDatabase`) use the tuned configuration.
+LogicalResult initCPULaunchConfig(ModuleOp moduleOp,
+                                  DictionaryAttr tuningDatabase = {});
 
 }  // namespace iree_compiler
 }  // namespace mlir
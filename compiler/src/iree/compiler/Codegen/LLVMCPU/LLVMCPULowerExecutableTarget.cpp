@@ -37,8 +37,8 @@ class LLVMCPULowerExecutableTargetPass
           LLVMCPULowerExecutableTargetPass> {
  public:
   LLVMCPULowerExecutableTargetPass() = default;
-  LLVMCPULowerExecutableTargetPass(
-      const LLVMCPULowerExecutableTargetPass &pass) {}
+  LLVMCPULowerExecutableTargetPass(const LLVMCPULowerExecutableTargetPass &pass)
+      : tuningDatabase(pass.tuningDatabase) {}
   void getDependentDialects(DialectRegistry &registry) const override {
     // clang-format off
     registry.insert<IREE::Codegen::IREECodegenDialect,
@@ -57,9 +57,20 @@ class LLVMCPULowerExecutableTargetPass
     // clang-format on
   }
 
+  // Loads the tuning database once instead of for each variant. Attributes
+  // are owned by the context so clones of the pass can share it.
+  LogicalResult initialize(MLIRContext *context) override {
+    FailureOr<DictionaryAttr> database = loadCPUTuningDatabase(context);
+    if (failed(database)) return failure();
+    tuningDatabase = *database;
+    return success();
+  }
+
   void runOnOperation() override;
 
  private:
+  DictionaryAttr tuningDatabase;
+
   Option<bool> testLoweringConfiguration{
       *this, "test-lowering-configuration",
       llvm::cl::desc(
@@ -131,7 +142,7 @@ void LLVMCPULowerExecutableTargetPass::runOnOperation() {
     }
   } else {
     // Use default heuristics.
-    if (failed(initCPULaunchConfig(moduleOp))) {
+    if (failed(initCPULaunchConfig(moduleOp, tuningDatabase))) {
       return signalPassFailure();
     }
 
@@ -232,7 +243,7 @@ void LLVMCPULowerExecutableTargetPass::runOnOperation() {
           case IREE::Codegen::DispatchLoweringPassPipeline::
               CPUAArchDoubleTilingExpert:
             addCPUAArchDoubleTilingExpertPassPipeline(
-                executableLoweringPipeline);
+                executableLoweringPipeline, canLowerToUKernels(moduleOp));
             break;
           case IREE::Codegen::DispatchLoweringPassPipeline::VMVXDefault:
             addVMVXDefaultPassPipeline(executableLoweringPipeline);
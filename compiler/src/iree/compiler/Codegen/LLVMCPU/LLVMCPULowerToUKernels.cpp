@@ -0,0 +1,179 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Codegen/PassDetail.h"
+#include "iree/compiler/Codegen/Passes.h"
+#include "llvm/ADT/StringRef.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/IR/TypeUtilities.h"
+#include "mlir/Pass/Pass.h"
+
+namespace mlir {
+namespace iree_compiler {
+
+namespace {
+
+// Must match the limits checked by iree_ukernel_mmt4d in
+// runtime/src/iree/builtins/ukernel/ as the generated code cannot handle
+// failures returned by the library.
+static constexpr int64_t kMaxTileDimSize = (1 << 15) - 1;
+static constexpr int64_t kMaxGenericTileBytes = 4096;
+
+// Returns the suffix of the microkernel entry point handling the element types
+// of |op| or an empty string if the combination is not supported.
+static StringRef getMmt4DUKernelSuffix(linalg::Mmt4DOp op) {
+  Type lhsType = getElementTypeOrSelf(op.getInputs()[0].getType());
+  Type rhsType = getElementTypeOrSelf(op.getInputs()[1].getType());
+  Type outType = getElementTypeOrSelf(op.getOutputs()[0].getType());
+  if (lhsType.isF32() && rhsType.isF32() && outType.isF32()) {
+    return "f32f32f32";
+  }
+  if (lhsType.isSignlessInteger(8) && rhsType.isSignlessInteger(8) &&
+      outType.isSignlessInteger(32)) {
+    return "i8i8i32";
+  }
+  return "";
+}
+
+// Returns true if all but the outer-most dimension of |type| are statically
+// known to be contiguous row-major. The microkernels only take the outer-most
+// stride and assume the tiles within each row are densely packed.
+static bool hasContiguousInnerDims(MemRefType type) {
+  if (type.getLayout().isIdentity()) return true;
+  SmallVector<int64_t> strides;
+  int64_t offset;
+  if (failed(getStridesAndOffset(type, strides, offset))) return false;
+  ArrayRef<int64_t> shape = type.getShape();
+  int64_t expectedStride = 1;
+  for (int64_t i = type.getRank() - 1; i >= 1; --i) {
+    if (strides[i] != expectedStride) return false;
+    if (i == 1) break;
+    if (ShapedType::isDynamic(shape[i])) return false;
+    expectedStride *= shape[i];
+  }
+  return true;
+}
+
+// Returns true if the inner tile of |op| has a static size the generic
+// microkernel implementation can handle.
+static bool hasSupportedTileSizes(linalg::Mmt4DOp op) {
+  auto lhsType = op.getInputs()[0].getType().cast<ShapedType>();
+  auto rhsType = op.getInputs()[1].getType().cast<ShapedType>();
+  auto outType = op.getOutputs()[0].getType().cast<ShapedType>();
+  int64_t M0 = lhsType.getDimSize(2);
+  int64_t N0 = rhsType.getDimSize(2);
+  int64_t K0 = lhsType.getDimSize(3);
+  for (int64_t size : {M0, N0, K0}) {
+    if (ShapedType::isDynamic(size) || size > kMaxTileDimSize) return false;
+  }
+  int64_t outElementBytes = outType.getElementTypeBitWidth() / 8;
+  return M0 * N0 * outElementBytes <= kMaxGenericTileBytes;
+}
+
+// Returns true if there is a microkernel for the element types and inner tile
+// sizes of |op|. On buffers the operands must also have densely packed inner
+// dimensions.
+static bool isSupportedMmt4D(linalg::Mmt4DOp op) {
+  return !getMmt4DUKernelSuffix(op).empty() && hasSupportedTileSizes(op);
+}
+
+// Returns |type| with all sizes, strides, and the offset made dynamic so that
+// all call sites of a microkernel can share a single declaration.
+static MemRefType getFullyDynamicMemRefType(MemRefType type) {
+  SmallVector<int64_t> shape(type.getRank(), ShapedType::kDynamicSize);
+  SmallVector<int64_t> strides(type.getRank(),
+                               ShapedType::kDynamicStrideOrOffset);
+  AffineMap layout = makeStridedLinearLayoutMap(
+      strides, ShapedType::kDynamicStrideOrOffset, type.getContext());
+  return MemRefType::get(shape, type.getElementType(), layout,
+                         type.getMemorySpace());
+}
+
+// Returns the declaration of the microkernel entry point |name| in |moduleOp|,
+// inserting it if needed. The declaration uses the C interface calling
+// convention such that memrefs are passed as pointers to their descriptors.
+static func::FuncOp lookupOrCreateUKernelDecl(ModuleOp moduleOp,
+                                              StringRef name,
+                                              TypeRange argumentTypes) {
+  if (auto funcOp = moduleOp.lookupSymbol<func::FuncOp>(name)) return funcOp;
+  auto builder = OpBuilder::atBlockBegin(moduleOp.getBody());
+  auto funcOp = builder.create<func::FuncOp>(
+      moduleOp.getLoc(), name,
+      builder.getFunctionType(argumentTypes, /*results=*/{}));
+  funcOp.setPrivate();
+  funcOp->setAttr(LLVM::LLVMDialect::getEmitCWrapperAttrName(),
+                  builder.getUnitAttr());
+  return funcOp;
+}
+
+// Replaces |op| with a call to the matching microkernel entry point if the
+// operands are supported. Unsupported ops are left for regular codegen.
+static void lowerMmt4DToUKernel(ModuleOp moduleOp, linalg::Mmt4DOp op) {
+  if (!op.hasBufferSemantics() || !isSupportedMmt4D(op)) return;
+  SmallVector<Value> operands = {op.getInputs()[0], op.getInputs()[1],
+                                 op.getOutputs()[0]};
+  for (Value operand : operands) {
+    if (!hasContiguousInnerDims(operand.getType().cast<MemRefType>())) return;
+  }
+
+  OpBuilder builder(op);
+  Location loc = op.getLoc();
+  for (Value &operand : operands) {
+    operand = builder.create<memref::CastOp>(
+        loc, getFullyDynamicMemRefType(operand.getType().cast<MemRefType>()),
+        operand);
+  }
+  auto funcOp = lookupOrCreateUKernelDecl(
+      moduleOp, ("iree_ukernel_mmt4d_" + getMmt4DUKernelSuffix(op)).str(),
+      ValueRange(operands).getTypes());
+  builder.create<func::CallOp>(loc, funcOp, operands);
+  op.erase();
+}
+
+struct LLVMCPULowerToUKernelsPass
+    : LLVMCPULowerToUKernelsBase<LLVMCPULowerToUKernelsPass> {
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<func::FuncDialect, memref::MemRefDialect>();
+  }
+  void runOnOperation() override;
+};
+
+}  // namespace
+
+void LLVMCPULowerToUKernelsPass::runOnOperation() {
+  ModuleOp moduleOp = getOperation();
+  SmallVector<linalg::Mmt4DOp> mmt4dOps;
+  moduleOp.walk([&](linalg::Mmt4DOp op) { mmt4dOps.push_back(op); });
+  for (auto op : mmt4dOps) {
+    lowerMmt4DToUKernel(moduleOp, op);
+  }
+}
+
+bool canLowerToUKernels(ModuleOp moduleOp) {
+  bool hasMmt4D = false;
+  WalkResult result = moduleOp.walk([&](linalg::LinalgOp op) {
+    // Fills initialize the accumulator of the microkernels.
+    if (isa<linalg::FillOp>(op)) return WalkResult::advance();
+    auto mmt4dOp = dyn_cast<linalg::Mmt4DOp>(op.getOperation());
+    if (!mmt4dOp || !isSupportedMmt4D(mmt4dOp)) return WalkResult::interrupt();
+    hasMmt4D = true;
+    return WalkResult::advance();
+  });
+  return hasMmt4D && !result.wasInterrupted();
+}
+
+std::unique_ptr<OperationPass<ModuleOp>> createLLVMCPULowerToUKernelsPass() {
+  return std::make_unique<LLVMCPULowerToUKernelsPass>();
+}
+
+}  // namespace iree_compiler
+}  // namespace mlir
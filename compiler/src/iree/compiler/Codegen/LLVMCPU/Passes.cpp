@@ -52,6 +52,11 @@ static llvm::cl::opt<bool> clEnableMicrokernels(
     llvm::cl::desc("Enables microkernel lowering for vmvx (experimental)"),
     llvm::cl::init(false));
 
+static llvm::cl::opt<bool> clEnableLLVMCPUMicrokernels(
+    "iree-llvmcpu-enable-microkernels",
+    llvm::cl::desc("Enables microkernel lowering for llvm-cpu (experimental)"),
+    llvm::cl::init(false));
+
 // MLIR file containing a top-level module that specifies the transformations to
 // apply to form dispatch regions.
 // Defined externally in KernelDispatch.cpp to control the codegen pass
@@ -520,10 +525,24 @@ void addConvTileAndDecomposeExpertPassPipeline(OpPassManager &passManager) {
   }
 }
 
-void addCPUAArchDoubleTilingExpertPassPipeline(OpPassManager &passManager) {
+void addCPUAArchDoubleTilingExpertPassPipeline(OpPassManager &passManager,
+                                               bool lowerToUKernels) {
   addTileAndDistributePasses(passManager);
 
   OpPassManager &nestedModulePM = passManager.nest<ModuleOp>();
+  if (clEnableLLVMCPUMicrokernels && lowerToUKernels) {
+    // The microkernels handle the tiling within a workgroup tile themselves so
+    // go straight to buffers and replace the ops with library calls. Dispatches
+    // with ops the microkernels do not handle are vectorized below instead;
+    // any op that still cannot be lowered once on buffers (such as one with
+    // non-contiguous operands) falls back to scalar loops.
+    addBufferizePasses(nestedModulePM);
+    nestedModulePM.addNestedPass<func::FuncOp>(
+        createRemoveSingleIterationLoopPass());
+    nestedModulePM.addPass(createLLVMCPULowerToUKernelsPass());
+    return;
+  }
+
   {
     LinalgFusePassOptions options;
     options.tilingLevel =
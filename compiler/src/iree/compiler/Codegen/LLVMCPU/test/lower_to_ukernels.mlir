@@ -0,0 +1,52 @@
+// RUN: iree-opt --split-input-file --iree-llvmcpu-lower-to-ukernels %s | FileCheck %s
+
+func.func @mmt4d_f32(%lhs: memref<2x4x8x1xf32>, %rhs: memref<3x4x8x1xf32>, %out: memref<2x3x8x8xf32>) {
+  linalg.mmt4d ins(%lhs, %rhs : memref<2x4x8x1xf32>, memref<3x4x8x1xf32>) outs(%out : memref<2x3x8x8xf32>)
+  return
+}
+// CHECK:      func.func private @iree_ukernel_mmt4d_f32f32f32
+// CHECK-SAME:   (memref<?x?x?x?xf32, #{{.+}}>, memref<?x?x?x?xf32, #{{.+}}>, memref<?x?x?x?xf32, #{{.+}}>)
+// CHECK-SAME:   attributes {llvm.emit_c_interface}
+// CHECK:      func.func @mmt4d_f32
+// CHECK-SAME:   %[[LHS:[a-zA-Z0-9]+]]: memref<2x4x8x1xf32>
+// CHECK-SAME:   %[[RHS:[a-zA-Z0-9]+]]: memref<3x4x8x1xf32>
+// CHECK-SAME:   %[[OUT:[a-zA-Z0-9]+]]: memref<2x3x8x8xf32>
+// CHECK:        %[[LHS_CAST:.+]] = memref.cast %[[LHS]]
+// CHECK:        %[[RHS_CAST:.+]] = memref.cast %[[RHS]]
+// CHECK:        %[[OUT_CAST:.+]] = memref.cast %[[OUT]]
+// CHECK:        call @iree_ukernel_mmt4d_f32f32f32(%[[LHS_CAST]], %[[RHS_CAST]], %[[OUT_CAST]])
+// CHECK-NOT:    linalg.mmt4d
+
+// -----
+
+func.func @mmt4d_i8i8i32(%lhs: memref<?x?x8x4xi8, strided<[?, 32, 4, 1], offset: ?>>, %rhs: memref<?x?x8x4xi8, strided<[?, 32, 4, 1], offset: ?>>, %out: memref<?x?x8x8xi32, strided<[?, 64, 8, 1], offset: ?>>) {
+  linalg.mmt4d ins(%lhs, %rhs : memref<?x?x8x4xi8, strided<[?, 32, 4, 1], offset: ?>>, memref<?x?x8x4xi8, strided<[?, 32, 4, 1], offset: ?>>) outs(%out : memref<?x?x8x8xi32, strided<[?, 64, 8, 1], offset: ?>>)
+  return
+}
+// CHECK:      func.func private @iree_ukernel_mmt4d_i8i8i32
+// CHECK-SAME:   attributes {llvm.emit_c_interface}
+// CHECK:      func.func @mmt4d_i8i8i32
+// CHECK:        call @iree_ukernel_mmt4d_i8i8i32
+// CHECK-NOT:    linalg.mmt4d
+
+// -----
+
+// Inner tile rows that are not densely packed are left for regular codegen.
+func.func @mmt4d_non_contiguous(%lhs: memref<2x4x8x1xf32, strided<[64, 16, 2, 1]>>, %rhs: memref<3x4x8x1xf32>, %out: memref<2x3x8x8xf32>) {
+  linalg.mmt4d ins(%lhs, %rhs : memref<2x4x8x1xf32, strided<[64, 16, 2, 1]>>, memref<3x4x8x1xf32>) outs(%out : memref<2x3x8x8xf32>)
+  return
+}
+// CHECK-NOT:  func.func private @iree_ukernel_mmt4d
+// CHECK:      func.func @mmt4d_non_contiguous
+// CHECK:        linalg.mmt4d
+
+// -----
+
+// Element type combinations without a microkernel are left for regular codegen.
+func.func @mmt4d_f16(%lhs: memref<2x4x8x1xf16>, %rhs: memref<3x4x8x1xf16>, %out: memref<2x3x8x8xf16>) {
+  linalg.mmt4d ins(%lhs, %rhs : memref<2x4x8x1xf16>, memref<3x4x8x1xf16>) outs(%out : memref<2x3x8x8xf16>)
+  return
+}
+// CHECK-NOT:  func.func private @iree_ukernel_mmt4d
+// CHECK:      func.func @mmt4d_f16
+// CHECK:        linalg.mmt4d
@@ -0,0 +1,121 @@
+// RUN: iree-opt --pass-pipeline='hal.executable(hal.executable.variant(iree-llvmcpu-lower-executable-target))' --iree-llvmcpu-enable-microkernels --split-input-file %s | FileCheck %s
+
+// Tests that with microkernels enabled only dispatches of mmt4d ops the
+// microkernels handle skip vectorization and are lowered to microkernel calls.
+
+#executable_target_embedded_elf_arm_64_ = #hal.executable.target<"llvm-cpu", "embedded-elf-arm_64", {data_layout = "e-m:e-i8:8:32-i16:16:32-i64:64-i128:128-n32:64-S128", native_vector_size = 16 : index, target_triple = "aarch64-unknown-unknown-eabi-elf"}>
+#pipeline_layout = #hal.pipeline.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>,
+    #hal.descriptor_set.binding<2, storage_buffer>
+  ]>
+]>
+hal.executable private @mmt4d_f32 {
+  hal.executable.variant public @embedded_elf_arm_64, target = #executable_target_embedded_elf_arm_64_ {
+    hal.executable.export public @mmt4d_f32 layout(#pipeline_layout)
+    builtin.module {
+      func.func @mmt4d_f32() {
+        %cst = arith.constant 0.000000e+00 : f32
+        %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : !flow.dispatch.tensor<readonly:96x384x8x1xf32>
+        %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : !flow.dispatch.tensor<readonly:128x384x8x1xf32>
+        %2 = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) : !flow.dispatch.tensor<writeonly:96x128x8x8xf32>
+        %3 = flow.dispatch.tensor.load %0, offsets = [0, 0, 0, 0], sizes = [96, 384, 8, 1], strides = [1, 1, 1, 1]
+            : !flow.dispatch.tensor<readonly:96x384x8x1xf32> -> tensor<96x384x8x1xf32>
+        %4 = flow.dispatch.tensor.load %1, offsets = [0, 0, 0, 0], sizes = [128, 384, 8, 1], strides = [1, 1, 1, 1]
+            : !flow.dispatch.tensor<readonly:128x384x8x1xf32> -> tensor<128x384x8x1xf32>
+        %5 = linalg.init_tensor [96, 128, 8, 8] : tensor<96x128x8x8xf32>
+        %6 = linalg.fill ins(%cst : f32) outs(%5 : tensor<96x128x8x8xf32>) -> tensor<96x128x8x8xf32>
+        %7 = linalg.mmt4d ins(%3, %4 : tensor<96x384x8x1xf32>, tensor<128x384x8x1xf32>)
+            outs(%6 : tensor<96x128x8x8xf32>) -> tensor<96x128x8x8xf32>
+        flow.dispatch.tensor.store %7, %2, offsets = [0, 0, 0, 0], sizes = [96, 128, 8, 8], strides = [1, 1, 1, 1]
+            : tensor<96x128x8x8xf32> -> !flow.dispatch.tensor<writeonly:96x128x8x8xf32>
+        return
+      }
+    }
+  }
+}
+// CHECK-LABEL: func.func @mmt4d_f32()
+//   CHECK-NOT:   vector.
+//       CHECK:   call @iree_ukernel_mmt4d_f32f32f32
+//   CHECK-NOT:   linalg.mmt4d
+
+// -----
+
+// Element types without a microkernel are vectorized.
+
+#executable_target_embedded_elf_arm_64_ = #hal.executable.target<"llvm-cpu", "embedded-elf-arm_64", {data_layout = "e-m:e-i8:8:32-i16:16:32-i64:64-i128:128-n32:64-S128", native_vector_size = 16 : index, target_triple = "aarch64-unknown-unknown-eabi-elf"}>
+#pipeline_layout = #hal.pipeline.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>,
+    #hal.descriptor_set.binding<2, storage_buffer>
+  ]>
+]>
+hal.executable private @mmt4d_f16 {
+  hal.executable.variant public @embedded_elf_arm_64, target = #executable_target_embedded_elf_arm_64_ {
+    hal.executable.export public @mmt4d_f16 layout(#pipeline_layout)
+    builtin.module {
+      func.func @mmt4d_f16() {
+        %cst = arith.constant 0.000000e+00 : f16
+        %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : !flow.dispatch.tensor<readonly:96x384x8x1xf16>
+        %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : !flow.dispatch.tensor<readonly:128x384x8x1xf16>
+        %2 = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) : !flow.dispatch.tensor<writeonly:96x128x8x8xf16>
+        %3 = flow.dispatch.tensor.load %0, offsets = [0, 0, 0, 0], sizes = [96, 384, 8, 1], strides = [1, 1, 1, 1]
+            : !flow.dispatch.tensor<readonly:96x384x8x1xf16> -> tensor<96x384x8x1xf16>
+        %4 = flow.dispatch.tensor.load %1, offsets = [0, 0, 0, 0], sizes = [128, 384, 8, 1], strides = [1, 1, 1, 1]
+            : !flow.dispatch.tensor<readonly:128x384x8x1xf16> -> tensor<128x384x8x1xf16>
+        %5 = linalg.init_tensor [96, 128, 8, 8] : tensor<96x128x8x8xf16>
+        %6 = linalg.fill ins(%cst : f16) outs(%5 : tensor<96x128x8x8xf16>) -> tensor<96x128x8x8xf16>
+        %7 = linalg.mmt4d ins(%3, %4 : tensor<96x384x8x1xf16>, tensor<128x384x8x1xf16>)
+            outs(%6 : tensor<96x128x8x8xf16>) -> tensor<96x128x8x8xf16>
+        flow.dispatch.tensor.store %7, %2, offsets = [0, 0, 0, 0], sizes = [96, 128, 8, 8], strides = [1, 1, 1, 1]
+            : tensor<96x128x8x8xf16> -> !flow.dispatch.tensor<writeonly:96x128x8x8xf16>
+        return
+      }
+    }
+  }
+}
+// CHECK-LABEL: func.func @mmt4d_f16()
+//   CHECK-NOT:   call @iree_ukernel_mmt4d
+//       CHECK:   vector.
+
+// -----
+
+// Other ops using the same pipeline are vectorized.
+
+#executable_target_embedded_elf_arm_64_ = #hal.executable.target<"llvm-cpu", "embedded-elf-arm_64", {data_layout = "e-m:e-i8:8:32-i16:16:32-i64:64-i128:128-n32:64-S128", native_vector_size = 16 : index, target_triple = "aarch64-unknown-unknown-eabi-elf"}>
+#pipeline_layout = #hal.pipeline.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>,
+    #hal.descriptor_set.binding<2, storage_buffer>
+  ]>
+]>
+hal.executable private @matmul_f32 {
+  hal.executable.variant public @embedded_elf_arm_64, target = #executable_target_embedded_elf_arm_64_ {
+    hal.executable.export public @matmul_f32 layout(#pipeline_layout)
+    builtin.module {
+      func.func @matmul_f32() {
+        %cst = arith.constant 0.000000e+00 : f32
+        %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : !flow.dispatch.tensor<readonly:384x512xf32>
+        %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : !flow.dispatch.tensor<readonly:512x128xf32>
+        %2 = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) : !flow.dispatch.tensor<writeonly:384x128xf32>
+        %3 = flow.dispatch.tensor.load %0, offsets = [0, 0], sizes = [384, 512], strides = [1, 1]
+            : !flow.dispatch.tensor<readonly:384x512xf32> -> tensor<384x512xf32>
+        %4 = flow.dispatch.tensor.load %1, offsets = [0, 0], sizes = [512, 128], strides = [1, 1]
+            : !flow.dispatch.tensor<readonly:512x128xf32> -> tensor<512x128xf32>
+        %5 = linalg.init_tensor [384, 128] : tensor<384x128xf32>
+        %6 = linalg.fill ins(%cst : f32) outs(%5 : tensor<384x128xf32>) -> tensor<384x128xf32>
+        %7 = linalg.matmul ins(%3, %4 : tensor<384x512xf32>, tensor<512x128xf32>)
+            outs(%6 : tensor<384x128xf32>) -> tensor<384x128xf32>
+        flow.dispatch.tensor.store %7, %2, offsets = [0, 0], sizes = [384, 128], strides = [1, 1]
+            : tensor<384x128xf32> -> !flow.dispatch.tensor<writeonly:384x128xf32>
+        return
+      }
+    }
+  }
+}
+// CHECK-LABEL: func.func @matmul_f32()
+//   CHECK-NOT:   call @iree_ukernel_mmt4d
+//       CHECK:   vector.
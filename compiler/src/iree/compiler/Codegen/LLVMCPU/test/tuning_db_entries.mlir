@@ -0,0 +1,10 @@
+// Tuning database used by tuning_db.mlir.
+module attributes {
+  iree_codegen.tuning_db = {
+    "x86_64-unknown-unknown-eabi-elf||linalg.matmul|tensor<384x512xf32>,tensor<512x128xf32>,tensor<384x128xf32>" = #iree_codegen.compilation_info<
+        lowering_config = <tile_sizes = [[64, 32, 0], [16, 16, 0], [0, 0, 8]]>,
+        translation_info = <CPUDoubleTilingExpert>,
+        workgroup_size = []>
+  }
+} {
+}
@@ -225,6 +225,15 @@ createLLVMCPUCheckIRBeforeLLVMConversionPass();
 std::unique_ptr<OperationPass<IREE::HAL::ExecutableVariantOp>>
 createLLVMCPULowerExecutableTargetPass();
 
+/// Lowers supported linalg ops on buffers to calls into the microkernel
+/// library (runtime/src/iree/builtins/ukernel/) that is linked in as bitcode.
+std::unique_ptr<OperationPass<ModuleOp>> createLLVMCPULowerToUKernelsPass();
+
+/// Returns true if the compute ops of the dispatch in `moduleOp` are mmt4d ops
+/// that LLVMCPULowerToUKernelsPass lowers to microkernel calls (and fills
+/// initializing them).
+bool canLowerToUKernels(ModuleOp moduleOp);
+
 /// Synchronizes LLVM linkage with MLIR symbol visibility.
 std::unique_ptr<OperationPass<ModuleOp>>
 createLLVMCPUSynchronizeSymbolVisibilityPass();
@@ -303,8 +312,11 @@ void addConvTileAndDecomposeExpertPassPipeline(OpPassManager &passManager);
 void addTransformDialectInterpreterPasses(OpPassManager &passManager);
 
 /// Populates the passes needed to multi level tile, fuse and vectorize lowering
-/// of linalg ops on tensors to vectors operations.
-void addCPUAArchDoubleTilingExpertPassPipeline(OpPassManager &passManager);
+/// of linalg ops on tensors to vectors operations. When microkernels are
+/// enabled and `lowerToUKernels` is set the ops are instead lowered to
+/// microkernel calls on buffers.
+void addCPUAArchDoubleTilingExpertPassPipeline(OpPassManager &passManager,
+                                               bool lowerToUKernels = false);
 
 //----------------------------------------------------------------------------//
 // LLVMCPU Pass Pipelines for lowering to LLVM dialect.
@@ -7,9 +7,12 @@
 #include "iree/compiler/ConstEval/PassDetail.h"
 #include "iree/compiler/ConstEval/Passes.h"
 #include "iree/compiler/ConstEval/Runtime.h"
+#include "iree/compiler/Dialect/HAL/Target/TargetRegistry.h"
 #include "iree/compiler/Pipelines/Pipelines.h"
 #include "iree/compiler/Utils/PassUtils.h"
 #include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
@@ -25,6 +28,14 @@ namespace mlir {
 namespace iree_compiler {
 namespace ConstEval {
 
+static llvm::cl::opt<std::string> clJitTargetBackend(
+    "iree-consteval-jit-target-backend",
+    llvm::cl::desc("Target backend used to compile and evaluate global "
+                   "initializers at compile time (vmvx or llvm-cpu). The "
+                   "llvm-cpu backend requires the LLVM target options to "
+                   "produce code runnable on the host"),
+    llvm::cl::init("vmvx"));
+
 namespace {
 
 struct ProgramExtractor {
@@ -132,9 +143,10 @@ struct CompileOptions {
 struct JitGlobalsPass : public JitGlobalsBase<JitGlobalsPass> {
   JitGlobalsPass()
       : options(std::make_shared<CompileOptions>()),
+        targetBackend(clJitTargetBackend),
         compilePipeline("builtin.module") {
     // Invoke IREE compilation flow.
-    options->executableOptions.targets.push_back("vmvx");
+    options->executableOptions.targets.push_back(targetBackend);
     options->targetOptions.f32Extension = true;
     options->targetOptions.f64Extension = false;  // not yet implemented
 
@@ -151,6 +163,14 @@ struct JitGlobalsPass : public JitGlobalsBase<JitGlobalsPass> {
 
   void runOnOperation() override {
     auto outerModule = getOperation();
+    if (!IREE::HAL::getTargetBackend(targetBackend)) {
+      outerModule.emitError()
+          << "const-eval target backend '" << targetBackend
+          << "' is not registered; available backends: "
+          << llvm::join(IREE::HAL::getRegisteredTargetBackends(), ", ");
+      return signalPassFailure();
+    }
+
     SymbolTable outerSymbolTable(outerModule);
     OpBuilder builder = OpBuilder::atBlockEnd(outerModule.getBody());
     auto innerModule = builder.create<ModuleOp>(outerModule.getLoc());
@@ -180,7 +200,7 @@ struct JitGlobalsPass : public JitGlobalsBase<JitGlobalsPass> {
       // Only generate an accessor for types our runtime bridge knows how to
       // handle.
       Type type = globalOp.getType();
-      if (!CompiledBinary::isSupportedResultType(type)) {
+      if (!CompiledBinary::isSupportedResultType(type, targetBackend)) {
         LLVM_DEBUG(dbgs() << "JitGlobals: unsupported global type " << type);
         continue;
       }
@@ -244,6 +264,7 @@ struct JitGlobalsPass : public JitGlobalsBase<JitGlobalsPass> {
   }
 
   std::shared_ptr<CompileOptions> options;
+  std::string targetBackend;
   OpPassManager compilePipeline;
 };
 
@@ -82,6 +82,21 @@ static Attribute createAttributeFromRawData(Location loc,
   return {};
 }
 
+// Emits |status| as an error at |loc| and consumes it.
+static LogicalResult emitStatusError(Location loc, iree_status_t status) {
+  std::string message;
+  message.resize(512);
+  iree_host_size_t buffer_length;
+  if (!iree_status_format(status, message.size(), &message[0],
+                          &buffer_length)) {
+    message.resize(buffer_length + 1);
+    iree_status_format(status, message.size(), &message[0], &buffer_length);
+  }
+  message.resize(buffer_length);
+  iree_status_ignore(status);
+  return emitError(loc) << "internal error evaling constant: " << message;
+}
+
 }  // namespace
 
 CompiledBinary::CompiledBinary() {}
@@ -117,17 +132,7 @@ LogicalResult CompiledBinary::invokeNullary(Location loc, StringRef name,
           iree_vm_invoke(context, function, IREE_VM_INVOCATION_FLAG_NONE,
                          /*policy=*/nullptr, inputs.get(), outputs.get(),
                          iree_allocator_system())) {
-    std::string message;
-    message.resize(512);
-    iree_host_size_t buffer_length;
-    if (!iree_status_format(status, message.size(), &message[0],
-                            &buffer_length)) {
-      message.resize(buffer_length + 1);
-      iree_status_format(status, message.size(), &message[0], &buffer_length);
-    }
-    message.resize(buffer_length);
-    iree_status_ignore(status);
-    return emitError(loc) << "internal error evaling constant: " << message;
+    return emitStatusError(loc, status);
   }
 
   if (failed(callback(outputs.get()))) {
@@ -156,10 +161,23 @@ Attribute CompiledBinary::invokeNullaryAsAttribute(Location loc,
   return result;
 }
 
-bool CompiledBinary::isSupportedResultType(Type type) {
+bool CompiledBinary::isSupportedResultType(Type type,
+                                           StringRef targetBackend) {
+  // Support tensors. The elements are only ever touched by the executables so
+  // backends generating native code can handle wider float types than the VM.
+  if (auto tt = type.dyn_cast<RankedTensorType>()) {
+    Type elementType = tt.getElementType();
+    if (targetBackend == "llvm-cpu" &&
+        (elementType.isa<Float16Type>() || elementType.isa<Float64Type>())) {
+      return true;
+    }
+    return isSupportedResultType(elementType, targetBackend);
+  }
+
   // TODO(laurenzo): Not currently supported. VMVX would need to support these
-  // and today it doesn't. We could use alternative backends (LLVM CPU/etc) if
-  // we wanted to handle f64, but f16 and bf16 often need special hardware.
+  // and today it doesn't. The LLVM CPU backend handles f16 and f64 tensors
+  // above but scalars would need the VM f64 extension and bf16 often needs
+  // special hardware.
   if (type.isa<Float16Type>() || type.isa<BFloat16Type>() ||
       type.isa<Float64Type>()) {
     return false;
@@ -175,11 +193,6 @@ bool CompiledBinary::isSupportedResultType(Type type) {
     return true;
   }
 
-  // Support tensors.
-  if (auto tt = type.dyn_cast<RankedTensorType>()) {
-    return isSupportedResultType(tt.getElementType());
-  }
-
   return false;
 }
 
@@ -259,10 +272,14 @@ Attribute CompiledBinary::convertVariantToAttribute(
   return {};
 }
 
-void CompiledBinary::initialize(void* data, size_t length) {
+LogicalResult CompiledBinary::initialize(Location loc, void* data,
+                                         size_t length) {
   Runtime& runtime = Runtime::getInstance();
 
-  // Create driver and device.
+  // Create driver and device. The local-task driver executes the dispatches
+  // on the task system thread pool (configured by the --task_* flags) with
+  // whichever executable loaders are available so both VMVX and LLVM CPU
+  // executables can be run.
   iree_hal_driver_t* driver = nullptr;
   IREE_CHECK_OK(iree_hal_driver_registry_try_create(
       runtime.registry, iree_make_cstring_view("local-task"),
@@ -281,11 +298,15 @@ void CompiledBinary::initialize(void* data, size_t length) {
       runtime.instance, iree_make_const_byte_span(data, length),
       iree_allocator_null(), iree_allocator_system(), &main_module));
 
-  // Context.
+  // Context. Creating it runs the module initializers which load the
+  // executables and fails if they cannot be run on the host.
   std::array<iree_vm_module_t*, 2> modules = {hal_module, main_module};
-  IREE_CHECK_OK(iree_vm_context_create_with_modules(
-      runtime.instance, IREE_VM_CONTEXT_FLAG_NONE, modules.size(),
-      modules.data(), iree_allocator_system(), &context));
+  if (auto status = iree_vm_context_create_with_modules(
+          runtime.instance, IREE_VM_CONTEXT_FLAG_NONE, modules.size(),
+          modules.data(), iree_allocator_system(), &context)) {
+    return emitStatusError(loc, status);
+  }
+  return success();
 }
 
 InMemoryCompiledBinary::~InMemoryCompiledBinary() { deinitialize(); }
@@ -299,8 +320,7 @@ LogicalResult InMemoryCompiledBinary::translateFromModule(
     return failure();
   }
   os.flush();
-  initialize(&binary[0], binary.length());
-  return success();
+  return initialize(moduleOp.getLoc(), &binary[0], binary.length());
 }
 
 Runtime::Runtime() {
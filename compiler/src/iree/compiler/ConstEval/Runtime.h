@@ -36,12 +36,13 @@ class CompiledBinary {
   // as an Attribute.
   Attribute invokeNullaryAsAttribute(Location loc, StringRef name);
 
-  // Whether the given type is supported in *AsAttribute methods.
-  static bool isSupportedResultType(Type type);
+  // Whether the given type is supported in *AsAttribute methods when the
+  // binary was compiled for |targetBackend|.
+  static bool isSupportedResultType(Type type, StringRef targetBackend);
 
  protected:
   CompiledBinary();
-  void initialize(void* data, size_t length);
+  LogicalResult initialize(Location loc, void* data, size_t length);
   // The base class does not clean up initialized state. This must be done
   // explicitly by subclasses, ensuring that any backing images remain valid
   // through the call to deinitialize().
@@ -0,0 +1,157 @@
+// RUN: iree-opt --split-input-file --iree-consteval-jit-target-backend=llvm-cpu --iree-consteval-jit-globals %s | FileCheck %s
+
+// CHECK-LABEL: @linalg_tensor_jit
+// CHECK: util.global private @{{.*}} = dense<4.000000e+04> : tensor<5x6xf32>
+#map0 = affine_map<(d0, d1) -> ()>
+#map1 = affine_map<(d0, d1) -> (d0, d1)>
+module @linalg_tensor_jit {
+  util.global private @hoisted : tensor<5x6xf32>
+  func.func @main() -> tensor<5x6xf32> {
+    %hoisted = util.global.load @hoisted : tensor<5x6xf32>
+    return %hoisted : tensor<5x6xf32>
+  }
+  // CHECK-NOT: util.initializer
+  util.initializer {
+    %cst = arith.constant dense<2.0e+02> : tensor<f32>
+    %0 = linalg.init_tensor [5, 6] : tensor<5x6xf32>
+    %1 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel"]} ins(%cst : tensor<f32>) outs(%0 : tensor<5x6xf32>) {
+    ^bb0(%arg0: f32, %arg1: f32):
+      linalg.yield %arg0 : f32
+    } -> tensor<5x6xf32>
+    %2 = linalg.init_tensor [5, 6] : tensor<5x6xf32>
+    %3 = linalg.generic {indexing_maps = [#map1, #map1, #map1], iterator_types = ["parallel", "parallel"]} ins(%1, %1 : tensor<5x6xf32>, tensor<5x6xf32>) outs(%2 : tensor<5x6xf32>) {
+    ^bb0(%arg0: f32, %arg1: f32, %arg2: f32):
+      %4 = arith.mulf %arg0, %arg1 : f32
+      linalg.yield %4 : f32
+    } -> tensor<5x6xf32>
+    util.global.store %3, @hoisted : tensor<5x6xf32>
+    util.initializer.return
+  }
+}
+
+// -----
+// CHECK-LABEL: @transpose_jit
+// CHECK: util.global private @{{.*}} = dense<{{\[}}[1, 4], [2, 5], [3, 6]{{\]}}> : tensor<3x2xi32>
+#map0 = affine_map<(d0, d1) -> (d1, d0)>
+#map1 = affine_map<(d0, d1) -> (d0, d1)>
+module @transpose_jit {
+  util.global private @hoisted : tensor<3x2xi32>
+  func.func @main() -> tensor<3x2xi32> {
+    %hoisted = util.global.load @hoisted : tensor<3x2xi32>
+    return %hoisted : tensor<3x2xi32>
+  }
+  // CHECK-NOT: util.initializer
+  util.initializer {
+    %cst = arith.constant dense<[[1, 2, 3], [4, 5, 6]]> : tensor<2x3xi32>
+    %0 = linalg.init_tensor [3, 2] : tensor<3x2xi32>
+    %1 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel"]} ins(%cst : tensor<2x3xi32>) outs(%0 : tensor<3x2xi32>) {
+    ^bb0(%arg0: i32, %arg1: i32):
+      linalg.yield %arg0 : i32
+    } -> tensor<3x2xi32>
+    util.global.store %1, @hoisted : tensor<3x2xi32>
+    util.initializer.return
+  }
+}
+
+// -----
+// The executables handle the wider float types that VMVX does not support.
+// CHECK-LABEL: @eval_f16_tensor
+// CHECK: util.global private @{{.*}} = dense<2.000000e+02> : tensor<5x6xf16>
+module @eval_f16_tensor {
+  util.global private @hoisted : tensor<5x6xf16>
+  func.func @main() -> tensor<5x6xf16> {
+    %hoisted = util.global.load @hoisted : tensor<5x6xf16>
+    return %hoisted : tensor<5x6xf16>
+  }
+  // CHECK-NOT: util.initializer
+  util.initializer {
+    %cst = arith.constant dense<2.0e+2> : tensor<5x6xf16>
+    util.global.store %cst, @hoisted : tensor<5x6xf16>
+    util.initializer.return
+  }
+}
+
+// -----
+// CHECK-LABEL: @eval_f64_tensor
+// CHECK: util.global private @{{.*}} = dense<[2.000000e+02, 3.200000e+03]> : tensor<2xf64>
+module @eval_f64_tensor {
+  util.global private @hoisted : tensor<2xf64>
+  func.func @main() -> tensor<2xf64> {
+    %hoisted = util.global.load @hoisted : tensor<2xf64>
+    return %hoisted : tensor<2xf64>
+  }
+  // CHECK-NOT: util.initializer
+  util.initializer {
+    %cst = arith.constant dense<[2.0e+2, 3.2e+3]> : tensor<2xf64>
+    util.global.store %cst, @hoisted : tensor<2xf64>
+    util.initializer.return
+  }
+}
+
+// -----
+// CHECK-LABEL: @linalg_f16_jit
+// CHECK: util.global private @{{.*}} = dense<3.750000e+00> : tensor<5x6xf16>
+#map0 = affine_map<(d0, d1) -> ()>
+#map1 = affine_map<(d0, d1) -> (d0, d1)>
+module @linalg_f16_jit {
+  util.global private @hoisted : tensor<5x6xf16>
+  func.func @main() -> tensor<5x6xf16> {
+    %hoisted = util.global.load @hoisted : tensor<5x6xf16>
+    return %hoisted : tensor<5x6xf16>
+  }
+  // CHECK-NOT: util.initializer
+  util.initializer {
+    %cst = arith.constant dense<1.5e+00> : tensor<f16>
+    %cst_0 = arith.constant dense<2.25e+00> : tensor<5x6xf16>
+    %0 = linalg.init_tensor [5, 6] : tensor<5x6xf16>
+    %1 = linalg.generic {indexing_maps = [#map0, #map1, #map1], iterator_types = ["parallel", "parallel"]} ins(%cst, %cst_0 : tensor<f16>, tensor<5x6xf16>) outs(%0 : tensor<5x6xf16>) {
+    ^bb0(%arg0: f16, %arg1: f16, %arg2: f16):
+      %2 = arith.addf %arg0, %arg1 : f16
+      linalg.yield %2 : f16
+    } -> tensor<5x6xf16>
+    util.global.store %1, @hoisted : tensor<5x6xf16>
+    util.initializer.return
+  }
+}
+
+// -----
+// CHECK-LABEL: @linalg_f64_jit
+// CHECK: util.global private @{{.*}} = dense<[5.000000e+02, 8.000000e+03]> : tensor<2xf64>
+#map = affine_map<(d0) -> (d0)>
+module @linalg_f64_jit {
+  util.global private @hoisted : tensor<2xf64>
+  func.func @main() -> tensor<2xf64> {
+    %hoisted = util.global.load @hoisted : tensor<2xf64>
+    return %hoisted : tensor<2xf64>
+  }
+  // CHECK-NOT: util.initializer
+  util.initializer {
+    %cst = arith.constant dense<[2.0e+2, 3.2e+3]> : tensor<2xf64>
+    %cst_0 = arith.constant 2.5e+00 : f64
+    %0 = linalg.init_tensor [2] : tensor<2xf64>
+    %1 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel"]} ins(%cst : tensor<2xf64>) outs(%0 : tensor<2xf64>) {
+    ^bb0(%arg0: f64, %arg1: f64):
+      %2 = arith.mulf %arg0, %cst_0 : f64
+      linalg.yield %2 : f64
+    } -> tensor<2xf64>
+    util.global.store %1, @hoisted : tensor<2xf64>
+    util.initializer.return
+  }
+}
+
+// -----
+// CHECK-LABEL: @eval_bf16_tensor
+// Not currently supported (initializer should remain)
+// CHECK: util.initializer
+module @eval_bf16_tensor {
+  util.global private @hoisted : tensor<5x6xbf16>
+  func.func @main() -> tensor<5x6xbf16> {
+    %hoisted = util.global.load @hoisted : tensor<5x6xbf16>
+    return %hoisted : tensor<5x6xbf16>
+  }
+  util.initializer {
+    %cst = arith.constant dense<2.0e+2> : tensor<5x6xbf16>
+    util.global.store %cst, @hoisted : tensor<5x6xbf16>
+    util.initializer.return
+  }
+}
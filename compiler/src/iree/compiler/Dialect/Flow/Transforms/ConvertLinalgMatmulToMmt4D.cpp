@@ -6,14 +6,18 @@
 
 #include <algorithm>
 #include <array>
+#include <cstring>
+#include <vector>
 
 #include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
 #include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
 #include "iree/compiler/Utils/CustomKernelsTargetInfo.h"
 #include "llvm/ADT/Optional.h"
+#include "llvm/Support/MathExtras.h"
 #include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/Tensor/Utils/Utils.h"
+#include "mlir/IR/Matchers.h"
 #include "mlir/IR/PatternMatch.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
@@ -194,6 +198,62 @@ static Value pad(Location loc, PatternRewriter &rewriter, Value input,
                                    /* nofold = */ false, loc, rewriter);
 }
 
+// Returns |rhs| relaid out at compile time into the (N1, K1, N0, K0) layout
+// expected by mmt4d for the given (K0, N0) |tileShape| if |rhs| is a dense
+// constant, padding with zeros. This is the result of pad, expandTo4D and
+// transpose but avoids relaying out the weights on every invocation and the
+// transient memory this requires. Returns a null value if |rhs| is not a
+// constant of a byte-aligned element type.
+static Value packConstantRhs(Location loc, PatternRewriter &rewriter,
+                             Value rhs, ArrayRef<int64_t> tileShape) {
+  DenseElementsAttr rhsAttr;
+  if (!matchPattern(rhs, m_Constant(&rhsAttr))) return nullptr;
+  auto rhsType = rhs.getType().cast<RankedTensorType>();
+  Type elementType = rhsType.getElementType();
+  if (!elementType.isIntOrFloat() ||
+      elementType.getIntOrFloatBitWidth() % 8 != 0) {
+    return nullptr;
+  }
+
+  int64_t K = rhsType.getDimSize(0);
+  int64_t N = rhsType.getDimSize(1);
+  int64_t K0 = tileShape[0];
+  int64_t N0 = tileShape[1];
+  int64_t K1 = llvm::divideCeil(K, K0);
+  int64_t N1 = llvm::divideCeil(N, N0);
+  auto packedType = RankedTensorType::get({N1, K1, N0, K0}, elementType);
+
+  DenseElementsAttr packedAttr;
+  bool isZero =
+      matchPattern(rhs, m_Zero()) || matchPattern(rhs, m_AnyZeroFloat());
+  if (rhsAttr.isSplat() &&
+      (!needsPadding(rhsType.getShape(), tileShape) || isZero)) {
+    packedAttr = rhsAttr.resizeSplat(packedType);
+  } else {
+    // Zero bytes are the zero value of both integer and float types.
+    int64_t elementSize = elementType.getIntOrFloatBitWidth() / 8;
+    ArrayRef<char> rawData = rhsAttr.getRawData();
+    std::vector<char> packedData(N1 * K1 * N0 * K0 * elementSize, 0);
+    char *packedElement = packedData.data();
+    for (int64_t n1 = 0; n1 < N1; ++n1) {
+      for (int64_t k1 = 0; k1 < K1; ++k1) {
+        for (int64_t n0 = 0; n0 < N0; ++n0) {
+          for (int64_t k0 = 0; k0 < K0; ++k0, packedElement += elementSize) {
+            int64_t k = k1 * K0 + k0;
+            int64_t n = n1 * N0 + n0;
+            if (k >= K || n >= N) continue;
+            int64_t index = rhsAttr.isSplat() ? 0 : k * N + n;
+            std::memcpy(packedElement, rawData.data() + index * elementSize,
+                        elementSize);
+          }
+        }
+      }
+    }
+    packedAttr = DenseElementsAttr::getFromRawBuffer(packedType, packedData);
+  }
+  return rewriter.create<arith::ConstantOp>(loc, packedType, packedAttr);
+}
+
 // Returns a top-left slice from |input| shaped like |likeWhat|.
 static Value extractSliceLike(Location loc, PatternRewriter &rewriter,
                               Value input, Value likeWhat) {
@@ -279,16 +339,25 @@ class LinalgMatmulOpToLinalgMmt4DOpPattern
     }
     const Mmt4DTileParams &tileParams = maybeTileParams.value();
 
+    // Constant weights are stored pre-packed instead of being relaid out on
+    // every invocation.
+    Value rhs4DT = packConstantRhs(loc, rewriter, rhs, tileParams.rhs());
+    bool isRhsPacked = static_cast<bool>(rhs4DT);
+
     Value paddedLhs = pad(loc, rewriter, lhs, tileParams.lhs());
-    Value paddedRhs = pad(loc, rewriter, rhs, tileParams.rhs());
+    Value paddedRhs;
+    if (!isRhsPacked) paddedRhs = pad(loc, rewriter, rhs, tileParams.rhs());
     Value paddedAcc = pad(loc, rewriter, acc, tileParams.acc());
 
     Value lhs4D = expandTo4D(loc, rewriter, paddedLhs, tileParams.lhs());
-    Value rhs4D = expandTo4D(loc, rewriter, paddedRhs, tileParams.rhs());
+    Value rhs4D;
+    if (!isRhsPacked) {
+      rhs4D = expandTo4D(loc, rewriter, paddedRhs, tileParams.rhs());
+    }
     Value acc4D = expandTo4D(loc, rewriter, paddedAcc, tileParams.acc());
 
     Value lhs4DT = transpose(loc, rewriter, lhs4D, {0, 2, 1, 3});
-    Value rhs4DT = transpose(loc, rewriter, rhs4D, {2, 0, 3, 1});
+    if (!isRhsPacked) rhs4DT = transpose(loc, rewriter, rhs4D, {2, 0, 3, 1});
     Value acc4DT = transpose(loc, rewriter, acc4D, {0, 2, 1, 3});
 
     auto mmt4d = rewriter.create<linalg::Mmt4DOp>(
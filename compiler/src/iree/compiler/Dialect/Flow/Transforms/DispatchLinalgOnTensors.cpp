@@ -18,6 +18,7 @@
 #include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
 #include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
 #include "iree/compiler/Dialect/Flow/Transforms/RegionOpUtils.h"
+#include "iree/compiler/Dialect/Util/IR/UtilTypes.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/CommandLine.h"
@@ -838,10 +839,134 @@ static bool areOpsAggresiveFusable(Operation *producer, Operation *consumer,
   });
 }
 
+/// Returns the size in bytes of `value` if it is a statically shaped tensor.
+static Optional<int64_t> getStaticSizeInBytes(Value value) {
+  auto type = value.getType().dyn_cast<RankedTensorType>();
+  if (!type || !type.hasStaticShape() || !type.getElementType().isIntOrFloat())
+    return llvm::None;
+  return type.getNumElements() *
+         IREE::Util::getRoundedElementByteWidth(type.getElementType());
+}
+
+/// Returns true if `op` has users other than `user`.
+static bool hasOtherUsers(Operation *op, Operation *user) {
+  return llvm::any_of(op->getUsers(),
+                      [&](Operation *opUser) { return opUser != user; });
+}
+
+/// Minimum number of iterations of the outer parallel loops of a root for a
+/// consumer with more parallel loops to be fused into its dispatch.
+static constexpr int64_t kMinParallelIterationsForConsumerFusion = 64;
+
+/// Returns the number of iterations of the outer parallel loops of `op` if
+/// they are all static.
+static Optional<int64_t> getStaticOuterParallelIterations(
+    linalg::LinalgOp op) {
+  llvm::SmallBitVector parallelLoops =
+      getOuterParallelLoops(cast<TilingInterface>(op.getOperation()));
+  SmallVector<int64_t> loopRanges = op.getStaticLoopRanges();
+  int64_t numIterations = 1;
+  for (unsigned loop : parallelLoops.set_bits()) {
+    if (ShapedType::isDynamic(loopRanges[loop])) return llvm::None;
+    numIterations *= loopRanges[loop];
+  }
+  return numIterations;
+}
+
+namespace {
+/// Estimates the memory traffic saved by fusing ops into the same dispatch.
+/// Used on top of the aggressive fusion heuristics, which decide whether a
+/// fusion is legal, to only keep the fusions that are profitable.
+class FusionCostModel {
+ public:
+  /// Returns true if fusing the producer of `operand` into the dispatch of
+  /// its owner saves memory traffic. A producer with other users is
+  /// recomputed in the dispatch and its result still has to be written out
+  /// for the other users, so only the read of the result by the consumer is
+  /// saved while the tensors read by the producer that the consumer does not
+  /// already read have to be read again.
+  bool isProfitableToFuseProducer(OpOperand &operand) {
+    auto producer = operand.get().getDefiningOp<linalg::LinalgOp>();
+    Operation *consumer = operand.getOwner();
+    Optional<int64_t> resultSize = getStaticSizeInBytes(operand.get());
+    if (!hasOtherUsers(producer, consumer)) {
+      return recordBytesSaved(resultSize, /*numAccesses=*/2);
+    }
+
+    if (!resultSize) return false;
+    int64_t bytesSaved = *resultSize;
+    for (OpOperand *producerOperand : producer.getInputAndOutputOperands()) {
+      if (producer.isOutputTensor(producerOperand) &&
+          !producer.payloadUsesValueFromOperand(producerOperand)) {
+        continue;
+      }
+      Value value = producerOperand->get();
+      if (!value.getType().isa<ShapedType>() ||
+          llvm::is_contained(consumer->getOperands(), value)) {
+        continue;
+      }
+      Optional<int64_t> valueSize = getStaticSizeInBytes(value);
+      if (!valueSize) return false;
+      bytesSaved -= *valueSize;
+    }
+    if (bytesSaved <= 0) return false;
+    totalBytesSaved += bytesSaved;
+    return true;
+  }
+
+  /// Returns true if fusing the consumer owning `operand` into the dispatch
+  /// of the root producing it is profitable. The root is not recomputed: if
+  /// it has other users its results are also returned by the dispatch and
+  /// only the reads by the consumer are saved. A consumer with more parallel
+  /// loops than the root (such as a broadcast of a reduction) is distributed
+  /// only along the parallel loops of the root, so it is not fused when the
+  /// root has too few parallel iterations to keep the device busy.
+  bool isProfitableToFuseConsumer(OpOperand &operand) {
+    auto root = operand.get().getDefiningOp<linalg::LinalgOp>();
+    auto consumer = cast<linalg::LinalgOp>(operand.getOwner());
+    if (getOuterParallelLoops(cast<TilingInterface>(root.getOperation()))
+            .count() < consumer.getNumParallelLoops()) {
+      Optional<int64_t> numIterations = getStaticOuterParallelIterations(root);
+      if (numIterations &&
+          *numIterations < kMinParallelIterationsForConsumerFusion) {
+        return false;
+      }
+    }
+
+    int64_t numAccesses = hasOtherUsers(root, consumer) ? 1 : 2;
+    for (OpOperand *consumerOperand : consumer.getInputOperands()) {
+      if (consumerOperand->get().getDefiningOp() != root.getOperation()) {
+        continue;
+      }
+      recordBytesSaved(getStaticSizeInBytes(consumerOperand->get()),
+                       numAccesses);
+    }
+    return true;
+  }
+
+  /// Returns the estimated number of bytes of memory traffic saved by all
+  /// the fusions deemed profitable.
+  int64_t getTotalBytesSaved() const { return totalBytesSaved; }
+
+ private:
+  /// Records that `numAccesses` reads/writes of a tensor of `size` bytes are
+  /// avoided. Fusions of dynamically shaped tensors are always profitable
+  /// but their savings are unknown.
+  bool recordBytesSaved(Optional<int64_t> size, int64_t numAccesses) {
+    if (size) totalBytesSaved += numAccesses * *size;
+    return true;
+  }
+
+  int64_t totalBytesSaved = 0;
+};
+}  // namespace
+
 /// Returns true if this is a fusable use, while fusing a root with its
-/// consumer.
+/// consumer. When a `costModel` is given, uses of the aggressive fusion
+/// heuristics are only fused if the cost model deems it profitable.
 static bool isFusableWithConsumer(OpOperand &fusedOperand,
-                                  bool aggressiveFusion) {
+                                  bool aggressiveFusion,
+                                  FusionCostModel *costModel) {
   // Use the original fusion heuristics if aggressive fusion isn't enabled.
   if (!aggressiveFusion)
     return areLinalgOpsFusableUsingTileAndFuse(fusedOperand);
@@ -861,8 +986,11 @@ static bool isFusableWithConsumer(OpOperand &fusedOperand,
     return false;
   }
 
-  return areOpsAggresiveFusable(producer, consumer,
-                                /*allowConsumerParallelismPessimization=*/true);
+  if (!areOpsAggresiveFusable(producer, consumer,
+                              /*allowConsumerParallelismPessimization=*/true)) {
+    return false;
+  }
+  return !costModel || costModel->isProfitableToFuseConsumer(fusedOperand);
 }
 
 /// Fuses roots with its consumers. If a root is fused with its consumer, it is
@@ -870,7 +998,8 @@ static bool isFusableWithConsumer(OpOperand &fusedOperand,
 static void fuseRootsWithConsumers(MLIRContext *context,
                                    ArrayRef<Operation *> roots,
                                    DominanceInfo const &dominanceInfo,
-                                   bool aggressiveFusion) {
+                                   bool aggressiveFusion,
+                                   FusionCostModel *costModel) {
   SmallVector<Operation *> workList(roots.begin(), roots.end());
   // Fuse with consumers where possible.
   while (!workList.empty()) {
@@ -898,7 +1027,8 @@ static void fuseRootsWithConsumers(MLIRContext *context,
       continue;
     }
 
-    if (isFusableWithConsumer(*(fusableUse.value()), aggressiveFusion)) {
+    if (isFusableWithConsumer(*(fusableUse.value()), aggressiveFusion,
+                              costModel)) {
       updateRootTo(consumerOp);
       workList.push_back(consumerOp);
     }
@@ -906,7 +1036,10 @@ static void fuseRootsWithConsumers(MLIRContext *context,
 }
 
 /// Method to check if the consumer of a use can be fused with its producer.
-static bool isFusableWithProducer(OpOperand &operand, bool aggressiveFusion) {
+/// When a `costModel` is given, uses of the aggressive fusion heuristics are
+/// only fused if the cost model deems it profitable.
+static bool isFusableWithProducer(OpOperand &operand, bool aggressiveFusion,
+                                  FusionCostModel *costModel) {
   Operation *producer = operand.get().getDefiningOp();
   Operation *consumer = operand.getOwner();
 
@@ -924,9 +1057,12 @@ static bool isFusableWithProducer(OpOperand &operand, bool aggressiveFusion) {
   // Only fuse on inputs if both are generic ops.
   if (aggressiveFusion && consumerLinalgOp.isInputTensor(&operand) &&
       isa<linalg::GenericOp>(consumer) && isa<linalg::GenericOp>(producer)) {
-    return areOpsAggresiveFusable(
-        producer, consumer,
-        /*allowConsumerParallelismPessimization=*/false);
+    if (!areOpsAggresiveFusable(
+            producer, consumer,
+            /*allowConsumerParallelismPessimization=*/false)) {
+      return false;
+    }
+    return !costModel || costModel->isProfitableToFuseProducer(operand);
   }
 
   return false;
@@ -937,7 +1073,8 @@ static bool isFusableWithProducer(OpOperand &operand, bool aggressiveFusion) {
 static void fuseRootsWithProducers(MLIRContext *context, Operation *root,
                                    unsigned groupNum,
                                    DominanceInfo const &dominanceInfo,
-                                   bool aggressiveFusion) {
+                                   bool aggressiveFusion,
+                                   FusionCostModel *costModel) {
   SmallVector<Operation *> worklist;
   worklist.push_back(root);
 
@@ -954,7 +1091,9 @@ static void fuseRootsWithProducers(MLIRContext *context, Operation *root,
           producer, dominanceInfo, /*fuseMultiUse=*/aggressiveFusion);
       if (!fusableUse || fusableUse.value()->getOwner() != candidate) continue;
 
-      if (!isFusableWithProducer(operand, aggressiveFusion)) continue;
+      if (!isFusableWithProducer(operand, aggressiveFusion, costModel)) {
+        continue;
+      }
 
       appendToFusionGroup(producer, groupNum);
       worklist.push_back(producer);
@@ -972,7 +1111,8 @@ static void fuseRootsWithProducers(MLIRContext *context, Operation *root,
 /// enough to capture any heuristic.
 static unsigned decideFusableLinalgOps(FunctionOpInterface funcOp,
                                        DominanceInfo const &dominanceInfo,
-                                       bool aggressiveFusion) {
+                                       bool aggressiveFusion,
+                                       FusionCostModel *costModel) {
   unsigned numRootOps = 0;
   MLIRContext *context = funcOp->getContext();
   OpBuilder builder(context);
@@ -990,11 +1130,12 @@ static unsigned decideFusableLinalgOps(FunctionOpInterface funcOp,
       setRootAttribute(context, &op, newGroup);
 
       fuseRootsWithProducers(context, &op, newGroup, dominanceInfo,
-                             aggressiveFusion);
+                             aggressiveFusion, costModel);
       roots.push_back(&op);
     }
     roots = llvm::to_vector(llvm::reverse(roots));
-    fuseRootsWithConsumers(context, roots, dominanceInfo, aggressiveFusion);
+    fuseRootsWithConsumers(context, roots, dominanceInfo, aggressiveFusion,
+                           costModel);
   }
 
   // Once all root linalg ops have been tagged, put all remaining generic ops
@@ -1014,7 +1155,8 @@ static unsigned decideFusableLinalgOps(FunctionOpInterface funcOp,
       roots.push_back(&op);
     }
     roots = llvm::to_vector(llvm::reverse(roots));
-    fuseRootsWithConsumers(context, roots, dominanceInfo, aggressiveFusion);
+    fuseRootsWithConsumers(context, roots, dominanceInfo, aggressiveFusion,
+                           costModel);
   }
 
   return numRootOps;
@@ -1029,16 +1171,21 @@ struct DispatchLinalgOnTensorsPass
         .insert<AffineDialect, IREE::Flow::FlowDialect, linalg::LinalgDialect,
                 scf::SCFDialect, tensor::TensorDialect>();
   }
-  DispatchLinalgOnTensorsPass(bool aggressiveFusion) {
+  DispatchLinalgOnTensorsPass(bool aggressiveFusion, bool costModelFusion) {
     this->aggressiveFusion = aggressiveFusion;
+    this->costModelFusion = costModelFusion;
   }
   DispatchLinalgOnTensorsPass(const DispatchLinalgOnTensorsPass &pass)
-      : DispatchLinalgOnTensorsPass(pass.aggressiveFusion) {}
+      : DispatchLinalgOnTensorsPass(pass.aggressiveFusion,
+                                    pass.costModelFusion) {}
   void runOnOperation() override;
 
  private:
   Statistic numDispatches{this, "number of dispatches",
                           "Number of Flow dispatches created"};
+  Statistic numFusionBytesSaved{
+      this, "fusion bytes saved",
+      "Estimated bytes of memory traffic saved by cost-model-driven fusion"};
 };
 }  // namespace
 
@@ -1116,7 +1263,13 @@ void DispatchLinalgOnTensorsPass::runOnOperation() {
   auto funcOp = getOperation();
   MLIRContext *context = &getContext();
   DominanceInfo const &dominanceInfo = getAnalysis<DominanceInfo>();
-  decideFusableLinalgOps(funcOp, dominanceInfo, aggressiveFusion);
+  // The cost model selects among the fusions allowed by the aggressive
+  // heuristics.
+  FusionCostModel costModel;
+  decideFusableLinalgOps(funcOp, dominanceInfo,
+                         aggressiveFusion || costModelFusion,
+                         costModelFusion ? &costModel : nullptr);
+  numFusionBytesSaved += costModel.getTotalBytesSaved();
 
   LLVM_DEBUG({
     llvm::dbgs() << "\n--- After annotating linalg op fusion scheme ---\n";
@@ -1199,8 +1352,9 @@ void DispatchLinalgOnTensorsPass::runOnOperation() {
 }
 
 std::unique_ptr<InterfacePass<mlir::FunctionOpInterface>>
-createDispatchLinalgOnTensorsPass(bool aggressiveFusion) {
-  return std::make_unique<DispatchLinalgOnTensorsPass>(aggressiveFusion);
+createDispatchLinalgOnTensorsPass(bool aggressiveFusion, bool costModelFusion) {
+  return std::make_unique<DispatchLinalgOnTensorsPass>(aggressiveFusion,
+                                                       costModelFusion);
 }
 
 }  // namespace Flow
@@ -91,6 +91,16 @@ static llvm::cl::opt<bool> clEnableAggressiveFusion(
         "with reduction loops"),
     llvm::cl::init(false));
 
+static llvm::cl::opt<bool> clEnableCostModelFusion(
+    "iree-flow-enable-cost-model-fusion",
+    llvm::cl::desc(
+        "Form dispatch regions with the aggressive fusion heuristics (multiuse "
+        "producers, reductions followed by broadcasts and matmul epilogues) "
+        "but only keep the fusions that a cost model estimates save memory "
+        "traffic without limiting parallelism. The estimated savings are "
+        "reported by -mlir-pass-statistics"),
+    llvm::cl::init(false));
+
 static llvm::cl::opt<std::string> clMmt4dTargetOptions(
     "iree-flow-mmt4d-target-options",
     llvm::cl::desc("Convert linalg.matmul ops to MMT4D ops targetting the "
@@ -245,7 +255,9 @@ void buildFlowTransformPassPipeline(OpPassManager &passManager,
       .addPass(memref::createResolveShapedTypeResultDimsPass)
       .addPass(mlir::createCanonicalizerPass)
       .addPass(mlir::createCSEPass)
-      // Elementwise fusion.
+      // Elementwise fusion. Multi-use producers fused here are not checked
+      // by the cost model, so with cost-model fusion they are instead left to
+      // dispatch region formation.
       .addPass([]() {
         return createFusionOfTensorOpsPass(clEnableAggressiveFusion);
       })
@@ -276,7 +288,8 @@ void buildFlowTransformPassPipeline(OpPassManager &passManager,
       .addPredicatedPass(
           !clDispatchViaRegionOps,
           []() {
-            return createDispatchLinalgOnTensorsPass(clEnableAggressiveFusion);
+            return createDispatchLinalgOnTensorsPass(clEnableAggressiveFusion,
+                                                     clEnableCostModelFusion);
           })
       // DispatchLinalgOnTensorsViaRegionsPass is a variant of
       // DispatchLinalgOnTensorsPass that lowers via DispatchRegionOps. This is
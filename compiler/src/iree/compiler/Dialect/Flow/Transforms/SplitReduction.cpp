@@ -13,6 +13,7 @@
 #include "iree-dialects/Dialect/LinalgExt/Passes/Passes.h"
 #include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
 #include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
+#include "iree/compiler/Dialect/HAL/IR/HALTypes.h"
 #include "mlir/Dialect/Affine/IR/AffineOps.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/Linalg/Transforms/Transforms.h"
@@ -28,11 +29,67 @@ static llvm::cl::opt<int64_t> splitReductionRatio(
     "iree-flow-split-matmul-reduction", llvm::cl::desc("split ratio"),
     llvm::cl::init(1));
 
+static llvm::cl::opt<int64_t> splitReductionNumWorkers(
+    "iree-flow-split-matmul-reduction-num-workers",
+    llvm::cl::desc("overrides the number of workers derived from the "
+                   "`num_workers` of the executable targets; when non-zero "
+                   "and no explicit split ratio is given, split the reduction "
+                   "dimension of static matmuls whose parallel iteration "
+                   "space is too small to keep this many workers busy"),
+    llvm::cl::init(0));
+
 static llvm::cl::list<int64_t> topkSplitReductionRatio(
     "iree-flow-topk-split-reduction",
     llvm::cl::desc("comma separated list of split ratios"),
     llvm::cl::CommaSeparated);
 
+/// Minimum number of elements of the parallel iteration space of a matmul per
+/// worker. Below that the workers are starved and the reduction is split.
+static constexpr int64_t kMinParallelSizePerWorker = 64 * 64;
+
+/// Minimum size of each of the reduction slices produced by splitting.
+static constexpr int64_t kMinSplitReductionSize = 256;
+
+/// Returns the ratio to split the reduction dimension of `matmulOp` by such
+/// that `numWorkers` workers have enough parallel work, or 0 if the matmul
+/// should not be split. The ratio has to divide the reduction dimension.
+static int64_t getSplitReductionRatio(linalg::MatmulOp matmulOp,
+                                      int64_t numWorkers) {
+  SmallVector<int64_t> loopRanges = matmulOp.getStaticLoopRanges();
+  if (llvm::any_of(loopRanges, ShapedType::isDynamic)) return 0;
+  int64_t parallelSize = loopRanges[0] * loopRanges[1];
+  int64_t reductionSize = loopRanges[2];
+  int64_t targetParallelSize = numWorkers * kMinParallelSizePerWorker;
+  if (parallelSize >= targetParallelSize) return 0;
+
+  int64_t maxRatio =
+      std::min({numWorkers, llvm::divideCeil(targetParallelSize, parallelSize),
+                reductionSize / kMinSplitReductionSize});
+  for (int64_t ratio = maxRatio; ratio > 1; --ratio) {
+    if (reductionSize % ratio == 0) return ratio;
+  }
+  return 0;
+}
+
+/// Returns the number of workers the dispatches of `op` are expected to be
+/// distributed across: the largest `num_workers` of the executable targets
+/// `op` may be compiled for unless overridden by the flag. Returns 0 if
+/// unknown.
+static int64_t getNumWorkers(Operation *op) {
+  if (splitReductionNumWorkers > 0) return splitReductionNumWorkers;
+  int64_t numWorkers = 0;
+  for (auto targetAttr :
+       IREE::HAL::DeviceTargetAttr::lookupExecutableTargets(op)) {
+    auto configAttr = targetAttr.getConfiguration();
+    auto numWorkersAttr =
+        configAttr ? configAttr.getAs<IntegerAttr>("num_workers") : nullptr;
+    if (numWorkersAttr) {
+      numWorkers = std::max(numWorkers, numWorkersAttr.getInt());
+    }
+  }
+  return numWorkers;
+}
+
 namespace {
 /// Pattern to wrap splitReduction transformation. This also propagates
 /// attributes to allow compilation info attribute to not be lost.
@@ -81,7 +138,8 @@ struct SplitReductionPass : public SplitReductionBase<SplitReductionPass> {
   }
 
   void runOnOperation() override {
-    if (splitReductionRatio.getValue() <= 1 &&
+    int64_t numWorkers = getNumWorkers(getOperation());
+    if (splitReductionRatio.getValue() <= 1 && numWorkers <= 0 &&
         topkSplitReductionRatio.empty()) {
       return;
     }
@@ -91,9 +149,16 @@ struct SplitReductionPass : public SplitReductionBase<SplitReductionPass> {
         &getContext(),
         [&](linalg::LinalgOp op) {
           // For matmul make the new parallel dimension first so that it looks
-          // like a batch_matmul and can follow the same codegen.
-          if (isa<linalg::MatmulOp>(op))
-            return std::make_pair(int64_t(splitReductionRatio), 0);
+          // like a batch_matmul and can follow the same codegen. An explicit
+          // split ratio takes precedence over the one derived from the number
+          // of workers.
+          if (auto matmulOp = dyn_cast<linalg::MatmulOp>(op.getOperation())) {
+            if (splitReductionRatio > 1 || numWorkers <= 0) {
+              return std::make_pair(int64_t(splitReductionRatio), 0);
+            }
+            return std::make_pair(getSplitReductionRatio(matmulOp, numWorkers),
+                                  0);
+          }
           // Currently disable spliting reduction for non-matmul op. This will
           // get enabled after once tests are ready.
           return std::make_pair(int64_t(0), 0);
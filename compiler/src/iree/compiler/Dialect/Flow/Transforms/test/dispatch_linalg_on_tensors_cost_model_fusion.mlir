@@ -0,0 +1,178 @@
+// RUN: iree-opt --split-input-file --pass-pipeline="func.func(iree-flow-dispatch-linalg-on-tensors-pass{cost-model-fusion=true})" %s | FileCheck %s
+// RUN: iree-opt --split-input-file --pass-pipeline="func.func(iree-flow-dispatch-linalg-on-tensors-pass{cost-model-fusion=true})" --mlir-pass-statistics --mlir-pass-statistics-display=list %s -o /dev/null 2>&1 | FileCheck %s --check-prefix=STATS
+
+#map0 = affine_map<(d0, d1, d2) -> (d0, d1, d2)>
+#map1 = affine_map<(d0, d1, d2) -> (d0, d1)>
+module {
+  func.func @softmax(%arg0: tensor<12x128x128xf32>) -> tensor<12x128x128xf32> {
+    %cst = arith.constant 1.000000e+00 : f32
+    %cst_0 = arith.constant 0.000000e+00 : f32
+    %cst_1 = arith.constant -3.40282347E+38 : f32
+    %0 = linalg.init_tensor [12, 128] : tensor<12x128xf32>
+    %1 = linalg.fill ins(%cst_1 : f32) outs(%0 : tensor<12x128xf32>) -> tensor<12x128xf32>
+    %2 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel", "reduction"]} ins(%arg0 : tensor<12x128x128xf32>) outs(%1 : tensor<12x128xf32>) {
+    ^bb0(%arg1: f32, %arg2: f32):
+      %7 = arith.maxf %arg1, %arg2 : f32
+      linalg.yield %7 : f32
+    } -> tensor<12x128xf32>
+    %3 = linalg.init_tensor [12, 128, 128] : tensor<12x128x128xf32>
+    %4 = linalg.fill ins(%cst_0 : f32) outs(%0 : tensor<12x128xf32>) -> tensor<12x128xf32>
+    %5:2 = linalg.generic {indexing_maps = [#map0, #map1, #map0, #map1], iterator_types = ["parallel", "parallel", "reduction"]} ins(%arg0, %2 : tensor<12x128x128xf32>, tensor<12x128xf32>) outs(%3, %4 : tensor<12x128x128xf32>, tensor<12x128xf32>) {
+    ^bb0(%arg1: f32, %arg2: f32, %arg3: f32, %arg4: f32):
+      %7 = arith.subf %arg1, %arg2 : f32
+      %8 = math.exp %7 : f32
+      %9 = arith.addf %8, %arg4 : f32
+      linalg.yield %8, %9 : f32, f32
+    } -> (tensor<12x128x128xf32>, tensor<12x128xf32>)
+    %6 = linalg.generic {indexing_maps = [#map0, #map1, #map0], iterator_types = ["parallel", "parallel", "parallel"]} ins(%5#0, %5#1 : tensor<12x128x128xf32>, tensor<12x128xf32>) outs(%3 : tensor<12x128x128xf32>) {
+    ^bb0(%arg1: f32, %arg2: f32, %arg3: f32):
+      %7 = arith.divf %cst, %arg2 : f32
+      %8 = arith.mulf %arg1, %7 : f32
+      linalg.yield %8 : f32
+    } -> tensor<12x128x128xf32>
+    return %6 : tensor<12x128x128xf32>
+  }
+}
+// CHECK-LABEL: func @softmax(
+//  CHECK-SAME:     %[[ARG0:[a-zA-Z0-9]+]]: tensor<12x128x128xf32>
+//       CHECK:   %[[DISPATCH:.+]] = flow.dispatch.workgroups
+//  CHECK-SAME:       (%[[ARG0]])
+//  CHECK-NEXT:     %[[ARG1:.+]]: !flow.dispatch.tensor<readonly:12x128x128xf32>
+//       CHECK:     %[[LOAD0:.+]] = flow.dispatch.tensor.load %[[ARG1]]
+//       CHECK:     %[[FILL0:.+]] = linalg.fill
+//       CHECK:     %[[FILL1:.+]] = linalg.fill
+//       CHECK:     %[[GENERIC0:.+]] = linalg.generic
+//  CHECK-SAME:         ins(%[[LOAD0]] :
+//       CHECK:     %[[GENERIC1:.+]]:2 = linalg.generic
+//  CHECK-SAME:         ins(%[[LOAD0]], %[[GENERIC0]] :
+//       CHECK:     %[[GENERIC2:.+]] = linalg.generic
+//  CHECK-SAME:         ins(%[[GENERIC1]]#0, %[[GENERIC1]]#1 :
+//       CHECK:     flow.dispatch.tensor.store %[[GENERIC2]]
+//       CHECK:     flow.return
+//       CHECK:   return %[[DISPATCH]]
+// Writing and reading back the 12x128 max (2 * 6144 bytes), the 12x128x128
+// exponentials (2 * 786432 bytes) and the 12x128 sum (2 * 6144 bytes) is
+// avoided.
+//       STATS: DispatchLinalgOnTensors
+//  STATS-NEXT:   (S) {{ *}}1597440 fusion bytes saved
+
+
+// -----
+
+#map0 = affine_map<(d0, d1) -> (d0, d1)>
+#map1 = affine_map<(d0, d1, d2) -> (d0, d1)>
+#map2 = affine_map<(d0, d1, d2) -> (d0, d1, d2)>
+module {
+  func.func @multi_use_producer_not_profitable(%arg0: tensor<64x64xf32>, %arg1: tensor<64x64xf32>, %arg2: tensor<64x64x64xf32>) -> (tensor<64x64xf32>, tensor<64x64xf32>) {
+    %cst = arith.constant 0.000000e+00 : f32
+    %0 = linalg.init_tensor [64, 64] : tensor<64x64xf32>
+    %1 = linalg.generic {indexing_maps = [#map0, #map0, #map0], iterator_types = ["parallel", "parallel"]} ins(%arg0, %arg1 : tensor<64x64xf32>, tensor<64x64xf32>) outs(%0 : tensor<64x64xf32>) {
+    ^bb0(%arg3: f32, %arg4: f32, %arg5: f32):
+      %5 = arith.addf %arg3, %arg4 : f32
+      linalg.yield %5 : f32
+    } -> tensor<64x64xf32>
+    %2 = linalg.fill ins(%cst : f32) outs(%0 : tensor<64x64xf32>) -> tensor<64x64xf32>
+    %3 = linalg.generic {indexing_maps = [#map1, #map2, #map1], iterator_types = ["parallel", "parallel", "reduction"]} ins(%1, %arg2 : tensor<64x64xf32>, tensor<64x64x64xf32>) outs(%2 : tensor<64x64xf32>) {
+    ^bb0(%arg3: f32, %arg4: f32, %arg5: f32):
+      %5 = arith.mulf %arg3, %arg4 : f32
+      %6 = arith.addf %5, %arg5 : f32
+      linalg.yield %6 : f32
+    } -> tensor<64x64xf32>
+    return %1, %3 : tensor<64x64xf32>, tensor<64x64xf32>
+  }
+}
+// Recomputing the elementwise op in the reduction dispatch would read both of
+// its operands again to avoid a single read of its result.
+// CHECK-LABEL: func @multi_use_producer_not_profitable(
+//  CHECK-SAME:     %[[ARG0:[a-zA-Z0-9]+]]: tensor<64x64xf32>
+//  CHECK-SAME:     %[[ARG1:[a-zA-Z0-9]+]]: tensor<64x64xf32>
+//       CHECK:   %[[DISPATCH0:.+]] = flow.dispatch.workgroups
+//  CHECK-SAME:       (%[[ARG0]], %[[ARG1]])
+//       CHECK:     %[[GENERIC0:.+]] = linalg.generic
+//       CHECK:     flow.dispatch.tensor.store %[[GENERIC0]]
+//       CHECK:     flow.return
+//       CHECK:   %[[DISPATCH1:.+]] = flow.dispatch.workgroups
+//  CHECK-SAME:       %[[DISPATCH0]]
+//   CHECK-NOT:     linalg.generic {{.+}} ["parallel", "parallel"]
+//       CHECK:     %[[GENERIC1:.+]] = linalg.generic
+//  CHECK-SAME:         ["parallel", "parallel", "reduction"]
+//       CHECK:     flow.dispatch.tensor.store %[[GENERIC1]]
+//       CHECK:     flow.return
+//       CHECK:   return %[[DISPATCH0]], %[[DISPATCH1]]
+//       STATS: DispatchLinalgOnTensors
+//  STATS-NEXT:   (S) {{ *}}0 fusion bytes saved
+
+// -----
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+module {
+  func.func @matmul_multi_use_epilogue(%arg0: tensor<128x256xf32>, %arg1: tensor<256x64xf32>, %arg2: tensor<128x64xf32>) -> (tensor<128x64xf32>, tensor<128x64xf32>) {
+    %cst = arith.constant 0.000000e+00 : f32
+    %0 = linalg.init_tensor [128, 64] : tensor<128x64xf32>
+    %1 = linalg.fill ins(%cst : f32) outs(%0 : tensor<128x64xf32>) -> tensor<128x64xf32>
+    %2 = linalg.matmul ins(%arg0, %arg1 : tensor<128x256xf32>, tensor<256x64xf32>) outs(%1 : tensor<128x64xf32>) -> tensor<128x64xf32>
+    %3 = linalg.generic {indexing_maps = [#map, #map, #map], iterator_types = ["parallel", "parallel"]} ins(%2, %arg2 : tensor<128x64xf32>, tensor<128x64xf32>) outs(%0 : tensor<128x64xf32>) {
+    ^bb0(%arg3: f32, %arg4: f32, %arg5: f32):
+      %4 = arith.addf %arg3, %arg4 : f32
+      linalg.yield %4 : f32
+    } -> tensor<128x64xf32>
+    return %2, %3 : tensor<128x64xf32>, tensor<128x64xf32>
+  }
+}
+// The matmul result is still written out but fusing the epilogue saves reading
+// it back.
+// CHECK-LABEL: func @matmul_multi_use_epilogue(
+//       CHECK:   %[[DISPATCH:.+]]:2 = flow.dispatch.workgroups
+//       CHECK:     %[[MATMUL:.+]] = linalg.matmul
+//       CHECK:     %[[GENERIC:.+]] = linalg.generic
+//  CHECK-SAME:         ins(%[[MATMUL]],
+//   CHECK-DAG:     flow.dispatch.tensor.store %[[MATMUL]]
+//   CHECK-DAG:     flow.dispatch.tensor.store %[[GENERIC]]
+//       CHECK:     flow.return
+//       CHECK:   return %[[DISPATCH]]#0, %[[DISPATCH]]#1
+// Only the read of the 128x64 matmul result (32768 bytes) is avoided.
+//       STATS: DispatchLinalgOnTensors
+//  STATS-NEXT:   (S) {{ *}}32768 fusion bytes saved
+
+// -----
+
+#map0 = affine_map<(d0, d1) -> (d0, d1)>
+#map1 = affine_map<(d0, d1) -> (d0)>
+module {
+  func.func @reduction_broadcast_low_parallelism(%arg0: tensor<4x4096xf32>) -> tensor<4x4096xf32> {
+    %cst = arith.constant -3.40282347E+38 : f32
+    %0 = linalg.init_tensor [4] : tensor<4xf32>
+    %1 = linalg.fill ins(%cst : f32) outs(%0 : tensor<4xf32>) -> tensor<4xf32>
+    %2 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "reduction"]} ins(%arg0 : tensor<4x4096xf32>) outs(%1 : tensor<4xf32>) {
+    ^bb0(%arg1: f32, %arg2: f32):
+      %5 = arith.maxf %arg1, %arg2 : f32
+      linalg.yield %5 : f32
+    } -> tensor<4xf32>
+    %3 = linalg.init_tensor [4, 4096] : tensor<4x4096xf32>
+    %4 = linalg.generic {indexing_maps = [#map0, #map1, #map0], iterator_types = ["parallel", "parallel"]} ins(%arg0, %2 : tensor<4x4096xf32>, tensor<4xf32>) outs(%3 : tensor<4x4096xf32>) {
+    ^bb0(%arg1: f32, %arg2: f32, %arg3: f32):
+      %5 = arith.subf %arg1, %arg2 : f32
+      linalg.yield %5 : f32
+    } -> tensor<4x4096xf32>
+    return %4 : tensor<4x4096xf32>
+  }
+}
+// Fusing the broadcast into the reduction dispatch would only distribute it
+// along the 4 rows of the reduction.
+// CHECK-LABEL: func @reduction_broadcast_low_parallelism(
+//  CHECK-SAME:     %[[ARG0:[a-zA-Z0-9]+]]: tensor<4x4096xf32>
+//       CHECK:   %[[DISPATCH0:.+]] = flow.dispatch.workgroups
+//  CHECK-SAME:       (%[[ARG0]])
+//       CHECK:     %[[GENERIC0:.+]] = linalg.generic
+//  CHECK-SAME:         ["parallel", "reduction"]
+//       CHECK:     flow.dispatch.tensor.store %[[GENERIC0]]
+//       CHECK:     flow.return
+//       CHECK:   %[[DISPATCH1:.+]] = flow.dispatch.workgroups
+//  CHECK-SAME:       %[[DISPATCH0]]
+//       CHECK:     %[[GENERIC1:.+]] = linalg.generic
+//  CHECK-SAME:         ["parallel", "parallel"]
+//       CHECK:     flow.dispatch.tensor.store %[[GENERIC1]]
+//       CHECK:     flow.return
+//       CHECK:   return %[[DISPATCH1]]
+//       STATS: DispatchLinalgOnTensors
+//  STATS-NEXT:   (S) {{ *}}0 fusion bytes saved
@@ -115,6 +115,30 @@ func.func @check_mmt4d_i8_static_pad(%arg0: tensor<13x15xi8>, %arg1: tensor<15x1
 // CHECK-SAME: tensor<16x12xi32> to tensor<13x12xi32>
 //      CHECK: return %[[RES]] : tensor<13x12xi32>
 
+// -----
+func.func @check_mmt4d_i32_constant_rhs(%arg0: tensor<24x3xi32>, %arg1: tensor<24x5xi32>) -> tensor<24x5xi32> {
+    %cst = arith.constant dense<[[1, 2, 3, 4, 5], [6, 7, 8, 9, 10], [11, 12, 13, 14, 15]]> : tensor<3x5xi32>
+    %0 = linalg.matmul ins(%arg0, %cst : tensor<24x3xi32>, tensor<3x5xi32>) outs(%arg1 : tensor<24x5xi32>) -> tensor<24x5xi32>
+    return %0 : tensor<24x5xi32>
+}
+// The constant RHS is padded and relaid out at compile time.
+//CHECK-LABEL: @check_mmt4d_i32_constant_rhs(
+//  CHECK-DAG: %[[PACKED_RHS:.+]] = arith.constant dense<{{\[}}{{\[}}{{\[}}[1, 6], [2, 7], [3, 8], [4, 9]], {{\[}}[11, 0], [12, 0], [13, 0], [14, 0]]], {{\[}}{{\[}}[5, 10], [0, 0], [0, 0], [0, 0]], {{\[}}[15, 0], [0, 0], [0, 0], [0, 0]]]]> : tensor<2x2x4x2xi32>
+//  CHECK-NOT: tensor.pad {{.+}} : tensor<3x5xi32>
+//      CHECK: linalg.mmt4d
+// CHECK-SAME:   ins(%{{.+}}, %[[PACKED_RHS]] : tensor<3x2x8x2xi32>, tensor<2x2x4x2xi32>)
+
+// -----
+func.func @check_mmt4d_f32_zero_splat_constant_rhs(%arg0: tensor<24x3xf32>, %arg1: tensor<24x5xf32>) -> tensor<24x5xf32> {
+    %cst = arith.constant dense<0.0> : tensor<3x5xf32>
+    %0 = linalg.matmul ins(%arg0, %cst : tensor<24x3xf32>, tensor<3x5xf32>) outs(%arg1 : tensor<24x5xf32>) -> tensor<24x5xf32>
+    return %0 : tensor<24x5xf32>
+}
+//CHECK-LABEL: @check_mmt4d_f32_zero_splat_constant_rhs(
+//  CHECK-DAG: %[[PACKED_RHS:.+]] = arith.constant dense<0.000000e+00> : tensor<2x2x4x2xf32>
+//      CHECK: linalg.mmt4d
+// CHECK-SAME:   ins(%{{.+}}, %[[PACKED_RHS]] : tensor<3x2x8x2xf32>, tensor<2x2x4x2xf32>)
+
 // -----
 func.func @check_mmt4d_i8_dynamic(%arg0: tensor<?x?xi8>, %arg1: tensor<?x?xi8>, %arg2: tensor<?x?xi32>) -> tensor<?x?xi32> {
     %0 = linalg.matmul ins(%arg0, %arg1 : tensor<?x?xi8>, tensor<?x?xi8>) outs(%arg2 : tensor<?x?xi32>) -> tensor<?x?xi32>
@@ -0,0 +1,57 @@
+// RUN: iree-opt --split-input-file --pass-pipeline='func.func(iree-flow-split-reduction-ops)' --iree-flow-split-matmul-reduction-num-workers=8 %s | FileCheck %s
+
+func.func @matmul_small_parallel_large_k(%lhs: tensor<1x4096xf32>, %rhs: tensor<4096x64xf32>, %acc: tensor<1x64xf32>) -> tensor<1x64xf32> {
+  %0 = linalg.matmul ins(%lhs, %rhs : tensor<1x4096xf32>, tensor<4096x64xf32>) outs(%acc : tensor<1x64xf32>) -> tensor<1x64xf32>
+  return %0 : tensor<1x64xf32>
+}
+// CHECK-LABEL: func.func @matmul_small_parallel_large_k
+//       CHECK:   %[[LHS:.+]] = tensor.expand_shape {{.+}} into tensor<1x8x512xf32>
+//       CHECK:   %[[RHS:.+]] = tensor.expand_shape {{.+}} into tensor<8x512x64xf32>
+//       CHECK:   %[[SPLIT:.+]] = linalg.generic
+//  CHECK-SAME:       ins(%[[LHS]], %[[RHS]] :
+//  CHECK-SAME:       -> tensor<8x1x64xf32>
+//       CHECK:   %[[RESULT:.+]] = linalg.generic
+//  CHECK-SAME:       ins(%[[SPLIT]] : tensor<8x1x64xf32>)
+//  CHECK-SAME:       -> tensor<1x64xf32>
+//       CHECK:   return %[[RESULT]]
+
+// -----
+
+// The split ratio has to divide the reduction dimension.
+func.func @matmul_split_ratio_divides_k(%lhs: tensor<7x1000xf32>, %rhs: tensor<1000x13xf32>, %acc: tensor<7x13xf32>) -> tensor<7x13xf32> {
+  %0 = linalg.matmul ins(%lhs, %rhs : tensor<7x1000xf32>, tensor<1000x13xf32>) outs(%acc : tensor<7x13xf32>) -> tensor<7x13xf32>
+  return %0 : tensor<7x13xf32>
+}
+// CHECK-LABEL: func.func @matmul_split_ratio_divides_k
+//       CHECK:   linalg.generic
+//  CHECK-SAME:       -> tensor<2x7x13xf32>
+
+// -----
+
+func.func @matmul_large_parallel(%lhs: tensor<256x4096xf32>, %rhs: tensor<4096x256xf32>, %acc: tensor<256x256xf32>) -> tensor<256x256xf32> {
+  %0 = linalg.matmul ins(%lhs, %rhs : tensor<256x4096xf32>, tensor<4096x256xf32>) outs(%acc : tensor<256x256xf32>) -> tensor<256x256xf32>
+  return %0 : tensor<256x256xf32>
+}
+// CHECK-LABEL: func.func @matmul_large_parallel
+//   CHECK-NOT:   linalg.generic
+//       CHECK:   linalg.matmul
+
+// -----
+
+func.func @matmul_small_k(%lhs: tensor<1x256xf32>, %rhs: tensor<256x64xf32>, %acc: tensor<1x64xf32>) -> tensor<1x64xf32> {
+  %0 = linalg.matmul ins(%lhs, %rhs : tensor<1x256xf32>, tensor<256x64xf32>) outs(%acc : tensor<1x64xf32>) -> tensor<1x64xf32>
+  return %0 : tensor<1x64xf32>
+}
+// CHECK-LABEL: func.func @matmul_small_k
+//   CHECK-NOT:   linalg.generic
+//       CHECK:   linalg.matmul
+
+// -----
+
+func.func @matmul_dynamic(%lhs: tensor<?x?xf32>, %rhs: tensor<?x?xf32>, %acc: tensor<?x?xf32>) -> tensor<?x?xf32> {
+  %0 = linalg.matmul ins(%lhs, %rhs : tensor<?x?xf32>, tensor<?x?xf32>) outs(%acc : tensor<?x?xf32>) -> tensor<?x?xf32>
+  return %0 : tensor<?x?xf32>
+}
+// CHECK-LABEL: func.func @matmul_dynamic
+//   CHECK-NOT:   linalg.generic
+//       CHECK:   linalg.matmul
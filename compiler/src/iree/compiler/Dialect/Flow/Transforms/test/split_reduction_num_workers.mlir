@@ -0,0 +1,36 @@
+// RUN: iree-opt --split-input-file --pass-pipeline='func.func(iree-flow-split-reduction-ops)' %s | FileCheck %s
+// RUN: iree-opt --split-input-file --pass-pipeline='func.func(iree-flow-split-reduction-ops)' --iree-flow-split-matmul-reduction-num-workers=2 %s | FileCheck %s --check-prefix=OVERRIDE
+
+// Tests that the number of workers to split matmul reductions for is derived
+// from the executable targets of the module unless overridden by the flag.
+
+#executable_target = #hal.executable.target<"llvm-cpu", "embedded-elf-x86_64", {num_workers = 4 : index}>
+#device_target = #hal.device.target<"llvm-cpu", {executable_targets = [#executable_target]}>
+module attributes {hal.device.targets = [#device_target]} {
+  func.func @matmul_target_num_workers(%lhs: tensor<1x4096xf32>, %rhs: tensor<4096x64xf32>, %acc: tensor<1x64xf32>) -> tensor<1x64xf32> {
+    %0 = linalg.matmul ins(%lhs, %rhs : tensor<1x4096xf32>, tensor<4096x64xf32>) outs(%acc : tensor<1x64xf32>) -> tensor<1x64xf32>
+    return %0 : tensor<1x64xf32>
+  }
+}
+// CHECK-LABEL: func.func @matmul_target_num_workers
+//       CHECK:   tensor.expand_shape {{.+}} into tensor<1x4x1024xf32>
+//       CHECK:   linalg.generic
+//  CHECK-SAME:       -> tensor<4x1x64xf32>
+// OVERRIDE-LABEL: func.func @matmul_target_num_workers
+//       OVERRIDE:   tensor.expand_shape {{.+}} into tensor<1x2x2048xf32>
+//       OVERRIDE:   linalg.generic
+//  OVERRIDE-SAME:       -> tensor<2x1x64xf32>
+
+// -----
+
+// Without targets the number of workers is unknown and nothing is split.
+func.func @matmul_no_targets(%lhs: tensor<1x4096xf32>, %rhs: tensor<4096x64xf32>, %acc: tensor<1x64xf32>) -> tensor<1x64xf32> {
+  %0 = linalg.matmul ins(%lhs, %rhs : tensor<1x4096xf32>, tensor<4096x64xf32>) outs(%acc : tensor<1x64xf32>) -> tensor<1x64xf32>
+  return %0 : tensor<1x64xf32>
+}
+// CHECK-LABEL: func.func @matmul_no_targets
+//   CHECK-NOT:   linalg.generic
+//       CHECK:   linalg.matmul
+// OVERRIDE-LABEL: func.func @matmul_no_targets
+//       OVERRIDE:   linalg.generic
+//  OVERRIDE-SAME:       -> tensor<2x1x64xf32>
@@ -313,7 +313,14 @@ std::string ExecutableTargetAttr::getSymbolNameFragment() {
 }
 
 Attribute ExecutableTargetAttr::getMatchExpression() {
-  return DeviceMatchExecutableFormatAttr::get(getContext(), getFormat());
+  auto formatAttr =
+      DeviceMatchExecutableFormatAttr::get(getContext(), getFormat());
+  auto configAttr = getConfiguration();
+  auto requirementAttr =
+      configAttr ? configAttr.getAs<MatchAttrInterface>("match") : nullptr;
+  if (!requirementAttr) return formatAttr;
+  return MatchAllAttr::get(getContext(),
+                           ArrayRef<Attribute>{formatAttr, requirementAttr});
 }
 
 //===----------------------------------------------------------------------===//
@@ -495,6 +502,33 @@ Value DeviceMatchArchitectureAttr::buildConditionExpression(
       .getValue();
 }
 
+// static
+Attribute DeviceMatchCPUFeatureAttr::parse(AsmParser &p, Type type) {
+  StringAttr patternAttr;
+  if (failed(p.parseLess()) || failed(p.parseAttribute(patternAttr)) ||
+      failed(p.parseGreater())) {
+    return {};
+  }
+  return get(p.getContext(), patternAttr);
+}
+
+void DeviceMatchCPUFeatureAttr::print(AsmPrinter &p) const {
+  auto &os = p.getStream();
+  os << "<";
+  p.printAttribute(getPattern());
+  os << ">";
+}
+
+Value DeviceMatchCPUFeatureAttr::buildConditionExpression(
+    Location loc, Value device, OpBuilder builder) const {
+  auto i1Type = builder.getI1Type();
+  return builder
+      .create<IREE::HAL::DeviceQueryOp>(
+          loc, i1Type, i1Type, device, builder.getStringAttr("hal.cpu"),
+          getPattern(), builder.getZeroAttr(i1Type))
+      .getValue();
+}
+
 // static
 Attribute DeviceMatchExecutableFormatAttr::parse(AsmParser &p, Type type) {
   StringAttr patternAttr;
@@ -0,0 +1,94 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/HAL/Target/LLVM/Builtins/UKernel.h"
+
+#include "iree/builtins/ukernel/bin/libukernel.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/Support/MemoryBufferRef.h"
+#include "mlir/Support/LLVM.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace HAL {
+
+static const iree_file_toc_t *lookupUKernelFile(StringRef filename) {
+  for (size_t i = 0; i < iree_builtins_libukernel_size(); ++i) {
+    const auto &file_toc = iree_builtins_libukernel_create()[i];
+    if (filename == file_toc.name) return &file_toc;
+  }
+  return nullptr;
+}
+
+static const iree_file_toc_t *lookupUKernelFile(
+    llvm::TargetMachine *targetMachine) {
+  const auto &triple = targetMachine->getTargetTriple();
+
+  // NOTE: other arch-specific checks go here. The architecture-specific tile
+  // functions are assembled as ELF and selected at runtime based on the
+  // processor data.
+  if (triple.isAArch64() && triple.isOSBinFormatELF()) {
+    if (const auto *file = lookupUKernelFile("libukernel_arm_64.bc")) {
+      return file;
+    }
+  }
+
+  // Fallback path using the generic wasm variants as they are largely
+  // machine-agnostic.
+  if (triple.isArch32Bit()) {
+    return lookupUKernelFile("libukernel_wasm32_generic.bc");
+  } else if (triple.isArch64Bit()) {
+    return lookupUKernelFile("libukernel_wasm64_generic.bc");
+  } else {
+    return nullptr;
+  }
+}
+
+static void overridePlatformGlobal(llvm::Module &module, StringRef globalName,
+                                   uint64_t newValue) {
+  // NOTE: the global will not be defined if it is not used in the module.
+  auto *globalValue = module.getNamedGlobal(globalName);
+  if (!globalValue) return;
+  globalValue->setLinkage(llvm::GlobalValue::PrivateLinkage);
+  globalValue->setDSOLocal(true);
+  globalValue->setConstant(true);
+  globalValue->setInitializer(
+      llvm::ConstantInt::get(globalValue->getValueType(), APInt(64, newValue)));
+}
+
+llvm::Expected<std::unique_ptr<llvm::Module>> loadUKernelBitcode(
+    llvm::TargetMachine *targetMachine, uint64_t cpuDataField0,
+    llvm::LLVMContext &context) {
+  // Find a bitcode file for the current architecture.
+  const auto *file = lookupUKernelFile(targetMachine);
+  if (!file) {
+    return llvm::createStringError(
+        llvm::inconvertibleErrorCode(),
+        "no matching architecture bitcode file; the microkernel bitcode is "
+        "produced by runtime/src/iree/builtins/ukernel/bin/build.sh");
+  }
+
+  // Load the bitcode file contents.
+  llvm::MemoryBufferRef bitcodeBufferRef(
+      llvm::StringRef(file->data, file->size), file->name);
+  auto bitcodeModuleValue = llvm::parseBitcodeFile(bitcodeBufferRef, context);
+  if (!bitcodeModuleValue) return bitcodeModuleValue;
+  auto bitcodeModule = std::move(bitcodeModuleValue.get());
+
+  // Inject the processor data so tile function selection folds away.
+  overridePlatformGlobal(*bitcodeModule,
+                         "iree_ukernel_mmt4d_memref_cpu_data_field_0",
+                         cpuDataField0);
+
+  return std::move(bitcodeModule);
+}
+
+}  // namespace HAL
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -0,0 +1,31 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_COMPILER_DIALECT_HAL_TARGET_LLVM_BUILTINS_UKERNEL_H_
+#define IREE_COMPILER_DIALECT_HAL_TARGET_LLVM_BUILTINS_UKERNEL_H_
+
+#include "llvm/IR/Module.h"
+#include "llvm/Target/TargetMachine.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace HAL {
+
+// Loads the microkernel library bitcode matching |targetMachine|.
+// |cpuDataField0| is the processor data field 0 (as defined in
+// runtime/src/iree/schemas/cpu_data.h) guaranteed to be supported by the
+// processors the code will run on and is used to select tile functions.
+llvm::Expected<std::unique_ptr<llvm::Module>> loadUKernelBitcode(
+    llvm::TargetMachine *targetMachine, uint64_t cpuDataField0,
+    llvm::LLVMContext &context);
+
+}  // namespace HAL
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
+
+#endif  // IREE_COMPILER_DIALECT_HAL_TARGET_LLVM_BUILTINS_UKERNEL_H_
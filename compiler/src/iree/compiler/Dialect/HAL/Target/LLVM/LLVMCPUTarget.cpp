@@ -14,17 +14,21 @@
 #include "iree/compiler/Codegen/Passes.h"
 #include "iree/compiler/Dialect/HAL/Target/LLVM/Builtins/Device.h"
 #include "iree/compiler/Dialect/HAL/Target/LLVM/Builtins/Musl.h"
+#include "iree/compiler/Dialect/HAL/Target/LLVM/Builtins/UKernel.h"
 #include "iree/compiler/Dialect/HAL/Target/LLVM/LLVMIRPasses.h"
 #include "iree/compiler/Dialect/HAL/Target/LLVM/LibraryBuilder.h"
 #include "iree/compiler/Dialect/HAL/Target/LLVM/LinkerTool.h"
 #include "iree/compiler/Dialect/HAL/Target/LLVM/StaticLibraryGenerator.h"
 #include "iree/compiler/Dialect/HAL/Target/TargetRegistry.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Linker/Linker.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/MC/SubtargetFeature.h"
 #include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/TargetSelect.h"
 #include "mlir/Dialect/ArmNeon/ArmNeonDialect.h"
@@ -136,6 +140,72 @@ static LogicalResult linkBuiltinLibrary(
   return success();
 }
 
+// Returns true if |module| calls into the microkernel library. Codegen emits
+// the calls as declarations of the library entry points.
+static bool hasUKernelDeclarations(llvm::Module &module) {
+  for (auto &func : module) {
+    if (func.isDeclaration() &&
+        func.getName().startswith("_mlir_ciface_iree_ukernel_")) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns the CPU features that the runtime can query with the `hal.cpu`
+// device query category when selecting between executable variants.
+// Must match the canonical keys in runtime/src/iree/schemas/cpu_data.h and be
+// in the order of their bits in processor data field 0.
+static ArrayRef<StringRef> getRuntimeQueryableCPUFeatures(
+    const llvm::Triple &triple) {
+  switch (triple.getArch()) {
+    case llvm::Triple::ArchType::aarch64: {
+      static const StringRef features[] = {"dotprod", "i8mm"};
+      return features;
+    }
+    case llvm::Triple::ArchType::x86_64: {
+      static const StringRef features[] = {
+          "sse3",     "ssse3",    "sse4.1",   "sse4.2",   "popcnt",
+          "avx",      "fma",      "f16c",     "avx2",     "bmi",
+          "bmi2",     "lzcnt",    "movbe",    "avx512f",  "avx512cd",
+          "avx512vl", "avx512dq", "avx512bw", "avx512vnni",
+      };
+      return features;
+    }
+    default:
+      return {};
+  }
+}
+
+// Returns the names of all features enabled in |targetMachine|, including
+// those implied by its CPU.
+static llvm::StringSet<> getEnabledCPUFeatures(
+    const llvm::TargetMachine &targetMachine) {
+  llvm::StringSet<> features;
+  const llvm::MCSubtargetInfo *subtargetInfo =
+      targetMachine.getMCSubtargetInfo();
+  for (const auto &featureKV : subtargetInfo->getAllProcessorFeatures()) {
+    if (subtargetInfo->checkFeatures(std::string("+") + featureKV.Key)) {
+      features.insert(featureKV.Key);
+    }
+  }
+  return features;
+}
+
+// Returns processor data field 0 (see runtime/src/iree/schemas/cpu_data.h)
+// with the bits set for the runtime-queryable features |targetMachine| is
+// configured with. The bits are in the order of
+// getRuntimeQueryableCPUFeatures.
+static uint64_t getCPUDataField0(const llvm::TargetMachine &targetMachine) {
+  auto enabledFeatures = getEnabledCPUFeatures(targetMachine);
+  uint64_t field0 = 0;
+  for (auto it : llvm::enumerate(
+           getRuntimeQueryableCPUFeatures(targetMachine.getTargetTriple()))) {
+    if (enabledFeatures.contains(it.value())) field0 |= 1ull << it.index();
+  }
+  return field0;
+}
+
 class LLVMCPUTargetBackend final : public TargetBackend {
  public:
   explicit LLVMCPUTargetBackend(LLVMTargetOptions options)
@@ -159,6 +229,10 @@ class LLVMCPUTargetBackend final : public TargetBackend {
     // clang-format on
   }
 
+  void emitConfigurationDiagnostics(Location loc) const override {
+    for (auto &warning : configurationWarnings_) emitWarning(loc) << warning;
+  }
+
   IREE::HAL::DeviceTargetAttr getDefaultDeviceTarget(
       MLIRContext *context) const override {
     Builder b(context);
@@ -187,8 +261,21 @@ class LLVMCPUTargetBackend final : public TargetBackend {
         llvm::to_vector<8>(moduleOp.getOps<IREE::HAL::ExecutableOp>());
     if (sourceExecutableOps.size() <= 1) return success();
 
-    // TODO(benvanik): rework linking to support multiple formats.
-    auto sharedTargetAttr = getExecutableTarget(builder.getContext());
+    // Gather the targets of all source variants in their original order.
+    // When producing multiple CPU variants each is linked separately into its
+    // own variant of the linked executable.
+    SmallVector<IREE::HAL::ExecutableTargetAttr> targetAttrs;
+    for (auto sourceExecutableOp : sourceExecutableOps) {
+      for (auto variantOp :
+           sourceExecutableOp.getOps<IREE::HAL::ExecutableVariantOp>()) {
+        auto targetAttr = variantOp.getTarget();
+        if (targetAttr.getBackend().getValue() != name()) continue;
+        if (!llvm::is_contained(targetAttrs, targetAttr)) {
+          targetAttrs.push_back(targetAttr);
+        }
+      }
+    }
+    if (targetAttrs.empty()) return success();
 
     // Guess a module name, if needed, to make the output files readable.
     auto moduleName = guessModuleName(moduleOp);
@@ -200,19 +287,37 @@ class LLVMCPUTargetBackend final : public TargetBackend {
         moduleOp.getLoc(), linkedExecutableName);
     linkedExecutableOp.setVisibility(
         sourceExecutableOps.front().getVisibility());
+    SymbolTable linkedSymbolTable(linkedExecutableOp);
+
+    for (auto targetAttr : targetAttrs) {
+      // Add our hal.executable.variant with an empty module. Variants sharing
+      // the same format are uniqued by the symbol table.
+      builder.setInsertionPoint(&linkedExecutableOp.getBlock().back());
+      auto linkedTargetOp = builder.create<IREE::HAL::ExecutableVariantOp>(
+          moduleOp.getLoc(), targetAttr.getSymbolNameFragment(), targetAttr);
+      linkedSymbolTable.insert(linkedTargetOp);
+      builder.setInsertionPoint(&linkedTargetOp.getBlock().back());
+      builder.create<ModuleOp>(moduleOp.getLoc());
+
+      // Source executables are erased once all of their variants have been
+      // linked so only pass along those that remain.
+      SmallVector<IREE::HAL::ExecutableOp> remainingExecutableOps;
+      for (auto sourceExecutableOp :
+           moduleOp.getOps<IREE::HAL::ExecutableOp>()) {
+        if (llvm::is_contained(sourceExecutableOps, sourceExecutableOp)) {
+          remainingExecutableOps.push_back(sourceExecutableOp);
+        }
+      }
 
-    // Add our hal.executable.variant with an empty module.
-    builder.setInsertionPointToStart(&linkedExecutableOp.getBlock());
-    auto linkedTargetOp = builder.create<IREE::HAL::ExecutableVariantOp>(
-        moduleOp.getLoc(), sharedTargetAttr.getSymbolNameFragment(),
-        sharedTargetAttr);
-    builder.setInsertionPoint(&linkedTargetOp.getBlock().back());
-    builder.create<ModuleOp>(moduleOp.getLoc());
-
-    // Try linking together all executables in moduleOp.
-    return linkExecutablesInto(
-        moduleOp, sourceExecutableOps, linkedExecutableOp, linkedTargetOp,
-        [](mlir::ModuleOp moduleOp) { return moduleOp; }, builder);
+      // Try linking together all executables in moduleOp.
+      if (failed(linkExecutablesInto(
+              moduleOp, remainingExecutableOps, linkedExecutableOp,
+              linkedTargetOp, [](mlir::ModuleOp moduleOp) { return moduleOp; },
+              builder, targetAttr))) {
+        return failure();
+      }
+    }
+    return success();
   }
 
   LogicalResult serializeExecutable(const SerializationOptions &options,
@@ -230,6 +335,10 @@ class LLVMCPUTargetBackend final : public TargetBackend {
     auto libraryName =
         variantOp->getParentOfType<IREE::HAL::ExecutableOp>().getName().str();
 
+    // Additional CPU variants override the base target CPU.
+    LLVMTargetOptions variantOptions =
+        getVariantTargetOptions(variantOp.getTarget());
+
     // Validate flags for output mode.
     if (options_.linkEmbedded && options_.linkStatic) {
       return variantOp.emitError()
@@ -375,7 +484,7 @@ class LLVMCPUTargetBackend final : public TargetBackend {
     }
 
     // Specialize the module to our target machine.
-    auto targetMachine = createTargetMachine(options_);
+    auto targetMachine = createTargetMachine(variantOptions);
     if (!targetMachine) {
       return mlir::emitError(variantOp.getLoc())
              << "failed to create target machine for target triple '"
@@ -392,6 +501,17 @@ class LLVMCPUTargetBackend final : public TargetBackend {
     llvm::Linker::Flags linkerFlag = llvm::Linker::OverrideFromSrc;
     if (options_.linkStatic) linkerFlag = llvm::Linker::LinkOnlyNeeded;
 
+    // The microkernel library is linked first as it may depend on the others.
+    if (hasUKernelDeclarations(*llvmModule) &&
+        failed(linkBuiltinLibrary(
+            variantOp.getLoc(), moduleLinker, linkerFlag, targetMachine.get(),
+            "libukernel",
+            loadUKernelBitcode(targetMachine.get(),
+                               getCPUDataField0(*targetMachine), context)))) {
+      return mlir::emitError(variantOp.getLoc())
+             << "failed linking in builtin library for target triple '"
+             << options_.targetTriple << "'";
+    }
     if (failed(linkBuiltinLibrary(
             variantOp.getLoc(), moduleLinker, linkerFlag, targetMachine.get(),
             "libdevice", loadDeviceBitcode(targetMachine.get(), context)))) {
@@ -414,8 +534,8 @@ class LLVMCPUTargetBackend final : public TargetBackend {
 
     // LLVM opt passes that perform code generation optimizations/transformation
     // similar to what a frontend would do.
-    if (failed(
-            runLLVMIRPasses(options_, targetMachine.get(), llvmModule.get()))) {
+    if (failed(runLLVMIRPasses(variantOptions, targetMachine.get(),
+                               llvmModule.get()))) {
       return variantOp.emitError()
              << "failed to run LLVM-IR opt passes for IREE::HAL::ExecutableOp "
                 "targeting '"
@@ -645,15 +765,51 @@ class LLVMCPUTargetBackend final : public TargetBackend {
   }
 
  private:
+  // Target information derived from the target machine that is not contained
+  // in LLVMTargetOptions.
+  struct AdditionalConfigurationValues {
+    std::string dataLayoutStr;
+    int64_t vectorSize;
+  };
+
+  // An additional executable variant compiled for a specific CPU.
+  struct CPUVariant {
+    std::string cpu;
+    std::string cpuFeatures;
+    AdditionalConfigurationValues config;
+    // Runtime-queryable CPU features the variant requires beyond those of the
+    // base target.
+    SmallVector<std::string> requiredFeatures;
+  };
+
   ArrayAttr getExecutableTargets(MLIRContext *context) const {
     SmallVector<Attribute> targetAttrs;
-    // This is where we would multiversion.
+    // Additional CPU variants are listed in order of preference before the
+    // base target so that the first one supported by the device is selected.
+    for (const auto &variant : variants_) {
+      targetAttrs.push_back(getExecutableTarget(context, variant.cpu,
+                                                variant.cpuFeatures,
+                                                variant.config,
+                                                variant.requiredFeatures));
+    }
     targetAttrs.push_back(getExecutableTarget(context));
     return ArrayAttr::get(context, targetAttrs);
   }
 
   IREE::HAL::ExecutableTargetAttr getExecutableTarget(
       MLIRContext *context) const {
+    return getExecutableTarget(context, /*cpu=*/"", options_.targetCPUFeatures,
+                               config_, /*requiredFeatures=*/{});
+  }
+
+  // Returns an executable target for |cpu| with |cpuFeatures|. The base target
+  // has no |cpu| as it is specified by the target options. Additional variants
+  // carry their CPU in the configuration and are only matched on devices
+  // supporting all |requiredFeatures|.
+  IREE::HAL::ExecutableTargetAttr getExecutableTarget(
+      MLIRContext *context, StringRef cpu, StringRef cpuFeatures,
+      const AdditionalConfigurationValues &config,
+      ArrayRef<std::string> requiredFeatures) const {
     std::string format;
     if (options_.linkStatic) {
       // Static libraries are just string references when serialized so we don't
@@ -727,28 +883,180 @@ class LLVMCPUTargetBackend final : public TargetBackend {
     addConfig("target_triple", StringAttr::get(context, options_.targetTriple));
 
     // Set data layout
-    addConfig("data_layout", StringAttr::get(context, config_.dataLayoutStr));
+    addConfig("data_layout", StringAttr::get(context, config.dataLayoutStr));
 
     // Set the native vector size. This creates a dummy llvm module just to
     // build the TTI the right way.
     addConfig("native_vector_size",
-              IntegerAttr::get(IndexType::get(context), config_.vectorSize));
+              IntegerAttr::get(IndexType::get(context), config.vectorSize));
+
+    // Set the data cache sizes used to derive tile sizes, if known.
+    LLVMTargetCacheSizes cacheSizes = getLLVMTargetCacheSizes(
+        options_, cpu.empty() ? StringRef(options_.targetCPU) : cpu);
+    if (cacheSizes.l1) {
+      addConfig("l1_cache_size",
+                IntegerAttr::get(IndexType::get(context), cacheSizes.l1));
+    }
+    if (cacheSizes.l2) {
+      addConfig("l2_cache_size",
+                IntegerAttr::get(IndexType::get(context), cacheSizes.l2));
+    }
 
-    // Set target CPU features.
-    addConfig("cpu_features",
-              StringAttr::get(context, options_.targetCPUFeatures));
+    // Set the number of workers executables are dispatched across, if known.
+    if (options_.numWorkers) {
+      addConfig("num_workers", IntegerAttr::get(IndexType::get(context),
+                                                options_.numWorkers));
+    }
+
+    // Set target CPU and features.
+    if (!cpu.empty()) addConfig("cpu", StringAttr::get(context, cpu));
+    addConfig("cpu_features", StringAttr::get(context, cpuFeatures));
+
+    // Require the device to support the features the variant adds over the
+    // base target.
+    if (!requiredFeatures.empty()) {
+      SmallVector<Attribute> matchAttrs;
+      for (auto &feature : requiredFeatures) {
+        matchAttrs.push_back(
+            IREE::HAL::DeviceMatchCPUFeatureAttr::get(context, feature));
+      }
+      addConfig("match", IREE::HAL::MatchAllAttr::get(context, matchAttrs));
+    }
 
     return IREE::HAL::ExecutableTargetAttr::get(
         context, StringAttr::get(context, "llvm-cpu"),
         StringAttr::get(context, format), DictionaryAttr::get(context, config));
   }
 
+  // Returns the target options used to serialize a variant for |targetAttr|.
+  LLVMTargetOptions getVariantTargetOptions(
+      IREE::HAL::ExecutableTargetAttr targetAttr) const {
+    LLVMTargetOptions variantOptions = options_;
+    auto configAttr = targetAttr.getConfiguration();
+    auto cpuAttr = configAttr ? configAttr.getAs<StringAttr>("cpu") : nullptr;
+    if (!cpuAttr) return variantOptions;
+    variantOptions.targetCPU = cpuAttr.str();
+    if (auto featuresAttr = configAttr.getAs<StringAttr>("cpu_features")) {
+      variantOptions.targetCPUFeatures = featuresAttr.str();
+    }
+    return variantOptions;
+  }
+
   void initConfiguration() {
     auto targetMachine = createTargetMachine(options_);
+    config_ = getAdditionalConfiguration(*targetMachine);
+    initCPUVariants(*targetMachine);
+  }
+
+  // Populates variants_ from the additional target CPUs requested.
+  // Variants are only useful if the runtime can tell them apart from the base
+  // target so any that add no queryable features are dropped. Variants that
+  // are dropped are reported in configurationWarnings_ as there is no
+  // location to emit diagnostics at until the backend is assigned to a module.
+  //
+  // A variant is selected at runtime when the processor supports its required
+  // features and as such it may only be compiled with the base target features
+  // plus the runtime-queryable features the CPU supports. Any other feature the
+  // CPU implies (such as SVE on aarch64 or AVX-512 VBMI on x86-64) is
+  // explicitly disabled as it may be missing on processors that otherwise
+  // match.
+  void initCPUVariants(const llvm::TargetMachine &baseTargetMachine) {
+    if (options_.targetCPUVariants.empty()) return;
+    if (options_.linkStatic) {
+      configurationWarnings_.push_back(
+          "--iree-llvm-target-cpu-variants is ignored when producing static "
+          "libraries");
+      return;
+    }
+    llvm::Triple targetTriple(options_.targetTriple);
+    auto queryableFeatures = getRuntimeQueryableCPUFeatures(targetTriple);
+    auto baseFeatures = getEnabledCPUFeatures(baseTargetMachine);
+    for (auto &cpu : options_.targetCPUVariants) {
+      LLVMTargetOptions variantOptions = options_;
+      variantOptions.targetCPU = cpu;
+      variantOptions.targetCPUFeatures = "";
+      auto cpuTargetMachine = createTargetMachine(variantOptions);
+      if (!cpuTargetMachine ||
+          !cpuTargetMachine->getMCSubtargetInfo()->isCPUStringValid(cpu)) {
+        configurationWarnings_.push_back(
+            "ignoring unknown target CPU variant '" + cpu +
+            "' for target triple '" + options_.targetTriple + "'");
+        continue;
+      }
+
+      // Allow the base features plus the queryable features the CPU has (and
+      // anything those imply).
+      CPUVariant variant;
+      variant.cpu = cpu;
+      auto cpuFeatures = getEnabledCPUFeatures(*cpuTargetMachine);
+      llvm::SubtargetFeatures allowedSubtargetFeatures(
+          options_.targetCPUFeatures);
+      for (auto feature : queryableFeatures) {
+        if (cpuFeatures.contains(feature) && !baseFeatures.contains(feature)) {
+          allowedSubtargetFeatures.AddFeature(feature, /*Enable=*/true);
+          variant.requiredFeatures.push_back(feature.str());
+        }
+      }
+      if (variant.requiredFeatures.empty()) {
+        configurationWarnings_.push_back(
+            "ignoring target CPU variant '" + cpu +
+            "' as it adds no runtime-queryable features over the base target");
+        continue;
+      }
+      LLVMTargetOptions allowedOptions = options_;
+      allowedOptions.targetCPUFeatures = allowedSubtargetFeatures.getString();
+      auto allowedTargetMachine = createTargetMachine(allowedOptions);
+      if (!allowedTargetMachine) continue;
+      auto allowedFeatures = getEnabledCPUFeatures(*allowedTargetMachine);
+
+      // Make all features explicit so that the CPU cannot imply any others and
+      // so that codegen can query them from the target attribute.
+      SmallVector<StringRef> sortedFeatures;
+      for (auto &feature : allowedFeatures) {
+        sortedFeatures.push_back(feature.getKey());
+      }
+      for (auto &feature : cpuFeatures) {
+        if (!allowedFeatures.contains(feature.getKey())) {
+          sortedFeatures.push_back(feature.getKey());
+        }
+      }
+      llvm::sort(sortedFeatures);
+      llvm::SubtargetFeatures subtargetFeatures;
+      for (auto feature : sortedFeatures) {
+        bool enable = allowedFeatures.contains(feature);
+        subtargetFeatures.AddFeature(feature, /*Enable=*/enable);
+      }
+      variant.cpuFeatures = subtargetFeatures.getString();
+
+      // Verify that the CPU does not imply anything beyond the allowed
+      // features (or disable any of them).
+      variantOptions.targetCPUFeatures = variant.cpuFeatures;
+      auto targetMachine = createTargetMachine(variantOptions);
+      if (!targetMachine) continue;
+      auto features = getEnabledCPUFeatures(*targetMachine);
+      bool featuresMatch = features.size() == allowedFeatures.size();
+      for (auto &feature : allowedFeatures) {
+        featuresMatch = featuresMatch && features.contains(feature.getKey());
+      }
+      if (!featuresMatch) {
+        configurationWarnings_.push_back(
+            "ignoring target CPU variant '" + cpu +
+            "' as it cannot be restricted to runtime-queryable features");
+        continue;
+      }
+
+      variant.config = getAdditionalConfiguration(*targetMachine);
+      variants_.push_back(std::move(variant));
+    }
+  }
+
+  static AdditionalConfigurationValues getAdditionalConfiguration(
+      llvm::TargetMachine &targetMachine) {
+    AdditionalConfigurationValues config;
 
     // Data layout
-    llvm::DataLayout DL = targetMachine->createDataLayout();
-    config_.dataLayoutStr = DL.getStringRepresentation();
+    llvm::DataLayout DL = targetMachine.createDataLayout();
+    config.dataLayoutStr = DL.getStringRepresentation();
 
     // Set the native vector size. This creates a dummy llvm module just to
     // build the TTI the right way.
@@ -762,29 +1070,34 @@ class LLVMCPUTargetBackend final : public TargetBackend {
         llvm::FunctionType::get(voidType, false),
         llvm::GlobalValue::ExternalLinkage, "dummy_func", *llvmModule);
     llvm::TargetTransformInfo tti =
-        targetMachine->getTargetTransformInfo(*dummyFunc);
-    config_.vectorSize = tti.getRegisterBitWidth(
-                             llvm::TargetTransformInfo::RGK_FixedWidthVector) /
-                         8;
+        targetMachine.getTargetTransformInfo(*dummyFunc);
+    config.vectorSize = tti.getRegisterBitWidth(
+                            llvm::TargetTransformInfo::RGK_FixedWidthVector) /
+                        8;
     LLVM_DEBUG({
-      llvm::dbgs() << "CPU : " << targetMachine->getTargetCPU() << "\n";
+      llvm::dbgs() << "CPU : " << targetMachine.getTargetCPU() << "\n";
       llvm::dbgs() << "Target Triple : "
-                   << targetMachine->getTargetTriple().normalize() << "\n";
+                   << targetMachine.getTargetTriple().normalize() << "\n";
       llvm::dbgs() << "Target Feature string : "
-                   << targetMachine->getTargetFeatureString() << "\n";
-      llvm::dbgs() << "Data Layout : " << config_.dataLayoutStr << "\n";
-      llvm::dbgs() << "Vector Width : " << config_.vectorSize << "\n";
+                   << targetMachine.getTargetFeatureString() << "\n";
+      llvm::dbgs() << "Data Layout : " << config.dataLayoutStr << "\n";
+      llvm::dbgs() << "Vector Width : " << config.vectorSize << "\n";
     });
+    return config;
   }
 
   LLVMTargetOptions options_;
 
   // Additional target information besides that is contained in
   // LLVMTargetOptions options_.
-  struct AdditionalConfigurationValues {
-    std::string dataLayoutStr;
-    int64_t vectorSize;
-  } config_;
+  AdditionalConfigurationValues config_;
+
+  // Additional variants produced for each executable in order of preference.
+  SmallVector<CPUVariant> variants_;
+
+  // Warnings about the target options (such as ignored CPU variants) emitted
+  // by emitConfigurationDiagnostics.
+  SmallVector<std::string> configurationWarnings_;
 };
 
 void registerLLVMCPUTargetBackends(
@@ -6,6 +6,7 @@
 
 #include "iree/compiler/Dialect/HAL/Target/LLVM/LLVMTargetOptions.h"
 
+#include <algorithm>
 #include <mutex>
 
 #include "llvm/ADT/APFloat.h"
@@ -14,6 +15,7 @@
 #include "llvm/MC/TargetRegistry.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Host.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Target/TargetOptions.h"
 
 namespace mlir {
@@ -77,6 +79,14 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
       llvm::cl::desc("LLVM target machine CPU features; use 'host' for your "
                      "host native CPU"),
       llvm::cl::init(""));
+  static llvm::cl::list<std::string> clTargetCPUVariants(
+      "iree-llvm-target-cpu-variants",
+      llvm::cl::desc("Additional LLVM target machine CPUs to produce executable "
+                     "variants for in order of preference (such as "
+                     "'x86-64-v4,x86-64-v3'); the best variant supported by "
+                     "the device is selected at runtime and the "
+                     "--iree-llvm-target-cpu variant is used as the fallback"),
+      llvm::cl::CommaSeparated);
 
   static llvm::cl::opt<bool> llvmLoopInterleaving(
       "iree-llvm-loop-interleaving", llvm::cl::init(false),
@@ -99,6 +109,32 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
   if (clTargetCPUFeatures != "host") {
     targetOptions.targetCPUFeatures = clTargetCPUFeatures;
   }
+  targetOptions.targetCPUVariants.assign(clTargetCPUVariants.begin(),
+                                         clTargetCPUVariants.end());
+
+  static llvm::cl::opt<int64_t> clTargetL1CacheSize(
+      "iree-llvm-target-l1-cache-size",
+      llvm::cl::desc("Per-core L1 data cache size in bytes used to derive tile "
+                     "sizes; defaults to the known size of the target CPU"),
+      llvm::cl::init(0));
+  static llvm::cl::opt<int64_t> clTargetL2CacheSize(
+      "iree-llvm-target-l2-cache-size",
+      llvm::cl::desc("Per-core L2 cache size in bytes used to derive tile "
+                     "sizes; defaults to the known size of the target CPU"),
+      llvm::cl::init(0));
+  targetOptions.l1CacheSize = clTargetL1CacheSize;
+  targetOptions.l2CacheSize = clTargetL2CacheSize;
+
+  static llvm::cl::opt<int64_t> clTargetNumWorkers(
+      "iree-llvm-target-num-workers",
+      llvm::cl::desc("Number of workers executables are expected to be "
+                     "dispatched across; defaults to the number of physical "
+                     "cores of the host when targeting the host CPU"),
+      llvm::cl::init(0));
+  targetOptions.numWorkers = clTargetNumWorkers;
+  if (!targetOptions.numWorkers && clTargetCPU == "host") {
+    targetOptions.numWorkers = std::max(llvm::get_physical_cores(), 0);
+  }
 
   // LLVM opt options.
   targetOptions.pipelineTuningOptions.LoopInterleaving = llvmLoopInterleaving;
@@ -216,6 +252,47 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
   return targetOptions;
 }
 
+LLVMTargetCacheSizes getLLVMTargetCacheSizes(
+    const LLVMTargetOptions &targetOptions, llvm::StringRef cpu) {
+  // Per-core data cache sizes of CPUs commonly targeted. Cores with sizes
+  // configurable by the SoC vendor are omitted and need the sizes specified
+  // explicitly.
+  static const struct {
+    const char *cpu;
+    LLVMTargetCacheSizes sizes;
+  } kKnownCacheSizes[] = {
+      // x86-64.
+      {"haswell", {32 * 1024, 256 * 1024}},
+      {"broadwell", {32 * 1024, 256 * 1024}},
+      {"skylake", {32 * 1024, 256 * 1024}},
+      {"skylake-avx512", {32 * 1024, 1024 * 1024}},
+      {"cascadelake", {32 * 1024, 1024 * 1024}},
+      {"cooperlake", {32 * 1024, 1024 * 1024}},
+      {"icelake-client", {48 * 1024, 512 * 1024}},
+      {"icelake-server", {48 * 1024, 1280 * 1024}},
+      {"tigerlake", {48 * 1024, 1280 * 1024}},
+      {"sapphirerapids", {48 * 1024, 2048 * 1024}},
+      {"znver1", {32 * 1024, 512 * 1024}},
+      {"znver2", {32 * 1024, 512 * 1024}},
+      {"znver3", {32 * 1024, 512 * 1024}},
+      // AArch64.
+      {"neoverse-n1", {64 * 1024, 1024 * 1024}},
+      {"neoverse-v1", {64 * 1024, 1024 * 1024}},
+  };
+
+  LLVMTargetCacheSizes cacheSizes;
+  if (cpu == "host") cpu = llvm::sys::getHostCPUName();
+  for (const auto &known : kKnownCacheSizes) {
+    if (cpu == known.cpu) {
+      cacheSizes = known.sizes;
+      break;
+    }
+  }
+  if (targetOptions.l1CacheSize) cacheSizes.l1 = targetOptions.l1CacheSize;
+  if (targetOptions.l2CacheSize) cacheSizes.l2 = targetOptions.l2CacheSize;
+  return cacheSizes;
+}
+
 }  // namespace HAL
 }  // namespace IREE
 }  // namespace iree_compiler
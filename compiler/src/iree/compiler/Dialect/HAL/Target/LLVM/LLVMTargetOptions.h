@@ -7,6 +7,11 @@
 #ifndef IREE_COMPILER_DIALECT_HAL_TARGET_LLVM_LLVMTARGETOPTIONS_H_
 #define IREE_COMPILER_DIALECT_HAL_TARGET_LLVM_LLVMTARGETOPTIONS_H_
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Passes/PassBuilder.h"
 #include "llvm/Target/TargetOptions.h"
 
@@ -29,6 +34,22 @@ struct LLVMTargetOptions {
   std::string targetCPU;
   std::string targetCPUFeatures;
 
+  // Additional CPUs to produce executable variants for, in order of
+  // preference. Each variant is compiled for the full feature set of its CPU
+  // and selected at runtime only when the device reports support for the
+  // features it adds over the base targetCPU/targetCPUFeatures variant, which
+  // is always produced last as the fallback.
+  std::vector<std::string> targetCPUVariants;
+
+  // Per-core data cache sizes in bytes used to derive tile sizes. When 0 the
+  // sizes known for the target CPU are used, if any.
+  int64_t l1CacheSize = 0;
+  int64_t l2CacheSize = 0;
+
+  // Number of workers the executables are expected to be dispatched across.
+  // When 0 the number is unknown.
+  int64_t numWorkers = 0;
+
   llvm::PipelineTuningOptions pipelineTuningOptions;
   // Optimization level to be used by the LLVM optimizer (middle-end).
   llvm::OptimizationLevel optimizerOptLevel;
@@ -80,6 +101,17 @@ struct LLVMTargetOptions {
 // Returns LLVMTargetOptions struct intialized with the iree-llvm-* flags.
 LLVMTargetOptions getLLVMTargetOptionsFromFlags();
 
+// Per-core data cache sizes in bytes. Sizes are 0 when unknown.
+struct LLVMTargetCacheSizes {
+  int64_t l1 = 0;
+  int64_t l2 = 0;
+};
+
+// Returns the data cache sizes to tune code generated for |cpu|: the sizes
+// specified in |targetOptions| if any and the known sizes of |cpu| otherwise.
+LLVMTargetCacheSizes getLLVMTargetCacheSizes(
+    const LLVMTargetOptions &targetOptions, llvm::StringRef cpu);
+
 }  // namespace HAL
 }  // namespace IREE
 }  // namespace iree_compiler
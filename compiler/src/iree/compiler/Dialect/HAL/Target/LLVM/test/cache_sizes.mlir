@@ -0,0 +1,14 @@
+// RUN: iree-opt --pass-pipeline='iree-hal-assign-target-devices{targets=llvm-cpu}' --iree-llvm-target-triple=x86_64-unknown-linux-gnu --iree-llvm-target-cpu=skylake-avx512 %s | FileCheck %s --check-prefix=PRESET
+// RUN: iree-opt --pass-pipeline='iree-hal-assign-target-devices{targets=llvm-cpu}' --iree-llvm-target-triple=x86_64-unknown-linux-gnu --iree-llvm-target-cpu=skylake-avx512 --iree-llvm-target-l2-cache-size=2097152 %s | FileCheck %s --check-prefix=OVERRIDE
+// RUN: iree-opt --pass-pipeline='iree-hal-assign-target-devices{targets=llvm-cpu}' --iree-llvm-target-triple=x86_64-unknown-linux-gnu --iree-llvm-target-cpu=generic %s | FileCheck %s --check-prefix=UNKNOWN
+
+// Tests that the data cache sizes of the target CPU are carried by the
+// executable target when known and can be overridden with flags.
+
+// PRESET: #hal.executable.target<"llvm-cpu", "embedded-elf-x86_64", {{.*}}l1_cache_size = 32768 : index, l2_cache_size = 1048576 : index,
+
+// OVERRIDE: #hal.executable.target<"llvm-cpu", "embedded-elf-x86_64", {{.*}}l1_cache_size = 32768 : index, l2_cache_size = 2097152 : index,
+
+// UNKNOWN: #hal.executable.target<"llvm-cpu", "embedded-elf-x86_64"
+// UNKNOWN-NOT: cache_size
+module @module {}
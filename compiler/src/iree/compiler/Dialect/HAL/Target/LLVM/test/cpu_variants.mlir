@@ -0,0 +1,26 @@
+// RUN: iree-opt --pass-pipeline='iree-hal-assign-target-devices{targets=llvm-cpu}' --iree-llvm-target-triple=x86_64-unknown-linux-gnu --iree-llvm-target-cpu=x86-64 --iree-llvm-target-cpu-variants=x86-64-v4,x86-64-v3 %s | FileCheck %s
+// RUN: iree-opt --pass-pipeline='iree-hal-assign-target-devices{targets=llvm-cpu}' --iree-llvm-target-triple=x86_64-unknown-linux-gnu --iree-llvm-target-cpu=x86-64 --iree-llvm-target-cpu-variants=icelake-server %s | FileCheck %s --check-prefix=ICX
+// RUN: iree-opt --pass-pipeline='iree-hal-assign-target-devices{targets=llvm-cpu}' --iree-llvm-target-triple=aarch64-none-linux-android29 --iree-llvm-target-cpu=generic --iree-llvm-target-cpu-variants=neoverse-v1 %s | FileCheck %s --check-prefix=AARCH64
+
+// Tests that additional CPU variants are produced in order of preference ahead
+// of the base target and require the runtime-queryable features they add.
+
+// CHECK-DAG: #[[V4:[a-z0-9_]+]] = #hal.executable.target<"llvm-cpu", "embedded-elf-x86_64", {cpu = "x86-64-v4", cpu_features = "{{.*}}+avx512f{{.*}}", data_layout = "{{.*}}", match = #hal.match.all<[{{.*}}#hal.device.match.cpu.feature<"avx2">{{.*}}#hal.device.match.cpu.feature<"avx512f">{{.*}}]>, native_vector_size = 64 : index, target_triple = "x86_64-unknown-linux-gnu"}>
+// CHECK-DAG: #[[V3:[a-z0-9_]+]] = #hal.executable.target<"llvm-cpu", "embedded-elf-x86_64", {cpu = "x86-64-v3", cpu_features = "{{.*}}+avx2{{.*}}", data_layout = "{{.*}}", match = #hal.match.all<[{{.*}}#hal.device.match.cpu.feature<"avx2">{{.*}}]>, native_vector_size = 32 : index, target_triple = "x86_64-unknown-linux-gnu"}>
+// CHECK-DAG: #[[BASE:[a-z0-9_]+]] = #hal.executable.target<"llvm-cpu", "embedded-elf-x86_64", {cpu_features = "", data_layout = "{{.*}}", native_vector_size = 16 : index, target_triple = "x86_64-unknown-linux-gnu"}>
+// CHECK: #hal.device.target<"llvm-cpu", {executable_targets = [#[[V4]], #[[V3]], #[[BASE]]]
+
+// Tests that variants are only compiled with the base features plus the
+// runtime-queryable features they require: anything else the CPU implies is
+// disabled so that the variant cannot be selected on a processor lacking it.
+
+// ICX: #hal.executable.target<"llvm-cpu", "embedded-elf-x86_64", {cpu = "icelake-server",
+// ICX-SAME: cpu_features = "{{[^"]*}}-avx512vbmi,{{[^"]*}}+avx512vnni{{[^"]*}}"
+// ICX-SAME: match = #hal.match.all<[{{.*}}#hal.device.match.cpu.feature<"avx512f">{{.*}}#hal.device.match.cpu.feature<"avx512vnni">]>
+
+// AARCH64: #hal.executable.target<"llvm-cpu", "embedded-elf-arm_64", {cpu = "neoverse-v1",
+// AARCH64-SAME: cpu_features = "{{[^"]*}}+dotprod{{[^"]*}}+i8mm{{[^"]*}}-sve{{[^"]*}}"
+// AARCH64-SAME: match = #hal.match.all<[#hal.device.match.cpu.feature<"dotprod">, #hal.device.match.cpu.feature<"i8mm">]>
+
+// CHECK: module @module
+module @module {}
@@ -0,0 +1,8 @@
+// RUN: iree-opt --pass-pipeline='iree-hal-assign-target-devices{targets=llvm-cpu}' --iree-llvm-target-triple=x86_64-unknown-linux-gnu --iree-llvm-target-cpu=x86-64-v3 --iree-llvm-target-cpu-variants=not-a-cpu,x86-64-v2 --verify-diagnostics %s
+
+// Tests that CPU variants that cannot be used are dropped with a warning
+// reported on the module the target device is assigned to.
+
+// expected-warning @+2 {{ignoring unknown target CPU variant 'not-a-cpu' for target triple 'x86_64-unknown-linux-gnu'}}
+// expected-warning @+1 {{ignoring target CPU variant 'x86-64-v2' as it adds no runtime-queryable features over the base target}}
+module @module {}
@@ -225,7 +225,7 @@ LogicalResult TargetBackend::linkExecutablesInto(
     IREE::HAL::ExecutableOp linkedExecutableOp,
     IREE::HAL::ExecutableVariantOp linkedTargetOp,
     std::function<Operation *(mlir::ModuleOp moduleOp)> getInnerModuleFn,
-    OpBuilder &builder) {
+    OpBuilder &builder, IREE::HAL::ExecutableTargetAttr sourceTargetAttr) {
   int nextEntryPointOrdinal = 0;
   DenseMap<StringRef, Operation *> targetSymbolMap;
   SymbolReplacements symbolReplacements;
@@ -245,6 +245,9 @@ LogicalResult TargetBackend::linkExecutablesInto(
     for (auto variantOp : variantOps) {
       // Only process targets matching our pattern.
       if (variantOp.getTarget().getBackend().getValue() != name()) continue;
+      if (sourceTargetAttr && variantOp.getTarget() != sourceTargetAttr) {
+        continue;
+      }
 
       // Remap variant refs.
       auto oldVariantRefAttr =
@@ -298,7 +301,9 @@ LogicalResult TargetBackend::linkExecutablesInto(
   // Remove if we didn't add anything.
   if (linkedTargetOp.getOps<IREE::HAL::ExecutableExportOp>().empty()) {
     linkedTargetOp.erase();
-    linkedExecutableOp.erase();
+    if (linkedExecutableOp.getOps<IREE::HAL::ExecutableVariantOp>().empty()) {
+      linkedExecutableOp.erase();
+    }
   }
 
   return success();
@@ -135,6 +135,11 @@ class TargetBackend {
   virtual IREE::HAL::DeviceTargetAttr getDefaultDeviceTarget(
       MLIRContext *context) const = 0;
 
+  // Emits diagnostics at |loc| for issues with the backend configuration that
+  // do not prevent it from being used (such as options that were ignored).
+  // Called when the backend is assigned as a target device of a module.
+  virtual void emitConfigurationDiagnostics(Location loc) const {}
+
   // Inserts passes used to translate the `hal.executable.variant` op contents.
   // The pass manager will be nested on `hal.executable` such that the pipeline
   // will only run on executable contents.
@@ -240,13 +245,17 @@ class TargetBackend {
  protected:
   // Links all executables for the current target found in |moduleOp| into
   // |linkedExecutableOp|. Functions will be cloned into |linkedModuleOp|.
+  // If |sourceTargetAttr| is provided only variants with that exact target are
+  // linked such that backends producing multiple variants can link each into
+  // its own |linkedTargetOp|.
   LogicalResult linkExecutablesInto(
       mlir::ModuleOp moduleOp,
       ArrayRef<IREE::HAL::ExecutableOp> sourceExecutableOps,
       IREE::HAL::ExecutableOp linkedExecutableOp,
       IREE::HAL::ExecutableVariantOp linkedTargetOp,
       std::function<Operation *(mlir::ModuleOp moduleOp)> getInnerModuleFn,
-      OpBuilder &builder);
+      OpBuilder &builder,
+      IREE::HAL::ExecutableTargetAttr sourceTargetAttr = {});
 };
 
 // Dumps binary data to a file formed by joining the given path components:
@@ -90,6 +90,8 @@ class AssignTargetDevicesPass
         return;
       }
 
+      targetBackend->emitConfigurationDiagnostics(moduleOp.getLoc());
+
       // Ask the target backend for its default device specification attribute.
       auto targetAttr =
           targetBackend->getDefaultDeviceTarget(moduleOp.getContext());
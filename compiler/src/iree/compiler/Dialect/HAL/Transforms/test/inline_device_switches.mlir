@@ -82,3 +82,32 @@ func.func @no_results(%device : !hal.device) {
   // CHECK-NEXT:  return
   return
 }
+
+// -----
+
+// CHECK-LABEL: @cpu_features
+// CHECK-SAME: %[[DEVICE:.+]]: !hal.device
+func.func @cpu_features(%device : !hal.device) {
+  hal.device.switch<%device : !hal.device>
+    // CHECK-NEXT:  %{{.+}}, %[[IS_ELF:.+]] = hal.device.query<%[[DEVICE]] : !hal.device> key("hal.executable.format" :: "embedded-elf-x86_64") : i1, i1 = false
+    // CHECK-NEXT:  %{{.+}}, %[[IS_AVX2:.+]] = hal.device.query<%[[DEVICE]] : !hal.device> key("hal.cpu" :: "avx2") : i1, i1 = false
+    // CHECK-NEXT:  %[[IS0:.+]] = arith.andi %[[IS_ELF]], %[[IS_AVX2]] : i1
+    // CHECK-NEXT:  cf.cond_br %[[IS0]], ^bb1, ^bb2
+    // CHECK-NEXT: ^bb1:
+    // CHECK-NEXT:  "some.op_a"()
+    // CHECK-NEXT:  cf.br ^bb3
+    #hal.match.all<[#hal.device.match.executable.format<"embedded-elf-x86_64">, #hal.device.match.cpu.feature<"avx2">]> {
+      "some.op_a"() : () -> ()
+      hal.return
+    },
+    // CHECK-NEXT: ^bb2:
+    // CHECK-NEXT:  "some.op_b"()
+    // CHECK-NEXT:  cf.br ^bb3
+    #hal.match.always {
+      "some.op_b"() : () -> ()
+      hal.return
+    }
+  // CHECK-NEXT: ^bb3:
+  // CHECK-NEXT:  return
+  return
+}
@@ -170,3 +170,43 @@ func.func @exeLookup(%device : !hal.device) -> !hal.executable {
 }
 
 }
+
+// -----
+
+// Tests that variants of the same format are selected based on the additional
+// requirements specified in their target configuration.
+
+#pipeline_layout = #hal.pipeline.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>
+  ]>
+]>
+
+module attributes {hal.device.targets = [#hal.device.target<"llvm-cpu">]} {
+
+hal.executable @exe {
+  hal.executable.variant @avx2, target = <"llvm-cpu", "embedded-elf-x86_64", {
+    match = #hal.device.match.cpu.feature<"avx2">
+  }> {
+    hal.executable.export @entry ordinal(0) layout(#pipeline_layout)
+  }
+  hal.executable.variant @baseline, target = <"llvm-cpu", "embedded-elf-x86_64"> {
+    hal.executable.export @entry ordinal(0) layout(#pipeline_layout)
+  }
+}
+
+// CHECK: util.global private @_executable_exe : !hal.executable
+// CHECK-NEXT: util.initializer {
+// CHECK:   %[[DEV:.+]] = hal.ex.shared_device : !hal.device
+// CHECK:   %[[RET:.+]] = hal.device.switch<%[[DEV]] : !hal.device> -> !hal.executable
+// CHECK:   #hal.match.all<[#hal.device.match.executable.format<"embedded-elf-x86_64">, #hal.device.match.cpu.feature<"avx2">]> {
+// CHECK:     hal.executable.create
+// CHECK-SAME:  target(@exe::@avx2)
+// CHECK:   },
+// CHECK:   #hal.device.match.executable.format<"embedded-elf-x86_64"> {
+// CHECK:     hal.executable.create
+// CHECK-SAME:  target(@exe::@baseline)
+// CHECK:   },
+// CHECK:   #hal.match.always {
+
+}
@@ -4,7 +4,7 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
-#include <list>
+#include <numeric>
 
 #include "iree/compiler/Dialect/Stream/IR/StreamDialect.h"
 #include "iree/compiler/Dialect/Stream/IR/StreamOps.h"
@@ -15,6 +15,7 @@
 #include "iree/compiler/Dialect/Util/IR/UtilOps.h"
 #include "iree/compiler/Dialect/Util/IR/UtilTypes.h"
 #include "iree/compiler/Utils/IndexSet.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/Debug.h"
 #include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
@@ -63,31 +64,27 @@ static Value packSlicesWithNoAliasing(
   return builder.createOrFold<IREE::Util::AlignOp>(loc, offset, rangeAlignment);
 }
 
-// Packs a set of statically-sized slices by greedy strip packing.
+// A statically-sized slice with its size aligned to the range alignment.
+struct StaticSlice {
+  const Slice *slice = nullptr;
+  int64_t alignedSize = 0;
+};
+
+// Places statically-sized slices in the given |order| by greedy strip packing.
 //
 // This is the same algorithm used in tflite here:
 // https://github.com/tensorflow/tensorflow/blob/master/tensorflow/lite/simple_memory_arena.cc
-// It's not fantastic and can end up with a significant amount of wastage.
-// They do the packing at runtime and as such care more about performance than
-// we do while doing the packing here offline. For this initial version I
-// wanted to ensure we matched apples/apples their implementation.
+// It's not fantastic on its own and can end up with a significant amount of
+// wastage depending on the order in which slices are placed. They do the
+// packing at runtime and as such care more about performance than we do while
+// doing the packing here offline; we run this with several orderings and keep
+// the best.
 //
-// We should use a set of heuristics and pick the smallest one. There are also
-// some really great papers that have approximations (as all of these are -
-// 2D strip packing is NP-hard) such as
-// https://www.sciencedirect.com/science/article/pii/S0925772113001016 that
-// someone with a brain able to parse mathy papers can try implementing.
-//
-// Slice packed offset SSA values will be updated and start at the given
-// |baseOffset|. Returns |baseOffset| + the total size of the allocation
-// aligned to the requirements of |resourceConfig|.
-static Value packStaticSlicesGreedily(
-    IREE::Stream::ResourcePackOp packOp, Value baseOffset,
-    ArrayRef<Slice> slices, IREE::Stream::ResourceConfigAttr resourceConfig,
-    IndexSet &indexSet, OpBuilder &builder) {
-  int64_t offsetAlignment = resourceConfig.getMinBufferOffsetAlignment();
-  int64_t rangeAlignment = resourceConfig.getMinBufferRangeAlignment();
-
+// Populates |offsets| (parallel to |slices|) and returns the highwater mark.
+static int64_t placeStaticSlicesGreedily(ArrayRef<StaticSlice> slices,
+                                         ArrayRef<unsigned> order,
+                                         int64_t offsetAlignment,
+                                         SmallVectorImpl<int64_t> &offsets) {
   struct Reservation {
     const Slice *slice = nullptr;
     int64_t staticOffset = 0;
@@ -95,14 +92,16 @@ static Value packStaticSlicesGreedily(
   };
   static constexpr int64_t UNASSIGNED = INT64_MAX;
 
-  std::list<Reservation> reservations;
+  offsets.resize(slices.size());
+  SmallVector<Reservation> reservations;
+  reservations.reserve(slices.size());
   int64_t highwaterMark = 0;
-  for (auto &slice : slices) {
+  for (unsigned sliceIndex : order) {
+    auto &staticSlice = slices[sliceIndex];
+    auto &slice = *staticSlice.slice;
+    int64_t alignedSize = staticSlice.alignedSize;
     int64_t bestOffset = UNASSIGNED;
     int64_t bestOffsetFit = UNASSIGNED;
-    int64_t staticSize =
-        cast<arith::ConstantIndexOp>(slice.dynamicSize.getDefiningOp()).value();
-    int64_t alignedSize = IREE::Util::align(staticSize, rangeAlignment);
 
     // Iterate through reservations (sorted by ascending offset) and identify
     // gaps in which the slice will fit. To reduce wastage we want to find the
@@ -135,21 +134,156 @@ static Value packStaticSlicesGreedily(
     reservation.slice = &slice;
     reservation.staticOffset = bestOffset;
     reservation.staticSize = alignedSize;
-    auto insertionIt = reservations.begin();
-    while (insertionIt != reservations.end() &&
-           insertionIt->staticOffset < reservation.staticOffset) {
-      ++insertionIt;
-    }
+    auto insertionIt = llvm::partition_point(
+        reservations, [&](const Reservation &existing) {
+          return existing.staticOffset < reservation.staticOffset;
+        });
     reservations.insert(insertionIt, reservation);
-    slice.packedOffset.replaceAllUsesWith(builder.createOrFold<arith::AddIOp>(
-        packOp.getLoc(), baseOffset, indexSet.get(bestOffset)));
+    offsets[sliceIndex] = bestOffset;
 
     // Update highwater mark indicating how much memory needs to be allocated
     // for the entire slab.
     highwaterMark = std::max(highwaterMark, bestOffset + alignedSize);
   }
+  return highwaterMark;
+}
+
+// Returns the maximum number of bytes live at any point in time. No packing
+// can use less than this and it's used to measure wastage and stop searching
+// early when a packing is optimal.
+static int64_t computeStaticSliceLowerBound(ArrayRef<StaticSlice> slices) {
+  // Lifetimes are inclusive and we release slices one past their end.
+  // Releases sort before reservations at the same point in time.
+  SmallVector<std::pair<int64_t, int64_t>> events;
+  events.reserve(slices.size() * 2);
+  for (auto &staticSlice : slices) {
+    events.push_back(
+        {staticSlice.slice->lifetimeStart, staticSlice.alignedSize});
+    events.push_back(
+        {staticSlice.slice->lifetimeEnd + 1, -staticSlice.alignedSize});
+  }
+  llvm::sort(events);
+  int64_t liveSize = 0;
+  int64_t maxLiveSize = 0;
+  for (auto &event : events) {
+    liveSize += event.second;
+    maxLiveSize = std::max(maxLiveSize, liveSize);
+  }
+  return maxLiveSize;
+}
+
+// Packs a set of statically-sized slices by greedy strip packing using several
+// slice orderings and keeps the one producing the smallest allocation.
+//
+// Orderings tried:
+//   - lifetime interval (program order, as produced by the pack op)
+//   - size descending (large slices first leave smaller gaps to fill)
+//   - lifetime length descending (long-lived slices at the bottom of the slab)
+//   - size * lifetime length descending (largest area in the 2D strip first)
+// If |searchIterations| is non-zero then the best ordering found is further
+// refined by a bounded local search that swaps adjacent slices and keeps any
+// improvement.
+//
+// There are also some really great papers that have approximations (as all of
+// these are - 2D strip packing is NP-hard) such as
+// https://www.sciencedirect.com/science/article/pii/S0925772113001016 that
+// someone with a brain able to parse mathy papers can try implementing.
+//
+// Slice packed offset SSA values will be updated and start at the given
+// |baseOffset|. Returns |baseOffset| + the total size of the allocation
+// aligned to the requirements of |resourceConfig|. |outPackedSize| and
+// |outLowerBound| are populated with the static size of the packing and the
+// smallest size any packing could possibly have.
+static Value packStaticSlicesWithHeuristics(
+    IREE::Stream::ResourcePackOp packOp, Value baseOffset,
+    ArrayRef<Slice> slices, IREE::Stream::ResourceConfigAttr resourceConfig,
+    int64_t searchIterations, IndexSet &indexSet, OpBuilder &builder,
+    int64_t &outPackedSize, int64_t &outLowerBound) {
+  int64_t offsetAlignment = resourceConfig.getMinBufferOffsetAlignment();
+  int64_t rangeAlignment = resourceConfig.getMinBufferRangeAlignment();
+
+  SmallVector<StaticSlice> staticSlices;
+  staticSlices.reserve(slices.size());
+  for (auto &slice : slices) {
+    int64_t staticSize =
+        cast<arith::ConstantIndexOp>(slice.dynamicSize.getDefiningOp()).value();
+    staticSlices.push_back(
+        {&slice, IREE::Util::align(staticSize, rangeAlignment)});
+  }
+  int64_t lowerBound = computeStaticSliceLowerBound(staticSlices);
+
+  auto lifetimeLength = [&](unsigned i) {
+    return staticSlices[i].slice->lifetimeEnd -
+           staticSlices[i].slice->lifetimeStart + 1;
+  };
+  SmallVector<unsigned> intervalOrder(staticSlices.size());
+  std::iota(intervalOrder.begin(), intervalOrder.end(), 0);
+  SmallVector<unsigned> sizeOrder = intervalOrder;
+  llvm::stable_sort(sizeOrder, [&](unsigned lhs, unsigned rhs) {
+    return staticSlices[lhs].alignedSize > staticSlices[rhs].alignedSize;
+  });
+  SmallVector<unsigned> lengthOrder = intervalOrder;
+  llvm::stable_sort(lengthOrder, [&](unsigned lhs, unsigned rhs) {
+    return std::make_pair(lifetimeLength(lhs), staticSlices[lhs].alignedSize) >
+           std::make_pair(lifetimeLength(rhs), staticSlices[rhs].alignedSize);
+  });
+  SmallVector<unsigned> areaOrder = intervalOrder;
+  llvm::stable_sort(areaOrder, [&](unsigned lhs, unsigned rhs) {
+    return lifetimeLength(lhs) * staticSlices[lhs].alignedSize >
+           lifetimeLength(rhs) * staticSlices[rhs].alignedSize;
+  });
+
+  // Try each ordering and keep the first smallest. The interval ordering goes
+  // first so that we only deviate from program order when it's beneficial.
+  SmallVector<unsigned> bestOrder;
+  SmallVector<int64_t> bestOffsets;
+  int64_t bestHighwaterMark = INT64_MAX;
+  SmallVector<int64_t> offsets;
+  auto tryOrder = [&](ArrayRef<unsigned> order) {
+    int64_t highwaterMark = placeStaticSlicesGreedily(
+        staticSlices, order, offsetAlignment, offsets);
+    if (highwaterMark >= bestHighwaterMark) return;
+    bestHighwaterMark = highwaterMark;
+    bestOrder.assign(order.begin(), order.end());
+    std::swap(bestOffsets, offsets);
+  };
+  for (auto order : {ArrayRef<unsigned>(intervalOrder),
+                     ArrayRef<unsigned>(sizeOrder),
+                     ArrayRef<unsigned>(lengthOrder),
+                     ArrayRef<unsigned>(areaOrder)}) {
+    tryOrder(order);
+    if (bestHighwaterMark <= lowerBound) break;
+  }
 
-  highwaterMark = IREE::Util::align(highwaterMark, rangeAlignment);
+  // Refine the best ordering by swapping adjacent slices. This is a cheap
+  // local search and the number of iterations bounds the compile-time cost.
+  if (staticSlices.size() > 1) {
+    SmallVector<unsigned> candidateOrder;
+    for (int64_t i = 0;
+         i < searchIterations && bestHighwaterMark > lowerBound; ++i) {
+      unsigned swapIndex = i % (staticSlices.size() - 1);
+      candidateOrder = bestOrder;
+      std::swap(candidateOrder[swapIndex], candidateOrder[swapIndex + 1]);
+      tryOrder(candidateOrder);
+    }
+  }
+
+  LLVM_DEBUG({
+    llvm::dbgs() << "[LayoutSlices] packed " << staticSlices.size()
+                 << " static slices into " << bestHighwaterMark
+                 << " bytes (lower bound " << lowerBound << " bytes)\n";
+  });
+
+  for (auto it : llvm::enumerate(staticSlices)) {
+    Value staticOffset = indexSet.get(bestOffsets[it.index()]);
+    it.value().slice->packedOffset.replaceAllUsesWith(
+        builder.createOrFold<arith::AddIOp>(packOp.getLoc(), baseOffset,
+                                            staticOffset));
+  }
+
+  int64_t highwaterMark = IREE::Util::align(bestHighwaterMark, rangeAlignment);
+  outPackedSize = highwaterMark;
+  outLowerBound = lowerBound;
   return builder.createOrFold<arith::AddIOp>(packOp.getLoc(), baseOffset,
                                              indexSet.get(highwaterMark));
 }
@@ -260,9 +394,6 @@ class LayoutSlicesPass : public LayoutSlicesBase<LayoutSlicesPass> {
       return;
     }
 
-    // NOTE: we could try several algorithms and compute which packs best. For
-    // now we just pack greedily as it's fast and what most existing ML
-    // frameworks do.
     parentOp.walk([&](IREE::Stream::ResourcePackOp packOp) {
       // Derive resource constraints based on pack affinity.
       auto resourceConfig = IREE::Stream::ResourceConfigAttr::lookup(packOp);
@@ -290,8 +421,14 @@ class LayoutSlicesPass : public LayoutSlicesBase<LayoutSlicesPass> {
       // compile time.
       auto offset = packOp.getOffset() ? packOp.getOffset() : indexSet.get(0);
       if (!staticSlices.empty()) {
-        offset = packStaticSlicesGreedily(packOp, offset, staticSlices,
-                                          resourceConfig, indexSet, builder);
+        int64_t packedSize = 0;
+        int64_t lowerBound = 0;
+        offset = packStaticSlicesWithHeuristics(
+            packOp, offset, staticSlices, resourceConfig, searchIterations,
+            indexSet, builder, packedSize, lowerBound);
+        staticPackedBytes += packedSize;
+        staticLowerBoundBytes += lowerBound;
+        staticWastedBytes += packedSize - lowerBound;
 
         // TODO(benvanik): make this an option; it can be useful for debugging
         // this code.
@@ -314,6 +451,17 @@ class LayoutSlicesPass : public LayoutSlicesBase<LayoutSlicesPass> {
       packOp.erase();
     });
   }
+
+ private:
+  Statistic staticPackedBytes{
+      this, "static packed bytes",
+      "Total bytes of statically-sized slices after packing"};
+  Statistic staticLowerBoundBytes{
+      this, "static lower bound bytes",
+      "Total bytes of statically-sized slices live at the same time"};
+  Statistic staticWastedBytes{
+      this, "static wasted bytes",
+      "Total bytes of packed static slices in excess of the lower bound"};
 };
 
 }  // namespace
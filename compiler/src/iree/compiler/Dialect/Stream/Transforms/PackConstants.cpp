@@ -4,6 +4,8 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <limits>
+
 #include "iree/compiler/Dialect/Stream/IR/StreamDialect.h"
 #include "iree/compiler/Dialect/Stream/IR/StreamOps.h"
 #include "iree/compiler/Dialect/Stream/IR/StreamTypes.h"
@@ -63,6 +65,8 @@ struct ConstantSlice {
 struct PackedSpan {
   // Original slice this span represents.
   ConstantSlice slice;
+  // Additional slices with identical constant values that share this span.
+  SmallVector<ConstantSlice> aliasedSlices;
   // Byte offset within the storage buffer.
   uint64_t offset = 0;
   // Length of the valid data when padded out.
@@ -85,35 +89,110 @@ struct StorageResource {
 };
 
 // Buckets |slices| into 1+ storage resources based on |resourceConfig|.
+// Slices are placed in order into the storage resource with the least
+// remaining space that can still hold them (best-fit) such that large models
+// spanning multiple storage resources have as few resources and as little
+// padding as possible. When |dedupeValues| is set slices with identical
+// constant values alias the same span and are only stored once. This is only
+// valid for immutable resources as otherwise writes through one would be
+// visible through the others.
 static SmallVector<StorageResource, 8> bucketValuesIntoStorageResources(
     ArrayRef<ConstantSlice> slices,
-    IREE::Stream::ResourceConfigAttr resourceConfig) {
-  // TODO(benvanik): replace with a better strategy (best-fit, etc).
+    IREE::Stream::ResourceConfigAttr resourceConfig, bool dedupeValues) {
+  uint64_t maxAllocationSize = resourceConfig.getMaxAllocationSize();
+  uint64_t offsetAlignment = resourceConfig.getMinBufferOffsetAlignment();
+  uint64_t rangeAlignment = resourceConfig.getMinBufferRangeAlignment();
   SmallVector<StorageResource, 8> storageBuffers;
-  storageBuffers.push_back({UnknownLoc::get(resourceConfig.getContext())});
-  StorageResource *currentBuffer = &storageBuffers.back();
+  DenseMap<Attribute, std::pair<unsigned, unsigned>> spansByValue;
   for (auto slice : slices) {
-    uint64_t offset = IREE::Util::align(
-        currentBuffer->totalSize, resourceConfig.getMinBufferOffsetAlignment());
+    // Attributes are uniqued and if we've already stored the same value we
+    // can just point at that.
+    auto existingIt =
+        dedupeValues ? spansByValue.find(slice.value) : spansByValue.end();
+    if (existingIt != spansByValue.end()) {
+      auto &storageBuffer = storageBuffers[existingIt->second.first];
+      storageBuffer.spans[existingIt->second.second].aliasedSlices.push_back(
+          slice);
+      continue;
+    }
+
     uint64_t unpaddedLength = slice.getStorageSize();
-    uint64_t paddedLength = IREE::Util::align(
-        unpaddedLength, resourceConfig.getMinBufferRangeAlignment());
-    if (offset + unpaddedLength > resourceConfig.getMaxAllocationSize()) {
-      // Spilling buffer; make a new one.
+    uint64_t paddedLength = IREE::Util::align(unpaddedLength, rangeAlignment);
+
+    // Find the storage buffer with the smallest remaining space that can hold
+    // the slice.
+    StorageResource *targetBuffer = nullptr;
+    uint64_t targetOffset = 0;
+    uint64_t targetRemaining = UINT64_MAX;
+    for (auto &storageBuffer : storageBuffers) {
+      uint64_t offset =
+          IREE::Util::align(storageBuffer.totalSize, offsetAlignment);
+      if (offset + unpaddedLength > maxAllocationSize) continue;
+      uint64_t remaining = maxAllocationSize - offset;
+      if (remaining < targetRemaining) {
+        targetBuffer = &storageBuffer;
+        targetOffset = offset;
+        targetRemaining = remaining;
+      }
+    }
+    if (!targetBuffer) {
+      // No space (or no buffers yet); make a new one.
       storageBuffers.push_back({UnknownLoc::get(resourceConfig.getContext())});
-      currentBuffer = &storageBuffers.back();
-      offset = 0;
+      targetBuffer = &storageBuffers.back();
+      targetOffset = 0;
     }
-    currentBuffer->spans.push_back({slice, offset, unpaddedLength});
-    currentBuffer->totalSize =
-        std::max(currentBuffer->totalSize, offset + paddedLength);
-  }
-  if (storageBuffers.back().spans.empty()) {
-    storageBuffers.pop_back();
+
+    if (dedupeValues) {
+      spansByValue[slice.value] = {
+          static_cast<unsigned>(targetBuffer - storageBuffers.begin()),
+          static_cast<unsigned>(targetBuffer->spans.size()),
+      };
+    }
+    targetBuffer->spans.push_back({slice, {}, targetOffset, unpaddedLength});
+    targetBuffer->totalSize =
+        std::max(targetBuffer->totalSize, targetOffset + paddedLength);
   }
   return storageBuffers;
 }
 
+// Returns the pre-order position of every op nested within |parentOp|.
+static DenseMap<Operation *, unsigned> computeOpOrdinals(Operation *parentOp) {
+  DenseMap<Operation *, unsigned> opOrdinals;
+  unsigned nextOrdinal = 0;
+  parentOp->walk<WalkOrder::PreOrder>(
+      [&](Operation *op) { opOrdinals[op] = nextOrdinal++; });
+  return opOrdinals;
+}
+
+// Returns |slices| stably sorted by the first use of each slice as ordered by
+// |opOrdinals|. Constants used together end up adjacent in storage so that
+// mapping or prefetching the pages of one brings in those used next.
+// Unused slices retain their relative order at the end.
+static SmallVector<ConstantSlice> sortSlicesByFirstUse(
+    ArrayRef<ConstantSlice> slices,
+    const DenseMap<Operation *, unsigned> &opOrdinals) {
+  SmallVector<std::pair<unsigned, unsigned>> sliceOrdinals;
+  sliceOrdinals.reserve(slices.size());
+  for (auto it : llvm::enumerate(slices)) {
+    unsigned firstUse = std::numeric_limits<unsigned>::max();
+    for (auto *user : it.value().result.getUsers()) {
+      auto ordinalIt = opOrdinals.find(user);
+      if (ordinalIt == opOrdinals.end()) continue;
+      firstUse = std::min(firstUse, ordinalIt->second);
+    }
+    sliceOrdinals.push_back({firstUse, static_cast<unsigned>(it.index())});
+  }
+  llvm::stable_sort(sliceOrdinals, [](auto lhs, auto rhs) {
+    return lhs.first < rhs.first;
+  });
+  SmallVector<ConstantSlice> sortedSlices;
+  sortedSlices.reserve(slices.size());
+  for (auto sliceOrdinal : sliceOrdinals) {
+    sortedSlices.push_back(slices[sliceOrdinal.second]);
+  }
+  return sortedSlices;
+}
+
 // Packs all span data into a single data attribute we can tag on the buffer.
 // The data produced will contain all spans at the specified offsets with no
 // additional padding.
@@ -187,7 +266,9 @@ static void packStorageResourceData(StorageResource &storageBuffer,
 // locality/lifetime/etc).
 static SmallVector<StorageResource, 8> computePackingMap(
     ArrayRef<ConstantSlice> slices,
-    IREE::Stream::ResourceConfigAttr resourceConfig, MLIRContext *context) {
+    IREE::Stream::ResourceConfigAttr resourceConfig,
+    IREE::Stream::Lifetime lifetime,
+    const DenseMap<Operation *, unsigned> &opOrdinals, MLIRContext *context) {
   // This is literally all my brain has brain for right now. The ideal here is
   // that we have a basic static (and ideally profile-guided) sorting pass
   // that keeps constant values that are accessed sorted together.
@@ -215,13 +296,20 @@ static SmallVector<StorageResource, 8> computePackingMap(
   // things around and waste on silly things like loading times).
   //
   // Here it's all descriptor sets and mapped pages but same thing pretty
-  // much, and passes earlier on may duplicate constants in the pool if it
-  // means they can improve locality at runtime. This pass doesn't dedupe and
-  // just sticks to packing for that reason.
+  // much. Within a single pool there's no locality benefit to storing the
+  // same value twice so we dedupe identical values; passes earlier on may
+  // still duplicate constants across pools if it means they can improve
+  // locality at runtime. Variables are uploaded into a single mutable
+  // allocation and must each get their own storage so they don't alias.
 
-  // Build a list of resources and spans (append to current or spill to new).
-  auto storageBuffers =
-      bucketValuesIntoStorageResources(slices, resourceConfig);
+  // Group constants by when they are first used so that those used together
+  // are stored together.
+  auto sortedSlices = sortSlicesByFirstUse(slices, opOrdinals);
+
+  // Build a list of resources and spans (best-fit or spill to new).
+  auto storageBuffers = bucketValuesIntoStorageResources(
+      sortedSlices, resourceConfig,
+      /*dedupeValues=*/lifetime == IREE::Stream::Lifetime::Constant);
 
   // Pack each storage resource bucket into a single data blob.
   for (auto &storageBuffer : storageBuffers) {
@@ -460,6 +548,11 @@ class PackConstantsPass : public PackConstantsBase<PackConstantsPass> {
       return;
     }
 
+    // Op ordering is used to sort constants by first use. The ops that use
+    // constants are not changed by packing so this only needs to be computed
+    // once.
+    auto opOrdinals = computeOpOrdinals(parentOp);
+
     parentOp.walk([&](IREE::Stream::ResourceConstantsOp constantsOp) {
       // Derive resource constraints based on pack affinity.
       auto resourceConfig =
@@ -483,8 +576,14 @@ class PackConstantsPass : public PackConstantsBase<PackConstantsPass> {
 
       // Perform the packing of dense values to compute the storage resources we
       // will need and where each value will be placed.
+      auto lifetime = constantsOp.getResults()
+                          .front()
+                          .getType()
+                          .cast<IREE::Stream::ResourceType>()
+                          .getLifetime();
       auto storageResources =
-          computePackingMap(slices, resourceConfig, constantsOp.getContext());
+          computePackingMap(slices, resourceConfig, lifetime, opOrdinals,
+                            constantsOp.getContext());
       if (storageResources.empty()) return;
 
       OpBuilder builder(constantsOp);
@@ -525,11 +624,17 @@ class PackConstantsPass : public PackConstantsBase<PackConstantsPass> {
         auto &storageResource = std::get<0>(it);
         auto &allocatedStorage = std::get<1>(it);
         for (auto &span : storageResource.spans) {
-          auto loc = span.slice.result.getLoc();
-          auto subviewOp = builder.create<IREE::Stream::ResourceSubviewOp>(
-              loc, allocatedStorage.resource, allocatedStorage.resourceSize,
-              indexSet.get(span.offset), span.slice.resultSize);
-          span.slice.result.replaceAllUsesWith(subviewOp.getResult());
+          auto buildSubview = [&](ConstantSlice &slice) {
+            auto loc = slice.result.getLoc();
+            auto subviewOp = builder.create<IREE::Stream::ResourceSubviewOp>(
+                loc, allocatedStorage.resource, allocatedStorage.resourceSize,
+                indexSet.get(span.offset), slice.resultSize);
+            slice.result.replaceAllUsesWith(subviewOp.getResult());
+          };
+          buildSubview(span.slice);
+          for (auto &aliasedSlice : span.aliasedSlices) {
+            buildSubview(aliasedSlice);
+          }
         }
       }
 
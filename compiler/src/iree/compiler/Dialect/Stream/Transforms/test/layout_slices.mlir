@@ -29,6 +29,36 @@ func.func @layoutStatic() -> (index, index, index, index, index, index, index)
 
 // -----
 
+#layoutStaticReorderedConfig = #stream.resource_config<{
+  max_allocation_size = 1073741824,
+  min_buffer_offset_alignment = 16,
+  max_buffer_range = 1073741824,
+  min_buffer_range_alignment = 16,
+  index_bits = 32
+}>
+
+// Packing in lifetime order requires 192 bytes while placing the larger slices
+// first reaches the lower bound of 160 bytes (live at [3]).
+
+// CHECK-LABEL: @layoutStaticReordered
+func.func @layoutStaticReordered() -> (index, index, index, index, index, index)
+    attributes {stream.resources = #layoutStaticReorderedConfig} {
+  %c32 = arith.constant 32 : index
+  %c64 = arith.constant 64 : index
+  %t:6 = stream.resource.pack slices({
+    [0, 0] = %c64,  // +0
+    [0, 2] = %c32,  // +64
+    [1, 3] = %c64,  // +0 (reuse [0, 0])
+    [2, 4] = %c32,  // +128
+    [3, 4] = %c64,  // +64 (reuse [0, 2])
+  }) : index
+  // CHECK: return %c160
+  // CHECK-SAME: %c0, %c64, %c0, %c128, %c64
+  return %t#0, %t#1, %t#2, %t#3, %t#4, %t#5 : index, index, index, index, index, index
+}
+
+// -----
+
 #layoutDynamicConfig = #stream.resource_config<{
   max_allocation_size = 1073741824,
   min_buffer_offset_alignment = 16,
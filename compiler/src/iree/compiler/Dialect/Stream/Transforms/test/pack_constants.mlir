@@ -115,3 +115,187 @@ func.func @splitResourceConstants() -> (!stream.resource<constant>, !stream.reso
   // CHECK: return %[[RES0]], %[[RES1]], %[[IF]]#2
   return %0#0, %0#1, %0#2 : !stream.resource<constant>, !stream.resource<constant>, !stream.timepoint
 }
+
+// -----
+
+// Tests that constants are placed into the storage resource with the least
+// space remaining that can still hold them instead of spilling to a new one
+// each time the current resource is full.
+
+#bestFitResourceConstantsConfig = #stream.resource_config<{
+  max_allocation_size = 32,
+  min_buffer_offset_alignment = 16,
+  max_buffer_range = 1073741824,
+  min_buffer_range_alignment = 16,
+  index_bits = 32
+}>
+
+// CHECK: #composite_of_32b0 = #util.composite<32xi8, [
+// CHECK:     dense<[1, 2]> : tensor<2xi32>,
+// CHECK:     dense<0> : vector<8xi8>,
+// CHECK:     dense<3> : tensor<1xi32>,
+// CHECK:     dense<0> : vector<12xi8>,
+// CHECK: ]>
+// CHECK: #composite_of_32b1 = #util.composite<32xi8, [
+// CHECK:     dense<[4, 5, 6, 7, 8, 9]> : tensor<6xi32>,
+// CHECK:     dense<0> : vector<8xi8>,
+// CHECK: ]>
+
+// CHECK-LABEL: @bestFitResourceConstants
+func.func @bestFitResourceConstants() -> (!stream.resource<constant>, !stream.resource<constant>, !stream.resource<constant>, !stream.timepoint)
+    attributes {stream.resources = #bestFitResourceConstantsConfig} {
+  %c4 = arith.constant 4 : index
+  %c8 = arith.constant 8 : index
+  %c24 = arith.constant 24 : index
+
+  // CHECK: %[[RODATA0:.+]] = util.buffer.constant {alignment = 16 : index} : !util.buffer = #composite_of_32b0
+  // CHECK: %[[RODATA1:.+]] = util.buffer.constant {alignment = 16 : index} : !util.buffer = #composite_of_32b1
+  // CHECK-NOT: util.buffer.constant
+  %0:4 = stream.resource.constants :
+    !stream.resource<constant>{%c8} = dense<[1, 2]> : tensor<2xi32>,
+    !stream.resource<constant>{%c24} = dense<[4, 5, 6, 7, 8, 9]> : tensor<6xi32>,
+    !stream.resource<constant>{%c4} = dense<3> : tensor<1xi32>
+    => !stream.timepoint
+
+  // CHECK: %[[IF:.+]]:3 = scf.if
+
+  // CHECK: %[[RES0:.+]] = stream.resource.subview %[[IF]]#0[%c0] : !stream.resource<constant>{%c32} -> !stream.resource<constant>{%c8}
+  // CHECK: %[[RES2:.+]] = stream.resource.subview %[[IF]]#0[%c16] : !stream.resource<constant>{%c32} -> !stream.resource<constant>{%c4}
+  // CHECK: %[[RES1:.+]] = stream.resource.subview %[[IF]]#1[%c0] : !stream.resource<constant>{%c32} -> !stream.resource<constant>{%c24}
+
+  // CHECK: return %[[RES0]], %[[RES1]], %[[RES2]], %[[IF]]#2
+  return %0#0, %0#1, %0#2, %0#3 : !stream.resource<constant>, !stream.resource<constant>, !stream.resource<constant>, !stream.timepoint
+}
+
+// -----
+
+// Tests that identical constant values are only stored once.
+
+#dedupeResourceConstantsConfig = #stream.resource_config<{
+  max_allocation_size = 1073741824,
+  min_buffer_offset_alignment = 16,
+  max_buffer_range = 1073741824,
+  min_buffer_range_alignment = 16,
+  index_bits = 32
+}>
+
+//      CHECK: #composite_of_32b = #util.composite<32xi8, [
+// CHECK-NEXT:   dense<100> : tensor<1xi32>,
+// CHECK-NEXT:   dense<0> : vector<12xi8>,
+// CHECK-NEXT:   dense<101> : tensor<1xi32>,
+// CHECK-NEXT:   dense<0> : vector<12xi8>,
+// CHECK-NEXT: ]>
+
+// CHECK-LABEL: @dedupeResourceConstants
+func.func @dedupeResourceConstants() -> (!stream.resource<constant>, !stream.resource<constant>, !stream.resource<constant>, !stream.timepoint)
+    attributes {stream.resources = #dedupeResourceConstantsConfig} {
+  %c4 = arith.constant 4 : index
+
+  %0:4 = stream.resource.constants :
+    !stream.resource<constant>{%c4} = dense<100> : tensor<1xi32>,
+    !stream.resource<constant>{%c4} = dense<101> : tensor<1xi32>,
+    !stream.resource<constant>{%c4} = dense<100> : tensor<1xi32>
+    => !stream.timepoint
+
+  // CHECK: %[[IF:.+]]:2 = scf.if
+
+  // CHECK: %[[RES0:.+]] = stream.resource.subview %[[IF]]#0[%c0] : !stream.resource<constant>{%c32} -> !stream.resource<constant>{%c4}
+  // CHECK: %[[RES2:.+]] = stream.resource.subview %[[IF]]#0[%c0] : !stream.resource<constant>{%c32} -> !stream.resource<constant>{%c4}
+  // CHECK: %[[RES1:.+]] = stream.resource.subview %[[IF]]#0[%c16] : !stream.resource<constant>{%c32} -> !stream.resource<constant>{%c4}
+
+  // CHECK: return %[[RES0]], %[[RES1]], %[[RES2]], %[[IF]]#1
+  return %0#0, %0#1, %0#2, %0#3 : !stream.resource<constant>, !stream.resource<constant>, !stream.resource<constant>, !stream.timepoint
+}
+
+// -----
+
+// Tests that identical variable values are not deduplicated as they are
+// uploaded into a single mutable allocation and must not alias.
+
+#dedupeResourceVariablesConfig = #stream.resource_config<{
+  max_allocation_size = 1073741824,
+  min_buffer_offset_alignment = 16,
+  max_buffer_range = 1073741824,
+  min_buffer_range_alignment = 16,
+  index_bits = 32
+}>
+
+//      CHECK: #composite_of_48b = #util.composite<48xi8, [
+// CHECK-NEXT:   dense<100> : tensor<1xi32>,
+// CHECK-NEXT:   dense<0> : vector<12xi8>,
+// CHECK-NEXT:   dense<101> : tensor<1xi32>,
+// CHECK-NEXT:   dense<0> : vector<12xi8>,
+// CHECK-NEXT:   dense<100> : tensor<1xi32>,
+// CHECK-NEXT:   dense<0> : vector<12xi8>,
+// CHECK-NEXT: ]>
+
+// CHECK-LABEL: @dedupeResourceVariables
+func.func @dedupeResourceVariables() -> (!stream.resource<variable>, !stream.resource<variable>, !stream.resource<variable>, !stream.timepoint)
+    attributes {stream.resources = #dedupeResourceVariablesConfig} {
+  %c4 = arith.constant 4 : index
+
+  %0:4 = stream.resource.constants :
+    !stream.resource<variable>{%c4} = dense<100> : tensor<1xi32>,
+    !stream.resource<variable>{%c4} = dense<101> : tensor<1xi32>,
+    !stream.resource<variable>{%c4} = dense<100> : tensor<1xi32>
+    => !stream.timepoint
+
+  // CHECK: %[[ALLOC:.+]] = stream.resource.alloc uninitialized : !stream.resource<variable>{%c48}
+  // CHECK: %[[TIMEPOINT:.+]] = stream.cmd.execute
+
+  // CHECK: %[[RES0:.+]] = stream.resource.subview %[[ALLOC]][%c0] : !stream.resource<variable>{%c48} -> !stream.resource<variable>{%c4}
+  // CHECK: %[[RES1:.+]] = stream.resource.subview %[[ALLOC]][%c16] : !stream.resource<variable>{%c48} -> !stream.resource<variable>{%c4}
+  // CHECK: %[[RES2:.+]] = stream.resource.subview %[[ALLOC]][%c32] : !stream.resource<variable>{%c48} -> !stream.resource<variable>{%c4}
+
+  // CHECK: return %[[RES0]], %[[RES1]], %[[RES2]], %[[TIMEPOINT]]
+  return %0#0, %0#1, %0#2, %0#3 : !stream.resource<variable>, !stream.resource<variable>, !stream.resource<variable>, !stream.timepoint
+}
+
+// -----
+
+// Tests that constants are grouped in storage by the order of their first use.
+
+#firstUseResourceConstantsConfig = #stream.resource_config<{
+  max_allocation_size = 1073741824,
+  min_buffer_offset_alignment = 16,
+  max_buffer_range = 1073741824,
+  min_buffer_range_alignment = 16,
+  index_bits = 32
+}>
+
+//      CHECK: #composite_of_48b = #util.composite<48xi8, [
+// CHECK-NEXT:   dense<102> : tensor<1xi32>,
+// CHECK-NEXT:   dense<0> : vector<12xi8>,
+// CHECK-NEXT:   dense<100> : tensor<1xi32>,
+// CHECK-NEXT:   dense<0> : vector<12xi8>,
+// CHECK-NEXT:   dense<101> : tensor<1xi32>,
+// CHECK-NEXT:   dense<0> : vector<12xi8>,
+// CHECK-NEXT: ]>
+
+// CHECK-LABEL: @firstUseResourceConstants
+func.func @firstUseResourceConstants() -> (!stream.resource<constant>, !stream.resource<constant>, !stream.resource<constant>, !stream.timepoint)
+    attributes {stream.resources = #firstUseResourceConstantsConfig} {
+  %c4 = arith.constant 4 : index
+
+  %0:4 = stream.resource.constants :
+    !stream.resource<constant>{%c4} = dense<100> : tensor<1xi32>,
+    !stream.resource<constant>{%c4} = dense<101> : tensor<1xi32>,
+    !stream.resource<constant>{%c4} = dense<102> : tensor<1xi32>
+    => !stream.timepoint
+
+  // CHECK: %[[IF:.+]]:2 = scf.if
+
+  // CHECK: %[[RES2:.+]] = stream.resource.subview %[[IF]]#0[%c0] : !stream.resource<constant>{%c48} -> !stream.resource<constant>{%c4}
+  // CHECK: %[[RES0:.+]] = stream.resource.subview %[[IF]]#0[%c16] : !stream.resource<constant>{%c48} -> !stream.resource<constant>{%c4}
+  // CHECK: %[[RES1:.+]] = stream.resource.subview %[[IF]]#0[%c32] : !stream.resource<constant>{%c48} -> !stream.resource<constant>{%c4}
+
+  // CHECK: %[[USE2:.+]] = util.do_not_optimize(%[[RES2]])
+  %1 = util.do_not_optimize(%0#2) : !stream.resource<constant>
+  // CHECK: %[[USE0:.+]] = util.do_not_optimize(%[[RES0]])
+  %2 = util.do_not_optimize(%0#0) : !stream.resource<constant>
+  // CHECK: %[[USE1:.+]] = util.do_not_optimize(%[[RES1]])
+  %3 = util.do_not_optimize(%0#1) : !stream.resource<constant>
+
+  // CHECK: return %[[USE0]], %[[USE1]], %[[USE2]], %[[IF]]#1
+  return %2, %3, %1, %0#3 : !stream.resource<constant>, !stream.resource<constant>, !stream.resource<constant>, !stream.timepoint
+}
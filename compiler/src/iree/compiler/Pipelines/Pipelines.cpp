@@ -114,6 +114,13 @@ void buildIREEVMTransformPassPipeline(
       // No flow/stream processing (implies no tensors).
       break;
     default:
+      // Assign the target devices ahead of the flow pipeline so that it can
+      // query the executable targets (such as the number of workers to
+      // parallelize across). The HAL pipeline keeps the assigned targets.
+      if (!executableOptions.targets.empty()) {
+        passManager.addPass(IREE::HAL::createAssignTargetDevicesPass(
+            executableOptions.targets));
+      }
       IREE::Flow::buildFlowTransformPassPipeline(passManager, flowOptions);
       IREE::Stream::buildStreamTransformPassPipeline(passManager,
                                                      streamOptions);
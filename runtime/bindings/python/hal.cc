@@ -43,6 +43,52 @@ static std::string ToHexString(uint32_t value) {
   return ToHexString((const uint8_t*)&value, sizeof(value));
 }
 
+// Py_buffer that is kept acquired for as long as a HAL buffer imported from
+// its memory is live. Released from the HAL buffer release callback, which
+// may be issued from any thread and without the GIL held.
+struct ImportedPyBuffer {
+  Py_buffer view;
+
+  static void Release(void* user_data, iree_hal_buffer_t* buffer) {
+    auto* imported = static_cast<ImportedPyBuffer*>(user_data);
+    if (Py_IsInitialized()) {
+      PyGILState_STATE gil_state = PyGILState_Ensure();
+      PyBuffer_Release(&imported->view);
+      PyGILState_Release(gil_state);
+    }
+    delete imported;
+  }
+};
+
+// Wraps |hal_buffer| in a buffer view with the shape of |py_view| and returns
+// it as a Python object. If no |element_type| is provided then the buffer is
+// returned directly. Consumes the caller's reference to |hal_buffer|.
+static py::object WrapBufferAsPyObject(
+    iree_hal_allocator_t* allocator, iree_hal_buffer_t* hal_buffer,
+    const Py_buffer& py_view,
+    std::optional<iree_hal_element_types_t> element_type) {
+  if (!element_type) {
+    return py::cast(HalBuffer::StealFromRawPtr(hal_buffer),
+                    py::return_value_policy::move);
+  }
+
+  // Create the buffer_view. (note that numpy shape is ssize_t, so we need to
+  // copy).
+  iree_hal_encoding_type_t encoding_type =
+      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR;
+  std::vector<iree_hal_dim_t> dims(py_view.ndim);
+  std::copy(py_view.shape, py_view.shape + py_view.ndim, dims.begin());
+  iree_hal_buffer_view_t* hal_buffer_view;
+  iree_status_t status = iree_hal_buffer_view_create(
+      hal_buffer, dims.size(), dims.data(), *element_type, encoding_type,
+      iree_hal_allocator_host_allocator(allocator), &hal_buffer_view);
+  iree_hal_buffer_release(hal_buffer);
+  CheckApiStatus(status, "Error allocating buffer_view");
+
+  return py::cast(HalBufferView::StealFromRawPtr(hal_buffer_view),
+                  py::return_value_policy::move);
+}
+
 }  // namespace
 
 //------------------------------------------------------------------------------
@@ -115,27 +161,70 @@ py::object HalAllocator::AllocateBufferCopy(
   }
   CheckApiStatus(status, "Failed to allocate device visible buffer");
 
-  if (!element_type) {
-    return py::cast(HalBuffer::StealFromRawPtr(hal_buffer),
-                    py::return_value_policy::move);
+  return WrapBufferAsPyObject(raw_ptr(), hal_buffer, py_view, element_type);
+}
+
+py::object HalAllocator::ImportBuffer(
+    int memory_type, int allowed_usage, py::object buffer,
+    std::optional<iree_hal_element_types_t> element_type) {
+  IREE_TRACE_SCOPE0("HalAllocator::ImportBuffer");
+  // The view stays acquired (and thus keeps the exporting object alive) until
+  // the HAL releases the imported buffer. A writable view is preferred so that
+  // the device may write into the memory; read-only exporters are imported
+  // with read-only access.
+  auto imported = std::make_unique<ImportedPyBuffer>();
+  iree_hal_memory_access_t access = IREE_HAL_MEMORY_ACCESS_ALL;
+  if (PyObject_GetBuffer(buffer.ptr(), &imported->view,
+                         PyBUF_FORMAT | PyBUF_ND | PyBUF_WRITABLE) != 0) {
+    PyErr_Clear();
+    access = IREE_HAL_MEMORY_ACCESS_READ;
+    if (PyObject_GetBuffer(buffer.ptr(), &imported->view,
+                           PyBUF_FORMAT | PyBUF_ND) != 0) {
+      // The GetBuffer call is required to set an appropriate error.
+      throw py::error_already_set();
+    }
   }
+  Py_buffer& py_view = imported->view;
 
-  // Create the buffer_view. (note that numpy shape is ssize_t, so we need to
-  // copy).
-  iree_hal_encoding_type_t encoding_type =
-      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR;
-  std::vector<iree_hal_dim_t> dims(py_view.ndim);
-  std::copy(py_view.shape, py_view.shape + py_view.ndim, dims.begin());
-  iree_hal_buffer_view_t* hal_buffer_view;
-  CheckApiStatus(
-      iree_hal_buffer_view_create(
-          hal_buffer, dims.size(), dims.data(), *element_type, encoding_type,
-          iree_hal_allocator_host_allocator(raw_ptr()), &hal_buffer_view),
-      "Error allocating buffer_view");
-  iree_hal_buffer_release(hal_buffer);
+  iree_hal_buffer_params_t params = {0};
+  params.type = memory_type | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE;
+  params.access = access;
+  params.usage = allowed_usage;
 
-  return py::cast(HalBufferView::StealFromRawPtr(hal_buffer_view),
-                  py::return_value_policy::move);
+  iree_hal_buffer_t* hal_buffer = nullptr;
+  iree_status_t status = iree_ok_status();
+  if (!iree_all_bits_set(
+          iree_hal_allocator_query_compatibility(raw_ptr(), params,
+                                                 py_view.len),
+          IREE_HAL_BUFFER_COMPATIBILITY_IMPORTABLE)) {
+    status = iree_make_status(IREE_STATUS_UNAVAILABLE,
+                              "allocator cannot import host allocations");
+  } else {
+    iree_hal_external_buffer_t external_buffer = {};
+    external_buffer.type = IREE_HAL_EXTERNAL_BUFFER_TYPE_HOST_ALLOCATION;
+    external_buffer.flags = IREE_HAL_EXTERNAL_BUFFER_FLAG_NONE;
+    external_buffer.size = py_view.len;
+    external_buffer.handle.host_allocation.ptr = py_view.buf;
+    iree_hal_buffer_release_callback_t release_callback = {
+        ImportedPyBuffer::Release, imported.get()};
+    status = iree_hal_allocator_import_buffer(
+        raw_ptr(), params, &external_buffer, release_callback, &hal_buffer);
+  }
+
+  // Unavailable imports (unsupported memory, misaligned pointers, etc) are not
+  // errors: the caller is expected to fall back to a copy.
+  if (iree_status_is_unavailable(status) ||
+      iree_status_is_out_of_range(status)) {
+    iree_status_ignore(status);
+    PyBuffer_Release(&py_view);
+    return py::none();
+  }
+  if (!iree_status_is_ok(status)) PyBuffer_Release(&py_view);
+  CheckApiStatus(status, "Failed to import host buffer");
+
+  // Ownership of the view has passed to the HAL buffer release callback.
+  imported.release();
+  return WrapBufferAsPyObject(raw_ptr(), hal_buffer, py_view, element_type);
 }
 
 //------------------------------------------------------------------------------
@@ -615,7 +704,17 @@ void SetupHalBindings(pybind11::module m) {
            "object. If an element type is specified, wraps in a BufferView "
            "matching the characteristics of the Python buffer. The format is "
            "requested as ND/C-Contiguous, which may incur copies if not "
-           "already in that format.");
+           "already in that format.")
+      .def("import_buffer", &HalAllocator::ImportBuffer,
+           py::arg("memory_type"), py::arg("allowed_usage"), py::arg("buffer"),
+           py::arg("element_type") = py::none(), py::keep_alive<0, 1>(),
+           "Imports the memory of a Python buffer object without copying. "
+           "The buffer object is kept alive (and its buffer acquired) for as "
+           "long as the returned HAL buffer is live. Only C-Contiguous "
+           "buffers are supported. Returns None if the allocator cannot "
+           "import the memory (such as when it is not suitably aligned or "
+           "not device accessible), in which case the caller should fall back "
+           "to allocate_buffer_copy.");
 
   py::class_<HalBuffer>(m, "HalBuffer")
       .def("fill_zero", &HalBuffer::FillZero, py::arg("byte_offset"),
@@ -22,8 +22,12 @@ from ._binding import (
 __all__ = [
     "asdevicearray",
     "DeviceArray",
+    "from_dlpack",
 ]
 
+# DLPack device type code for host (CPU) memory (kDLCPU).
+_DLPACK_DEVICE_CPU = 1
+
 _DEVICE_HANDLED_FUNCTIONS = {}
 
 
@@ -98,7 +102,21 @@ class DeviceArray(numpy.lib.mixins.NDArrayOperatorsMixin):
     """Whether this array is currently host accessible."""
     return self._host_array is not None
 
+  def __dlpack__(self, stream=None):
+    # Exported as a view of the host mapping, which for host-local device
+    # memory (CPU backends) aliases the device buffer without a copy.
+    host_array = self.to_host()
+    return host_array.__dlpack__(stream=stream)  # pytype: disable=attribute-error
+
+  def __dlpack_device__(self):
+    return (_DLPACK_DEVICE_CPU, 0)
+
   def to_host(self) -> np.ndarray:
+    """Returns an ndarray view of the array contents.
+
+    For buffers that are host visible (which includes all buffers on the CPU
+    backends) this maps the device memory in place and does not copy.
+    """
     self._transfer_to_host(False)
     return self._host_array
 
@@ -187,7 +205,8 @@ def asdevicearray(device: HalDevice,
                   implicit_host_transfer: bool = False,
                   memory_type=MemoryType.DEVICE_LOCAL,
                   allowed_usage=(BufferUsage.DEFAULT | BufferUsage.MAPPING),
-                  element_type: Optional[HalElementType] = None) -> DeviceArray:
+                  element_type: Optional[HalElementType] = None,
+                  copy: Optional[bool] = None) -> DeviceArray:
   """Helper to create a DeviceArray from an arbitrary array like.
 
   This is similar in purpose and usage to np.asarray, except that it takes
@@ -197,6 +216,14 @@ def asdevicearray(device: HalDevice,
   transfers to satisfy the request. If this is important to you, then a lower
   level API is likely more appropriate.
 
+  The `copy` flag follows the numpy convention: when None (the default) the
+  host memory of `a` is imported into the device without a copy if the device
+  allocator supports it (such as C-contiguous arrays aligned to the allocator
+  requirements on the CPU backends) and copied otherwise. When True a copy is
+  always made and when False a ValueError is raised if the memory cannot be
+  imported. Imported arrays alias the host memory: modifications made to
+  either are visible to the other.
+
   Note that additional flags `memory_type`, `allowed_usage` and `element_type`
   are only hints if creating a new DeviceArray. If `a` is already a DeviceArray,
   they are ignored.
@@ -213,17 +240,48 @@ def asdevicearray(device: HalDevice,
   element_type = map_dtype_to_element_type(a.dtype)
   if element_type is None:
     raise ValueError(f"Could not map dtype {a.dtype} to IREE element type")
-  buffer_view = device.allocator.allocate_buffer_copy(
-      memory_type=memory_type,
-      allowed_usage=allowed_usage,
-      buffer=a,
-      element_type=element_type)
+  buffer_view = None
+  if not copy:
+    buffer_view = device.allocator.import_buffer(memory_type=memory_type,
+                                                 allowed_usage=allowed_usage,
+                                                 buffer=a,
+                                                 element_type=element_type)
+    if buffer_view is None and copy is not None:
+      raise ValueError(
+          "Array memory cannot be imported by the device allocator without a "
+          "copy (it may be misaligned or not device accessible)")
+  if buffer_view is None:
+    buffer_view = device.allocator.allocate_buffer_copy(
+        memory_type=memory_type,
+        allowed_usage=allowed_usage,
+        buffer=a,
+        element_type=element_type)
   return DeviceArray(device,
                      buffer_view,
                      implicit_host_transfer=implicit_host_transfer,
                      override_dtype=a.dtype)
 
 
+def from_dlpack(device: HalDevice,
+                x,
+                *,
+                implicit_host_transfer: bool = False,
+                copy: Optional[bool] = None) -> DeviceArray:
+  """Creates a DeviceArray from an object supporting the DLPack protocol.
+
+  Host (CPU) tensors such as those from PyTorch are consumed through
+  np.from_dlpack and imported without a copy when possible; see
+  `asdevicearray` for the semantics of `copy`.
+  """
+  if isinstance(x, DeviceArray):
+    return x
+  a = np.from_dlpack(x)
+  return asdevicearray(device,
+                       a,
+                       implicit_host_transfer=implicit_host_transfer,
+                       copy=copy)
+
+
 # NOTE: Numpy dtypes are not hashable and exist in a hierarchy that should
 # be queried via isinstance checks. This should be done as a fallback but
 # this is a linear list for quick access to the most common. There may also
@@ -163,6 +163,57 @@ class DeviceHalTest(unittest.TestCase):
     self.assertEqual(repr(ary), "<IREE DeviceArray: shape=[3, 4], dtype=bool>")
     np.testing.assert_array_equal(ary.to_host(), init_ary)
 
+  def _aligned_array(self, shape, dtype, alignment=64):
+    dtype = np.dtype(dtype)
+    byte_length = int(np.prod(shape)) * dtype.itemsize
+    storage = np.empty(byte_length + alignment, dtype=np.uint8)
+    offset = -storage.ctypes.data % alignment
+    return storage[offset:offset + byte_length].view(dtype).reshape(shape)
+
+  def testImportAligned(self):
+    init_ary = self._aligned_array([3, 4], np.float32)
+    init_ary[...] = 2
+    ary = iree.runtime.asdevicearray(self.device, init_ary, copy=False)
+    host_ary = ary.to_host()
+    self.assertEqual(host_ary.ctypes.data, init_ary.ctypes.data)
+    # The device array aliases the host memory.
+    init_ary[0, 0] = 7
+    self.assertEqual(host_ary[0, 0], 7)
+
+  def testImportKeepsHostArrayAlive(self):
+    init_ary = self._aligned_array([3, 4], np.int32)
+    init_ary[...] = 3
+    ary = iree.runtime.asdevicearray(self.device, init_ary, copy=False)
+    init_ary = None
+    gc.collect()
+    np.testing.assert_array_equal(ary.to_host(), np.zeros([3, 4]) + 3)
+
+  def testImportMisalignedFallsBackToCopy(self):
+    init_ary = self._aligned_array([16], np.uint8)[1:]
+    init_ary[...] = 5
+    with self.assertRaises(ValueError):
+      iree.runtime.asdevicearray(self.device, init_ary, copy=False)
+    ary = iree.runtime.asdevicearray(self.device, init_ary)
+    host_ary = ary.to_host()
+    self.assertNotEqual(host_ary.ctypes.data, init_ary.ctypes.data)
+    np.testing.assert_array_equal(host_ary, init_ary)
+
+  def testForcedCopy(self):
+    init_ary = self._aligned_array([3, 4], np.float32)
+    init_ary[...] = 2
+    ary = iree.runtime.asdevicearray(self.device, init_ary, copy=True)
+    init_ary[0, 0] = 7
+    self.assertEqual(ary.to_host()[0, 0], 2)
+
+  def testDLPack(self):
+    init_ary = self._aligned_array([3, 4], np.float32)
+    init_ary[...] = 2
+    ary = iree.runtime.from_dlpack(self.device, init_ary, copy=False)
+    self.assertEqual(ary.to_host().ctypes.data, init_ary.ctypes.data)
+    round_trip = np.from_dlpack(ary)
+    self.assertEqual(round_trip.ctypes.data, init_ary.ctypes.data)
+    np.testing.assert_array_equal(round_trip, init_ary)
+
 
 if __name__ == "__main__":
   unittest.main()
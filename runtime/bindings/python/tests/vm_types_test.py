@@ -46,6 +46,13 @@ class VmTypesTest(unittest.TestCase):
     l.push_int(10 * 1000 * 1000 * 1000)
     self.assertEqual(str(l), "<VmVariantList(1): [10000000000]>")
 
+  def test_variant_list_ints(self):
+    l = rt.VmVariantList(5)
+    l.push_int(1)
+    l.push_ints([2, 3, 10 * 1000 * 1000 * 1000])
+    self.assertEqual(str(l), "<VmVariantList(4): [1, 2, 3, 10000000000]>")
+    self.assertEqual(l.get_variant(3), 10 * 1000 * 1000 * 1000)
+
   def test_variant_list_buffers(self):
     device = rt.get_device("local-sync")
     ET = rt.HalElementType
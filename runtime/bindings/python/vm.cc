@@ -231,6 +231,19 @@ void VmVariantList::PushInt(int64_t ivalue) {
                  "Could not push int");
 }
 
+void VmVariantList::PushInts(const std::vector<int64_t>& ivalues) {
+  // Extends the list and sets all values at once instead of pushing each.
+  iree_host_size_t offset = size();
+  CheckApiStatus(iree_vm_list_resize(raw_ptr(), offset + ivalues.size()),
+                 "Could not resize list");
+  CheckApiStatus(
+      iree_vm_list_set_values(
+          raw_ptr(), offset, IREE_VM_VALUE_TYPE_I64,
+          iree_make_const_byte_span(ivalues.data(),
+                                    ivalues.size() * sizeof(int64_t))),
+      "Could not push ints");
+}
+
 void VmVariantList::PushList(VmVariantList& other) {
   iree_vm_ref_t retained = iree_vm_list_retain_ref(other.raw_ptr());
   iree_vm_list_push_ref_move(raw_ptr(), &retained);
@@ -582,6 +595,7 @@ void SetupVmBindings(pybind11::module m) {
            &VmVariantList::GetAsSerializedTraceValue)
       .def("push_float", &VmVariantList::PushFloat)
       .def("push_int", &VmVariantList::PushInt)
+      .def("push_ints", &VmVariantList::PushInts)
       .def("push_list", &VmVariantList::PushList)
       .def("push_ref", &VmVariantList::PushRef)
       .def("__repr__", &VmVariantList::DebugString);
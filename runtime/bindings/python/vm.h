@@ -104,6 +104,7 @@ class VmVariantList : public ApiRefCounted<VmVariantList, iree_vm_list_t> {
   std::string DebugString() const;
   void PushFloat(double fvalue);
   void PushInt(int64_t ivalue);
+  void PushInts(const std::vector<int64_t>& ivalues);
   void PushList(VmVariantList& other);
   void PushRef(py::handle ref_or_object);
   py::object GetAsList(int index);
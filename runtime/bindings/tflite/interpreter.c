@@ -128,13 +128,10 @@ static iree_status_t _TfLiteInterpreterShapeFrameReadValue(
     _TfLiteInterpreterShapeFrame* frame, int32_t* out_shape_rank,
     int32_t* out_shape_dims) {
   *out_shape_rank = (int32_t)iree_vm_list_size(frame->shape_list);
-  for (int32_t i = 0; i < *out_shape_rank; ++i) {
-    iree_vm_value_t dim;
-    IREE_RETURN_IF_ERROR(iree_vm_list_get_value_as(
-        frame->shape_list, i, IREE_VM_VALUE_TYPE_I32, &dim));
-    out_shape_dims[i] = dim.i32;
-  }
-  return iree_ok_status();
+  return iree_vm_list_get_values(
+      frame->shape_list, 0, IREE_VM_VALUE_TYPE_I32,
+      iree_make_byte_span(out_shape_dims,
+                          *out_shape_rank * sizeof(*out_shape_dims)));
 }
 
 // Writes the shape value to the current frame storage for future applications.
@@ -142,11 +139,9 @@ static iree_status_t _TfLiteInterpreterShapeFrameWriteValue(
     _TfLiteInterpreterShapeFrame* frame, int32_t shape_rank,
     const int32_t* shape_dims) {
   IREE_RETURN_IF_ERROR(iree_vm_list_resize(frame->shape_list, shape_rank));
-  for (int32_t i = 0; i < shape_rank; ++i) {
-    iree_vm_value_t dim = iree_vm_value_make_i32(shape_dims[i]);
-    IREE_RETURN_IF_ERROR(iree_vm_list_set_value(frame->shape_list, i, &dim));
-  }
-  return iree_ok_status();
+  return iree_vm_list_set_values(
+      frame->shape_list, 0, IREE_VM_VALUE_TYPE_I32,
+      iree_make_const_byte_span(shape_dims, shape_rank * sizeof(*shape_dims)));
 }
 
 // Calls the |apply_fn| with the current shape frame state.
@@ -93,6 +93,136 @@ static void iree_cpu_initialize_from_platform(iree_allocator_t temp_allocator,
 
 #endif  // IREE_PLATFORM_*
 
+//===----------------------------------------------------------------------===//
+// Architecture-specific processor data queries
+//===----------------------------------------------------------------------===//
+// Some architectures allow unprivileged queries of processor features that
+// work the same across all platforms. These are ORed into the fields produced
+// by the platform queries above.
+
+#if defined(IREE_ARCH_X86_64)
+
+#if defined(IREE_COMPILER_MSVC)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif  // IREE_COMPILER_MSVC
+
+// Executes CPUID for |leaf| and |subleaf| and stores eax/ebx/ecx/edx.
+static void iree_cpu_x86_64_cpuid(uint32_t leaf, uint32_t subleaf,
+                                  uint32_t* out_regs) {
+#if defined(IREE_COMPILER_MSVC)
+  int regs[4];
+  __cpuidex(regs, (int)leaf, (int)subleaf);
+  memcpy(out_regs, regs, sizeof(regs));
+#else
+  __cpuid_count(leaf, subleaf, out_regs[0], out_regs[1], out_regs[2],
+                out_regs[3]);
+#endif  // IREE_COMPILER_MSVC
+}
+
+// Returns the XCR0 register indicating which register state the OS saves.
+// Must only be called if CPUID reports OSXSAVE.
+static uint64_t iree_cpu_x86_64_xgetbv0(void) {
+#if defined(IREE_COMPILER_MSVC)
+  return _xgetbv(0);
+#else
+  uint32_t eax = 0, edx = 0;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return ((uint64_t)edx << 32) | eax;
+#endif  // IREE_COMPILER_MSVC
+}
+
+// ORs |field_bit| into |field_value| if |reg_bit| is set in |reg_value|.
+#define IREE_SET_IF_CPUID(reg_value, reg_bit, field_value, field_bit) \
+  if ((reg_value) & (1u << (reg_bit))) (field_value) |= (field_bit)
+
+static void iree_cpu_initialize_from_arch(uint64_t* out_fields) {
+  uint32_t regs[4] = {0};
+  iree_cpu_x86_64_cpuid(0, 0, regs);
+  const uint32_t max_leaf = regs[0];
+  if (max_leaf < 1) return;
+
+  uint32_t leaf1[4] = {0};
+  iree_cpu_x86_64_cpuid(1, 0, leaf1);
+  const uint32_t leaf1_ecx = leaf1[2];
+  IREE_SET_IF_CPUID(leaf1_ecx, 0, out_fields[0],
+                    IREE_CPU_DATA_FIELD_0_X86_64_HAVE_SSE3);
+  IREE_SET_IF_CPUID(leaf1_ecx, 9, out_fields[0],
+                    IREE_CPU_DATA_FIELD_0_X86_64_HAVE_SSSE3);
+  IREE_SET_IF_CPUID(leaf1_ecx, 19, out_fields[0],
+                    IREE_CPU_DATA_FIELD_0_X86_64_HAVE_SSE41);
+  IREE_SET_IF_CPUID(leaf1_ecx, 20, out_fields[0],
+                    IREE_CPU_DATA_FIELD_0_X86_64_HAVE_SSE42);
+  IREE_SET_IF_CPUID(leaf1_ecx, 22, out_fields[0],
+                    IREE_CPU_DATA_FIELD_0_X86_64_HAVE_MOVBE);
+  IREE_SET_IF_CPUID(leaf1_ecx, 23, out_fields[0],
+                    IREE_CPU_DATA_FIELD_0_X86_64_HAVE_POPCNT);
+
+  // AVX and AVX-512 are only usable if the OS saves the YMM/ZMM state.
+  bool os_saves_ymm = false;
+  bool os_saves_zmm = false;
+  if (leaf1_ecx & (1u << 27)) {  // OSXSAVE
+    const uint64_t xcr0 = iree_cpu_x86_64_xgetbv0();
+    os_saves_ymm = (xcr0 & 0x6) == 0x6;
+    os_saves_zmm = os_saves_ymm && (xcr0 & 0xE0) == 0xE0;
+  }
+  if (os_saves_ymm) {
+    IREE_SET_IF_CPUID(leaf1_ecx, 28, out_fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX);
+    IREE_SET_IF_CPUID(leaf1_ecx, 12, out_fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_FMA);
+    IREE_SET_IF_CPUID(leaf1_ecx, 29, out_fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_F16C);
+  }
+
+  if (max_leaf >= 7) {
+    uint32_t leaf7[4] = {0};
+    iree_cpu_x86_64_cpuid(7, 0, leaf7);
+    const uint32_t leaf7_ebx = leaf7[1];
+    const uint32_t leaf7_ecx = leaf7[2];
+    IREE_SET_IF_CPUID(leaf7_ebx, 3, out_fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_BMI);
+    IREE_SET_IF_CPUID(leaf7_ebx, 8, out_fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_BMI2);
+    if (os_saves_ymm) {
+      IREE_SET_IF_CPUID(leaf7_ebx, 5, out_fields[0],
+                        IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX2);
+    }
+    if (os_saves_zmm && (leaf7_ebx & (1u << 16))) {
+      out_fields[0] |= IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512F;
+      IREE_SET_IF_CPUID(leaf7_ebx, 28, out_fields[0],
+                        IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512CD);
+      IREE_SET_IF_CPUID(leaf7_ebx, 31, out_fields[0],
+                        IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512VL);
+      IREE_SET_IF_CPUID(leaf7_ebx, 17, out_fields[0],
+                        IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512DQ);
+      IREE_SET_IF_CPUID(leaf7_ebx, 30, out_fields[0],
+                        IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512BW);
+      IREE_SET_IF_CPUID(leaf7_ecx, 11, out_fields[0],
+                        IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512VNNI);
+    }
+  }
+
+  iree_cpu_x86_64_cpuid(0x80000000u, 0, regs);
+  if (regs[0] >= 0x80000001u) {
+    uint32_t ext_leaf1[4] = {0};
+    iree_cpu_x86_64_cpuid(0x80000001u, 0, ext_leaf1);
+    IREE_SET_IF_CPUID(ext_leaf1[2], 5, out_fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_LZCNT);
+  }
+}
+
+#undef IREE_SET_IF_CPUID
+
+#else
+
+static void iree_cpu_initialize_from_arch(uint64_t* out_fields) {
+  // No architecture-level queries available.
+}
+
+#endif  // IREE_ARCH_*
+
 //===----------------------------------------------------------------------===//
 // Architecture-specific string lookup
 //===----------------------------------------------------------------------===//
@@ -115,6 +245,49 @@ static bool iree_cpu_lookup_data_by_key_for_arch(
   return false;
 }
 
+#elif defined(IREE_ARCH_X86_64)
+
+static bool iree_cpu_lookup_data_by_key_for_arch(
+    const uint64_t* fields, iree_string_view_t key,
+    int64_t* IREE_RESTRICT out_value) {
+  IREE_TEST_FIELD_BIT("sse3", fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_SSE3);
+  IREE_TEST_FIELD_BIT("ssse3", fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_SSSE3);
+  IREE_TEST_FIELD_BIT("sse4.1", fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_SSE41);
+  IREE_TEST_FIELD_BIT("sse4.2", fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_SSE42);
+  IREE_TEST_FIELD_BIT("popcnt", fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_POPCNT);
+  IREE_TEST_FIELD_BIT("avx", fields[0], IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX);
+  IREE_TEST_FIELD_BIT("fma", fields[0], IREE_CPU_DATA_FIELD_0_X86_64_HAVE_FMA);
+  IREE_TEST_FIELD_BIT("f16c", fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_F16C);
+  IREE_TEST_FIELD_BIT("avx2", fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX2);
+  IREE_TEST_FIELD_BIT("bmi", fields[0], IREE_CPU_DATA_FIELD_0_X86_64_HAVE_BMI);
+  IREE_TEST_FIELD_BIT("bmi2", fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_BMI2);
+  IREE_TEST_FIELD_BIT("lzcnt", fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_LZCNT);
+  IREE_TEST_FIELD_BIT("movbe", fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_MOVBE);
+  IREE_TEST_FIELD_BIT("avx512f", fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512F);
+  IREE_TEST_FIELD_BIT("avx512cd", fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512CD);
+  IREE_TEST_FIELD_BIT("avx512vl", fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512VL);
+  IREE_TEST_FIELD_BIT("avx512dq", fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512DQ);
+  IREE_TEST_FIELD_BIT("avx512bw", fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512BW);
+  IREE_TEST_FIELD_BIT("avx512vnni", fields[0],
+                      IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512VNNI);
+  return false;
+}
+
 #else
 
 static bool iree_cpu_lookup_data_by_key_for_arch(
@@ -139,6 +312,7 @@ void iree_cpu_initialize(iree_allocator_t temp_allocator) {
   IREE_TRACE_ZONE_BEGIN(z0);
   memset(iree_cpu_data_cache_, 0, sizeof(iree_cpu_data_cache_));
   iree_cpu_initialize_from_platform(temp_allocator, iree_cpu_data_cache_);
+  iree_cpu_initialize_from_arch(iree_cpu_data_cache_);
   IREE_TRACE_ZONE_END(z0);
 }
 
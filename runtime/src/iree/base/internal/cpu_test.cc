@@ -0,0 +1,98 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/cpu.h"
+
+#include "iree/base/status_cc.h"
+#include "iree/base/target_platform.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace iree {
+namespace {
+
+using ::iree::testing::status::StatusIs;
+
+class CPUTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() { iree_cpu_initialize(iree_allocator_system()); }
+};
+
+// Returns true if the canonical |key| is reported as supported.
+static bool HasFeature(const char* key) {
+  int64_t value = 0;
+  IREE_EXPECT_OK(
+      iree_cpu_lookup_data_by_key(iree_make_cstring_view(key), &value));
+  return value != 0;
+}
+
+TEST_F(CPUTest, UnknownKeyNotFound) {
+  int64_t value = 0;
+  EXPECT_THAT(Status(iree_cpu_lookup_data_by_key(
+                  IREE_SV("not-a-real-cpu-feature"), &value)),
+              StatusIs(StatusCode::kNotFound));
+}
+
+TEST_F(CPUTest, LookupMatchesFields) {
+  iree_cpu_initialize_with_data(0, NULL);
+  EXPECT_EQ(0u, iree_cpu_data_field(0));
+#if defined(IREE_ARCH_X86_64)
+  const uint64_t fields[1] = {IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX2};
+  iree_cpu_initialize_with_data(IREE_ARRAYSIZE(fields), fields);
+  EXPECT_TRUE(HasFeature("avx2"));
+  EXPECT_FALSE(HasFeature("avx512f"));
+#elif defined(IREE_ARCH_ARM_64)
+  const uint64_t fields[1] = {IREE_CPU_DATA_FIELD_0_AARCH64_HAVE_DOTPROD};
+  iree_cpu_initialize_with_data(IREE_ARRAYSIZE(fields), fields);
+  EXPECT_TRUE(HasFeature("dotprod"));
+  EXPECT_FALSE(HasFeature("i8mm"));
+#endif  // IREE_ARCH_*
+  iree_cpu_initialize(iree_allocator_system());
+}
+
+#if defined(IREE_ARCH_X86_64)
+
+// Features that require OS support for extended register state must only be
+// reported when the features they build on are also reported.
+TEST_F(CPUTest, X86_64FeatureImplications) {
+  if (HasFeature("fma")) EXPECT_TRUE(HasFeature("avx"));
+  if (HasFeature("f16c")) EXPECT_TRUE(HasFeature("avx"));
+  if (HasFeature("avx2")) EXPECT_TRUE(HasFeature("avx"));
+  if (HasFeature("avx512f")) EXPECT_TRUE(HasFeature("avx"));
+  for (const char* key :
+       {"avx512cd", "avx512vl", "avx512dq", "avx512bw", "avx512vnni"}) {
+    if (HasFeature(key)) EXPECT_TRUE(HasFeature("avx512f")) << key;
+  }
+}
+
+#if defined(IREE_COMPILER_GCC_COMPAT)
+
+// The compiler runtime performs the same CPUID/XGETBV checks; the features it
+// knows about must agree with ours.
+TEST_F(CPUTest, X86_64MatchesCompilerRuntime) {
+  __builtin_cpu_init();
+  EXPECT_EQ(!!__builtin_cpu_supports("sse3"), HasFeature("sse3"));
+  EXPECT_EQ(!!__builtin_cpu_supports("ssse3"), HasFeature("ssse3"));
+  EXPECT_EQ(!!__builtin_cpu_supports("sse4.1"), HasFeature("sse4.1"));
+  EXPECT_EQ(!!__builtin_cpu_supports("sse4.2"), HasFeature("sse4.2"));
+  EXPECT_EQ(!!__builtin_cpu_supports("popcnt"), HasFeature("popcnt"));
+  EXPECT_EQ(!!__builtin_cpu_supports("avx"), HasFeature("avx"));
+  EXPECT_EQ(!!__builtin_cpu_supports("avx2"), HasFeature("avx2"));
+  EXPECT_EQ(!!__builtin_cpu_supports("bmi"), HasFeature("bmi"));
+  EXPECT_EQ(!!__builtin_cpu_supports("bmi2"), HasFeature("bmi2"));
+  EXPECT_EQ(!!__builtin_cpu_supports("avx512f"), HasFeature("avx512f"));
+  EXPECT_EQ(!!__builtin_cpu_supports("avx512cd"), HasFeature("avx512cd"));
+  EXPECT_EQ(!!__builtin_cpu_supports("avx512vl"), HasFeature("avx512vl"));
+  EXPECT_EQ(!!__builtin_cpu_supports("avx512dq"), HasFeature("avx512dq"));
+  EXPECT_EQ(!!__builtin_cpu_supports("avx512bw"), HasFeature("avx512bw"));
+}
+
+#endif  // IREE_COMPILER_GCC_COMPAT
+
+#endif  // IREE_ARCH_X86_64
+
+}  // namespace
+}  // namespace iree
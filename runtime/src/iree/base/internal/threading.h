@@ -135,6 +135,10 @@ void iree_thread_release(iree_thread_t* thread);
 // Returns a platform-defined thread ID for the given |thread|.
 uintptr_t iree_thread_id(iree_thread_t* thread);
 
+// Returns the platform-defined thread ID of the calling thread.
+// Matches iree_thread_id for threads created with iree_thread_create.
+uintptr_t iree_thread_current_id(void);
+
 typedef struct iree_thread_override_t iree_thread_override_t;
 
 // Begins overriding the priority class of the given |thread|.
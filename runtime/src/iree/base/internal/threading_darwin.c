@@ -174,6 +174,8 @@ uintptr_t iree_thread_id(iree_thread_t* thread) {
   return (uintptr_t)thread->handle;
 }
 
+uintptr_t iree_thread_current_id(void) { return (uintptr_t)pthread_self(); }
+
 // Maps an IREE iree_thread_priority_class_t value to a QoS type.
 // https://developer.apple.com/library/archive/documentation/Performance/Conceptual/EnergyGuide-iOS/PrioritizeWorkWithQoS.html
 static qos_class_t iree_thread_qos_class_for_priority_class(
@@ -231,6 +231,8 @@ uintptr_t iree_thread_id(iree_thread_t* thread) {
   return (uintptr_t)thread->handle;
 }
 
+uintptr_t iree_thread_current_id(void) { return (uintptr_t)pthread_self(); }
+
 // Maps an IREE iree_thread_priority_class_t value to a pthreads priority param.
 // The min/max ranges of the priority are implementation dependent so we need to
 // do this at runtime.
@@ -228,6 +228,10 @@ uintptr_t iree_thread_id(iree_thread_t* thread) {
   return (uintptr_t)thread->id;
 }
 
+uintptr_t iree_thread_current_id(void) {
+  return (uintptr_t)GetCurrentThreadId();
+}
+
 // Sets the thread priority to the given |priority_class| immediately.
 static void iree_thread_set_priority_class(
     iree_thread_t* thread, iree_thread_priority_class_t priority_class) {
@@ -0,0 +1,168 @@
+# Copyright 2022 The IREE Authors
+#
+# Licensed under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+# Example command line:
+#   LLVM_AS=/usr/bin/llvm-as \
+#   LLVM_LINK=/usr/bin/llvm-link \
+#   LLVM_OPT=/usr/bin/opt \
+#   CLANG=/usr/bin/clang-13 \
+#   ./iree/builtins/ukernel/bin/build.sh [output directory]
+#
+# The CMake and Bazel builds run this script with the in-tree tools to produce
+# the bitcode files embedded into the compiler. When run manually the files are
+# written next to this script unless an output directory is given.
+
+set -x
+set -e
+
+SCRIPT_DIR="$(realpath `dirname $0`)"
+OUT="$(realpath "${1:-${SCRIPT_DIR?}}")"
+SRC="${SCRIPT_DIR?}/.."
+
+CLANG="${CLANG:-clang}"
+CLANG_INCLUDE="${CLANG_INCLUDE:-$(${CLANG?} -print-resource-dir)/include}"
+IREE_SRC_DIR="${IREE_SRC_DIR:-$(realpath "${SCRIPT_DIR?}/../../../../../..")}"
+IREE_BUILD_DIR="${IREE_BUILD_DIR:-${IREE_SRC_DIR?}/../build}"
+LLVM_AS="${LLVM_AS:-${IREE_BUILD_DIR}/third_party/llvm-project/llvm/bin/llvm-as}"
+LLVM_LINK="${LLVM_LINK:-${IREE_BUILD_DIR}/third_party/llvm-project/llvm/bin/llvm-link}"
+LLVM_OPT="${LLVM_OPT:-${IREE_BUILD_DIR}/third_party/llvm-project/llvm/bin/opt}"
+
+# Sources linked into each bitcode file.
+SOURCE_FILES=(
+  "mmt4d.c"
+  "mmt4d_memref.c"
+  "mmt4d_select_tile_generic.c"
+  "arch/mmt4d_select_tile_arch.c"
+)
+
+# Compiles the C |SOURCE_FILE| into a bitcode file in |WORK_DIR|.
+function make_c_bc {
+  local WORK_DIR=$1
+  local SOURCE_FILE=$2
+  local LL_FILE="${WORK_DIR}/$(basename ${SOURCE_FILE} .c).ll"
+  ${CLANG?} \
+      "${@:3}" \
+      -isystem "${CLANG_INCLUDE?}" \
+      -I "${WORK_DIR}" \
+      -I "${IREE_SRC_DIR?}/runtime/src" \
+      -std=c17 \
+      -O3 \
+      -fno-ident \
+      -fvisibility=hidden \
+      -nostdinc \
+      -S \
+      -emit-llvm \
+      -fdiscard-value-names \
+      -DIREE_UKERNEL_MMT4D_MEMREF_LINK_TIME_CPU_DATA \
+      -o "${LL_FILE}" \
+      -c \
+      "${SRC}/${SOURCE_FILE}"
+
+  # Clang adds a bunch of bad attributes and host-specific information that
+  # we don't want (so we get at least somewhat deterministic builds).
+  sed -i 's/^;.*$//' "${LL_FILE}"
+  sed -i 's/^source_filename.*$//' "${LL_FILE}"
+  sed -i 's/^target datalayout.*$//' "${LL_FILE}"
+  sed -i 's/^target triple.*$//' "${LL_FILE}"
+  sed -i 's/^\(attributes #[0-9]* = {\).*$/\1 inlinehint }/' "${LL_FILE}"
+
+  # NOTE: we do this from stdin so that the filename on the user's system is
+  # not embedded in the bitcode file (making it non-deterministic).
+  cat "${LL_FILE}" | ${LLVM_AS?} -opaque-pointers=0 -o="${LL_FILE}.bc"
+}
+
+# Preprocesses the assembly |SOURCE_FILE| and wraps it as module-level inline
+# assembly in a bitcode file in |WORK_DIR|. The IREE compiler assembles it with
+# the rest of the generated code when producing the executable library.
+# |ARCH_EXTENSION| is enabled for the file so that the instructions assemble
+# regardless of the target features the executable is compiled with; the
+# functions are only selected when the processor data reports support.
+function make_asm_bc {
+  local WORK_DIR=$1
+  local SOURCE_FILE=$2
+  local ARCH_EXTENSION=$3
+  local S_FILE="${WORK_DIR}/$(basename ${SOURCE_FILE} .S).s"
+  local LL_FILE="${WORK_DIR}/$(basename ${SOURCE_FILE} .S).ll"
+  ${CLANG?} \
+      "${@:4}" \
+      -I "${IREE_SRC_DIR?}/runtime/src" \
+      -E \
+      -P \
+      -x assembler-with-cpp \
+      -o "${S_FILE}" \
+      "${SRC}/${SOURCE_FILE}"
+  if [ -n "${ARCH_EXTENSION}" ]; then
+    sed -i "1i .arch_extension ${ARCH_EXTENSION}" "${S_FILE}"
+  fi
+  # Escape backslashes and quotes per LLVM IR string rules.
+  sed -e 's/\\/\\5C/g' -e 's/"/\\22/g' -e 's/^.*$/module asm "&"/' \
+      "${S_FILE}" > "${LL_FILE}"
+  cat "${LL_FILE}" | ${LLVM_AS?} -opaque-pointers=0 -o="${LL_FILE}.bc"
+}
+
+# Links all bitcode files in |WORK_DIR| together and optimizes across them so
+# that the tile function selection is inlined into the entry points.
+function link_bc {
+  local WORK_DIR=$1
+  local FILE_BASENAME=$2
+  ${LLVM_LINK?} -opaque-pointers=0 "${WORK_DIR}"/*.bc -o "${WORK_DIR}/linked.bc"
+  ${LLVM_OPT?} "${WORK_DIR}/linked.bc" -O3 -opaque-pointers=0 \
+      -o "${FILE_BASENAME}.bc"
+}
+
+# Portable variants using only the generic tile functions.
+function make_generic_bc {
+  local ARCH=$1
+  local POINTER_SIZE=$2
+  local WORK_DIR="$(mktemp -d)"
+
+  # The configured header normally produced by the build system. No
+  # IREE_UKERNEL_ARCH_* is defined so that the output is target-agnostic.
+  mkdir -p "${WORK_DIR}/iree/builtins/ukernel/arch"
+  echo "#define IREE_UKERNEL_POINTER_SIZE ${POINTER_SIZE}" > \
+      "${WORK_DIR}/iree/builtins/ukernel/arch/config.h"
+
+  for SOURCE_FILE in "${SOURCE_FILES[@]}"; do
+    make_c_bc "${WORK_DIR}" "${SOURCE_FILE}" "${@:3}"
+  done
+  link_bc "${WORK_DIR}" "${OUT}/libukernel_${ARCH}_generic"
+  rm -rf "${WORK_DIR}"
+}
+
+# aarch64 variant including the architecture-specific tile functions. Those are
+# selected at runtime based on the processor data the compiler provides (see
+# README.md) so a single file serves all aarch64 targets.
+function make_arm_64_bc {
+  local WORK_DIR="$(mktemp -d)"
+  local TARGET_FLAGS=(--target=aarch64-none-elf)
+
+  mkdir -p "${WORK_DIR}/iree/builtins/ukernel/arch/arm_64"
+  printf "%s\n" \
+      "#define IREE_UKERNEL_POINTER_SIZE 8" \
+      "#define IREE_UKERNEL_ARCH_ARM_64" > \
+      "${WORK_DIR}/iree/builtins/ukernel/arch/config.h"
+  printf "%s\n" \
+      "#define IREE_UKERNEL_BUILD_ARM_64_DOTPROD" \
+      "#define IREE_UKERNEL_BUILD_ARM_64_I8MM" > \
+      "${WORK_DIR}/iree/builtins/ukernel/arch/arm_64/config.h"
+
+  for SOURCE_FILE in "${SOURCE_FILES[@]}" \
+      "arch/arm_64/mmt4d_select_tile_arm_64.c"; do
+    make_c_bc "${WORK_DIR}" "${SOURCE_FILE}" "${TARGET_FLAGS[@]}"
+  done
+  make_asm_bc "${WORK_DIR}" "arch/arm_64/mmt4d_tile_arm_64.S" "" \
+      "${TARGET_FLAGS[@]}"
+  make_asm_bc "${WORK_DIR}" "arch/arm_64/mmt4d_tile_arm_64_dotprod.S" \
+      "dotprod" "${TARGET_FLAGS[@]}"
+  make_asm_bc "${WORK_DIR}" "arch/arm_64/mmt4d_tile_arm_64_i8mm.S" \
+      "i8mm" "${TARGET_FLAGS[@]}"
+  link_bc "${WORK_DIR}" "${OUT}/libukernel_arm_64"
+  rm -rf "${WORK_DIR}"
+}
+
+make_generic_bc "wasm32" 4 --target=wasm32
+make_generic_bc "wasm64" 8 --target=wasm64
+make_arm_64_bc
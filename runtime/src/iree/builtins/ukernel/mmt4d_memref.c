@@ -0,0 +1,74 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/builtins/ukernel/mmt4d_memref.h"
+
+#include "iree/builtins/ukernel/mmt4d.h"
+#include "iree/schemas/cpu_data.h"
+
+// Processor data field 0 used to select tile functions. When producing bitcode
+// the value is left symbolic and the IREE compiler provides the features of
+// the target the executable is compiled for; the runtime only selects an
+// executable when the processor supports all of its features. Other builds
+// have no target information and only select the tile functions that do not
+// depend on optional CPU features.
+#if defined(IREE_UKERNEL_MMT4D_MEMREF_LINK_TIME_CPU_DATA)
+extern uint64_t iree_ukernel_mmt4d_memref_cpu_data_field_0;
+#else
+static const uint64_t iree_ukernel_mmt4d_memref_cpu_data_field_0 = 0;
+#endif  // IREE_UKERNEL_MMT4D_MEMREF_LINK_TIME_CPU_DATA
+
+static void iree_ukernel_mmt4d_memref(iree_ukernel_mmt4d_type_t type,
+                                      const iree_ukernel_memref_4d_t* lhs,
+                                      const iree_ukernel_memref_4d_t* rhs,
+                                      const iree_ukernel_memref_4d_t* out) {
+  iree_ukernel_mmt4d_params_t params;
+  params.type = type;
+  params.flags = IREE_VMVX_MATMUL_FLAG_ACCUMULATE;
+  params.lhs_buffer =
+      (const char*)lhs->aligned +
+      (lhs->offset << iree_ukernel_mmt4d_lhs_elem_size_log2(type));
+  params.rhs_buffer =
+      (const char*)rhs->aligned +
+      (rhs->offset << iree_ukernel_mmt4d_rhs_elem_size_log2(type));
+  params.out_buffer =
+      (char*)out->aligned +
+      (out->offset << iree_ukernel_mmt4d_out_elem_size_log2(type));
+  params.lhs_stride = lhs->strides[0];
+  params.rhs_stride = rhs->strides[0];
+  params.out_stride = out->strides[0];
+  params.M = lhs->sizes[0];
+  params.N = rhs->sizes[0];
+  params.K = lhs->sizes[1];
+  params.M0 = (int32_t)lhs->sizes[2];
+  params.N0 = (int32_t)rhs->sizes[2];
+  params.K0 = (int32_t)lhs->sizes[3];
+  const uint64_t cpu_data[IREE_CPU_DATA_FIELD_COUNT] = {
+      iree_ukernel_mmt4d_memref_cpu_data_field_0,
+  };
+  params.cpu_data = cpu_data;
+  // The generated code has no way to handle failures and the compiler only
+  // emits calls for shapes that pass validation: a failure here is a compiler
+  // bug and must not silently leave the output unwritten.
+  iree_ukernel_mmt4d_status_t status = iree_ukernel_mmt4d(&params);
+  if (status != iree_ukernel_mmt4d_status_ok) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_trap();
+#endif  // __GNUC__ || __clang__
+  }
+}
+
+IREE_UKERNEL_EXPORT void _mlir_ciface_iree_ukernel_mmt4d_f32f32f32(
+    const iree_ukernel_memref_4d_t* lhs, const iree_ukernel_memref_4d_t* rhs,
+    const iree_ukernel_memref_4d_t* out) {
+  iree_ukernel_mmt4d_memref(iree_ukernel_mmt4d_type_f32f32f32, lhs, rhs, out);
+}
+
+IREE_UKERNEL_EXPORT void _mlir_ciface_iree_ukernel_mmt4d_i8i8i32(
+    const iree_ukernel_memref_4d_t* lhs, const iree_ukernel_memref_4d_t* rhs,
+    const iree_ukernel_memref_4d_t* out) {
+  iree_ukernel_mmt4d_memref(iree_ukernel_mmt4d_type_i8i8i32, lhs, rhs, out);
+}
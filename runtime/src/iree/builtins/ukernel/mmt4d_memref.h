@@ -0,0 +1,54 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_BUILTINS_UKERNEL_MMT4D_MEMREF_H_
+#define IREE_BUILTINS_UKERNEL_MMT4D_MEMREF_H_
+
+#include "iree/builtins/ukernel/mmt4d_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// Ahead-of-time entry points
+//===----------------------------------------------------------------------===//
+// These are called from code generated by the LLVM CPU compiler backend when
+// the library is linked in as bitcode (see README.md). The compiler declares
+// the functions with the MLIR C interface calling convention
+// (`llvm.emit_c_interface`) such that each memref operand is passed as a
+// pointer to a descriptor matching iree_ukernel_memref_4d_t.
+//
+// Operands are required to be contiguous row-major in all but their outer-most
+// dimension and the output is always accumulated into. The compiler only emits
+// calls for shapes that pass iree_ukernel_mmt4d validation.
+
+// Ranked 4D memref descriptor as defined by the MLIR LLVM lowering.
+// Offset, sizes, and strides are in elements.
+typedef struct iree_ukernel_memref_4d_t {
+  void* allocated;
+  void* aligned;
+  iree_ukernel_ssize_t offset;
+  iree_ukernel_ssize_t sizes[4];
+  iree_ukernel_ssize_t strides[4];
+} iree_ukernel_memref_4d_t;
+
+// out(MxNxM0xN0) += lhs(MxKxM0xK0) * rhs(NxKxN0xK0)^T with f32 operands.
+IREE_UKERNEL_EXPORT void _mlir_ciface_iree_ukernel_mmt4d_f32f32f32(
+    const iree_ukernel_memref_4d_t* lhs, const iree_ukernel_memref_4d_t* rhs,
+    const iree_ukernel_memref_4d_t* out);
+
+// out(MxNxM0xN0) += lhs(MxKxM0xK0) * rhs(NxKxN0xK0)^T with i8 operands
+// accumulated into i32.
+IREE_UKERNEL_EXPORT void _mlir_ciface_iree_ukernel_mmt4d_i8i8i32(
+    const iree_ukernel_memref_4d_t* lhs, const iree_ukernel_memref_4d_t* rhs,
+    const iree_ukernel_memref_4d_t* out);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_BUILTINS_UKERNEL_MMT4D_MEMREF_H_
@@ -97,6 +97,109 @@ TEST_P(executable_cache_test, PrepareExecutable) {
   IREE_ASSERT_OK(loop_status);
 }
 
+TEST_P(executable_cache_test, PrepareExecutables) {
+  iree_status_t loop_status = iree_ok_status();
+  iree_hal_executable_cache_t* executable_cache = NULL;
+  IREE_ASSERT_OK(iree_hal_executable_cache_create(
+      device_, iree_make_cstring_view("default"),
+      iree_loop_inline(&loop_status), &executable_cache));
+
+  // Note: this layout must match the testdata executable.
+  iree_hal_descriptor_set_layout_t* descriptor_set_layout = NULL;
+  iree_hal_descriptor_set_layout_binding_t descriptor_set_layout_bindings[] = {
+      {
+          0,
+          IREE_HAL_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+          IREE_HAL_DESCRIPTOR_FLAG_NONE,
+      },
+      {
+          1,
+          IREE_HAL_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+          IREE_HAL_DESCRIPTOR_FLAG_NONE,
+      },
+  };
+  IREE_ASSERT_OK(iree_hal_descriptor_set_layout_create(
+      device_, IREE_HAL_DESCRIPTOR_SET_LAYOUT_FLAG_NONE,
+      IREE_ARRAYSIZE(descriptor_set_layout_bindings),
+      descriptor_set_layout_bindings, &descriptor_set_layout));
+  iree_hal_pipeline_layout_t* pipeline_layout;
+  IREE_ASSERT_OK(iree_hal_pipeline_layout_create(
+      device_, /*push_constants=*/0, /*set_layout_count=*/1,
+      &descriptor_set_layout, &pipeline_layout));
+
+  // Two distinct executables sharing the same layout are each prepared several
+  // times to exercise concurrent preparation of both distinct and identical
+  // executables in a single batch.
+  const char* executable_names[2] = {
+      "executable_cache_test.bin",
+      "command_buffer_dispatch_test.bin",
+  };
+  iree_hal_executable_params_t executable_params[8];
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(executable_params); ++i) {
+    iree_hal_executable_params_initialize(&executable_params[i]);
+    executable_params[i].caching_mode =
+        IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA;
+    executable_params[i].executable_format =
+        iree_make_cstring_view(get_test_executable_format());
+    executable_params[i].executable_data = get_test_executable_data(
+        iree_make_cstring_view(executable_names[i % 2]));
+    executable_params[i].pipeline_layout_count = 1;
+    executable_params[i].pipeline_layouts = &pipeline_layout;
+  }
+
+  iree_hal_executable_t* executables[IREE_ARRAYSIZE(executable_params)] = {
+      NULL};
+  IREE_ASSERT_OK(iree_hal_executable_cache_prepare_executables(
+      executable_cache, IREE_ARRAYSIZE(executable_params), executable_params,
+      executables));
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(executables); ++i) {
+    EXPECT_NE(executables[i], nullptr);
+    iree_hal_executable_release(executables[i]);
+  }
+
+  iree_hal_pipeline_layout_release(pipeline_layout);
+  iree_hal_descriptor_set_layout_release(descriptor_set_layout);
+  iree_hal_executable_cache_release(executable_cache);
+  IREE_ASSERT_OK(loop_status);
+}
+
+TEST_P(executable_cache_test, PrepareExecutablesFailure) {
+  iree_status_t loop_status = iree_ok_status();
+  iree_hal_executable_cache_t* executable_cache = NULL;
+  IREE_ASSERT_OK(iree_hal_executable_cache_create(
+      device_, iree_make_cstring_view("default"),
+      iree_loop_inline(&loop_status), &executable_cache));
+
+  // The second executable has an unknown format and the whole batch must fail
+  // without returning any executables.
+  iree_hal_executable_params_t executable_params[2];
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(executable_params); ++i) {
+    iree_hal_executable_params_initialize(&executable_params[i]);
+    executable_params[i].caching_mode =
+        IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA |
+        IREE_HAL_EXECUTABLE_CACHING_MODE_DISABLE_VERIFICATION;
+    executable_params[i].executable_format =
+        iree_make_cstring_view(get_test_executable_format());
+    executable_params[i].executable_data = get_test_executable_data(
+        iree_make_cstring_view("executable_cache_test.bin"));
+  }
+  executable_params[1].executable_format = iree_make_cstring_view("FOO?");
+
+  iree_hal_executable_t* executables[IREE_ARRAYSIZE(executable_params)] = {
+      NULL};
+  iree_status_t status = iree_hal_executable_cache_prepare_executables(
+      executable_cache, IREE_ARRAYSIZE(executable_params), executable_params,
+      executables);
+  EXPECT_FALSE(iree_status_is_ok(status));
+  iree_status_ignore(status);
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(executables); ++i) {
+    EXPECT_EQ(executables[i], nullptr);
+  }
+
+  iree_hal_executable_cache_release(executable_cache);
+  IREE_ASSERT_OK(loop_status);
+}
+
 }  // namespace cts
 }  // namespace hal
 }  // namespace iree
@@ -230,6 +230,50 @@ TEST_P(semaphore_test, PingPong) {
   iree_hal_semaphore_release(b2a);
 }
 
+// Tests that joining fences merges timepoints on the same semaphore and that
+// the joined fence can be waited on by the device.
+TEST_P(semaphore_test, FenceJoinAndWaitOnDevice) {
+  iree_hal_semaphore_t* semaphore_a = NULL;
+  iree_hal_semaphore_t* semaphore_b = NULL;
+  IREE_ASSERT_OK(iree_hal_semaphore_create(device_, 0ull, &semaphore_a));
+  IREE_ASSERT_OK(iree_hal_semaphore_create(device_, 0ull, &semaphore_b));
+
+  iree_hal_fence_t* fence_0 = NULL;
+  IREE_ASSERT_OK(iree_hal_fence_create(2, iree_allocator_system(), &fence_0));
+  IREE_ASSERT_OK(iree_hal_fence_insert(fence_0, semaphore_a, 1ull));
+  IREE_ASSERT_OK(iree_hal_fence_insert(fence_0, semaphore_b, 2ull));
+  iree_hal_fence_t* fence_1 = NULL;
+  IREE_ASSERT_OK(iree_hal_fence_create(1, iree_allocator_system(), &fence_1));
+  IREE_ASSERT_OK(iree_hal_fence_insert(fence_1, semaphore_a, 3ull));
+
+  iree_hal_fence_t* fences[] = {fence_0, NULL, fence_1};
+  iree_hal_fence_t* joined_fence = NULL;
+  IREE_ASSERT_OK(iree_hal_fence_join(IREE_ARRAYSIZE(fences), fences,
+                                     iree_allocator_system(), &joined_fence));
+  ASSERT_EQ(2, iree_hal_fence_timepoint_count(joined_fence));
+  iree_hal_semaphore_list_t joined_list =
+      iree_hal_fence_semaphore_list(joined_fence);
+  EXPECT_EQ(semaphore_a, joined_list.semaphores[0]);
+  EXPECT_EQ(3ull, joined_list.payload_values[0]);
+  EXPECT_EQ(semaphore_b, joined_list.semaphores[1]);
+  EXPECT_EQ(2ull, joined_list.payload_values[1]);
+
+  IREE_ASSERT_OK(iree_hal_semaphore_signal(semaphore_a, 1ull));
+  IREE_ASSERT_OK(iree_hal_semaphore_signal(semaphore_b, 2ull));
+  IREE_ASSERT_OK(iree_hal_fence_wait_on_device(fence_0, device_,
+                                               iree_immediate_timeout()));
+  EXPECT_TRUE(iree_status_is_deferred(iree_hal_fence_query(joined_fence)));
+  IREE_ASSERT_OK(iree_hal_semaphore_signal(semaphore_a, 3ull));
+  IREE_ASSERT_OK(iree_hal_fence_wait_on_device(joined_fence, device_,
+                                               iree_infinite_timeout()));
+
+  iree_hal_fence_release(joined_fence);
+  iree_hal_fence_release(fence_0);
+  iree_hal_fence_release(fence_1);
+  iree_hal_semaphore_release(semaphore_a);
+  iree_hal_semaphore_release(semaphore_b);
+}
+
 }  // namespace cts
 }  // namespace hal
 }  // namespace iree
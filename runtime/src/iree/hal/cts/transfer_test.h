@@ -0,0 +1,196 @@
+// Copyright 2026 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_CTS_TRANSFER_TEST_H_
+#define IREE_HAL_CTS_TRANSFER_TEST_H_
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/cts/cts_test_base.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace iree {
+namespace hal {
+namespace cts {
+
+namespace {
+// Transfers below this size are copied to/from mapped device memory in place
+// and transfers at or above it try to import the host memory into the device.
+constexpr iree_device_size_t kSmallTransferSize = 256 * 1024;
+constexpr iree_device_size_t kLargeTransferSize = 2 * 1024 * 1024;
+// Larger than two staging chunks so that both staging buffers are used and
+// reused when a transfer cannot use the host memory in place.
+constexpr iree_device_size_t kChunkedTransferSize = 9 * 1024 * 1024 + 123;
+// Offset into host allocations such that host pointers are not aligned.
+constexpr iree_host_size_t kUnalignedHostOffset = 3;
+// Offset into device buffers to ensure offsets are honored.
+constexpr iree_device_size_t kDeviceOffset = 256;
+}  // namespace
+
+// Tests for iree_hal_device_transfer_* between host memory and device buffers.
+//
+// Depending on the size of the transfer, the timeout, and the memory type of
+// the device buffer implementations route transfers through mapped device
+// memory, imported host memory, or pipelined staging buffers; each test
+// round-trips a pattern through the device and compares the results.
+class transfer_test : public CtsTestBase {
+ protected:
+  // Allocates a device buffer of |buffer_size| bytes. If |mappable| is false
+  // the buffer is only usable with transfers and has to be staged.
+  void AllocateDeviceBuffer(iree_device_size_t buffer_size, bool mappable,
+                            iree_hal_buffer_t** out_buffer) {
+    iree_hal_buffer_params_t params = {0};
+    params.type = IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL;
+    params.usage = IREE_HAL_BUFFER_USAGE_TRANSFER;
+    if (mappable) {
+      params.type |= IREE_HAL_MEMORY_TYPE_HOST_VISIBLE;
+      params.usage |= IREE_HAL_BUFFER_USAGE_MAPPING;
+    }
+    IREE_CHECK_OK(iree_hal_allocator_allocate_buffer(
+        device_allocator_, params, buffer_size, iree_const_byte_span_empty(),
+        out_buffer));
+  }
+
+  // Returns |length| bytes of a pattern that doesn't repeat at power-of-two
+  // boundaries so that misplaced chunks are detected.
+  static std::vector<uint8_t> MakePattern(iree_device_size_t length) {
+    std::vector<uint8_t> pattern(length);
+    for (size_t i = 0; i < pattern.size(); ++i) {
+      pattern[i] = (uint8_t)((i * 7 + i / 251) & 0xFF);
+    }
+    return pattern;
+  }
+
+  // Uploads |length| bytes of a pattern to a device buffer at kDeviceOffset,
+  // downloads it again, and verifies the contents. Host pointers are offset by
+  // kUnalignedHostOffset when |unaligned_host| is true.
+  void RoundTrip(iree_device_size_t length, bool mappable, bool unaligned_host,
+                 iree_timeout_t timeout) {
+    const iree_host_size_t host_offset =
+        unaligned_host ? kUnalignedHostOffset : 0;
+    std::vector<uint8_t> source_storage(host_offset + length);
+    std::vector<uint8_t> pattern = MakePattern(length);
+    memcpy(source_storage.data() + host_offset, pattern.data(), length);
+
+    iree_hal_buffer_t* device_buffer = NULL;
+    AllocateDeviceBuffer(kDeviceOffset + length, mappable, &device_buffer);
+    IREE_ASSERT_OK(iree_hal_device_transfer_h2d(
+        device_, source_storage.data() + host_offset, device_buffer,
+        kDeviceOffset, length, IREE_HAL_TRANSFER_BUFFER_FLAG_DEFAULT,
+        timeout));
+
+    std::vector<uint8_t> target_storage(host_offset + length, 0xCD);
+    IREE_ASSERT_OK(iree_hal_device_transfer_d2h(
+        device_, device_buffer, kDeviceOffset,
+        target_storage.data() + host_offset, length,
+        IREE_HAL_TRANSFER_BUFFER_FLAG_DEFAULT, timeout));
+    iree_hal_buffer_release(device_buffer);
+
+    // Bytes before the transfer range must not have been touched.
+    for (iree_host_size_t i = 0; i < host_offset; ++i) {
+      ASSERT_EQ(0xCD, target_storage[i]) << "byte " << i << " clobbered";
+    }
+    std::vector<uint8_t> actual(target_storage.begin() + host_offset,
+                                target_storage.end());
+    EXPECT_TRUE(actual == pattern) << "round trip of " << length
+                                   << " bytes did not match";
+  }
+};
+
+TEST_P(transfer_test, SmallMappable) {
+  RoundTrip(kSmallTransferSize, /*mappable=*/true, /*unaligned_host=*/false,
+            iree_infinite_timeout());
+}
+
+TEST_P(transfer_test, SmallStaged) {
+  RoundTrip(kSmallTransferSize, /*mappable=*/false, /*unaligned_host=*/false,
+            iree_infinite_timeout());
+}
+
+TEST_P(transfer_test, SmallUnalignedHost) {
+  RoundTrip(kSmallTransferSize + 5, /*mappable=*/true, /*unaligned_host=*/true,
+            iree_infinite_timeout());
+}
+
+TEST_P(transfer_test, LargeImported) {
+  RoundTrip(kLargeTransferSize, /*mappable=*/false, /*unaligned_host=*/false,
+            iree_infinite_timeout());
+}
+
+TEST_P(transfer_test, LargeImportedUnalignedHost) {
+  RoundTrip(kLargeTransferSize + 5, /*mappable=*/false,
+            /*unaligned_host=*/true, iree_infinite_timeout());
+}
+
+TEST_P(transfer_test, LargeMappable) {
+  RoundTrip(kLargeTransferSize, /*mappable=*/true, /*unaligned_host=*/true,
+            iree_infinite_timeout());
+}
+
+// Host memory is only imported with an infinite timeout so these transfers
+// are pipelined through the staging buffers in multiple chunks.
+TEST_P(transfer_test, ChunkedStagedFiniteTimeout) {
+  RoundTrip(kChunkedTransferSize, /*mappable=*/false, /*unaligned_host=*/false,
+            iree_make_timeout_ms(60 * 1000));
+}
+
+TEST_P(transfer_test, ChunkedStagedUnalignedHost) {
+  RoundTrip(kChunkedTransferSize, /*mappable=*/false, /*unaligned_host=*/true,
+            iree_make_timeout_ms(60 * 1000));
+}
+
+TEST_P(transfer_test, ChunkedImported) {
+  RoundTrip(kChunkedTransferSize, /*mappable=*/false, /*unaligned_host=*/true,
+            iree_infinite_timeout());
+}
+
+TEST_P(transfer_test, SmallFiniteTimeout) {
+  RoundTrip(kSmallTransferSize, /*mappable=*/true, /*unaligned_host=*/false,
+            iree_make_timeout_ms(60 * 1000));
+}
+
+// Copies between device buffers both with and without host-local memory and
+// above and below the size at which transfers go through the device queue.
+TEST_P(transfer_test, DeviceToDevice) {
+  for (iree_device_size_t length : {kSmallTransferSize, kLargeTransferSize}) {
+    for (bool mappable : {true, false}) {
+      std::vector<uint8_t> pattern = MakePattern(length);
+      iree_hal_buffer_t* source_buffer = NULL;
+      AllocateDeviceBuffer(length, mappable, &source_buffer);
+      IREE_ASSERT_OK(iree_hal_device_transfer_h2d(
+          device_, pattern.data(), source_buffer, 0, length,
+          IREE_HAL_TRANSFER_BUFFER_FLAG_DEFAULT, iree_infinite_timeout()));
+
+      iree_hal_buffer_t* target_buffer = NULL;
+      AllocateDeviceBuffer(kDeviceOffset + length, mappable, &target_buffer);
+      IREE_ASSERT_OK(iree_hal_device_transfer_d2d(
+          device_, source_buffer, 0, target_buffer, kDeviceOffset, length,
+          IREE_HAL_TRANSFER_BUFFER_FLAG_DEFAULT, iree_infinite_timeout()));
+
+      std::vector<uint8_t> actual(length);
+      IREE_ASSERT_OK(iree_hal_device_transfer_d2h(
+          device_, target_buffer, kDeviceOffset, actual.data(), length,
+          IREE_HAL_TRANSFER_BUFFER_FLAG_DEFAULT, iree_infinite_timeout()));
+      EXPECT_TRUE(actual == pattern)
+          << "device copy of " << length << " bytes (mappable=" << mappable
+          << ") did not match";
+
+      iree_hal_buffer_release(target_buffer);
+      iree_hal_buffer_release(source_buffer);
+    }
+  }
+}
+
+}  // namespace cts
+}  // namespace hal
+}  // namespace iree
+
+#endif  // IREE_HAL_CTS_TRANSFER_TEST_H_
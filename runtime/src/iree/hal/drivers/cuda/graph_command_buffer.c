@@ -478,10 +478,11 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_push_descriptor_set(
             : 0;
     *((CUdeviceptr*)command_buffer->current_descriptor[i + base_binding]) =
         device_ptr;
-    if (binding->buffer) {
-      IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
-          command_buffer->resource_set, 1, &binding->buffer));
-    }
+  }
+  if (binding_count) {
+    IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert_strided(
+        command_buffer->resource_set, binding_count, &bindings[0].buffer,
+        sizeof(bindings[0])));
   }
   return iree_ok_status();
 }
@@ -230,7 +230,7 @@ static iree_status_t iree_hal_sync_device_create_executable_cache(
   iree_hal_sync_device_t* device = iree_hal_sync_device_cast(base_device);
   return iree_hal_local_executable_cache_create(
       identifier, /*worker_capacity=*/1, device->loader_count, device->loaders,
-      iree_hal_device_host_allocator(base_device), out_executable_cache);
+      loop, iree_hal_device_host_allocator(base_device), out_executable_cache);
 }
 
 static iree_status_t iree_hal_sync_device_create_pipeline_layout(
@@ -254,6 +254,12 @@ static iree_status_t iree_hal_sync_device_create_semaphore(
 static iree_hal_semaphore_compatibility_t
 iree_hal_sync_device_query_semaphore_compatibility(
     iree_hal_device_t* base_device, iree_hal_semaphore_t* semaphore) {
+  iree_hal_sync_device_t* device = iree_hal_sync_device_cast(base_device);
+  if (iree_hal_sync_semaphore_isa(semaphore, &device->semaphore_state)) {
+    // Semaphores created from this device share its notification and can be
+    // waited on together with iree_hal_device_wait_semaphores.
+    return IREE_HAL_SEMAPHORE_COMPATIBILITY_ALL;
+  }
   // The synchronous submission queue handles all semaphores as if host-side.
   return IREE_HAL_SEMAPHORE_COMPATIBILITY_HOST_ONLY;
 }
@@ -94,6 +94,14 @@ iree_status_t iree_hal_sync_semaphore_create(
   return status;
 }
 
+bool iree_hal_sync_semaphore_isa(
+    iree_hal_semaphore_t* semaphore,
+    iree_hal_sync_semaphore_state_t* shared_state) {
+  return iree_hal_resource_is(&semaphore->resource,
+                              &iree_hal_sync_semaphore_vtable) &&
+         ((iree_hal_sync_semaphore_t*)semaphore)->shared_state == shared_state;
+}
+
 static void iree_hal_sync_semaphore_destroy(
     iree_hal_semaphore_t* base_semaphore) {
   iree_hal_sync_semaphore_t* semaphore =
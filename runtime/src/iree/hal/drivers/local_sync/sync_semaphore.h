@@ -52,6 +52,10 @@ iree_status_t iree_hal_sync_semaphore_create(
     iree_hal_sync_semaphore_state_t* shared_state, uint64_t initial_value,
     iree_allocator_t host_allocator, iree_hal_semaphore_t** out_semaphore);
 
+// Returns true if |semaphore| is a sync semaphore created with |shared_state|.
+bool iree_hal_sync_semaphore_isa(iree_hal_semaphore_t* semaphore,
+                                 iree_hal_sync_semaphore_state_t* shared_state);
+
 // Performs a signal of a list of semaphores.
 // The semaphores will transition to their new values (nearly) atomically and
 // batching up signals will reduce synchronization overhead.
@@ -10,10 +10,40 @@
 #include <stddef.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/flags.h"
 #include "iree/hal/drivers/local_task/task_driver.h"
 #include "iree/hal/local/loaders/registration/init.h"
 #include "iree/task/api.h"
 
+IREE_FLAG(int32_t, local_task_queue_count, 8,
+          "Number of queues exposed by each local-task device.");
+
+IREE_FLAG(bool, local_task_partition_queues, false,
+          "Partitions the task executor workers into disjoint subsets with one\n"
+          "subset per local-task device queue. Work submitted with queue\n"
+          "affinity bit N will only run on the workers of queue N.");
+
+IREE_FLAG(int64_t, local_task_high_priority_queues, 0,
+          "Bitmask of local-task device queues (bit N for queue N) whose work\n"
+          "is scheduled ahead of the work of all other queues.");
+
+IREE_FLAG(int64_t, local_task_low_priority_queues, 0,
+          "Bitmask of local-task device queues (bit N for queue N) whose work\n"
+          "yields to the work of all other queues.");
+
+IREE_API_EXPORT void iree_hal_local_task_device_params_initialize_from_flags(
+    iree_hal_task_device_params_t* out_params) {
+  iree_hal_task_device_params_initialize(out_params);
+  if (FLAG_local_task_queue_count > 0) {
+    out_params->queue_count = (iree_host_size_t)FLAG_local_task_queue_count;
+  }
+  out_params->partition_queue_workers = FLAG_local_task_partition_queues;
+  out_params->high_priority_queues =
+      (iree_hal_queue_affinity_t)FLAG_local_task_high_priority_queues;
+  out_params->low_priority_queues =
+      (iree_hal_queue_affinity_t)FLAG_local_task_low_priority_queues;
+}
+
 static iree_status_t iree_hal_local_task_driver_factory_enumerate(
     void* self, iree_host_size_t* out_driver_info_count,
     const iree_hal_driver_info_t** out_driver_infos) {
@@ -39,7 +69,7 @@ static iree_status_t iree_hal_local_task_driver_factory_try_create(
   }
 
   iree_hal_task_device_params_t default_params;
-  iree_hal_task_device_params_initialize(&default_params);
+  iree_hal_local_task_device_params_initialize_from_flags(&default_params);
 
   iree_hal_executable_loader_t* loaders[8] = {NULL};
   iree_host_size_t loader_count = 0;
@@ -9,6 +9,7 @@
 
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
+#include "iree/hal/drivers/local_task/task_device.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,6 +18,11 @@ extern "C" {
 IREE_API_EXPORT iree_status_t iree_hal_local_task_driver_module_register(
     iree_hal_driver_registry_t* registry);
 
+// Initializes |out_params| with the device parameters specified by the
+// --local_task_* flags. Used by the driver factory for all devices it creates.
+IREE_API_EXPORT void iree_hal_local_task_device_params_initialize_from_flags(
+    iree_hal_task_device_params_t* out_params);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -0,0 +1,93 @@
+// Copyright 2026 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/drivers/local_task/registration/driver_module.h"
+
+#include <string>
+#include <vector>
+
+#include "iree/base/internal/flags.h"
+#include "iree/testing/gtest.h"
+
+namespace {
+
+// Parses |args| as command line flags. Flags are global so each test sets all
+// of the flags it depends on.
+void ParseFlags(std::vector<std::string> args) {
+  args.insert(args.begin(), "driver_module_test");
+  // Parsing modifies the argument strings in place so they must be mutable.
+  std::vector<char*> arg_ptrs;
+  for (auto& arg : args) arg_ptrs.push_back(&arg[0]);
+  int argc = (int)arg_ptrs.size();
+  char** argv = arg_ptrs.data();
+  iree_flags_parse_checked(IREE_FLAGS_PARSE_MODE_DEFAULT, &argc, &argv);
+}
+
+TEST(LocalTaskDriverModuleTest, DefaultQueuePriorities) {
+  ParseFlags({
+      "--local_task_high_priority_queues=0",
+      "--local_task_low_priority_queues=0",
+  });
+  iree_hal_task_device_params_t params;
+  iree_hal_local_task_device_params_initialize_from_flags(&params);
+  for (iree_host_size_t i = 0; i < params.queue_count; ++i) {
+    EXPECT_EQ(IREE_TASK_PRIORITY_DEFAULT,
+              iree_hal_task_device_params_queue_priority(&params, i));
+  }
+}
+
+TEST(LocalTaskDriverModuleTest, QueuePriorityFlags) {
+  ParseFlags({
+      "--local_task_high_priority_queues=5",  // queues 0 and 2
+      "--local_task_low_priority_queues=10",  // queues 1 and 3
+  });
+  iree_hal_task_device_params_t params;
+  iree_hal_local_task_device_params_initialize_from_flags(&params);
+  EXPECT_EQ(5u, params.high_priority_queues);
+  EXPECT_EQ(10u, params.low_priority_queues);
+  EXPECT_EQ(IREE_TASK_PRIORITY_HIGH,
+            iree_hal_task_device_params_queue_priority(&params, 0));
+  EXPECT_EQ(IREE_TASK_PRIORITY_LOW,
+            iree_hal_task_device_params_queue_priority(&params, 1));
+  EXPECT_EQ(IREE_TASK_PRIORITY_HIGH,
+            iree_hal_task_device_params_queue_priority(&params, 2));
+  EXPECT_EQ(IREE_TASK_PRIORITY_LOW,
+            iree_hal_task_device_params_queue_priority(&params, 3));
+  EXPECT_EQ(IREE_TASK_PRIORITY_DEFAULT,
+            iree_hal_task_device_params_queue_priority(&params, 4));
+}
+
+// Queues in both masks are ambiguous and use the default priority.
+TEST(LocalTaskDriverModuleTest, QueueInBothPriorityMasks) {
+  ParseFlags({
+      "--local_task_high_priority_queues=3",  // queues 0 and 1
+      "--local_task_low_priority_queues=6",   // queues 1 and 2
+  });
+  iree_hal_task_device_params_t params;
+  iree_hal_local_task_device_params_initialize_from_flags(&params);
+  EXPECT_EQ(IREE_TASK_PRIORITY_HIGH,
+            iree_hal_task_device_params_queue_priority(&params, 0));
+  EXPECT_EQ(IREE_TASK_PRIORITY_DEFAULT,
+            iree_hal_task_device_params_queue_priority(&params, 1));
+  EXPECT_EQ(IREE_TASK_PRIORITY_LOW,
+            iree_hal_task_device_params_queue_priority(&params, 2));
+}
+
+// Queues beyond the range of the masks always use the default priority.
+TEST(LocalTaskDriverModuleTest, QueueOutsideOfPriorityMasks) {
+  ParseFlags({
+      "--local_task_high_priority_queues=-1",
+      "--local_task_low_priority_queues=0",
+  });
+  iree_hal_task_device_params_t params;
+  iree_hal_local_task_device_params_initialize_from_flags(&params);
+  EXPECT_EQ(IREE_TASK_PRIORITY_HIGH,
+            iree_hal_task_device_params_queue_priority(&params, 63));
+  EXPECT_EQ(IREE_TASK_PRIORITY_DEFAULT,
+            iree_hal_task_device_params_queue_priority(&params, 64));
+}
+
+}  // namespace
@@ -8,10 +8,12 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <string.h>
 
 #include "iree/base/internal/arena.h"
 #include "iree/base/internal/cpu.h"
+#include "iree/base/internal/math.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/drivers/local_task/task_command_buffer.h"
 #include "iree/hal/drivers/local_task/task_event.h"
@@ -57,6 +59,9 @@ void iree_hal_task_device_params_initialize(
     iree_hal_task_device_params_t* out_params) {
   out_params->arena_block_size = 32 * 1024;
   out_params->queue_count = 8;
+  out_params->partition_queue_workers = false;
+  out_params->high_priority_queues = 0;
+  out_params->low_priority_queues = 0;
 }
 
 static iree_status_t iree_hal_task_device_check_params(
@@ -72,6 +77,32 @@ static iree_status_t iree_hal_task_device_check_params(
   return iree_ok_status();
 }
 
+// Returns the set of workers that queue |queue_index| may use.
+// When partitioning each queue is confined to its own disjoint range of the
+// executor workers (see iree_task_affinity_for_partition).
+static iree_task_affinity_set_t iree_hal_task_device_queue_worker_affinity(
+    const iree_hal_task_device_params_t* params, iree_host_size_t queue_index,
+    iree_host_size_t worker_count) {
+  if (!params->partition_queue_workers || worker_count == 0) {
+    return iree_task_affinity_for_any_worker();
+  }
+  return iree_task_affinity_for_partition(queue_index, params->queue_count,
+                                          worker_count);
+}
+
+iree_task_priority_t iree_hal_task_device_params_queue_priority(
+    const iree_hal_task_device_params_t* params, iree_host_size_t queue_index) {
+  if (queue_index >= sizeof(iree_hal_queue_affinity_t) * 8) {
+    return IREE_TASK_PRIORITY_DEFAULT;
+  }
+  const iree_hal_queue_affinity_t queue_bit = 1ull << queue_index;
+  const bool is_high = (params->high_priority_queues & queue_bit) != 0;
+  const bool is_low = (params->low_priority_queues & queue_bit) != 0;
+  if (is_high && !is_low) return IREE_TASK_PRIORITY_HIGH;
+  if (is_low && !is_high) return IREE_TASK_PRIORITY_LOW;
+  return IREE_TASK_PRIORITY_DEFAULT;
+}
+
 iree_status_t iree_hal_task_device_create(
     iree_string_view_t identifier, const iree_hal_task_device_params_t* params,
     iree_task_executor_t* executor, iree_host_size_t loader_count,
@@ -123,12 +154,24 @@ iree_status_t iree_hal_task_device_create(
       iree_hal_executable_loader_retain(device->loaders[i]);
     }
 
+    iree_host_size_t worker_count =
+        iree_task_executor_worker_count(device->executor);
     device->queue_count = params->queue_count;
     for (iree_host_size_t i = 0; i < device->queue_count; ++i) {
-      // TODO(benvanik): add a number to each queue ID.
-      iree_hal_task_queue_initialize(device->identifier, device->executor,
-                                     &device->small_block_pool,
-                                     &device->queues[i]);
+      // Queues are named with their ordinal so they can be told apart in
+      // traces; the name is truncated to fit in the task scope.
+      char queue_name[32];
+      int queue_name_length =
+          snprintf(queue_name, sizeof(queue_name), "%.*s:%" PRIhsz,
+                   (int)device->identifier.size, device->identifier.data, i);
+      iree_hal_task_queue_initialize(
+          iree_make_string_view(queue_name,
+                                iree_min((iree_host_size_t)queue_name_length,
+                                         sizeof(queue_name) - 1)),
+          device->executor,
+          iree_hal_task_device_queue_worker_affinity(params, i, worker_count),
+          iree_hal_task_device_params_queue_priority(params, i),
+          &device->small_block_pool, &device->queues[i]);
     }
   }
 
@@ -221,6 +264,9 @@ static iree_status_t iree_hal_task_device_query_i64(
 }
 
 // Returns the queue index to submit work to based on the |queue_affinity|.
+// Affinity bit N maps to queue N (modulo the queue count) and when multiple
+// bits are set the lowest is used. This lets programs pin work to a queue -
+// and with partitioned workers a set of workers - by setting a single bit.
 //
 // If we wanted to have dedicated transfer queues we'd fork off based on
 // command_categories. For now all queues are general purpose.
@@ -228,10 +274,9 @@ static iree_host_size_t iree_hal_task_device_select_queue(
     iree_hal_task_device_t* device,
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity) {
-  // TODO(benvanik): evaluate if we want to obscure this mapping a bit so that
-  // affinity really means "equivalent affinities map to equivalent queues" and
-  // not a specific queue index.
-  return queue_affinity % device->queue_count;
+  if (!queue_affinity) return 0;
+  return iree_math_count_trailing_zeros_u64((uint64_t)queue_affinity) %
+         device->queue_count;
 }
 
 static iree_status_t iree_hal_task_device_create_command_buffer(
@@ -265,13 +310,128 @@ static iree_status_t iree_hal_task_device_create_event(
                                     out_event);
 }
 
+typedef struct iree_hal_task_device_loop_dispatch_t {
+  iree_loop_t loop;
+  const iree_loop_dispatch_params_t* params;
+} iree_hal_task_device_loop_dispatch_t;
+
+static iree_status_t iree_hal_task_device_loop_dispatch_tile(
+    void* user_context, const iree_task_tile_context_t* tile_context,
+    iree_task_submission_t* pending_submission) {
+  const iree_hal_task_device_loop_dispatch_t* dispatch =
+      (const iree_hal_task_device_loop_dispatch_t*)user_context;
+  return dispatch->params->workgroup_fn(
+      dispatch->params->callback.user_data, dispatch->loop,
+      tile_context->workgroup_xyz[0], tile_context->workgroup_xyz[1],
+      tile_context->workgroup_xyz[2]);
+}
+
+// Runs the workgroups of a loop dispatch on the calling thread.
+static iree_status_t iree_hal_task_device_loop_dispatch_inline(
+    iree_loop_t loop, const iree_loop_dispatch_params_t* params) {
+  iree_status_t status = iree_ok_status();
+  for (uint32_t z = 0; z < params->workgroup_count_xyz[2]; ++z) {
+    for (uint32_t y = 0; y < params->workgroup_count_xyz[1]; ++y) {
+      for (uint32_t x = 0; x < params->workgroup_count_xyz[0]; ++x) {
+        status = params->workgroup_fn(params->callback.user_data, loop, x, y,
+                                      z);
+        if (!iree_status_is_ok(status)) return status;
+      }
+    }
+  }
+  return status;
+}
+
+// Runs the workgroups of a loop dispatch across the executor workers and
+// returns after the completion callback has been issued.
+//
+// Waiting on the executor from one of its own workers could deadlock (the
+// dispatch may be queued behind the blocked worker) so when called from a
+// worker the workgroups are run inline on the calling thread instead.
+static iree_status_t iree_hal_task_device_loop_dispatch(
+    iree_task_executor_t* executor, iree_loop_t loop,
+    const iree_loop_dispatch_params_t* params) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  if (iree_task_executor_is_worker_thread(executor)) {
+    iree_status_t status =
+        iree_hal_task_device_loop_dispatch_inline(loop, params);
+    status = params->callback.fn(params->callback.user_data, loop, status);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("loop_dispatch"), &scope);
+
+  iree_hal_task_device_loop_dispatch_t dispatch = {
+      .loop = loop,
+      .params = params,
+  };
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  iree_task_dispatch_t dispatch_task;
+  iree_task_dispatch_initialize(
+      &scope,
+      iree_task_make_dispatch_closure(iree_hal_task_device_loop_dispatch_tile,
+                                      &dispatch),
+      workgroup_size, params->workgroup_count_xyz, &dispatch_task);
+
+  iree_task_fence_t* fence = NULL;
+  iree_status_t status =
+      iree_task_executor_acquire_fence(executor, &scope, &fence);
+  if (iree_status_is_ok(status)) {
+    iree_task_set_completion_task(&dispatch_task.header, &fence->header);
+    iree_task_submission_t submission;
+    iree_task_submission_initialize(&submission);
+    iree_task_submission_enqueue(&submission, &dispatch_task.header);
+    iree_task_executor_submit(executor, &submission);
+    iree_task_executor_flush(executor);
+    status = iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE);
+    if (iree_status_is_ok(status)) {
+      status = iree_task_scope_consume_status(&scope);
+    }
+  }
+  iree_task_scope_deinitialize(&scope);
+
+  // The completion callback is always issued, even on failure.
+  status = params->callback.fn(params->callback.user_data, loop, status);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// iree_loop_t control function for the executor loop used for host work such
+// as executable preparation. Only dispatches are supported and they complete
+// synchronously.
+static iree_status_t iree_hal_task_device_loop_ctl(void* self,
+                                                   iree_loop_command_t command,
+                                                   const void* params,
+                                                   void** inout_ptr) {
+  iree_task_executor_t* executor = (iree_task_executor_t*)self;
+  iree_loop_t loop = {self, iree_hal_task_device_loop_ctl};
+  switch (command) {
+    case IREE_LOOP_COMMAND_DISPATCH:
+      return iree_hal_task_device_loop_dispatch(
+          executor, loop, (const iree_loop_dispatch_params_t*)params);
+    case IREE_LOOP_COMMAND_DRAIN:
+      // All operations complete before returning so we are always drained.
+      return iree_ok_status();
+    default:
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "unimplemented executor loop command");
+  }
+}
+
 static iree_status_t iree_hal_task_device_create_executable_cache(
     iree_hal_device_t* base_device, iree_string_view_t identifier,
     iree_loop_t loop, iree_hal_executable_cache_t** out_executable_cache) {
   iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
+  // Executable preparation is routed to the executor so that batches of
+  // executables load concurrently on the workers.
+  iree_loop_t executor_loop = {device->executor, iree_hal_task_device_loop_ctl};
   return iree_hal_local_executable_cache_create(
       identifier, iree_task_executor_worker_count(device->executor),
-      device->loader_count, device->loaders,
+      device->loader_count, device->loaders, executor_loop,
       iree_hal_device_host_allocator(base_device), out_executable_cache);
 }
 
@@ -366,6 +526,19 @@ static iree_status_t iree_hal_task_device_wait_semaphores(
     iree_hal_device_t* base_device, iree_hal_wait_mode_t wait_mode,
     const iree_hal_semaphore_list_t semaphore_list, iree_timeout_t timeout) {
   iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
+
+  // The multi-wait acquires timepoints directly from task semaphores; any other
+  // semaphore is waited on individually through its own implementation.
+  for (iree_host_size_t i = 0; i < semaphore_list.count; ++i) {
+    if (iree_hal_task_semaphore_isa(semaphore_list.semaphores[i])) continue;
+    if (wait_mode != IREE_HAL_WAIT_MODE_ALL) {
+      return iree_make_status(
+          IREE_STATUS_UNIMPLEMENTED,
+          "wait-any is only supported on semaphores created by this device");
+    }
+    return iree_hal_semaphore_list_wait(semaphore_list, timeout);
+  }
+
   return iree_hal_task_semaphore_multi_wait(
       wait_mode, semaphore_list, timeout,
       iree_task_executor_event_pool(device->executor),
@@ -388,7 +561,7 @@ static const iree_hal_device_vtable_t iree_hal_task_device_vtable = {
     .create_semaphore = iree_hal_task_device_create_semaphore,
     .query_semaphore_compatibility =
         iree_hal_task_device_query_semaphore_compatibility,
-    .transfer_range = iree_hal_device_transfer_mappable_range,
+    .transfer_range = iree_hal_device_submit_transfer_range_and_wait,
     .queue_alloca = iree_hal_task_device_queue_alloca,
     .queue_dealloca = iree_hal_task_device_queue_dealloca,
     .queue_execute = iree_hal_task_device_queue_execute,
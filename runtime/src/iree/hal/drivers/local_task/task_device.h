@@ -24,6 +24,24 @@ typedef struct iree_hal_task_device_params_t {
   // concurrently unless prohibited by semaphores.
   iree_host_size_t queue_count;
 
+  // Partitions the executor workers into disjoint subsets with one subset per
+  // queue. Work submitted to different queues will then not contend for the
+  // same workers (and their caches) such as when running a latency-sensitive
+  // program alongside a throughput-oriented one. Queue affinity bit N selects
+  // queue N (modulo the queue count). When there are more queues than workers
+  // the queues are assigned to the workers round-robin and share them.
+  // When disabled all queues share all workers.
+  bool partition_queue_workers;
+
+  // Bitmasks of queues (bit N indicating queue N) whose work is scheduled with
+  // a high or low priority. Workers run ready tasks from high priority queues
+  // before any others and dispatches from lower priority queues yield to them
+  // at tile boundaries such that latency-sensitive work submitted to a high
+  // priority queue is not stuck behind large throughput-oriented dispatches.
+  // Queues in neither mask (or both) use the default priority.
+  iree_hal_queue_affinity_t high_priority_queues;
+  iree_hal_queue_affinity_t low_priority_queues;
+
   // Total size of each block in the device shared block pool.
   // Larger sizes will lower overhead and ensure the heap isn't hit for
   // transient allocations while also increasing memory consumption.
@@ -34,6 +52,11 @@ typedef struct iree_hal_task_device_params_t {
 void iree_hal_task_device_params_initialize(
     iree_hal_task_device_params_t* out_params);
 
+// Returns the priority of the task scope used by queue |queue_index| of a
+// device created with |params|.
+iree_task_priority_t iree_hal_task_device_params_queue_priority(
+    const iree_hal_task_device_params_t* params, iree_host_size_t queue_index);
+
 // Creates a new iree/task/-based local CPU device that uses |executor| for
 // scheduling tasks. |loaders| is the set of executable loaders that are
 // available for loading in the device context.
@@ -381,6 +381,8 @@ static iree_status_t iree_hal_task_queue_retire_cmd_allocate(
 
 void iree_hal_task_queue_initialize(iree_string_view_t identifier,
                                     iree_task_executor_t* executor,
+                                    iree_task_affinity_set_t worker_affinity,
+                                    iree_task_priority_t priority,
                                     iree_arena_block_pool_t* block_pool,
                                     iree_hal_task_queue_t* out_queue) {
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -393,6 +395,8 @@ void iree_hal_task_queue_initialize(iree_string_view_t identifier,
   out_queue->block_pool = block_pool;
 
   iree_task_scope_initialize(identifier, &out_queue->scope);
+  iree_task_scope_set_worker_affinity(&out_queue->scope, worker_affinity);
+  iree_task_scope_set_priority(&out_queue->scope, priority);
 
   iree_hal_task_queue_state_initialize(&out_queue->state);
 
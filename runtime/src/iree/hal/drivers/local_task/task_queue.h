@@ -39,8 +39,13 @@ typedef struct iree_hal_task_queue_t {
   iree_hal_task_queue_state_t state;
 } iree_hal_task_queue_t;
 
+// Initializes a queue submitting work to |executor|.
+// All tasks issued by the queue will only run on workers in |worker_affinity|
+// and be scheduled with |priority| relative to the work of other queues.
 void iree_hal_task_queue_initialize(iree_string_view_t identifier,
                                     iree_task_executor_t* executor,
+                                    iree_task_affinity_set_t worker_affinity,
+                                    iree_task_priority_t priority,
                                     iree_arena_block_pool_t* block_pool,
                                     iree_hal_task_queue_t* out_queue);
 
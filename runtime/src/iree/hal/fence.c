@@ -9,6 +9,7 @@
 #include <stddef.h>
 
 #include "iree/base/tracing.h"
+#include "iree/hal/device.h"
 
 //===----------------------------------------------------------------------===//
 // iree_hal_fence_t
@@ -46,10 +47,43 @@ IREE_API_EXPORT iree_status_t iree_hal_fence_create(
   return iree_ok_status();
 }
 
-// TODO(benvanik): actually join efficiently. Today we just create a fence that
-// can hold the worst-case sum of all fence timepoints and then insert but it
-// could be made much better. In most cases the joined fences have a near
-// perfect overlap of semaphores and we are wasting memory.
+// Maximum number of unique semaphores tracked on the stack when joining fences.
+// Joins with more unique semaphores fall back to sizing the joined fence for
+// the sum of all timepoints.
+#define IREE_HAL_FENCE_JOIN_INLINE_CAPACITY 16
+
+// Returns the capacity required to join |fences|: the number of unique
+// semaphores if small enough to count inline or the total timepoint count.
+static iree_host_size_t iree_hal_fence_join_capacity(
+    iree_host_size_t fence_count, iree_hal_fence_t** fences) {
+  iree_hal_semaphore_t* unique_semaphores[IREE_HAL_FENCE_JOIN_INLINE_CAPACITY];
+  iree_host_size_t unique_count = 0;
+  iree_host_size_t total_count = 0;
+  for (iree_host_size_t i = 0; i < fence_count; ++i) {
+    iree_hal_semaphore_list_t source_list =
+        iree_hal_fence_semaphore_list(fences[i]);
+    total_count += source_list.count;
+    for (iree_host_size_t j = 0; j < source_list.count; ++j) {
+      if (unique_count > IREE_HAL_FENCE_JOIN_INLINE_CAPACITY) break;
+      iree_hal_semaphore_t* semaphore = source_list.semaphores[j];
+      bool is_unique = true;
+      for (iree_host_size_t k = 0; k < unique_count; ++k) {
+        if (unique_semaphores[k] == semaphore) {
+          is_unique = false;
+          break;
+        }
+      }
+      if (!is_unique) continue;
+      if (unique_count < IREE_HAL_FENCE_JOIN_INLINE_CAPACITY) {
+        unique_semaphores[unique_count] = semaphore;
+      }
+      ++unique_count;
+    }
+  }
+  return unique_count > IREE_HAL_FENCE_JOIN_INLINE_CAPACITY ? total_count
+                                                            : unique_count;
+}
+
 IREE_API_EXPORT iree_status_t iree_hal_fence_join(
     iree_host_size_t fence_count, iree_hal_fence_t** fences,
     iree_allocator_t host_allocator, iree_hal_fence_t** out_fence) {
@@ -57,24 +91,22 @@ IREE_API_EXPORT iree_status_t iree_hal_fence_join(
   *out_fence = NULL;
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  // Find the maximum required timepoint capacity.
-  iree_host_size_t total_count = 0;
-  for (iree_host_size_t i = 0; i < fence_count; ++i) {
-    if (fences[i]) total_count += fences[i]->count;
-  }
+  // In most cases the joined fences have a near perfect overlap of semaphores
+  // and we only need capacity for each unique semaphore.
+  iree_host_size_t capacity = iree_hal_fence_join_capacity(fence_count, fences);
 
   // Empty list -> NULL.
-  if (!total_count) {
+  if (!capacity) {
     IREE_TRACE_ZONE_END(z0);
-    return NULL;
+    return iree_ok_status();
   }
 
-  // Create the fence with the maximum capacity.
   iree_hal_fence_t* fence = NULL;
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0, iree_hal_fence_create(total_count, host_allocator, &fence));
+      z0, iree_hal_fence_create(capacity, host_allocator, &fence));
 
-  // Insert all timepoints from all fences.
+  // Insert all timepoints from all fences. Timepoints on the same semaphore are
+  // merged by keeping the maximum payload value.
   iree_status_t status = iree_ok_status();
   for (iree_host_size_t i = 0; i < fence_count; ++i) {
     iree_hal_semaphore_list_t source_list =
@@ -223,6 +255,26 @@ IREE_API_EXPORT iree_status_t iree_hal_fence_wait(iree_hal_fence_t* fence,
   return status;
 }
 
+IREE_API_EXPORT iree_status_t iree_hal_fence_wait_on_device(
+    iree_hal_fence_t* fence, iree_hal_device_t* device,
+    iree_timeout_t timeout) {
+  IREE_ASSERT_ARGUMENT(device);
+  if (!fence || !fence->count) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_status_t status = iree_ok_status();
+  if (fence->count == 1) {
+    // Single timepoint; the semaphore wait avoids any multi-wait overheads.
+    status = iree_hal_semaphore_list_wait(iree_hal_fence_semaphore_list(fence),
+                                          timeout);
+  } else {
+    status = iree_hal_device_wait_semaphores(
+        device, IREE_HAL_WAIT_MODE_ALL, iree_hal_fence_semaphore_list(fence),
+        timeout);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 iree_status_t iree_hal_fence_wait_source_ctl(iree_wait_source_t wait_source,
                                              iree_wait_source_command_t command,
                                              const void* params,
@@ -52,6 +52,9 @@ IREE_API_EXPORT iree_status_t iree_hal_fence_create(
     iree_hal_fence_t** out_fence);
 
 // Creates a new fence joining all |fences| as a wait-all operation.
+// Timepoints on the same semaphore are merged such that the joined fence has a
+// single timepoint per unique semaphore with the maximum payload value.
+// |out_fence| is set to NULL if none of the |fences| have timepoints.
 IREE_API_EXPORT iree_status_t iree_hal_fence_join(
     iree_host_size_t fence_count, iree_hal_fence_t** fences,
     iree_allocator_t host_allocator, iree_hal_fence_t** out_fence);
@@ -113,6 +116,15 @@ IREE_API_EXPORT void iree_hal_fence_fail(iree_hal_fence_t* fence,
 IREE_API_EXPORT iree_status_t iree_hal_fence_wait(iree_hal_fence_t* fence,
                                                   iree_timeout_t timeout);
 
+// Blocks the caller until the fence is reached or the |timeout| elapses by
+// performing a single wait-all on |device|. All semaphores in the fence must
+// have been created from |device| (or be imported into it) as with
+// iree_hal_device_wait_semaphores. Prefer this over iree_hal_fence_wait when
+// the device is known as implementations can wait on all timepoints at once
+// instead of waking for each semaphore in turn.
+IREE_API_EXPORT iree_status_t iree_hal_fence_wait_on_device(
+    iree_hal_fence_t* fence, iree_hal_device_t* device, iree_timeout_t timeout);
+
 // Returns a wait source reference to |fence| after it reaches or exceeds
 // all defined timepoints.
 IREE_API_EXPORT iree_wait_source_t
@@ -9,13 +9,176 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
+#include "iree/base/internal/synchronization.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
 #include "iree/hal/local/elf/elf_module.h"
 #include "iree/hal/local/executable_library.h"
 #include "iree/hal/local/local_executable.h"
 
+typedef struct iree_hal_embedded_elf_loader_t iree_hal_embedded_elf_loader_t;
+
+//===----------------------------------------------------------------------===//
+// iree_hal_elf_library_t
+//===----------------------------------------------------------------------===//
+
+// SHA-256 digest of the executable data a library was loaded from.
+// Callers are not required to keep executable data live after preparing an
+// executable and the loaded image does not retain it so we identify binaries by
+// digest and length instead of keeping a copy around to compare against.
+typedef struct iree_hal_elf_library_digest_t {
+  uint8_t bytes[32];
+} iree_hal_elf_library_digest_t;
+
+static const uint32_t iree_hal_elf_library_digest_k[64] = {
+    0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1,
+    0x923F82A4, 0xAB1C5ED5, 0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3,
+    0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174, 0xE49B69C1, 0xEFBE4786,
+    0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+    0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147,
+    0x06CA6351, 0x14292967, 0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13,
+    0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85, 0xA2BFE8A1, 0xA81A664B,
+    0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+    0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A,
+    0x5B9CCA4F, 0x682E6FF3, 0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208,
+    0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
+};
+
+static inline uint32_t iree_hal_elf_library_digest_rotr(uint32_t x, int n) {
+  return (x >> n) | (x << (32 - n));
+}
+
+// Mixes one 64-byte |block| into the digest |state|.
+static void iree_hal_elf_library_digest_block(uint32_t state[8],
+                                              const uint8_t* block) {
+  uint32_t w[64];
+  for (int i = 0; i < 16; ++i) {
+    w[i] = ((uint32_t)block[i * 4 + 0] << 24) |
+           ((uint32_t)block[i * 4 + 1] << 16) |
+           ((uint32_t)block[i * 4 + 2] << 8) | ((uint32_t)block[i * 4 + 3]);
+  }
+  for (int i = 16; i < 64; ++i) {
+    uint32_t s0 = iree_hal_elf_library_digest_rotr(w[i - 15], 7) ^
+                  iree_hal_elf_library_digest_rotr(w[i - 15], 18) ^
+                  (w[i - 15] >> 3);
+    uint32_t s1 = iree_hal_elf_library_digest_rotr(w[i - 2], 17) ^
+                  iree_hal_elf_library_digest_rotr(w[i - 2], 19) ^
+                  (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+  uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+  uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+  for (int i = 0; i < 64; ++i) {
+    uint32_t s1 = iree_hal_elf_library_digest_rotr(e, 6) ^
+                  iree_hal_elf_library_digest_rotr(e, 11) ^
+                  iree_hal_elf_library_digest_rotr(e, 25);
+    uint32_t ch = (e & f) ^ (~e & g);
+    uint32_t t1 = h + s1 + ch + iree_hal_elf_library_digest_k[i] + w[i];
+    uint32_t s0 = iree_hal_elf_library_digest_rotr(a, 2) ^
+                  iree_hal_elf_library_digest_rotr(a, 13) ^
+                  iree_hal_elf_library_digest_rotr(a, 22);
+    uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+    uint32_t t2 = s0 + maj;
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+  state[5] += f;
+  state[6] += g;
+  state[7] += h;
+}
+
+// Computes the SHA-256 digest of |data|.
+static void iree_hal_elf_library_digest(
+    iree_const_byte_span_t data, iree_hal_elf_library_digest_t* out_digest) {
+  uint32_t state[8] = {
+      0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+      0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19,
+  };
+  iree_host_size_t offset = 0;
+  for (; offset + 64 <= data.data_length; offset += 64) {
+    iree_hal_elf_library_digest_block(state, data.data + offset);
+  }
+
+  // Pad the trailing partial block with 0x80, zeros, and the big-endian bit
+  // length; this spills into a second block if the length doesn't fit.
+  uint8_t tail[128] = {0};
+  iree_host_size_t tail_length = data.data_length - offset;
+  if (tail_length) memcpy(tail, data.data + offset, tail_length);
+  tail[tail_length] = 0x80;
+  iree_host_size_t tail_size = tail_length + 1 + 8 <= 64 ? 64 : 128;
+  uint64_t bit_length = (uint64_t)data.data_length * 8;
+  for (int i = 0; i < 8; ++i) {
+    tail[tail_size - 1 - i] = (uint8_t)(bit_length >> (i * 8));
+  }
+  for (iree_host_size_t i = 0; i < tail_size; i += 64) {
+    iree_hal_elf_library_digest_block(state, tail + i);
+  }
+
+  for (int i = 0; i < 8; ++i) {
+    out_digest->bytes[i * 4 + 0] = (uint8_t)(state[i] >> 24);
+    out_digest->bytes[i * 4 + 1] = (uint8_t)(state[i] >> 16);
+    out_digest->bytes[i * 4 + 2] = (uint8_t)(state[i] >> 8);
+    out_digest->bytes[i * 4 + 3] = (uint8_t)(state[i]);
+  }
+}
+
+// An ELF module loaded from a particular executable binary.
+// Libraries are shared by all executables created through the same loader from
+// identical executable data so that the parse/relocate/protect work done by
+// iree_elf_module_initialize_from_memory happens once per binary instead of
+// once per executable. Each executable still has its own environment (imports
+// and constants) and only the immutable loaded image is shared.
+//
+// Libraries are tracked in the loader's |library_list| for as long as any
+// executable references them and are unloaded when the last one is released.
+typedef struct iree_hal_elf_library_t {
+  // Next library in the loader's library list.
+  struct iree_hal_elf_library_t* next;
+  // Loader that owns the library list. Retained by the library.
+  iree_hal_embedded_elf_loader_t* loader;
+  // Number of executables referencing the library.
+  // Guarded by the loader's |library_mutex|.
+  int32_t ref_count;
+
+  // Digest and length of the executable data the library was loaded from.
+  iree_hal_elf_library_digest_t content_digest;
+  iree_host_size_t content_length;
+
+  // Loaded ELF module.
+  iree_elf_module_t module;
+} iree_hal_elf_library_t;
+
+// Returns true if |library| was loaded from data with the given digest and
+// length.
+static bool iree_hal_elf_library_matches(
+    const iree_hal_elf_library_t* library,
+    const iree_hal_elf_library_digest_t* content_digest,
+    iree_host_size_t content_length) {
+  return library->content_length == content_length &&
+         memcmp(library->content_digest.bytes, content_digest->bytes,
+                sizeof(content_digest->bytes)) == 0;
+}
+
+static iree_status_t iree_hal_embedded_elf_loader_acquire_library(
+    iree_hal_embedded_elf_loader_t* executable_loader,
+    iree_const_byte_span_t executable_data,
+    iree_hal_elf_library_t** out_library);
+
+static void iree_hal_elf_library_release(iree_hal_elf_library_t* library);
+
 //===----------------------------------------------------------------------===//
 // iree_hal_elf_executable_t
 //===----------------------------------------------------------------------===//
@@ -23,8 +186,8 @@
 typedef struct iree_hal_elf_executable_t {
   iree_hal_local_executable_t base;
 
-  // Loaded ELF module.
-  iree_elf_module_t module;
+  // Loaded ELF module shared with other executables using the same binary.
+  iree_hal_elf_library_t* library_image;
 
   // Name used for the file field in tracy and debuggers.
   iree_string_view_t identifier;
@@ -45,7 +208,8 @@ static iree_status_t iree_hal_elf_executable_query_library(
   // Get the exported symbol used to get the library metadata.
   iree_hal_executable_library_query_fn_t query_fn = NULL;
   IREE_RETURN_IF_ERROR(iree_elf_module_lookup_export(
-      &executable->module, IREE_HAL_EXECUTABLE_LIBRARY_EXPORT_NAME,
+      &executable->library_image->module,
+      IREE_HAL_EXECUTABLE_LIBRARY_EXPORT_NAME,
       (void**)&query_fn));
 
   // Query for a compatible version of the library.
@@ -125,6 +289,7 @@ static iree_status_t iree_hal_elf_executable_resolve_imports(
 }
 
 static iree_status_t iree_hal_elf_executable_create(
+    iree_hal_embedded_elf_loader_t* executable_loader,
     const iree_hal_executable_params_t* executable_params,
     const iree_hal_executable_import_provider_t import_provider,
     iree_allocator_t host_allocator, iree_hal_executable_t** out_executable) {
@@ -169,10 +334,10 @@ static iree_status_t iree_hal_elf_executable_create(
     }
   }
   if (iree_status_is_ok(status)) {
-    // Attempt to load the ELF module.
-    status = iree_elf_module_initialize_from_memory(
-        executable_params->executable_data, /*import_table=*/NULL,
-        host_allocator, &executable->module);
+    // Attempt to load the ELF module (or reuse one already loaded).
+    status = iree_hal_embedded_elf_loader_acquire_library(
+        executable_loader, executable_params->executable_data,
+        &executable->library_image);
   }
   if (iree_status_is_ok(status)) {
     // Query metadata and get the entry point function pointers.
@@ -229,7 +394,9 @@ static void iree_hal_elf_executable_destroy(
   iree_allocator_t host_allocator = executable->base.host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  iree_elf_module_deinitialize(&executable->module);
+  if (executable->library_image != NULL) {
+    iree_hal_elf_library_release(executable->library_image);
+  }
 
   if (executable->base.environment.imports != NULL) {
     iree_allocator_free(host_allocator,
@@ -316,10 +483,15 @@ static const iree_hal_local_executable_vtable_t iree_hal_elf_executable_vtable =
 // iree_hal_embedded_elf_loader_t
 //===----------------------------------------------------------------------===//
 
-typedef struct iree_hal_embedded_elf_loader_t {
+struct iree_hal_embedded_elf_loader_t {
   iree_hal_executable_loader_t base;
   iree_allocator_t host_allocator;
-} iree_hal_embedded_elf_loader_t;
+
+  // Guards the library list and library reference counts.
+  iree_slim_mutex_t library_mutex;
+  // Singly-linked list of live libraries loaded by this loader.
+  iree_hal_elf_library_t* library_list IREE_GUARDED_BY(library_mutex);
+};
 
 static const iree_hal_executable_loader_vtable_t
     iree_hal_embedded_elf_loader_vtable;
@@ -340,6 +512,8 @@ iree_status_t iree_hal_embedded_elf_loader_create(
                                           import_provider,
                                           &executable_loader->base);
     executable_loader->host_allocator = host_allocator;
+    iree_slim_mutex_initialize(&executable_loader->library_mutex);
+    executable_loader->library_list = NULL;
     *out_executable_loader = (iree_hal_executable_loader_t*)executable_loader;
   }
 
@@ -354,11 +528,143 @@ static void iree_hal_embedded_elf_loader_destroy(
   iree_allocator_t host_allocator = executable_loader->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Libraries retain the loader so none can be live by the time we get here.
+  IREE_ASSERT(!executable_loader->library_list);
+  iree_slim_mutex_deinitialize(&executable_loader->library_mutex);
   iree_allocator_free(host_allocator, executable_loader);
 
   IREE_TRACE_ZONE_END(z0);
 }
 
+iree_host_size_t iree_hal_embedded_elf_loader_library_count(
+    iree_hal_executable_loader_t* base_executable_loader) {
+  IREE_ASSERT_ARGUMENT(base_executable_loader);
+  iree_hal_embedded_elf_loader_t* executable_loader =
+      (iree_hal_embedded_elf_loader_t*)base_executable_loader;
+  iree_host_size_t library_count = 0;
+  iree_slim_mutex_lock(&executable_loader->library_mutex);
+  for (iree_hal_elf_library_t* library = executable_loader->library_list;
+       library; library = library->next) {
+    ++library_count;
+  }
+  iree_slim_mutex_unlock(&executable_loader->library_mutex);
+  return library_count;
+}
+
+// Returns the live library loaded from data with the given digest and length,
+// if any. Expects the library lock to be held.
+static iree_hal_elf_library_t* iree_hal_embedded_elf_loader_find_library(
+    iree_hal_embedded_elf_loader_t* executable_loader,
+    const iree_hal_elf_library_digest_t* content_digest,
+    iree_host_size_t content_length) {
+  iree_hal_elf_library_t* library = executable_loader->library_list;
+  while (library) {
+    if (iree_hal_elf_library_matches(library, content_digest,
+                                     content_length)) {
+      return library;
+    }
+    library = library->next;
+  }
+  return NULL;
+}
+
+// Returns a reference to a library loaded from |executable_data|, loading it
+// if no live library was loaded from identical data.
+static iree_status_t iree_hal_embedded_elf_loader_acquire_library(
+    iree_hal_embedded_elf_loader_t* executable_loader,
+    iree_const_byte_span_t executable_data,
+    iree_hal_elf_library_t** out_library) {
+  *out_library = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, executable_data.data_length);
+
+  iree_hal_elf_library_digest_t content_digest;
+  iree_hal_elf_library_digest(executable_data, &content_digest);
+
+  // Fast path: an identical binary is already loaded.
+  iree_slim_mutex_lock(&executable_loader->library_mutex);
+  iree_hal_elf_library_t* library = iree_hal_embedded_elf_loader_find_library(
+      executable_loader, &content_digest, executable_data.data_length);
+  if (library) ++library->ref_count;
+  iree_slim_mutex_unlock(&executable_loader->library_mutex);
+  if (library) {
+    *out_library = library;
+    IREE_TRACE_ZONE_END(z0);
+    return iree_ok_status();
+  }
+
+  // Load outside of the lock so that loads of different binaries can proceed
+  // concurrently (such as when preparing executables in parallel).
+  IREE_TRACE_ZONE_APPEND_TEXT(z0, "load");
+  iree_hal_elf_library_t* new_library = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      executable_loader->host_allocator,
+      sizeof(*new_library), (void**)&new_library);
+  if (iree_status_is_ok(status)) {
+    status = iree_elf_module_initialize_from_memory(
+        executable_data, /*import_table=*/NULL,
+        executable_loader->host_allocator, &new_library->module);
+    if (!iree_status_is_ok(status)) {
+      iree_allocator_free(executable_loader->host_allocator, new_library);
+      new_library = NULL;
+    }
+  }
+  if (!iree_status_is_ok(status)) {
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+  new_library->loader = executable_loader;
+  new_library->ref_count = 1;
+  new_library->content_digest = content_digest;
+  new_library->content_length = executable_data.data_length;
+
+  // Another thread may have loaded the same binary while we were loading; if
+  // so we use theirs and drop ours so that there's only ever one live image.
+  iree_slim_mutex_lock(&executable_loader->library_mutex);
+  library = iree_hal_embedded_elf_loader_find_library(
+      executable_loader, &content_digest, executable_data.data_length);
+  if (library) {
+    ++library->ref_count;
+  } else {
+    library = new_library;
+    new_library = NULL;
+    iree_hal_executable_loader_retain(&executable_loader->base);
+    library->next = executable_loader->library_list;
+    executable_loader->library_list = library;
+  }
+  iree_slim_mutex_unlock(&executable_loader->library_mutex);
+
+  if (new_library) {
+    iree_elf_module_deinitialize(&new_library->module);
+    iree_allocator_free(executable_loader->host_allocator, new_library);
+  }
+
+  *out_library = library;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+// Releases a reference to |library| and unloads it if it was the last.
+static void iree_hal_elf_library_release(iree_hal_elf_library_t* library) {
+  iree_hal_embedded_elf_loader_t* executable_loader = library->loader;
+
+  iree_slim_mutex_lock(&executable_loader->library_mutex);
+  const bool is_last = --library->ref_count == 0;
+  if (is_last) {
+    iree_hal_elf_library_t** prev_next = &executable_loader->library_list;
+    while (*prev_next != library) prev_next = &(*prev_next)->next;
+    *prev_next = library->next;
+  }
+  iree_slim_mutex_unlock(&executable_loader->library_mutex);
+  if (!is_last) return;
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_elf_module_deinitialize(&library->module);
+  iree_allocator_free(executable_loader->host_allocator, library);
+  iree_hal_executable_loader_release(&executable_loader->base);
+  IREE_TRACE_ZONE_END(z0);
+}
+
 static bool iree_hal_embedded_elf_loader_query_support(
     iree_hal_executable_loader_t* base_executable_loader,
     iree_hal_executable_caching_mode_t caching_mode,
@@ -377,7 +683,8 @@ static iree_status_t iree_hal_embedded_elf_loader_try_load(
 
   // Perform the load of the ELF and wrap it in an executable handle.
   iree_status_t status = iree_hal_elf_executable_create(
-      executable_params, base_executable_loader->import_provider,
+      executable_loader, executable_params,
+      base_executable_loader->import_provider,
       executable_loader->host_allocator, out_executable);
 
   IREE_TRACE_ZONE_END(z0);
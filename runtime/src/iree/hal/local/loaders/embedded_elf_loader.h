@@ -26,6 +26,12 @@ iree_status_t iree_hal_embedded_elf_loader_create(
     iree_allocator_t host_allocator,
     iree_hal_executable_loader_t** out_executable_loader);
 
+// Returns the number of distinct ELF images currently loaded by
+// |executable_loader|. Executables loaded from identical data share one image
+// that is unloaded when the last of them is released.
+iree_host_size_t iree_hal_embedded_elf_loader_library_count(
+    iree_hal_executable_loader_t* executable_loader);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
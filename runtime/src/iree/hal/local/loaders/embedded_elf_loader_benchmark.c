@@ -0,0 +1,157 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/local/loaders/embedded_elf_loader.h"
+#include "iree/testing/benchmark.h"
+
+// ELF modules for various platforms embedded in the binary:
+#include "iree/hal/local/elf/testdata/elementwise_mul.h"
+
+static iree_status_t iree_hal_elf_benchmark_query_file_data(
+    iree_const_byte_span_t* out_file_data) {
+  *out_file_data = iree_make_const_byte_span(NULL, 0);
+
+  iree_string_view_t pattern = iree_string_view_empty();
+#if defined(IREE_ARCH_ARM_32)
+  pattern = iree_make_cstring_view("*_arm_32.so");
+#elif defined(IREE_ARCH_ARM_64)
+  pattern = iree_make_cstring_view("*_arm_64.so");
+#elif defined(IREE_ARCH_RISCV_32)
+  pattern = iree_make_cstring_view("*_riscv_32.so");
+#elif defined(IREE_ARCH_RISCV_64)
+  pattern = iree_make_cstring_view("*_riscv_64.so");
+#elif defined(IREE_ARCH_X86_32)
+  pattern = iree_make_cstring_view("*_x86_32.so");
+#elif defined(IREE_ARCH_X86_64)
+  pattern = iree_make_cstring_view("*_x86_64.so");
+#endif  // IREE_ARCH_*
+
+  if (!iree_string_view_is_empty(pattern)) {
+    for (size_t i = 0; i < elementwise_mul_size(); ++i) {
+      const struct iree_file_toc_t* file_toc = &elementwise_mul_create()[i];
+      if (iree_string_view_match_pattern(iree_make_cstring_view(file_toc->name),
+                                         pattern)) {
+        *out_file_data =
+            iree_make_const_byte_span(file_toc->data, file_toc->size);
+        return iree_ok_status();
+      }
+    }
+  }
+
+  return iree_make_status(IREE_STATUS_NOT_FOUND,
+                          "no architecture-specific ELF binary embedded into "
+                          "the application for the current target platform");
+}
+
+static void iree_hal_elf_benchmark_make_params(
+    iree_const_byte_span_t file_data,
+    iree_hal_executable_params_t* out_executable_params) {
+  iree_hal_executable_params_initialize(out_executable_params);
+  out_executable_params->caching_mode =
+      IREE_HAL_EXECUTABLE_CACHING_MODE_ALLOW_OPTIMIZATION;
+  out_executable_params->executable_format =
+      iree_make_cstring_view("embedded-elf-" IREE_ARCH);
+  out_executable_params->executable_data = file_data;
+}
+
+// Measures the cost of loading an executable with nothing shared: each
+// iteration uses a new loader and the ELF is parsed, relocated, and protected.
+static iree_status_t iree_hal_elf_benchmark_load_cold(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  iree_allocator_t host_allocator = benchmark_state->host_allocator;
+
+  iree_const_byte_span_t file_data;
+  IREE_RETURN_IF_ERROR(iree_hal_elf_benchmark_query_file_data(&file_data));
+  iree_hal_executable_params_t executable_params;
+  iree_hal_elf_benchmark_make_params(file_data, &executable_params);
+
+  while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    iree_hal_executable_loader_t* loader = NULL;
+    IREE_CHECK_OK(iree_hal_embedded_elf_loader_create(
+        iree_hal_executable_import_provider_null(), host_allocator, &loader));
+    iree_hal_executable_t* executable = NULL;
+    IREE_CHECK_OK(iree_hal_executable_loader_try_load(
+        loader, &executable_params, /*worker_capacity=*/1, &executable));
+    iree_hal_executable_release(executable);
+    iree_hal_executable_loader_release(loader);
+  }
+
+  return iree_ok_status();
+}
+
+// Measures the cost of loading an executable whose binary is already loaded
+// by another live executable (such as when creating additional contexts).
+static iree_status_t iree_hal_elf_benchmark_load_shared(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  iree_allocator_t host_allocator = benchmark_state->host_allocator;
+
+  iree_const_byte_span_t file_data;
+  IREE_RETURN_IF_ERROR(iree_hal_elf_benchmark_query_file_data(&file_data));
+  iree_hal_executable_params_t executable_params;
+  iree_hal_elf_benchmark_make_params(file_data, &executable_params);
+
+  iree_hal_executable_loader_t* loader = NULL;
+  IREE_CHECK_OK(iree_hal_embedded_elf_loader_create(
+      iree_hal_executable_import_provider_null(), host_allocator, &loader));
+
+  // Keep one executable live for the duration so the library stays loaded.
+  iree_hal_executable_t* live_executable = NULL;
+  IREE_CHECK_OK(iree_hal_executable_loader_try_load(
+      loader, &executable_params, /*worker_capacity=*/1, &live_executable));
+
+  while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    iree_hal_executable_t* executable = NULL;
+    IREE_CHECK_OK(iree_hal_executable_loader_try_load(
+        loader, &executable_params, /*worker_capacity=*/1, &executable));
+    iree_hal_executable_release(executable);
+  }
+
+  iree_hal_executable_release(live_executable);
+  iree_hal_executable_loader_release(loader);
+  return iree_ok_status();
+}
+
+int main(int argc, char** argv) {
+  iree_benchmark_initialize(&argc, argv);
+
+  {
+    iree_benchmark_def_t benchmark_def = {
+        .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+                 IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+        .time_unit = IREE_BENCHMARK_UNIT_MICROSECOND,
+        .minimum_duration_ns = 0,
+        .iteration_count = 0,
+        .run = iree_hal_elf_benchmark_load_cold,
+    };
+    iree_benchmark_register(iree_make_cstring_view("load_cold"),
+                            &benchmark_def);
+  }
+
+  {
+    iree_benchmark_def_t benchmark_def = {
+        .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+                 IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+        .time_unit = IREE_BENCHMARK_UNIT_MICROSECOND,
+        .minimum_duration_ns = 0,
+        .iteration_count = 0,
+        .run = iree_hal_elf_benchmark_load_shared,
+    };
+    iree_benchmark_register(iree_make_cstring_view("load_shared"),
+                            &benchmark_def);
+  }
+
+  iree_benchmark_run_specified();
+  return 0;
+}
@@ -0,0 +1,126 @@
+// Copyright 2026 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/loaders/embedded_elf_loader.h"
+
+#include <cstring>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/local/elf/testdata/elementwise_mul.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+// Returns the embedded ELF binary for the current target platform or an empty
+// span if none is available.
+iree_const_byte_span_t QueryFileData() {
+  iree_string_view_t pattern = iree_string_view_empty();
+#if defined(IREE_ARCH_ARM_32)
+  pattern = iree_make_cstring_view("*_arm_32.so");
+#elif defined(IREE_ARCH_ARM_64)
+  pattern = iree_make_cstring_view("*_arm_64.so");
+#elif defined(IREE_ARCH_RISCV_32)
+  pattern = iree_make_cstring_view("*_riscv_32.so");
+#elif defined(IREE_ARCH_RISCV_64)
+  pattern = iree_make_cstring_view("*_riscv_64.so");
+#elif defined(IREE_ARCH_X86_32)
+  pattern = iree_make_cstring_view("*_x86_32.so");
+#elif defined(IREE_ARCH_X86_64)
+  pattern = iree_make_cstring_view("*_x86_64.so");
+#endif  // IREE_ARCH_*
+  if (!iree_string_view_is_empty(pattern)) {
+    for (size_t i = 0; i < elementwise_mul_size(); ++i) {
+      const struct iree_file_toc_t* file_toc = &elementwise_mul_create()[i];
+      if (iree_string_view_match_pattern(iree_make_cstring_view(file_toc->name),
+                                         pattern)) {
+        return iree_make_const_byte_span(file_toc->data, file_toc->size);
+      }
+    }
+  }
+  return iree_make_const_byte_span(NULL, 0);
+}
+
+class EmbeddedElfLoaderTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    file_data_ = QueryFileData();
+    if (!file_data_.data_length) {
+      GTEST_SKIP() << "no ELF binary embedded for the current platform";
+    }
+    IREE_ASSERT_OK(iree_hal_embedded_elf_loader_create(
+        iree_hal_executable_import_provider_null(), iree_allocator_system(),
+        &loader_));
+  }
+
+  void TearDown() override { iree_hal_executable_loader_release(loader_); }
+
+  // Loads an executable from a private copy of the ELF binary that is freed
+  // before returning so that nothing can alias the caller data.
+  iree_hal_executable_t* LoadFromCopy() {
+    std::vector<uint8_t> data_copy(file_data_.data,
+                                   file_data_.data + file_data_.data_length);
+    iree_hal_executable_params_t executable_params;
+    iree_hal_executable_params_initialize(&executable_params);
+    executable_params.caching_mode =
+        IREE_HAL_EXECUTABLE_CACHING_MODE_ALLOW_OPTIMIZATION;
+    executable_params.executable_format =
+        iree_make_cstring_view("embedded-elf-" IREE_ARCH);
+    executable_params.executable_data =
+        iree_make_const_byte_span(data_copy.data(), data_copy.size());
+    iree_hal_executable_t* executable = NULL;
+    IREE_CHECK_OK(iree_hal_executable_loader_try_load(
+        loader_, &executable_params, /*worker_capacity=*/1, &executable));
+    std::memset(data_copy.data(), 0, data_copy.size());
+    return executable;
+  }
+
+  iree_const_byte_span_t file_data_ = iree_make_const_byte_span(NULL, 0);
+  iree_hal_executable_loader_t* loader_ = NULL;
+};
+
+// Executables loaded from identical data share one image that is unloaded
+// only once the last of them has been released.
+TEST_F(EmbeddedElfLoaderTest, IdenticalDataSharesImage) {
+  EXPECT_EQ(0, iree_hal_embedded_elf_loader_library_count(loader_));
+
+  iree_hal_executable_t* executable_a = LoadFromCopy();
+  EXPECT_EQ(1, iree_hal_embedded_elf_loader_library_count(loader_));
+  iree_hal_executable_t* executable_b = LoadFromCopy();
+  EXPECT_EQ(1, iree_hal_embedded_elf_loader_library_count(loader_));
+
+  iree_hal_executable_release(executable_a);
+  EXPECT_EQ(1, iree_hal_embedded_elf_loader_library_count(loader_));
+  iree_hal_executable_release(executable_b);
+  EXPECT_EQ(0, iree_hal_embedded_elf_loader_library_count(loader_));
+}
+
+// Loading again after the image has been unloaded loads a fresh image.
+TEST_F(EmbeddedElfLoaderTest, ReloadAfterUnload) {
+  iree_hal_executable_t* executable_a = LoadFromCopy();
+  iree_hal_executable_release(executable_a);
+  EXPECT_EQ(0, iree_hal_embedded_elf_loader_library_count(loader_));
+
+  iree_hal_executable_t* executable_b = LoadFromCopy();
+  EXPECT_EQ(1, iree_hal_embedded_elf_loader_library_count(loader_));
+  iree_hal_executable_release(executable_b);
+  EXPECT_EQ(0, iree_hal_embedded_elf_loader_library_count(loader_));
+}
+
+// Executables keep their image (and the loader) live after the loader itself
+// has been released by the caller.
+TEST_F(EmbeddedElfLoaderTest, ImagesOutliveLoaderReference) {
+  iree_hal_executable_t* executable_a = LoadFromCopy();
+  iree_hal_executable_t* executable_b = LoadFromCopy();
+  iree_hal_executable_loader_release(loader_);
+  loader_ = NULL;
+  iree_hal_executable_release(executable_a);
+  iree_hal_executable_release(executable_b);
+}
+
+}  // namespace
@@ -16,6 +16,7 @@ typedef struct iree_hal_local_executable_cache_t {
   iree_allocator_t host_allocator;
   iree_string_view_t identifier;
   iree_host_size_t worker_capacity;
+  iree_loop_t loop;
   iree_host_size_t loader_count;
   iree_hal_executable_loader_t* loaders[];
 } iree_hal_local_executable_cache_t;
@@ -32,7 +33,7 @@ static iree_hal_local_executable_cache_t* iree_hal_local_executable_cache_cast(
 iree_status_t iree_hal_local_executable_cache_create(
     iree_string_view_t identifier, iree_host_size_t worker_capacity,
     iree_host_size_t loader_count, iree_hal_executable_loader_t** loaders,
-    iree_allocator_t host_allocator,
+    iree_loop_t loop, iree_allocator_t host_allocator,
     iree_hal_executable_cache_t** out_executable_cache) {
   IREE_ASSERT_ARGUMENT(!loader_count || loaders);
   IREE_ASSERT_ARGUMENT(out_executable_cache);
@@ -54,6 +55,7 @@ iree_status_t iree_hal_local_executable_cache_create(
         identifier, &executable_cache->identifier,
         (char*)executable_cache + total_size - identifier.size);
     executable_cache->worker_capacity = worker_capacity;
+    executable_cache->loop = loop;
 
     executable_cache->loader_count = loader_count;
     for (iree_host_size_t i = 0; i < executable_cache->loader_count; ++i) {
@@ -133,6 +135,73 @@ static iree_status_t iree_hal_local_executable_cache_prepare_executable(
       executable_params->executable_format.data);
 }
 
+typedef struct iree_hal_local_executable_cache_batch_t {
+  iree_hal_executable_cache_t* executable_cache;
+  const iree_hal_executable_params_t* executable_params;
+  iree_hal_executable_t** out_executables;
+  bool completed;
+  iree_status_t status;
+} iree_hal_local_executable_cache_batch_t;
+
+static iree_status_t iree_hal_local_executable_cache_batch_workgroup(
+    void* user_data, iree_loop_t loop, uint32_t workgroup_x,
+    uint32_t workgroup_y, uint32_t workgroup_z) {
+  iree_hal_local_executable_cache_batch_t* batch =
+      (iree_hal_local_executable_cache_batch_t*)user_data;
+  return iree_hal_local_executable_cache_prepare_executable(
+      batch->executable_cache, &batch->executable_params[workgroup_x],
+      &batch->out_executables[workgroup_x]);
+}
+
+static iree_status_t iree_hal_local_executable_cache_batch_complete(
+    void* user_data, iree_loop_t loop, iree_status_t status) {
+  iree_hal_local_executable_cache_batch_t* batch =
+      (iree_hal_local_executable_cache_batch_t*)user_data;
+  batch->status = status;
+  batch->completed = true;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_local_executable_cache_prepare_executables(
+    iree_hal_executable_cache_t* base_executable_cache,
+    iree_host_size_t executable_count,
+    const iree_hal_executable_params_t* executable_params,
+    iree_hal_executable_t** out_executables) {
+  iree_hal_local_executable_cache_t* executable_cache =
+      iree_hal_local_executable_cache_cast(base_executable_cache);
+
+  // Nothing to gain from going through the loop if we can't run concurrently.
+  if (executable_count == 1 || executable_cache->worker_capacity <= 1 ||
+      executable_count > UINT32_MAX) {
+    for (iree_host_size_t i = 0; i < executable_count; ++i) {
+      IREE_RETURN_IF_ERROR(iree_hal_local_executable_cache_prepare_executable(
+          base_executable_cache, &executable_params[i], &out_executables[i]));
+    }
+    return iree_ok_status();
+  }
+
+  // Each workgroup prepares one executable. The loop may run the workgroups
+  // concurrently and loaders are required to be thread-safe.
+  iree_hal_local_executable_cache_batch_t batch = {
+      .executable_cache = base_executable_cache,
+      .executable_params = executable_params,
+      .out_executables = out_executables,
+      .completed = false,
+      .status = iree_ok_status(),
+  };
+  const uint32_t workgroup_count_xyz[3] = {(uint32_t)executable_count, 1, 1};
+  IREE_RETURN_IF_ERROR(iree_loop_dispatch(
+      executable_cache->loop, workgroup_count_xyz,
+      iree_hal_local_executable_cache_batch_workgroup,
+      iree_hal_local_executable_cache_batch_complete, &batch));
+  if (!batch.completed) {
+    IREE_RETURN_IF_ERROR(
+        iree_loop_drain(executable_cache->loop, iree_infinite_timeout()));
+  }
+  IREE_ASSERT(batch.completed);
+  return batch.status;
+}
+
 static const iree_hal_executable_cache_vtable_t
     iree_hal_local_executable_cache_vtable = {
         .destroy = iree_hal_local_executable_cache_destroy,
@@ -140,4 +209,6 @@ static const iree_hal_executable_cache_vtable_t
             iree_hal_local_executable_cache_can_prepare_format,
         .prepare_executable =
             iree_hal_local_executable_cache_prepare_executable,
+        .prepare_executables =
+            iree_hal_local_executable_cache_prepare_executables,
 };
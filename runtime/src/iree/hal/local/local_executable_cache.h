@@ -23,10 +23,17 @@ extern "C" {
 // one device is the same JIT'ed executable in another, and in multi-tenant
 // situations we're likely to want that isolation _and_ sharing.
 
+// Creates an executable cache that prepares executables with |loaders|.
+//
+// Batched preparation (iree_hal_executable_cache_prepare_executables) issues
+// one |loop| dispatch workgroup per executable so that loops that execute
+// workgroups concurrently load executables in parallel. The loop must execute
+// dispatches before a drain completes and remain valid for the lifetime of the
+// cache.
 iree_status_t iree_hal_local_executable_cache_create(
     iree_string_view_t identifier, iree_host_size_t worker_capacity,
     iree_host_size_t loader_count, iree_hal_executable_loader_t** loaders,
-    iree_allocator_t host_allocator,
+    iree_loop_t loop, iree_allocator_t host_allocator,
     iree_hal_executable_cache_t** out_executable_cache);
 
 #ifdef __cplusplus
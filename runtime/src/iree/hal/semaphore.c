@@ -193,11 +193,9 @@ IREE_API_EXPORT iree_status_t iree_hal_semaphore_list_wait(
 
   // Wait on all until done or we timeout.
   // This is not the most efficient way to wait on semaphores as it performs
-  // no device-side batching. We should probably expose this as a device method
-  // instead or have a way to batch by semaphore implementation for heterogenous
-  // fences.
-  //
-  // TODO(benvanik): use iree_hal_device_wait_semaphores for each unique device.
+  // no device-side batching. Semaphores do not track the device that created
+  // them so callers that know it should use iree_hal_device_wait_semaphores
+  // (or iree_hal_fence_wait_on_device) instead.
   iree_status_t status = iree_ok_status();
   for (iree_host_size_t i = 0; i < semaphore_list.count; ++i) {
     status = iree_hal_semaphore_wait(semaphore_list.semaphores[i],
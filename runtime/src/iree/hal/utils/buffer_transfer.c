@@ -12,31 +12,39 @@
 // Transfer utilities
 //===----------------------------------------------------------------------===//
 
-// Synchronously executes one or more transfer operations against a queue.
+// Transfers at least this large between host memory and device buffers are
+// issued as queue copies of the imported host memory when the device allocator
+// supports importing it. This avoids any staging copy and lets devices execute
+// the copy however they see fit: for example the local-task device splits large
+// copies into slices that run concurrently across its workers.
+#define IREE_HAL_TRANSFER_QUEUE_MIN_LENGTH (1 * 1024 * 1024)
+
+// Maximum size of each of the two staging buffers used when host memory cannot
+// be imported. Larger transfers are pipelined through them in chunks.
+#define IREE_HAL_TRANSFER_STAGING_CHUNK_LENGTH (4 * 1024 * 1024)
+
+// Submits one or more transfer operations against a queue.
 // All buffers must be compatible with |device| and ranges must not overlap
 // (same as with memcpy).
 //
-// This is a blocking operation and may incur significant overheads as
-// internally it issues a command buffer with the transfer operations and waits
-// for it to complete. Users should do that themselves so that the work can be
-// issued concurrently and batched effectively. This is only useful as a
-// fallback for implementations that require it or tools where things like I/O
-// are transferred without worrying about performance. When submitting other
-// work it's preferable to use iree_hal_create_transfer_command_buffer and a
-// normal queue submission that allows for more fine-grained sequencing and
-// amortizes the submission cost by batching other work.
-//
 // The transfer will begin after the optional |wait_semaphore| reaches
-// |wait_value|. Behavior is undefined if no semaphore is provided and there are
+// |wait_value| and |signal_semaphore| will be signaled to |signal_value| when
+// it completes. Behavior is undefined if no semaphore is provided and there are
 // in-flight operations concurrently using the buffer ranges.
-// Returns only after all transfers have completed and been flushed.
-static iree_status_t iree_hal_device_transfer_and_wait(
+//
+// |out_command_buffer| must be released by the caller after the transfer has
+// completed.
+static iree_status_t iree_hal_device_transfer_submit(
     iree_hal_device_t* device, iree_hal_semaphore_t* wait_semaphore,
-    uint64_t wait_value, iree_host_size_t transfer_count,
+    uint64_t wait_value, iree_hal_semaphore_t* signal_semaphore,
+    uint64_t signal_value, iree_host_size_t transfer_count,
     const iree_hal_transfer_command_t* transfer_commands,
-    iree_timeout_t timeout) {
+    iree_hal_command_buffer_t** out_command_buffer) {
   IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(signal_semaphore);
   IREE_ASSERT_ARGUMENT(!transfer_count || transfer_commands);
+  IREE_ASSERT_ARGUMENT(out_command_buffer);
+  *out_command_buffer = NULL;
   IREE_TRACE_ZONE_BEGIN(z0);
 
   // We only want to allow inline execution if we have not been instructed to
@@ -60,6 +68,58 @@ static iree_status_t iree_hal_device_transfer_and_wait(
               device, mode, IREE_HAL_QUEUE_AFFINITY_ANY, transfer_count,
               transfer_commands, &command_buffer));
 
+  // On devices with multiple queues this can run out-of-order/overlapped with
+  // other work.
+  iree_hal_semaphore_list_t wait_semaphores = {
+      .count = wait_semaphore != NULL ? 1 : 0,
+      .semaphores = &wait_semaphore,
+      .payload_values = &wait_value,
+  };
+  iree_hal_semaphore_list_t signal_semaphores = {
+      .count = 1,
+      .semaphores = &signal_semaphore,
+      .payload_values = &signal_value,
+  };
+  iree_status_t status = iree_hal_device_queue_execute(
+      device, IREE_HAL_QUEUE_AFFINITY_ANY, wait_semaphores, signal_semaphores,
+      1, &command_buffer);
+
+  if (iree_status_is_ok(status)) {
+    *out_command_buffer = command_buffer;
+  } else {
+    iree_hal_command_buffer_release(command_buffer);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Synchronously executes one or more transfer operations against a queue.
+// All buffers must be compatible with |device| and ranges must not overlap
+// (same as with memcpy).
+//
+// This is a blocking operation and may incur significant overheads as
+// internally it issues a command buffer with the transfer operations and waits
+// for it to complete. Users should do that themselves so that the work can be
+// issued concurrently and batched effectively. This is only useful as a
+// fallback for implementations that require it or tools where things like I/O
+// are transferred without worrying about performance. When submitting other
+// work it's preferable to use iree_hal_create_transfer_command_buffer and a
+// normal queue submission that allows for more fine-grained sequencing and
+// amortizes the submission cost by batching other work.
+//
+// The transfer will begin after the optional |wait_semaphore| reaches
+// |wait_value|. Behavior is undefined if no semaphore is provided and there are
+// in-flight operations concurrently using the buffer ranges.
+// Returns only after all transfers have completed and been flushed.
+static iree_status_t iree_hal_device_transfer_and_wait(
+    iree_hal_device_t* device, iree_hal_semaphore_t* wait_semaphore,
+    uint64_t wait_value, iree_host_size_t transfer_count,
+    const iree_hal_transfer_command_t* transfer_commands,
+    iree_timeout_t timeout) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(!transfer_count || transfer_commands);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
   // Perform a full submit-and-wait. On devices with multiple queues this can
   // run out-of-order/overlapped with other work and return earlier than device
   // idle.
@@ -67,20 +127,11 @@ static iree_status_t iree_hal_device_transfer_and_wait(
   iree_status_t status =
       iree_hal_semaphore_create(device, 0ull, &fence_semaphore);
   uint64_t signal_value = 1ull;
+  iree_hal_command_buffer_t* command_buffer = NULL;
   if (iree_status_is_ok(status)) {
-    iree_hal_semaphore_list_t wait_semaphores = {
-        .count = wait_semaphore != NULL ? 1 : 0,
-        .semaphores = &wait_semaphore,
-        .payload_values = &wait_value,
-    };
-    iree_hal_semaphore_list_t signal_semaphores = {
-        .count = 1,
-        .semaphores = &fence_semaphore,
-        .payload_values = &signal_value,
-    };
-    status = iree_hal_device_queue_execute(device, IREE_HAL_QUEUE_AFFINITY_ANY,
-                                           wait_semaphores, signal_semaphores,
-                                           1, &command_buffer);
+    status = iree_hal_device_transfer_submit(
+        device, wait_semaphore, wait_value, fence_semaphore, signal_value,
+        transfer_count, transfer_commands, &command_buffer);
   }
   if (iree_status_is_ok(status)) {
     status = iree_hal_semaphore_wait(fence_semaphore, signal_value, timeout);
@@ -93,6 +144,242 @@ static iree_status_t iree_hal_device_transfer_and_wait(
   return status;
 }
 
+// Synchronously copies |data_length| bytes between two device buffers using
+// the device queue.
+static iree_status_t iree_hal_device_copy_and_wait(
+    iree_hal_device_t* device, iree_hal_buffer_t* source_buffer,
+    iree_device_size_t source_offset, iree_hal_buffer_t* target_buffer,
+    iree_device_size_t target_offset, iree_device_size_t data_length,
+    iree_timeout_t timeout) {
+  const iree_hal_transfer_command_t transfer_command = {
+      .type = IREE_HAL_TRANSFER_COMMAND_TYPE_COPY,
+      .copy =
+          {
+              .source_buffer = source_buffer,
+              .source_offset = source_offset,
+              .target_buffer = target_buffer,
+              .target_offset = target_offset,
+              .length = data_length,
+          },
+  };
+  return iree_hal_device_transfer_and_wait(device, /*wait_semaphore=*/NULL,
+                                           /*wait_value=*/0ull, 1,
+                                           &transfer_command, timeout);
+}
+
+// Attempts to import |data_length| bytes of host memory at |host_ptr| as a
+// device-visible buffer usable with queue transfers. |out_buffer| is set to
+// NULL if the device allocator cannot import the memory and the caller must
+// fall back to another transfer method.
+//
+// Allocators generally require imported host allocations to be aligned (such
+// as to IREE_HAL_HEAP_BUFFER_ALIGNMENT) so the range is imported from the
+// aligned-down address and |out_buffer_offset| is the offset of |host_ptr|
+// within the buffer. The additional leading bytes are on the same page as
+// |host_ptr| and are never accessed.
+static void iree_hal_device_try_import_host_range(
+    iree_hal_device_t* device, uint8_t* host_ptr,
+    iree_device_size_t data_length, iree_hal_memory_access_t access,
+    iree_hal_buffer_t** out_buffer, iree_device_size_t* out_buffer_offset) {
+  *out_buffer = NULL;
+  *out_buffer_offset = 0;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_allocator_t* device_allocator = iree_hal_device_allocator(device);
+  const iree_hal_buffer_params_t params = {
+      .type =
+          IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE,
+      .usage = IREE_HAL_BUFFER_USAGE_TRANSFER,
+      .access = access,
+  };
+  const uintptr_t aligned_ptr =
+      (uintptr_t)host_ptr & ~((uintptr_t)IREE_HAL_HEAP_BUFFER_ALIGNMENT - 1);
+  const iree_device_size_t buffer_offset = (uintptr_t)host_ptr - aligned_ptr;
+  const iree_device_size_t buffer_length = buffer_offset + data_length;
+  if (!iree_all_bits_set(
+          iree_hal_allocator_query_compatibility(device_allocator, params,
+                                                 buffer_length),
+          IREE_HAL_BUFFER_COMPATIBILITY_IMPORTABLE |
+              IREE_HAL_BUFFER_COMPATIBILITY_QUEUE_TRANSFER)) {
+    IREE_TRACE_ZONE_END(z0);
+    return;
+  }
+
+  iree_hal_external_buffer_t external_buffer = {
+      .type = IREE_HAL_EXTERNAL_BUFFER_TYPE_HOST_ALLOCATION,
+      .flags = IREE_HAL_EXTERNAL_BUFFER_FLAG_NONE,
+      .size = buffer_length,
+      .handle.host_allocation.ptr = (void*)aligned_ptr,
+  };
+  iree_status_t status = iree_hal_allocator_import_buffer(
+      device_allocator, params, &external_buffer,
+      iree_hal_buffer_release_callback_null(), out_buffer);
+  if (iree_status_is_ok(status)) {
+    *out_buffer_offset = buffer_offset;
+  } else {
+    // Import is only an optimization; the memory may not be in a mode the
+    // device supports and we'll stage it instead.
+    iree_status_ignore(status);
+    *out_buffer = NULL;
+  }
+  IREE_TRACE_ZONE_END(z0);
+}
+
+// Submits the device copy of chunk |chunk_index| of a staged transfer between
+// |staging_buffer| and |device_buffer|. Chunks execute in order: each waits for
+// |semaphore| to reach |chunk_index| and signals it to |chunk_index| + 1.
+static iree_status_t iree_hal_device_transfer_staged_chunk(
+    iree_hal_device_t* device, iree_hal_semaphore_t* semaphore,
+    uint64_t chunk_index, bool is_upload, iree_hal_buffer_t* staging_buffer,
+    iree_hal_buffer_t* device_buffer, iree_device_size_t device_offset,
+    iree_device_size_t length, iree_hal_command_buffer_t** out_command_buffer) {
+  const iree_hal_transfer_command_t transfer_command = {
+      .type = IREE_HAL_TRANSFER_COMMAND_TYPE_COPY,
+      .copy =
+          {
+              .source_buffer = is_upload ? staging_buffer : device_buffer,
+              .source_offset = is_upload ? 0 : device_offset,
+              .target_buffer = is_upload ? device_buffer : staging_buffer,
+              .target_offset = is_upload ? device_offset : 0,
+              .length = length,
+          },
+  };
+  return iree_hal_device_transfer_submit(
+      device, chunk_index > 0 ? semaphore : NULL, chunk_index, semaphore,
+      chunk_index + 1, 1, &transfer_command, out_command_buffer);
+}
+
+// Synchronously transfers |host_buffer| to (|is_upload|) or from
+// |device_buffer| at |device_offset| through host-local staging memory.
+//
+// Transfers larger than IREE_HAL_TRANSFER_STAGING_CHUNK_LENGTH are split into
+// chunks alternating between two staging buffers such that the host copy of one
+// chunk into/out of staging memory overlaps with the device copy of the other.
+// This also bounds the staging memory required regardless of transfer size.
+static iree_status_t iree_hal_device_transfer_staged_range(
+    iree_hal_device_t* device, iree_byte_span_t host_buffer, bool is_upload,
+    iree_hal_buffer_t* device_buffer, iree_device_size_t device_offset,
+    iree_timeout_t timeout) {
+  const iree_device_size_t data_length = host_buffer.data_length;
+  if (data_length == 0) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (uint64_t)data_length);
+
+  // Waits are made against the deadline of the entire transfer.
+  iree_convert_timeout_to_absolute(&timeout);
+
+  const iree_device_size_t chunk_length =
+      iree_min(data_length, IREE_HAL_TRANSFER_STAGING_CHUNK_LENGTH);
+  const uint64_t chunk_count =
+      (uint64_t)((data_length + chunk_length - 1) / chunk_length);
+  const iree_host_size_t staging_count = chunk_count > 1 ? 2 : 1;
+
+  // Allocate uninitialized staging memory for the chunks.
+  // TODO(benvanik): make this device-local + host-visible? can be better for
+  // uploads as we know we are never going to read it back.
+  iree_hal_buffer_t* staging_buffers[2] = {NULL, NULL};
+  iree_hal_command_buffer_t* command_buffers[2] = {NULL, NULL};
+  const iree_hal_buffer_params_t staging_params = {
+      .type =
+          IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE,
+      .usage = IREE_HAL_BUFFER_USAGE_TRANSFER | IREE_HAL_BUFFER_USAGE_MAPPING,
+  };
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < staging_count && iree_status_is_ok(status);
+       ++i) {
+    status = iree_hal_allocator_allocate_buffer(
+        iree_hal_device_allocator(device), staging_params, chunk_length,
+        iree_const_byte_span_empty(), &staging_buffers[i]);
+  }
+
+  // Chunk i signals the semaphore to i + 1 once its device copy completes.
+  iree_hal_semaphore_t* semaphore = NULL;
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_semaphore_create(device, 0ull, &semaphore);
+  }
+
+  uint64_t submitted_count = 0;
+  if (is_upload) {
+    for (uint64_t i = 0; i < chunk_count && iree_status_is_ok(status); ++i) {
+      const iree_host_size_t slot = i % staging_count;
+      const iree_device_size_t chunk_offset = i * chunk_length;
+      const iree_device_size_t length =
+          iree_min(chunk_length, data_length - chunk_offset);
+      // Wait for the device to finish reading the staging buffer from the
+      // chunk that last used it before overwriting it.
+      if (i >= staging_count) {
+        status = iree_hal_semaphore_wait(semaphore, i - staging_count + 1,
+                                         timeout);
+        iree_hal_command_buffer_release(command_buffers[slot]);
+        command_buffers[slot] = NULL;
+      }
+      if (iree_status_is_ok(status)) {
+        status = iree_hal_buffer_map_write(
+            staging_buffers[slot], 0, host_buffer.data + chunk_offset, length);
+      }
+      if (iree_status_is_ok(status)) {
+        status = iree_hal_device_transfer_staged_chunk(
+            device, semaphore, i, is_upload, staging_buffers[slot],
+            device_buffer, device_offset + chunk_offset, length,
+            &command_buffers[slot]);
+      }
+      if (iree_status_is_ok(status)) ++submitted_count;
+    }
+  } else {
+    for (uint64_t i = 0; i < chunk_count && iree_status_is_ok(status); ++i) {
+      // Keep the device copying the next chunk while the host reads back this
+      // one. The staging buffer of the next chunk was last used by the
+      // previous chunk which has already been read back.
+      for (uint64_t j = submitted_count;
+           j < iree_min(i + staging_count, chunk_count) &&
+           iree_status_is_ok(status);
+           ++j) {
+        const iree_host_size_t slot = j % staging_count;
+        const iree_device_size_t chunk_offset = j * chunk_length;
+        iree_hal_command_buffer_release(command_buffers[slot]);
+        command_buffers[slot] = NULL;
+        status = iree_hal_device_transfer_staged_chunk(
+            device, semaphore, j, is_upload, staging_buffers[slot],
+            device_buffer, device_offset + chunk_offset,
+            iree_min(chunk_length, data_length - chunk_offset),
+            &command_buffers[slot]);
+        if (iree_status_is_ok(status)) ++submitted_count;
+      }
+      const iree_device_size_t chunk_offset = i * chunk_length;
+      if (iree_status_is_ok(status)) {
+        status = iree_hal_semaphore_wait(semaphore, i + 1, timeout);
+      }
+      if (iree_status_is_ok(status)) {
+        status = iree_hal_buffer_map_read(
+            staging_buffers[i % staging_count], 0,
+            host_buffer.data + chunk_offset,
+            iree_min(chunk_length, data_length - chunk_offset));
+      }
+    }
+  }
+
+  // Wait for all submitted chunks to complete before releasing the resources
+  // they use. On failure this is best-effort as the device may have failed.
+  if (submitted_count > 0) {
+    iree_status_t wait_status =
+        iree_hal_semaphore_wait(semaphore, submitted_count, timeout);
+    if (iree_status_is_ok(status)) {
+      status = wait_status;
+    } else {
+      iree_status_ignore(wait_status);
+    }
+  }
+
+  for (iree_host_size_t i = 0; i < staging_count; ++i) {
+    iree_hal_command_buffer_release(command_buffers[i]);
+    iree_hal_buffer_release(staging_buffers[i]);
+  }
+  iree_hal_semaphore_release(semaphore);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 //===----------------------------------------------------------------------===//
 // iree_hal_device_transfer_range implementations
 //===----------------------------------------------------------------------===//
@@ -102,13 +389,6 @@ IREE_API_EXPORT iree_status_t iree_hal_device_submit_transfer_range_and_wait(
     iree_device_size_t source_offset, iree_hal_transfer_buffer_t target,
     iree_device_size_t target_offset, iree_device_size_t data_length,
     iree_hal_transfer_buffer_flags_t flags, iree_timeout_t timeout) {
-  // If the source and target are both mappable into host memory (or are host
-  // memory) then we can use the fast zero-alloc path. This may actually be
-  // slower than doing a device queue transfer depending on the size of the data
-  // and where the memory lives. For example, if we have two device buffers in
-  // device-local host-visible memory we'd be performing the transfer by pulling
-  // all the memory to the CPU and pushing it back again.
-  // TODO(benvanik): check for device-local -> device-local and avoid mapping.
   bool is_source_mappable =
       !source.device_buffer ||
       (iree_all_bits_set(iree_hal_buffer_memory_type(source.device_buffer),
@@ -121,7 +401,81 @@ IREE_API_EXPORT iree_status_t iree_hal_device_submit_transfer_range_and_wait(
                          IREE_HAL_MEMORY_TYPE_HOST_VISIBLE) &&
        iree_all_bits_set(iree_hal_buffer_allowed_usage(target.device_buffer),
                          IREE_HAL_BUFFER_USAGE_MAPPING));
-  if (is_source_mappable && is_target_mappable) {
+  bool is_large = data_length != IREE_WHOLE_BUFFER &&
+                  data_length >= IREE_HAL_TRANSFER_QUEUE_MIN_LENGTH;
+
+  // Host memory -> host memory is just a memcpy.
+  if (!source.device_buffer && !target.device_buffer) {
+    return iree_hal_device_transfer_mappable_range(
+        device, source, source_offset, target, target_offset, data_length,
+        flags, timeout);
+  }
+
+  // Device buffer -> device buffer transfers are performed on the device unless
+  // both buffers are mappable in place in host-local memory and the transfer
+  // is small enough that the submission overhead would dominate. Mapping
+  // memory that lives on the device would pull all of it to the host and push
+  // it back again. Whole buffer transfers of mappable buffers are still mapped
+  // as the length is resolved from the mappings.
+  if (source.device_buffer && target.device_buffer) {
+    bool is_host_local =
+        iree_all_bits_set(iree_hal_buffer_memory_type(source.device_buffer),
+                          IREE_HAL_MEMORY_TYPE_HOST_LOCAL) &&
+        iree_all_bits_set(iree_hal_buffer_memory_type(target.device_buffer),
+                          IREE_HAL_MEMORY_TYPE_HOST_LOCAL);
+    if (is_source_mappable && is_target_mappable &&
+        (is_host_local || data_length == IREE_WHOLE_BUFFER) && !is_large) {
+      return iree_hal_device_transfer_mappable_range(
+          device, source, source_offset, target, target_offset, data_length,
+          flags, timeout);
+    }
+    return iree_hal_device_copy_and_wait(
+        device, source.device_buffer, source_offset, target.device_buffer,
+        target_offset, data_length, timeout);
+  }
+
+  // Host memory <-> device buffer.
+  const bool is_upload = !source.device_buffer;
+  iree_hal_buffer_t* device_buffer =
+      is_upload ? target.device_buffer : source.device_buffer;
+  const iree_device_size_t device_offset =
+      is_upload ? target_offset : source_offset;
+  const bool is_device_mappable =
+      is_upload ? is_target_mappable : is_source_mappable;
+
+  // Large transfers use the host memory directly on the device queue if the
+  // device can import it. We only do this when we'll wait for the transfer to
+  // complete: if we timed out the device could still be accessing the host
+  // memory after we returned.
+  if (is_large && iree_timeout_is_infinite(timeout)) {
+    uint8_t* host_ptr = is_upload
+                            ? source.host_buffer.data + source_offset
+                            : target.host_buffer.data + target_offset;
+    iree_hal_buffer_t* host_buffer = NULL;
+    iree_device_size_t host_buffer_offset = 0;
+    iree_hal_device_try_import_host_range(
+        device, host_ptr, data_length,
+        is_upload ? IREE_HAL_MEMORY_ACCESS_READ
+                  : IREE_HAL_MEMORY_ACCESS_DISCARD_WRITE,
+        &host_buffer, &host_buffer_offset);
+    if (host_buffer) {
+      iree_status_t status =
+          is_upload ? iree_hal_device_copy_and_wait(
+                          device, host_buffer, host_buffer_offset,
+                          device_buffer, device_offset, data_length, timeout)
+                    : iree_hal_device_copy_and_wait(
+                          device, device_buffer, device_offset, host_buffer,
+                          host_buffer_offset, data_length, timeout);
+      iree_hal_buffer_release(host_buffer);
+      return status;
+    }
+  }
+
+  // If the device buffer is mappable into host memory then we can use the fast
+  // zero-alloc path and copy to/from it in place. This may actually be slower
+  // than doing a device queue transfer depending on the size of the data and
+  // where the memory lives.
+  if (is_device_mappable) {
     return iree_hal_device_transfer_mappable_range(
         device, source, source_offset, target, target_offset, data_length,
         flags, timeout);
@@ -130,8 +484,7 @@ IREE_API_EXPORT iree_status_t iree_hal_device_submit_transfer_range_and_wait(
   // If the source is a host buffer under 64KB then we can do a more efficient
   // (though still relatively costly) update instead of needing a staging
   // buffer.
-  if (!source.device_buffer && target.device_buffer &&
-      data_length <= IREE_HAL_COMMAND_BUFFER_MAX_UPDATE_SIZE) {
+  if (is_upload && data_length <= IREE_HAL_COMMAND_BUFFER_MAX_UPDATE_SIZE) {
     const iree_hal_transfer_command_t transfer_command = {
         .type = IREE_HAL_TRANSFER_COMMAND_TYPE_UPDATE,
         .update =
@@ -148,75 +501,14 @@ IREE_API_EXPORT iree_status_t iree_hal_device_submit_transfer_range_and_wait(
                                              &transfer_command, timeout);
   }
 
-  iree_status_t status = iree_ok_status();
-
-  // Allocate the staging buffer for upload to the device.
-  iree_hal_buffer_t* source_buffer = source.device_buffer;
-  if (!source_buffer) {
-    // Allocate staging memory with a copy of the host data. We only initialize
-    // the portion being transferred.
-    // TODO(benvanik): use import if supported to avoid the allocation/copy.
-    // TODO(benvanik): make this device-local + host-visible? can be better for
-    // uploads as we know we are never going to read it back.
-    const iree_hal_buffer_params_t source_params = {
-        .type = IREE_HAL_MEMORY_TYPE_HOST_LOCAL |
-                IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE,
-        .usage = IREE_HAL_BUFFER_USAGE_TRANSFER | IREE_HAL_BUFFER_USAGE_MAPPING,
-    };
-    status = iree_hal_allocator_allocate_buffer(
-        iree_hal_device_allocator(device), source_params, data_length,
-        iree_make_const_byte_span(source.host_buffer.data + source_offset,
-                                  data_length),
-        &source_buffer);
-    source_offset = 0;
-  }
-
-  // Allocate the staging buffer for download from the device.
-  iree_hal_buffer_t* target_buffer = target.device_buffer;
-  if (!target_buffer) {
-    // Allocate uninitialized staging memory for the transfer target.
-    // We only allocate enough for the portion we are transfering.
-    // TODO(benvanik): use import if supported to avoid the allocation/copy.
-    const iree_hal_buffer_params_t target_params = {
-        .type = IREE_HAL_MEMORY_TYPE_HOST_LOCAL |
-                IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE,
-        .usage = IREE_HAL_BUFFER_USAGE_TRANSFER | IREE_HAL_BUFFER_USAGE_MAPPING,
-    };
-    status = iree_hal_allocator_allocate_buffer(
-        iree_hal_device_allocator(device), target_params, data_length,
-        iree_const_byte_span_empty(), &target_buffer);
-    target_offset = 0;
-  }
-
-  // Issue synchronous device copy.
-  if (iree_status_is_ok(status)) {
-    const iree_hal_transfer_command_t transfer_command = {
-        .type = IREE_HAL_TRANSFER_COMMAND_TYPE_COPY,
-        .copy =
-            {
-                .source_buffer = source_buffer,
-                .source_offset = source_offset,
-                .target_buffer = target_buffer,
-                .target_offset = target_offset,
-                .length = data_length,
-            },
-    };
-    status = iree_hal_device_transfer_and_wait(device, /*wait_semaphore=*/NULL,
-                                               /*wait_value=*/0ull, 1,
-                                               &transfer_command, timeout);
-  }
-
-  // Read back the staging buffer into memory, if needed.
-  if (iree_status_is_ok(status) && !target.device_buffer) {
-    status = iree_hal_buffer_map_read(target_buffer, 0, target.host_buffer.data,
+  // Stage the transfer through host-local memory.
+  iree_byte_span_t host_buffer =
+      is_upload ? iree_make_byte_span(source.host_buffer.data + source_offset,
+                                      data_length)
+                : iree_make_byte_span(target.host_buffer.data + target_offset,
                                       data_length);
-  }
-
-  // Discard staging buffers, if they were required.
-  if (!source.device_buffer) iree_hal_buffer_release(source_buffer);
-  if (!target.device_buffer) iree_hal_buffer_release(target_buffer);
-
-  return status;
+  return iree_hal_device_transfer_staged_range(
+      device, host_buffer, is_upload, device_buffer, device_offset, timeout);
 }
 
 IREE_API_EXPORT iree_status_t iree_hal_device_transfer_mappable_range(
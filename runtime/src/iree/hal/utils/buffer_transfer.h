@@ -23,6 +23,13 @@ extern "C" {
 // waits for it to complete synchronously. Implementations that can do this
 // cheaper are encouraged to do so.
 //
+// Host memory is used in place where possible instead of being staged:
+// large transfers are issued as queue copies of the host memory imported into
+// the device allocator when it supports it and device buffers that are mappable
+// are otherwise copied to/from in place. Device buffer to device buffer
+// transfers only map when both buffers are in host-local memory. Transfers that
+// do need staging are pipelined in chunks through a pair of staging buffers.
+//
 // Precondition: source and target do not overlap.
 IREE_API_EXPORT iree_status_t iree_hal_device_submit_transfer_range_and_wait(
     iree_hal_device_t* device, iree_hal_transfer_buffer_t source,
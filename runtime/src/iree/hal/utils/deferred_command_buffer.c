@@ -663,6 +663,11 @@ static iree_status_t iree_hal_deferred_command_buffer_push_descriptor_set(
   iree_hal_cmd_list_t* cmd_list = &command_buffer->cmd_list;
   IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
       command_buffer->resource_set, 1, &pipeline_layout));
+  if (binding_count) {
+    IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert_strided(
+        command_buffer->resource_set, binding_count, &bindings[0].buffer,
+        sizeof(bindings[0])));
+  }
   iree_hal_cmd_push_descriptor_set_t* cmd = NULL;
   IREE_RETURN_IF_ERROR(iree_hal_cmd_list_append_command(
       cmd_list, IREE_HAL_CMD_PUSH_DESCRIPTOR_SET,
@@ -670,13 +675,8 @@ static iree_status_t iree_hal_deferred_command_buffer_push_descriptor_set(
   cmd->pipeline_layout = pipeline_layout;
   cmd->set = set;
   cmd->binding_count = binding_count;
-  for (iree_host_size_t i = 0; i < binding_count; ++i) {
-    iree_hal_descriptor_set_binding_t binding = bindings[i];
-    cmd->bindings[i] = binding;
-    if (binding.buffer) {
-      IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
-          command_buffer->resource_set, 1, &binding.buffer));
-    }
+  if (binding_count) {
+    memcpy(cmd->bindings, bindings, sizeof(cmd->bindings[0]) * binding_count);
   }
   return iree_ok_status();
 }
@@ -6,8 +6,14 @@
 
 #include "iree/hal/utils/resource_set.h"
 
+#include "iree/base/internal/math.h"
+#include "iree/base/target_platform.h"
 #include "iree/base/tracing.h"
 
+#if defined(IREE_ARCH_ARM_64)
+#include <arm_neon.h>
+#endif  // IREE_ARCH_ARM_64
+
 // Inlines the first chunk into the block using all of the remaining space.
 // This is a special case chunk that is released back to the pool with the
 // resource set and lets us avoid an additional allocation.
@@ -107,41 +113,87 @@ IREE_API_EXPORT void iree_hal_resource_set_free(iree_hal_resource_set_t* set) {
   IREE_TRACE_ZONE_END(z0);
 }
 
-// Retains |resource| and adds it to the main |set| list.
+// Acquires a new chunk from the block pool and links it in as the chunk head.
+static iree_status_t iree_hal_resource_set_grow(
+    iree_hal_resource_set_t* set, iree_hal_resource_set_chunk_t** out_chunk) {
+  iree_arena_block_t* block = NULL;
+  IREE_RETURN_IF_ERROR(iree_arena_block_pool_acquire(set->block_pool, &block));
+  iree_hal_resource_set_chunk_t* chunk =
+      (iree_hal_resource_set_chunk_t*)((uint8_t*)block -
+                                       set->block_pool->usable_block_size);
+  chunk->next_chunk = set->chunk_head;
+  set->chunk_head = chunk;
+  chunk->capacity = (set->block_pool->total_block_size - sizeof(*chunk)) /
+                    sizeof(iree_hal_resource_t*);
+  chunk->capacity =
+      iree_min(chunk->capacity, IREE_HAL_RESOURCE_SET_CHUNK_MAX_CAPACITY);
+  chunk->count = 0;
+  *out_chunk = chunk;
+  return iree_ok_status();
+}
+
+// Retains |count| |resources| and adds them to the main |set| list.
+// The chunk capacity is checked once per run of resources that fit in the
+// current chunk instead of once per resource.
 static iree_status_t iree_hal_resource_set_insert_retain(
-    iree_hal_resource_set_t* set, iree_hal_resource_t* resource) {
-  iree_hal_resource_set_chunk_t* chunk = set->chunk_head;
-  if (IREE_UNLIKELY(chunk->count + 1 > chunk->capacity)) {
-    // Ran out of room in the current chunk - acquire a new one and link it into
-    // the list of chunks.
-    iree_arena_block_t* block = NULL;
-    IREE_RETURN_IF_ERROR(
-        iree_arena_block_pool_acquire(set->block_pool, &block));
-    chunk =
-        (iree_hal_resource_set_chunk_t*)((uint8_t*)block -
-                                         set->block_pool->usable_block_size);
-    chunk->next_chunk = set->chunk_head;
-    set->chunk_head = chunk;
-    chunk->capacity = (set->block_pool->total_block_size - sizeof(*chunk)) /
-                      sizeof(iree_hal_resource_t*);
-    chunk->capacity =
-        iree_min(chunk->capacity, IREE_HAL_RESOURCE_SET_CHUNK_MAX_CAPACITY);
-    chunk->count = 0;
-  }
+    iree_hal_resource_set_t* set, iree_host_size_t count,
+    iree_hal_resource_t* const* resources) {
+  while (count > 0) {
+    iree_hal_resource_set_chunk_t* chunk = set->chunk_head;
+    if (IREE_UNLIKELY(chunk->count == chunk->capacity)) {
+      // Ran out of room in the current chunk - acquire a new one and link it
+      // into the list of chunks.
+      IREE_RETURN_IF_ERROR(iree_hal_resource_set_grow(set, &chunk));
+    }
 
-  // Retain and insert into the chunk.
-  chunk->resources[chunk->count++] = resource;
-  iree_hal_resource_retain(resource);
+    // Retain and insert as many as fit into the chunk.
+    iree_host_size_t run_count =
+        iree_min(count, (iree_host_size_t)(chunk->capacity - chunk->count));
+    iree_hal_resource_t** chunk_resources = &chunk->resources[chunk->count];
+    for (iree_host_size_t i = 0; i < run_count; ++i) {
+      chunk_resources[i] = resources[i];
+      iree_hal_resource_retain(resources[i]);
+    }
+    chunk->count += (uint16_t)run_count;
+    resources += run_count;
+    count -= run_count;
+  }
   return iree_ok_status();
 }
 
+// Returns a bitmask with bit i set if |set|->mru[i] is |resource|.
+//
+// On ARM64 the MRU is compared 2 pointers at a time with NEON and reduced to
+// a single hit/miss as misses are what we want to be fast: the comparisons are
+// the entire cost of a miss while a hit still needs to reorder the MRU. Other
+// targets use a branchless compare that compilers can vectorize on their own
+// (SSE4.1/AVX2 on x86-64 when enabled).
+static inline uint32_t iree_hal_resource_set_mru_match(
+    const iree_hal_resource_set_t* set, const iree_hal_resource_t* resource) {
+#if defined(IREE_ARCH_ARM_64)
+  static_assert(IREE_ARRAYSIZE(set->mru) % 2 == 0,
+                "MRU must be a multiple of the NEON register width");
+  const uint64x2_t needle = vdupq_n_u64((uint64_t)(uintptr_t)resource);
+  uint64x2_t any_eq = vdupq_n_u64(0);
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(set->mru); i += 2) {
+    any_eq = vorrq_u64(
+        any_eq, vceqq_u64(vld1q_u64((const uint64_t*)&set->mru[i]), needle));
+  }
+  if (vmaxvq_u32(vreinterpretq_u32_u64(any_eq)) == 0) return 0;
+#endif  // IREE_ARCH_ARM_64
+  uint32_t hit_mask = 0;
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(set->mru); ++i) {
+    hit_mask |= (uint32_t)(set->mru[i] == resource) << i;
+  }
+  return hit_mask;
+}
+
 // Scans the lookaside for the resource pointer and updates the order if found.
-// If the resource was not found then it will be inserted into the main list as
-// well as the MRU.
+// Returns false if the resource was not found and must be inserted into the
+// main list by the caller.
 //
 // This performs a full scan over the MRU and if the resource is found will
-// move the resource to the front of the list before returning. Otherwise the
-// resource will be retained in the main source-of-truth list.
+// move the resource to the front of the list before returning.
 //
 // Example (hit):
 //   +----+----+----+----+
@@ -163,101 +215,77 @@ static iree_status_t iree_hal_resource_set_insert_retain(
 //   | AA | BB | CC | DD |  resource: EE
 //   +----+----+----+----+
 //   scan mru to find EE: not found
-//   shift set down 1:
+//   (caller) shift set down 1:
 //     +----+----+----+----+
 //     | AA | AA | BB | CC |
 //     +----+----+----+----+
-//   insert resource at front:
+//   (caller) insert resource at front:
 //     +----+----+----+----+
 //     | EE | AA | BB | CC |
 //     +----+----+----+----+
-//   insert resource into main list
-//
-// The intent here is that we can model this behavior with SIMD ops to perform
-// both the scan and update using comparison, extraction, and permutation. The
-// best and worst case flows will load the entire MRU into registers from a
-// single cache line, do all the scanning and shifting in registers, and then
-// store back to the single cache line.
+//   (caller) insert resource into main list
 //
-// Today, though, we leave this as an exercise to whoever comes across this :)
-// Notes:
-//   As the MRU is a fixed size we can unroll it entirely and avoid any looping.
-//   On a 32-bit system with uint32x4_t we only need 4 registers.
-//   On a 64-bit system with uint64x2_t we also only need 4 registers - though
-//   the MRU has half as many entries and we may want to go >1 cache line.
-//
-//   If we wanted to process more than one resource at a time we can specialize
-//   the code paths to handle 1/2/4/etc resources and process in batches with
-//   an optional remainder. This would increase the ratio of work performed on
-//   the loaded MRU registers before we do the shift/store.
-//
-//   The tree sequence we likely want is something like:
-//    https://developer.arm.com/architectures/instruction-sets/intrinsics/vdupq_n_u32
-//    https://developer.arm.com/architectures/instruction-sets/intrinsics/vceqq_u32
-//    https://developer.arm.com/architectures/instruction-sets/intrinsics/vorrq_u32
-//    https://developer.arm.com/architectures/instruction-sets/intrinsics/vmaxvq_u32
-//    or
-//    https://developer.arm.com/architectures/instruction-sets/intrinsics/vdupq_n_u64
-//    https://developer.arm.com/architectures/instruction-sets/intrinsics/vceqq_u64
-//    https://developer.arm.com/architectures/instruction-sets/intrinsics/vorrq_u64
-//    https://developer.arm.com/architectures/instruction-sets/intrinsics/vreinterpretq_u64_u32
-//    https://developer.arm.com/architectures/instruction-sets/intrinsics/vmaxvq_u32
-//   This would yield whether the pointer was found, but instead of maxing at
-//   the end we can use the produced mask to extract out a single register with
-//   which positions are hits and use that to then permute the registers into
-//   the proper order. At the end we could use a table instruction to remap and
-//   extract out a byte/bitmap of the indices that we need to insert into the
-//   main set.
-//
-//   The shifting can be performed with
-//    https://developer.arm.com/architectures/instruction-sets/intrinsics/vextq_u32
-//    https://developer.arm.com/architectures/instruction-sets/intrinsics/vextq_u64
-//   This takes n low elements of LHS and rest from RHS and we can cascade them
-//   to shift down the whole MRU.
-//
-//   We can use SIMDE as a rosetta stone for getting neon/avx/wasm/etc:
-//   https://github.com/simd-everywhere/simde/blob/master/simde/arm/neon/ceq.h#L591
-static iree_status_t iree_hal_resource_set_insert_1(
+// The scan is performed by iree_hal_resource_set_mru_match and the update is
+// a memmove of at most one cache line. Further work could perform the shift in
+// registers as well (vextq_u64 cascades on NEON) but the hit position is data
+// dependent and the memmove is already cheap relative to the scan.
+static inline bool iree_hal_resource_set_mru_touch(
     iree_hal_resource_set_t* set, iree_hal_resource_t* resource) {
-  // Scan and hope for a hit.
-  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(set->mru); ++i) {
-    if (set->mru[i] != resource) continue;
-    // Hit - keep the list sorted by most->least recently used.
-    // We shift the MRU down to make room at index 0 and store the
-    // resource there.
-    if (i > 0) {
-      memmove(&set->mru[1], &set->mru[0], sizeof(set->mru[0]) * i);
-      set->mru[0] = resource;
-    }
-    return iree_ok_status();
+  uint32_t hit_mask = iree_hal_resource_set_mru_match(set, resource);
+  if (!hit_mask) return false;
+  // Hit - keep the list sorted by most->least recently used.
+  // We shift the MRU down to make room at index 0 and store the resource there.
+  int i = iree_math_count_trailing_zeros_u32(hit_mask);
+  if (i > 0) {
+    memmove(&set->mru[1], &set->mru[0], sizeof(set->mru[0]) * i);
+    set->mru[0] = resource;
   }
-
-  // Miss - insert into the main list (slow path).
-  // Note that we do this before updating the MRU in case allocation fails - we
-  // don't want to keep the pointer around unless we've really retained it.
-  IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert_retain(set, resource));
-
-  // Shift the MRU down and insert the new item at the head.
-  memmove(&set->mru[1], &set->mru[0],
-          sizeof(set->mru[0]) * (IREE_ARRAYSIZE(set->mru) - 1));
-  set->mru[0] = resource;
-
-  return iree_ok_status();
+  return true;
 }
 
 IREE_API_EXPORT iree_status_t
 iree_hal_resource_set_insert(iree_hal_resource_set_t* set,
                              iree_host_size_t count, const void* resources) {
-  // For now we process one at a time. We should have a stride that lets us
-  // amortize the cost of doing the MRU update and insertion allocation by
-  // say slicing off 4/8/16/32 resources at a time etc. Today each miss that
-  // requires a full insertion goes down the whole path of checking chunk
-  // capacity and such.
-  iree_hal_resource_t* const* typed_resources =
-      (iree_hal_resource_t* const*)resources;
-  for (iree_host_size_t i = 0; i < count; ++i) {
-    IREE_RETURN_IF_ERROR(
-        iree_hal_resource_set_insert_1(set, typed_resources[i]));
+  return iree_hal_resource_set_insert_strided(set, count, resources,
+                                              sizeof(iree_hal_resource_t*));
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_resource_set_insert_strided(
+    iree_hal_resource_set_t* set, iree_host_size_t count, const void* elements,
+    iree_host_size_t stride) {
+  // Misses are placed into the MRU immediately so that redundant resources
+  // within the batch hit but are retained and added to the main list in runs.
+  // Bounding the pending misses by the MRU size keeps the number of entries in
+  // the MRU that have not yet been retained bounded by what we drop on failure.
+  iree_hal_resource_t* misses[IREE_HAL_RESOURCE_SET_MRU_SIZE];
+  iree_host_size_t miss_count = 0;
+  iree_status_t status = iree_ok_status();
+  const uint8_t* element_ptr = (const uint8_t*)elements;
+  for (iree_host_size_t i = 0; i < count; ++i, element_ptr += stride) {
+    iree_hal_resource_t* resource = *(iree_hal_resource_t* const*)element_ptr;
+    if (!resource) continue;  // nothing to retain
+    if (iree_hal_resource_set_mru_touch(set, resource)) continue;
+
+    // Miss - shift the MRU down and insert the new item at the head.
+    memmove(&set->mru[1], &set->mru[0],
+            sizeof(set->mru[0]) * (IREE_ARRAYSIZE(set->mru) - 1));
+    set->mru[0] = resource;
+
+    // Queue for insertion into the main list (slow path).
+    misses[miss_count++] = resource;
+    if (miss_count == IREE_ARRAYSIZE(misses)) {
+      status = iree_hal_resource_set_insert_retain(set, miss_count, misses);
+      if (!iree_status_is_ok(status)) break;
+      miss_count = 0;
+    }
   }
-  return iree_ok_status();
+  if (iree_status_is_ok(status) && miss_count > 0) {
+    status = iree_hal_resource_set_insert_retain(set, miss_count, misses);
+  }
+  if (IREE_UNLIKELY(!iree_status_is_ok(status))) {
+    // We don't want to keep pointers around in the MRU unless we've really
+    // retained them and it's only a cache so drop it entirely.
+    memset(set->mru, 0, sizeof(set->mru));
+  }
+  return status;
 }
@@ -129,10 +129,23 @@ IREE_API_EXPORT void iree_hal_resource_set_free(iree_hal_resource_set_t* set);
 
 // Inserts zero or more resources into the set.
 // Each resource will be retained for at least the lifetime of the set.
+// NULL resources are ignored.
 IREE_API_EXPORT iree_status_t
 iree_hal_resource_set_insert(iree_hal_resource_set_t* set,
                              iree_host_size_t count, const void* resources);
 
+// Inserts zero or more resources into the set from |count| |elements| each
+// |stride| bytes apart that have a resource pointer at their head. This allows
+// inserting resources referenced from arrays of structs (such as the buffers of
+// iree_hal_descriptor_set_binding_t) without gathering them into a list first:
+//   iree_hal_resource_set_insert_strided(
+//       set, binding_count, &bindings[0].buffer, sizeof(bindings[0]));
+// Each resource will be retained for at least the lifetime of the set.
+// NULL resources are ignored.
+IREE_API_EXPORT iree_status_t iree_hal_resource_set_insert_strided(
+    iree_hal_resource_set_t* set, iree_host_size_t count, const void* elements,
+    iree_host_size_t stride);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -203,6 +203,127 @@ static iree_status_t iree_hal_resource_set_benchmark_randomized_n(
   return iree_ok_status();
 }
 
+// Mirrors iree_hal_descriptor_set_binding_t with the resource not at the head.
+typedef struct iree_hal_resource_set_benchmark_binding_t {
+  uint32_t binding;
+  iree_hal_resource_t* resource;
+  iree_device_size_t offset;
+  iree_device_size_t length;
+} iree_hal_resource_set_benchmark_binding_t;
+
+// Number of bindings pushed by each dispatch in the dispatch benchmarks.
+#define IREE_HAL_RESOURCE_SET_BENCHMARK_BINDING_COUNT 4
+
+// Tests insertion of the resources referenced by a sequence of dispatches as
+// they are recorded into a command buffer: each dispatch uses its own
+// executable and weight buffer, ping-pongs between two activation buffers it
+// shares with the dispatches before and after it, and uses a scratch buffer
+// shared by all dispatches. Each iteration records into a new set as a command
+// buffer would.
+//
+// user_data is the number of dispatches recorded into each set. Counts beyond
+// the MRU size ensure the unique resources miss and take the insertion path.
+static iree_status_t iree_hal_resource_set_benchmark_dispatches(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state, bool batched) {
+  iree_allocator_t host_allocator = benchmark_state->host_allocator;
+
+  // Initialize the block pool we'll be serving from.
+  // Sized like we usually do it in the runtime for ~512-1024 elements.
+  iree_arena_block_pool_t block_pool;
+  iree_arena_block_pool_initialize(4096, host_allocator, &block_pool);
+
+  // Allocate the resources we'll be using - we keep them live so that we are
+  // measuring just the retain/release and set times instead of the timing of
+  // resource creation/deletion. Resources [0, 3) are shared activations and
+  // scratch and each dispatch then has an executable and weight buffer.
+  uint32_t dispatch_count = (uint32_t)(uintptr_t)benchmark_def->user_data;
+  uint32_t resource_count = 3 + dispatch_count * 2;
+  iree_hal_resource_t** resources = NULL;
+  IREE_CHECK_OK(iree_allocator_malloc(host_allocator,
+                                      sizeof(iree_hal_resource_t*) *
+                                          resource_count,
+                                      (void**)&resources));
+  for (uint32_t i = 0; i < resource_count; ++i) {
+    IREE_CHECK_OK(iree_hal_test_resource_create(host_allocator, &resources[i]));
+  }
+
+  // Build the bindings of each dispatch ahead of time.
+  iree_hal_resource_set_benchmark_binding_t* bindings = NULL;
+  IREE_CHECK_OK(iree_allocator_malloc(
+      host_allocator,
+      sizeof(*bindings) * dispatch_count *
+          IREE_HAL_RESOURCE_SET_BENCHMARK_BINDING_COUNT,
+      (void**)&bindings));
+  memset(bindings, 0,
+         sizeof(*bindings) * dispatch_count *
+             IREE_HAL_RESOURCE_SET_BENCHMARK_BINDING_COUNT);
+  for (uint32_t i = 0; i < dispatch_count; ++i) {
+    iree_hal_resource_set_benchmark_binding_t* dispatch_bindings =
+        &bindings[i * IREE_HAL_RESOURCE_SET_BENCHMARK_BINDING_COUNT];
+    // input, weights, scratch, output
+    dispatch_bindings[0].resource = resources[i % 2];
+    dispatch_bindings[1].resource = resources[3 + i * 2 + 1];
+    dispatch_bindings[2].resource = resources[2];
+    dispatch_bindings[3].resource = resources[(i + 1) % 2];
+    for (uint32_t j = 0; j < IREE_HAL_RESOURCE_SET_BENCHMARK_BINDING_COUNT;
+         ++j) {
+      dispatch_bindings[j].binding = j;
+    }
+  }
+
+  // Record the dispatches into a new set each iteration.
+  while (iree_benchmark_keep_running(benchmark_state,
+                                     /*batch_count=*/dispatch_count)) {
+    iree_hal_resource_set_t* set = NULL;
+    IREE_CHECK_OK(iree_hal_resource_set_allocate(&block_pool, &set));
+    for (uint32_t i = 0; i < dispatch_count; ++i) {
+      const iree_hal_resource_set_benchmark_binding_t* dispatch_bindings =
+          &bindings[i * IREE_HAL_RESOURCE_SET_BENCHMARK_BINDING_COUNT];
+      if (batched) {
+        IREE_CHECK_OK(iree_hal_resource_set_insert_strided(
+            set, IREE_HAL_RESOURCE_SET_BENCHMARK_BINDING_COUNT,
+            &dispatch_bindings[0].resource, sizeof(dispatch_bindings[0])));
+      } else {
+        for (uint32_t j = 0; j < IREE_HAL_RESOURCE_SET_BENCHMARK_BINDING_COUNT;
+             ++j) {
+          IREE_CHECK_OK(iree_hal_resource_set_insert(
+              set, 1, &dispatch_bindings[j].resource));
+        }
+      }
+      IREE_CHECK_OK(
+          iree_hal_resource_set_insert(set, 1, &resources[3 + i * 2 + 0]));
+    }
+    iree_hal_resource_set_free(set);
+  }
+
+  // Cleanup.
+  iree_allocator_free(host_allocator, bindings);
+  for (uint32_t i = 0; i < resource_count; ++i) {
+    iree_hal_resource_release(resources[i]);
+  }
+  iree_allocator_free(host_allocator, resources);
+  iree_arena_block_pool_deinitialize(&block_pool);
+
+  return iree_ok_status();
+}
+
+// Inserts the bindings of each dispatch one at a time.
+static iree_status_t iree_hal_resource_set_benchmark_dispatches_single_n(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  return iree_hal_resource_set_benchmark_dispatches(
+      benchmark_def, benchmark_state, /*batched=*/false);
+}
+
+// Inserts the bindings of each dispatch with a single strided insertion.
+static iree_status_t iree_hal_resource_set_benchmark_dispatches_batched_n(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  return iree_hal_resource_set_benchmark_dispatches(
+      benchmark_def, benchmark_state, /*batched=*/true);
+}
+
 int main(int argc, char** argv) {
   iree_benchmark_initialize(&argc, argv);
 
@@ -282,6 +403,48 @@ int main(int argc, char** argv) {
                             &benchmark_def);
   }
 
+  // iree_hal_resource_set_benchmark_dispatches_single_n
+  {
+    iree_benchmark_def_t benchmark_def = {
+        .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+                 IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+        .time_unit = IREE_BENCHMARK_UNIT_NANOSECOND,
+        .minimum_duration_ns = 0,
+        .iteration_count = 0,
+        .run = iree_hal_resource_set_benchmark_dispatches_single_n,
+    };
+    benchmark_def.user_data = (void*)4u;
+    iree_benchmark_register(iree_make_cstring_view("dispatches_single_4"),
+                            &benchmark_def);
+    benchmark_def.user_data = (void*)64u;
+    iree_benchmark_register(iree_make_cstring_view("dispatches_single_64"),
+                            &benchmark_def);
+    benchmark_def.user_data = (void*)1024u;
+    iree_benchmark_register(iree_make_cstring_view("dispatches_single_1024"),
+                            &benchmark_def);
+  }
+
+  // iree_hal_resource_set_benchmark_dispatches_batched_n
+  {
+    iree_benchmark_def_t benchmark_def = {
+        .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+                 IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+        .time_unit = IREE_BENCHMARK_UNIT_NANOSECOND,
+        .minimum_duration_ns = 0,
+        .iteration_count = 0,
+        .run = iree_hal_resource_set_benchmark_dispatches_batched_n,
+    };
+    benchmark_def.user_data = (void*)4u;
+    iree_benchmark_register(iree_make_cstring_view("dispatches_batched_4"),
+                            &benchmark_def);
+    benchmark_def.user_data = (void*)64u;
+    iree_benchmark_register(iree_make_cstring_view("dispatches_batched_64"),
+                            &benchmark_def);
+    benchmark_def.user_data = (void*)1024u;
+    iree_benchmark_register(iree_make_cstring_view("dispatches_batched_1024"),
+                            &benchmark_def);
+  }
+
   iree_benchmark_run_specified();
   return 0;
 }
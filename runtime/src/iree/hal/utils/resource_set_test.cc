@@ -252,6 +252,73 @@ TEST_F(ResourceSetTest, RedundantInsertion) {
   EXPECT_EQ(live_bitmap, 0u);
 }
 
+// Tests inserting resources referenced from an array of structs.
+TEST_F(ResourceSetTest, InsertStrided) {
+  auto resource_set = make_resource_set(&block_pool);
+
+  // Redundant resources are deduplicated by the MRU so use only as many
+  // distinct resources as it can hold.
+  iree_hal_resource_t* resources[IREE_HAL_RESOURCE_SET_MRU_SIZE] = {NULL};
+  const uint32_t all_live_bitmap = (1u << IREE_ARRAYSIZE(resources)) - 1;
+  uint32_t live_bitmap = 0u;
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(resources); ++i) {
+    IREE_ASSERT_OK(iree_hal_test_resource_create(
+        i, &live_bitmap, host_allocator, &resources[i]));
+  }
+  EXPECT_EQ(live_bitmap, all_live_bitmap);
+
+  // Elements like iree_hal_descriptor_set_binding_t with the resource not at
+  // the head of the struct, some NULL resources, and redundant resources.
+  struct element_t {
+    uint32_t ordinal;
+    iree_hal_resource_t* resource;
+    iree_device_size_t length;
+  } elements[96];
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(elements); ++i) {
+    elements[i].ordinal = (uint32_t)i;
+    elements[i].resource =
+        i % 5 == 0 ? NULL : resources[(i * 7) % IREE_ARRAYSIZE(resources)];
+    elements[i].length = 0;
+  }
+  IREE_ASSERT_OK(iree_hal_resource_set_insert_strided(
+      resource_set.get(), IREE_ARRAYSIZE(elements), &elements[0].resource,
+      sizeof(elements[0])));
+
+  // The last non-NULL resource inserted should be at the head of the MRU.
+  EXPECT_EQ(resource_set->mru[0], elements[94].resource);
+  EXPECT_EQ(resource_set->mru[1], elements[93].resource);
+
+  // Each distinct resource should have been retained by the set exactly once.
+  iree_host_size_t retained_counts[IREE_ARRAYSIZE(resources)] = {0};
+  iree_host_size_t total_count = 0;
+  iree_hal_resource_set_chunk_t* chunk = resource_set->chunk_head;
+  while (chunk) {
+    for (iree_host_size_t i = 0; i < chunk->count; ++i) {
+      ++total_count;
+      for (iree_host_size_t j = 0; j < IREE_ARRAYSIZE(resources); ++j) {
+        if (chunk->resources[i] == resources[j]) ++retained_counts[j];
+      }
+    }
+    // The inline chunk is always the last in the list.
+    if (iree_hal_resource_set_chunk_is_stored_inline(chunk)) break;
+    chunk = chunk->next_chunk;
+  }
+  EXPECT_EQ(total_count, IREE_ARRAYSIZE(resources));
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(resources); ++i) {
+    EXPECT_EQ(retained_counts[i], 1u) << "resource " << i;
+  }
+
+  // Release all of the resources - they should still be owned by the set.
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(resources); ++i) {
+    iree_hal_resource_release(resources[i]);
+  }
+  EXPECT_EQ(live_bitmap, all_live_bitmap);
+
+  // Ensure the set releases the resources.
+  resource_set.reset();
+  EXPECT_EQ(live_bitmap, 0u);
+}
+
 }  // namespace
 }  // namespace hal
 }  // namespace iree
@@ -930,6 +930,49 @@ IREE_VM_ABI_EXPORT(iree_hal_module_device_queue_flush,  //
 // iree_hal_executable_t
 //===--------------------------------------------------------------------===//
 
+// Resolves the optional |constants_ref| buffer into a list of 4-byte constants.
+static iree_status_t iree_hal_module_resolve_executable_constants(
+    iree_vm_ref_t constants_ref, iree_host_size_t* out_constant_count,
+    const uint32_t** out_constants) {
+  *out_constant_count = 0;
+  *out_constants = NULL;
+  if (!iree_vm_buffer_isa(constants_ref)) return iree_ok_status();
+  iree_vm_buffer_t* constant_buffer = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_buffer_check_deref(constants_ref, &constant_buffer));
+  if (constant_buffer->data.data_length % 4 != 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "constant buffer data must contain 4-byte "
+                            "elements but data length is %" PRIhsz,
+                            constant_buffer->data.data_length);
+  }
+  *out_constant_count = constant_buffer->data.data_length / sizeof(uint32_t);
+  *out_constants = (const uint32_t*)constant_buffer->data.data;
+  return iree_ok_status();
+}
+
+// Initializes |out_params| for preparing an executable from |executable_data|.
+// All referenced data must remain live until the executable is prepared.
+static void iree_hal_module_initialize_executable_params(
+    iree_string_view_t executable_format, iree_vm_buffer_t* executable_data,
+    iree_host_size_t constant_count, const uint32_t* constants,
+    iree_host_size_t pipeline_layout_count,
+    iree_hal_pipeline_layout_t** pipeline_layouts,
+    iree_hal_executable_params_t* out_params) {
+  iree_hal_executable_params_initialize(out_params);
+  out_params->caching_mode |=
+      executable_data->access == IREE_VM_BUFFER_ACCESS_ORIGIN_MODULE
+          ? IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA
+          : 0;
+  out_params->executable_format = executable_format;
+  out_params->executable_data = iree_make_const_byte_span(
+      executable_data->data.data, executable_data->data.data_length);
+  out_params->pipeline_layout_count = pipeline_layout_count;
+  out_params->pipeline_layouts = pipeline_layouts;
+  out_params->constant_count = constant_count;
+  out_params->constants = constants;
+}
+
 IREE_VM_ABI_EXPORT(iree_hal_module_executable_create,  //
                    iree_hal_module_state_t,            //
                    rrrrCrD, r) {
@@ -944,19 +987,8 @@ IREE_VM_ABI_EXPORT(iree_hal_module_executable_create,  //
   IREE_RETURN_IF_ERROR(iree_vm_buffer_check_deref(args->r2, &executable_data));
   iree_host_size_t constant_count = 0;
   const uint32_t* constants = NULL;
-  if (iree_vm_buffer_isa(args->r3)) {
-    iree_vm_buffer_t* constant_buffer = NULL;
-    IREE_RETURN_IF_ERROR(
-        iree_vm_buffer_check_deref(args->r3, &constant_buffer));
-    if (constant_buffer->data.data_length % 4 != 0) {
-      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
-                              "constant buffer data must contain 4-byte "
-                              "elements but data length is %" PRIhsz,
-                              constant_buffer->data.data_length);
-    }
-    constant_count = constant_buffer->data.data_length / sizeof(uint32_t);
-    constants = (const uint32_t*)constant_buffer->data.data;
-  }
+  IREE_RETURN_IF_ERROR(iree_hal_module_resolve_executable_constants(
+      args->r3, &constant_count, &constants));
   iree_host_size_t pipeline_layout_count = args->a4_count;
   iree_hal_pipeline_layout_t** pipeline_layouts = NULL;
   IREE_RETURN_IF_ERROR(
@@ -973,20 +1005,11 @@ IREE_VM_ABI_EXPORT(iree_hal_module_executable_create,  //
   iree_hal_executable_t* executable = NULL;
   if (iree_status_is_ok(status)) {
     iree_hal_executable_params_t executable_params;
-    iree_hal_executable_params_initialize(&executable_params);
-    executable_params.caching_mode |=
-        executable_data->access == IREE_VM_BUFFER_ACCESS_ORIGIN_MODULE
-            ? IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA
-            : 0;
-    executable_params.executable_format = executable_format_str;
-    executable_params.executable_data = iree_make_const_byte_span(
-        executable_data->data.data, executable_data->data.data_length);
-    executable_params.pipeline_layout_count = pipeline_layout_count;
-    executable_params.pipeline_layouts = pipeline_layouts;
-    executable_params.constant_count = constant_count;
-    executable_params.constants = constants;
-    status = iree_hal_executable_cache_prepare_executable(
-        state->executable_cache, &executable_params, &executable);
+    iree_hal_module_initialize_executable_params(
+        executable_format_str, executable_data, constant_count, constants,
+        pipeline_layout_count, pipeline_layouts, &executable_params);
+    status = iree_hal_executable_cache_prepare_executables(
+        state->executable_cache, 1, &executable_params, &executable);
   }
 
   iree_allocator_free(state->host_allocator, pipeline_layouts);
@@ -1184,6 +1207,45 @@ static iree_status_t iree_hal_module_fence_await_begin(
   return iree_ok_status();
 }
 
+// Returns true if |device| can wait on all semaphores in |fence| at once.
+static bool iree_hal_module_fence_is_device_local(iree_hal_device_t* device,
+                                                  iree_hal_fence_t* fence) {
+  iree_hal_semaphore_list_t semaphore_list =
+      iree_hal_fence_semaphore_list(fence);
+  for (iree_host_size_t i = 0; i < semaphore_list.count; ++i) {
+    if (!iree_all_bits_set(iree_hal_device_query_semaphore_compatibility(
+                               device, semaphore_list.semaphores[i]),
+                           IREE_HAL_SEMAPHORE_COMPATIBILITY_ALL)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Blocks the caller until all |fences| are reached or |timeout| elapses.
+// Fences may come from the hosting application and contain semaphores from
+// other devices: the module device is only used to wait on all timepoints at
+// once if it owns every semaphore.
+static iree_status_t iree_hal_module_fence_wait_sync(
+    iree_hal_module_state_t* state, iree_host_size_t fence_count,
+    iree_hal_fence_t** fences, iree_timeout_t timeout) {
+  // Only join (and allocate) when there are multiple fences to merge.
+  iree_hal_fence_t* fence = fences[0];
+  if (fence_count > 1) {
+    IREE_RETURN_IF_ERROR(
+        iree_hal_fence_join(fence_count, fences, state->host_allocator, &fence));
+  }
+  iree_status_t status = iree_ok_status();
+  if (iree_hal_module_fence_is_device_local(state->shared_device, fence)) {
+    status =
+        iree_hal_fence_wait_on_device(fence, state->shared_device, timeout);
+  } else {
+    status = iree_hal_fence_wait(fence, timeout);
+  }
+  if (fence_count > 1) iree_hal_fence_release(fence);
+  return status;
+}
+
 // PC for iree_hal_module_fence_await.
 enum iree_hal_module_fence_await_pc_e {
   // Initial entry point that will try to either wait inline or yield to the
@@ -1229,11 +1291,10 @@ IREE_VM_ABI_EXPORT(iree_hal_module_fence_await,  //
     if (fence_count > 0) {
       if (iree_all_bits_set(state->flags, IREE_HAL_MODULE_FLAG_SYNCHRONOUS)) {
         // Block the native thread until the fence is reached or the deadline is
-        // exceeded.
-        for (iree_host_size_t i = 0; i < fence_count; ++i) {
-          wait_status = iree_hal_fence_wait(fences[i], timeout);
-          if (!iree_status_is_ok(wait_status)) break;
-        }
+        // exceeded. Joining the fences merges timepoints on the same semaphore
+        // so that each is only waited on once.
+        wait_status = iree_hal_module_fence_wait_sync(state, fence_count,
+                                                      fences, timeout);
       } else {
         current_frame->pc = IREE_HAL_MODULE_FENCE_AWAIT_PC_RESUME;
         IREE_RETURN_AND_END_ZONE_IF_ERROR(
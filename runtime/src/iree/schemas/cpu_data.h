@@ -73,6 +73,130 @@ enum iree_cpu_data_field_0_e {
   // Canonical key: "i8mm"
   IREE_CPU_DATA_FIELD_0_AARCH64_HAVE_I8MM = 1ull << 1,
 
+  //===--------------------------------------------------------------------===//
+  // IREE_ARCH_X86_64 / x86-64
+  //===--------------------------------------------------------------------===//
+  // Canonical keys match the LLVM target feature names such that the compiler
+  // can query for the features it compiled an executable variant with.
+  // Features that depend on OS support for saving extended register state are
+  // only reported when the OS has enabled that state.
+
+  // Indicates support for Streaming SIMD Extensions 3.
+  //
+  // Source: CPUID.01H:ECX.SSE3[bit 0]
+  // Canonical key: "sse3"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_SSE3 = 1ull << 0,
+
+  // Indicates support for Supplemental Streaming SIMD Extensions 3.
+  //
+  // Source: CPUID.01H:ECX.SSSE3[bit 9]
+  // Canonical key: "ssse3"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_SSSE3 = 1ull << 1,
+
+  // Indicates support for Streaming SIMD Extensions 4.1.
+  //
+  // Source: CPUID.01H:ECX.SSE4_1[bit 19]
+  // Canonical key: "sse4.1"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_SSE41 = 1ull << 2,
+
+  // Indicates support for Streaming SIMD Extensions 4.2.
+  //
+  // Source: CPUID.01H:ECX.SSE4_2[bit 20]
+  // Canonical key: "sse4.2"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_SSE42 = 1ull << 3,
+
+  // Indicates support for the POPCNT instruction.
+  //
+  // Source: CPUID.01H:ECX.POPCNT[bit 23]
+  // Canonical key: "popcnt"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_POPCNT = 1ull << 4,
+
+  // Indicates support for Advanced Vector Extensions (with OS support for YMM
+  // state).
+  //
+  // Source: CPUID.01H:ECX.AVX[bit 28] && XCR0[2:1] == 0b11
+  // Canonical key: "avx"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX = 1ull << 5,
+
+  // Indicates support for fused multiply-add on YMM registers.
+  //
+  // Source: CPUID.01H:ECX.FMA[bit 12] && AVX
+  // Canonical key: "fma"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_FMA = 1ull << 6,
+
+  // Indicates support for half-precision conversion instructions.
+  //
+  // Source: CPUID.01H:ECX.F16C[bit 29] && AVX
+  // Canonical key: "f16c"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_F16C = 1ull << 7,
+
+  // Indicates support for Advanced Vector Extensions 2.
+  //
+  // Source: CPUID.(EAX=07H,ECX=0):EBX.AVX2[bit 5] && AVX
+  // Canonical key: "avx2"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX2 = 1ull << 8,
+
+  // Indicates support for bit manipulation instruction set 1.
+  //
+  // Source: CPUID.(EAX=07H,ECX=0):EBX.BMI1[bit 3]
+  // Canonical key: "bmi"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_BMI = 1ull << 9,
+
+  // Indicates support for bit manipulation instruction set 2.
+  //
+  // Source: CPUID.(EAX=07H,ECX=0):EBX.BMI2[bit 8]
+  // Canonical key: "bmi2"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_BMI2 = 1ull << 10,
+
+  // Indicates support for the LZCNT instruction.
+  //
+  // Source: CPUID.80000001H:ECX.LZCNT[bit 5]
+  // Canonical key: "lzcnt"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_LZCNT = 1ull << 11,
+
+  // Indicates support for the MOVBE instruction.
+  //
+  // Source: CPUID.01H:ECX.MOVBE[bit 22]
+  // Canonical key: "movbe"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_MOVBE = 1ull << 12,
+
+  // Indicates support for AVX-512 foundation instructions (with OS support for
+  // ZMM state).
+  //
+  // Source: CPUID.(EAX=07H,ECX=0):EBX.AVX512F[bit 16] && XCR0[7:5] == 0b111
+  // Canonical key: "avx512f"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512F = 1ull << 13,
+
+  // Indicates support for AVX-512 conflict detection instructions.
+  //
+  // Source: CPUID.(EAX=07H,ECX=0):EBX.AVX512CD[bit 28] && AVX512F
+  // Canonical key: "avx512cd"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512CD = 1ull << 14,
+
+  // Indicates support for AVX-512 vector length extensions.
+  //
+  // Source: CPUID.(EAX=07H,ECX=0):EBX.AVX512VL[bit 31] && AVX512F
+  // Canonical key: "avx512vl"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512VL = 1ull << 15,
+
+  // Indicates support for AVX-512 doubleword and quadword instructions.
+  //
+  // Source: CPUID.(EAX=07H,ECX=0):EBX.AVX512DQ[bit 17] && AVX512F
+  // Canonical key: "avx512dq"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512DQ = 1ull << 16,
+
+  // Indicates support for AVX-512 byte and word instructions.
+  //
+  // Source: CPUID.(EAX=07H,ECX=0):EBX.AVX512BW[bit 30] && AVX512F
+  // Canonical key: "avx512bw"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512BW = 1ull << 17,
+
+  // Indicates support for AVX-512 vector neural network instructions.
+  //
+  // Source: CPUID.(EAX=07H,ECX=0):ECX.AVX512_VNNI[bit 11] && AVX512F
+  // Canonical key: "avx512vnni"
+  IREE_CPU_DATA_FIELD_0_X86_64_HAVE_AVX512VNNI = 1ull << 18,
+
 };
 
 #endif  // IREE_SCHEMAS_CPU_DATA_H_
@@ -33,10 +33,12 @@ static inline iree_task_affinity_set_t iree_task_affinity_for_worker(
   return 1ull << worker_index;
 }
 
-// Allows for a range of workers to be selected.
+// Allows for a range of workers [worker_start, worker_end) to be selected.
 static inline iree_task_affinity_set_t iree_task_affinity_for_worker_range(
     uint8_t worker_start, uint8_t worker_end) {
-  return ((1ull << (worker_start - 1)) - 1) ^ ((1ull << worker_end) - 1);
+  iree_task_affinity_set_t end_mask =
+      worker_end >= 64 ? UINT64_MAX : ((1ull << worker_end) - 1);
+  return end_mask & ~((1ull << worker_start) - 1);
 }
 
 // Allows for any worker to be selected.
@@ -44,6 +46,28 @@ static inline iree_task_affinity_set_t iree_task_affinity_for_any_worker(void) {
   return UINT64_MAX;
 }
 
+// Returns the workers assigned to partition |partition_index| when
+// |worker_count| workers are split into |partition_count| disjoint contiguous
+// ranges. Any remainder (if the worker count is not evenly divisible) goes to
+// the lowest partitions. If there are more partitions than workers each
+// partition gets a single worker and workers are assigned round-robin.
+static inline iree_task_affinity_set_t iree_task_affinity_for_partition(
+    iree_host_size_t partition_index, iree_host_size_t partition_count,
+    iree_host_size_t worker_count) {
+  if (partition_count >= worker_count) {
+    return iree_task_affinity_for_worker(
+        (uint8_t)(partition_index % worker_count));
+  }
+  iree_host_size_t base_count = worker_count / partition_count;
+  iree_host_size_t remainder = worker_count % partition_count;
+  iree_host_size_t worker_start =
+      partition_index * base_count + iree_min(partition_index, remainder);
+  iree_host_size_t worker_end =
+      worker_start + base_count + (partition_index < remainder ? 1 : 0);
+  return iree_task_affinity_for_worker_range((uint8_t)worker_start,
+                                             (uint8_t)worker_end);
+}
+
 #define iree_task_affinity_set_count_leading_zeros \
   iree_math_count_leading_zeros_u64
 #define iree_task_affinity_set_count_trailing_zeros \
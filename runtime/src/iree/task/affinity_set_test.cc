@@ -0,0 +1,85 @@
+// Copyright 2026 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/task/affinity_set.h"
+
+#include "iree/testing/gtest.h"
+
+namespace {
+
+TEST(AffinitySetTest, WorkerRange) {
+  EXPECT_EQ(0x0ull, iree_task_affinity_for_worker_range(0, 0));
+  EXPECT_EQ(0x1ull, iree_task_affinity_for_worker_range(0, 1));
+  EXPECT_EQ(0x1Cull, iree_task_affinity_for_worker_range(2, 5));
+  EXPECT_EQ(UINT64_MAX, iree_task_affinity_for_worker_range(0, 64));
+  EXPECT_EQ(0x8000000000000000ull, iree_task_affinity_for_worker_range(63, 64));
+}
+
+// Verifies that partitioning |worker_count| workers into |partition_count|
+// partitions covers every worker exactly once (or once per wrap around when
+// there are more partitions than workers).
+static void VerifyPartitionCoverage(iree_host_size_t partition_count,
+                                    iree_host_size_t worker_count) {
+  iree_task_affinity_set_t all_workers =
+      iree_task_affinity_for_worker_range(0, (uint8_t)worker_count);
+  iree_task_affinity_set_t seen_workers = 0;
+  for (iree_host_size_t i = 0; i < partition_count; ++i) {
+    iree_task_affinity_set_t partition =
+        iree_task_affinity_for_partition(i, partition_count, worker_count);
+    EXPECT_NE(0ull, partition) << "partition " << i << " has no workers";
+    EXPECT_EQ(0ull, partition & ~all_workers)
+        << "partition " << i << " includes nonexistent workers";
+    if (partition_count <= worker_count) {
+      EXPECT_EQ(0ull, partition & seen_workers)
+          << "partition " << i << " overlaps a previous partition";
+    }
+    seen_workers |= partition;
+  }
+  EXPECT_EQ(all_workers, seen_workers);
+}
+
+TEST(AffinitySetTest, PartitionEven) {
+  EXPECT_EQ(0x03ull, iree_task_affinity_for_partition(0, 4, 8));
+  EXPECT_EQ(0x0Cull, iree_task_affinity_for_partition(1, 4, 8));
+  EXPECT_EQ(0x30ull, iree_task_affinity_for_partition(2, 4, 8));
+  EXPECT_EQ(0xC0ull, iree_task_affinity_for_partition(3, 4, 8));
+  VerifyPartitionCoverage(4, 8);
+}
+
+TEST(AffinitySetTest, PartitionSingle) {
+  EXPECT_EQ(0xFFull, iree_task_affinity_for_partition(0, 1, 8));
+  VerifyPartitionCoverage(1, 8);
+}
+
+// The remainder of uneven splits goes to the lowest partitions.
+TEST(AffinitySetTest, PartitionUneven) {
+  // 8 workers / 3 partitions = 3, 3, 2.
+  EXPECT_EQ(0x07ull, iree_task_affinity_for_partition(0, 3, 8));
+  EXPECT_EQ(0x38ull, iree_task_affinity_for_partition(1, 3, 8));
+  EXPECT_EQ(0xC0ull, iree_task_affinity_for_partition(2, 3, 8));
+  VerifyPartitionCoverage(3, 8);
+  // 7 workers / 4 partitions = 2, 2, 2, 1.
+  EXPECT_EQ(0x03ull, iree_task_affinity_for_partition(0, 4, 7));
+  EXPECT_EQ(0x0Cull, iree_task_affinity_for_partition(1, 4, 7));
+  EXPECT_EQ(0x30ull, iree_task_affinity_for_partition(2, 4, 7));
+  EXPECT_EQ(0x40ull, iree_task_affinity_for_partition(3, 4, 7));
+  VerifyPartitionCoverage(4, 7);
+  VerifyPartitionCoverage(5, 64);
+}
+
+// Each partition gets one worker and workers are shared round-robin.
+TEST(AffinitySetTest, PartitionMorePartitionsThanWorkers) {
+  EXPECT_EQ(0x1ull, iree_task_affinity_for_partition(0, 5, 3));
+  EXPECT_EQ(0x2ull, iree_task_affinity_for_partition(1, 5, 3));
+  EXPECT_EQ(0x4ull, iree_task_affinity_for_partition(2, 5, 3));
+  EXPECT_EQ(0x1ull, iree_task_affinity_for_partition(3, 5, 3));
+  EXPECT_EQ(0x2ull, iree_task_affinity_for_partition(4, 5, 3));
+  VerifyPartitionCoverage(5, 3);
+  VerifyPartitionCoverage(3, 3);
+  VerifyPartitionCoverage(8, 1);
+}
+
+}  // namespace
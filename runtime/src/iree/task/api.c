@@ -25,15 +25,38 @@ IREE_FLAG(
     "when latency is the #1 priority (vs. thermals, system-wide scheduling,\n"
     "etc).");
 
+IREE_FLAG(
+    bool, task_worker_adaptive_idle, false,
+    "Workers spin (up to --task_worker_spin_us), then yield (up to\n"
+    "--task_worker_yield_us), and then park when they run out of work. The\n"
+    "budgets are only spent by workers that have recently seen new work\n"
+    "arrive within them such that workers handling bursts of small dispatches\n"
+    "stay responsive while those idle for long periods park immediately.");
+
+IREE_FLAG(
+    int32_t, task_worker_yield_us, 0,
+    "Maximum duration in microseconds each worker should spend yielding to\n"
+    "other threads after spinning and before parking when\n"
+    "--task_worker_adaptive_idle is enabled.");
+
 // TODO(benvanik): enable this when we use it - though hopefully we don't!
 IREE_FLAG(
     int32_t, task_worker_local_memory, 0,  // 64 * 1024,
     "Specifies the bytes of per-worker local memory allocated for use by\n"
-    "dispatched tiles. Tiles may use less than this but will fail to dispatch\n"
-    "if they require more. Conceptually it is like a stack reservation and\n"
-    "should be treated the same way: the source programs must be built to\n"
-    "only use a specific maximum amount of local memory and the runtime must\n"
-    "be configured to make at least that amount of local memory available.");
+    "dispatched tiles. Tiles may use less than this without any additional\n"
+    "allocations and if they require more workers will grow their local\n"
+    "memory up to --task_worker_local_memory_limit. Conceptually it is like a\n"
+    "stack reservation and should be treated the same way: the source\n"
+    "programs must be built to only use a specific maximum amount of local\n"
+    "memory and the runtime must be configured to make at least that amount\n"
+    "of local memory available.");
+
+IREE_FLAG(
+    int32_t, task_worker_local_memory_limit, 4 * 1024 * 1024,
+    "Specifies the maximum bytes of per-worker local memory that workers may\n"
+    "lazily allocate when dispatched tiles require more than\n"
+    "--task_worker_local_memory. Grown memory is retained by each worker for\n"
+    "reuse. Tiles will fail to dispatch if they require more than this.");
 
 iree_status_t iree_task_executor_options_initialize_from_flags(
     iree_task_executor_options_t* out_options) {
@@ -42,9 +65,16 @@ iree_status_t iree_task_executor_options_initialize_from_flags(
 
   out_options->worker_spin_ns =
       (iree_duration_t)FLAG_task_worker_spin_us * 1000;
+  out_options->worker_idle_mode = FLAG_task_worker_adaptive_idle
+                                      ? IREE_TASK_WORKER_IDLE_MODE_ADAPTIVE
+                                      : IREE_TASK_WORKER_IDLE_MODE_FIXED;
+  out_options->worker_yield_ns =
+      (iree_duration_t)FLAG_task_worker_yield_us * 1000;
 
   out_options->worker_local_memory_size =
       (iree_host_size_t)FLAG_task_worker_local_memory;
+  out_options->worker_local_memory_limit =
+      (iree_host_size_t)FLAG_task_worker_local_memory_limit;
 
   return iree_ok_status();
 }
@@ -0,0 +1,589 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/internal/threading.h"
+#include "iree/task/executor.h"
+#include "iree/task/scope.h"
+#include "iree/task/submission.h"
+#include "iree/task/task.h"
+#include "iree/task/topology.h"
+#include "iree/testing/benchmark.h"
+
+// Dispatch shape used by a benchmark case.
+typedef struct iree_task_dispatch_benchmark_params_t {
+  // Total workgroup count of the dispatch grid.
+  uint32_t workgroup_count[3];
+  // Number of arbitrary loop iterations performed per workgroup to simulate
+  // work. 0 measures just the scheduling overhead of the executor.
+  uint32_t work_per_workgroup;
+} iree_task_dispatch_benchmark_params_t;
+
+static iree_status_t iree_task_dispatch_benchmark_tile(
+    void* user_context, const iree_task_tile_context_t* tile_context,
+    iree_task_submission_t* pending_submission) {
+  const iree_task_dispatch_benchmark_params_t* params =
+      (const iree_task_dispatch_benchmark_params_t*)user_context;
+  // Simple LCG that the compiler can't elide; the result is only used to keep
+  // the loop alive.
+  volatile uint32_t value = tile_context->workgroup_xyz[0];
+  for (uint32_t i = 0; i < params->work_per_workgroup; ++i) {
+    value = value * 1664525u + 1013904223u;
+  }
+  return iree_ok_status();
+}
+
+// Issues a single dispatch of the given shape per iteration and waits for it
+// to complete. Measures end-to-end latency including executor wake/sleep.
+static iree_status_t iree_task_dispatch_benchmark_run(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  const iree_task_dispatch_benchmark_params_t* params =
+      (const iree_task_dispatch_benchmark_params_t*)benchmark_def->user_data;
+  iree_allocator_t host_allocator = benchmark_state->host_allocator;
+
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_physical_cores(
+      IREE_TASK_EXECUTOR_MAX_WORKER_COUNT, &topology);
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  iree_task_executor_t* executor = NULL;
+  iree_status_t status =
+      iree_task_executor_create(options, &topology, host_allocator, &executor);
+  iree_task_topology_deinitialize(&topology);
+  IREE_RETURN_IF_ERROR(status);
+
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("benchmark"), &scope);
+
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  int64_t dispatch_count = 0;
+  while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    iree_task_dispatch_t dispatch_task;
+    iree_task_dispatch_initialize(
+        &scope,
+        iree_task_make_dispatch_closure(iree_task_dispatch_benchmark_tile,
+                                        (void*)params),
+        workgroup_size, params->workgroup_count, &dispatch_task);
+
+    iree_task_fence_t* fence_task = NULL;
+    IREE_CHECK_OK(
+        iree_task_executor_acquire_fence(executor, &scope, &fence_task));
+    iree_task_set_completion_task(&dispatch_task.header, &fence_task->header);
+
+    iree_task_submission_t submission;
+    iree_task_submission_initialize(&submission);
+    iree_task_submission_enqueue(&submission, &dispatch_task.header);
+    iree_task_executor_submit(executor, &submission);
+    iree_task_executor_flush(executor);
+    IREE_CHECK_OK(iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE));
+    ++dispatch_count;
+  }
+  iree_benchmark_set_items_processed(
+      benchmark_state, dispatch_count * params->workgroup_count[0] *
+                           params->workgroup_count[1] *
+                           params->workgroup_count[2]);
+
+  status = iree_task_scope_consume_status(&scope);
+  iree_task_scope_deinitialize(&scope);
+  iree_task_executor_release(executor);
+  return status;
+}
+
+//===----------------------------------------------------------------------===//
+// Background load
+//===----------------------------------------------------------------------===//
+
+// Background load submitted continuously from its own thread while the
+// benchmark measures the latency of a foreground stream.
+typedef struct iree_task_dispatch_benchmark_load_t {
+  iree_task_executor_t* executor;
+  iree_task_scope_t scope;
+  const iree_task_dispatch_benchmark_params_t* params;
+  iree_thread_t* thread;
+  // Total number of dispatches the load has completed.
+  iree_atomic_int64_t dispatch_count;
+  iree_atomic_int32_t should_stop;
+  iree_atomic_int32_t has_exited;
+  iree_notification_t exit_notification;
+} iree_task_dispatch_benchmark_load_t;
+
+// Throughput-oriented dispatch that keeps all workers busy for a long time
+// relative to the foreground dispatches.
+static const iree_task_dispatch_benchmark_params_t
+    iree_task_dispatch_benchmark_load_params = {{64, 64, 16}, 1000};
+
+// Latency-sensitive dispatch measured in the foreground.
+static const iree_task_dispatch_benchmark_params_t
+    iree_task_dispatch_benchmark_foreground_params = {{64, 1, 1}, 1000};
+
+// Maximum number of latency samples retained; later iterations overwrite the
+// oldest samples.
+#define IREE_TASK_DISPATCH_BENCHMARK_MAX_SAMPLES (64 * 1024)
+
+// Submits |params| as a dispatch in |scope| and waits for it to complete.
+static void iree_task_dispatch_benchmark_submit_and_wait(
+    iree_task_executor_t* executor, iree_task_scope_t* scope,
+    const iree_task_dispatch_benchmark_params_t* params) {
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  iree_task_dispatch_t dispatch_task;
+  iree_task_dispatch_initialize(
+      scope,
+      iree_task_make_dispatch_closure(iree_task_dispatch_benchmark_tile,
+                                      (void*)params),
+      workgroup_size, params->workgroup_count, &dispatch_task);
+
+  iree_task_fence_t* fence_task = NULL;
+  IREE_CHECK_OK(iree_task_executor_acquire_fence(executor, scope, &fence_task));
+  iree_task_set_completion_task(&dispatch_task.header, &fence_task->header);
+
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  iree_task_submission_enqueue(&submission, &dispatch_task.header);
+  iree_task_executor_submit(executor, &submission);
+  iree_task_executor_flush(executor);
+  IREE_CHECK_OK(iree_task_scope_wait_idle(scope, IREE_TIME_INFINITE_FUTURE));
+}
+
+static int iree_task_dispatch_benchmark_load_main(
+    iree_task_dispatch_benchmark_load_t* load) {
+  while (!iree_atomic_load_int32(&load->should_stop,
+                                 iree_memory_order_acquire)) {
+    iree_task_dispatch_benchmark_submit_and_wait(load->executor, &load->scope,
+                                                 load->params);
+    iree_atomic_fetch_add_int64(&load->dispatch_count, 1,
+                                iree_memory_order_relaxed);
+  }
+  iree_atomic_store_int32(&load->has_exited, 1, iree_memory_order_release);
+  iree_notification_post(&load->exit_notification, IREE_ALL_WAITERS);
+  return 0;
+}
+
+static bool iree_task_dispatch_benchmark_load_has_exited(
+    iree_task_dispatch_benchmark_load_t* load) {
+  return iree_atomic_load_int32(&load->has_exited,
+                                iree_memory_order_acquire) == 1;
+}
+
+// Starts a thread continuously submitting |params| dispatches to |executor|
+// with |priority| until iree_task_dispatch_benchmark_load_stop is called.
+static void iree_task_dispatch_benchmark_load_start(
+    iree_task_executor_t* executor,
+    const iree_task_dispatch_benchmark_params_t* params,
+    iree_task_priority_t priority, iree_allocator_t host_allocator,
+    iree_task_dispatch_benchmark_load_t* out_load) {
+  out_load->executor = executor;
+  iree_task_scope_initialize(iree_make_cstring_view("load"), &out_load->scope);
+  iree_task_scope_set_priority(&out_load->scope, priority);
+  out_load->params = params;
+  iree_atomic_store_int64(&out_load->dispatch_count, 0,
+                          iree_memory_order_relaxed);
+  iree_atomic_store_int32(&out_load->should_stop, 0,
+                          iree_memory_order_relaxed);
+  iree_atomic_store_int32(&out_load->has_exited, 0, iree_memory_order_relaxed);
+  iree_notification_initialize(&out_load->exit_notification);
+  iree_thread_create_params_t thread_params;
+  memset(&thread_params, 0, sizeof(thread_params));
+  thread_params.name = iree_make_cstring_view("iree-benchmark-load");
+  IREE_CHECK_OK(iree_thread_create(
+      (iree_thread_entry_t)iree_task_dispatch_benchmark_load_main, out_load,
+      thread_params, host_allocator, &out_load->thread));
+}
+
+// Stops |load| and waits for its in-flight dispatch to complete. Returns the
+// status of the load scope.
+static iree_status_t iree_task_dispatch_benchmark_load_stop(
+    iree_task_dispatch_benchmark_load_t* load) {
+  iree_atomic_store_int32(&load->should_stop, 1, iree_memory_order_release);
+  iree_notification_await(
+      &load->exit_notification,
+      (iree_condition_fn_t)iree_task_dispatch_benchmark_load_has_exited, load,
+      iree_infinite_timeout());
+  iree_thread_release(load->thread);
+  load->thread = NULL;
+  iree_status_t status = iree_task_scope_consume_status(&load->scope);
+  iree_task_scope_deinitialize(&load->scope);
+  iree_notification_deinitialize(&load->exit_notification);
+  return status;
+}
+
+static int iree_task_dispatch_benchmark_compare_samples(const void* a,
+                                                        const void* b) {
+  int64_t lhs = *(const int64_t*)a;
+  int64_t rhs = *(const int64_t*)b;
+  return lhs < rhs ? -1 : (lhs > rhs ? 1 : 0);
+}
+
+// Sets the benchmark label to the p50/p99 of the latency |samples| recorded
+// over |dispatch_count| iterations. |samples| is sorted in-place.
+static void iree_task_dispatch_benchmark_set_latency_label(
+    iree_benchmark_state_t* benchmark_state, int64_t* samples,
+    int64_t dispatch_count) {
+  iree_host_size_t sample_count = (iree_host_size_t)iree_min(
+      dispatch_count, IREE_TASK_DISPATCH_BENCHMARK_MAX_SAMPLES);
+  if (sample_count == 0) return;
+  qsort(samples, sample_count, sizeof(*samples),
+        iree_task_dispatch_benchmark_compare_samples);
+  char label[64];
+  snprintf(label, IREE_ARRAYSIZE(label), "p50=%.1fus p99=%.1fus",
+           samples[sample_count / 2] / 1000.0,
+           samples[(sample_count * 99) / 100] / 1000.0);
+  iree_benchmark_set_label(benchmark_state, label);
+}
+
+// Measures the latency of small dispatches with the priority given by
+// |user_data| while a LOW priority background load saturates all workers.
+// Reports the p50/p99 latency of the foreground stream in the label; with
+// IREE_TASK_PRIORITY_HIGH the tail should be bounded by a tile reservation of
+// the background load instead of an entire background dispatch.
+static iree_status_t iree_task_dispatch_benchmark_run_mixed_priority(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  const iree_task_priority_t priority =
+      (iree_task_priority_t)(uintptr_t)benchmark_def->user_data;
+  iree_allocator_t host_allocator = benchmark_state->host_allocator;
+
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_physical_cores(
+      IREE_TASK_EXECUTOR_MAX_WORKER_COUNT, &topology);
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  iree_task_executor_t* executor = NULL;
+  iree_status_t status =
+      iree_task_executor_create(options, &topology, host_allocator, &executor);
+  iree_task_topology_deinitialize(&topology);
+  IREE_RETURN_IF_ERROR(status);
+
+  int64_t* samples = NULL;
+  status = iree_allocator_malloc(
+      host_allocator,
+      IREE_TASK_DISPATCH_BENCHMARK_MAX_SAMPLES * sizeof(*samples),
+      (void**)&samples);
+  if (!iree_status_is_ok(status)) {
+    iree_task_executor_release(executor);
+    return status;
+  }
+
+  iree_task_dispatch_benchmark_load_t load;
+  iree_task_dispatch_benchmark_load_start(
+      executor, &iree_task_dispatch_benchmark_load_params,
+      IREE_TASK_PRIORITY_LOW, host_allocator, &load);
+
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("foreground"), &scope);
+  iree_task_scope_set_priority(&scope, priority);
+
+  int64_t dispatch_count = 0;
+  while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    iree_time_t start_ns = iree_time_now();
+    iree_task_dispatch_benchmark_submit_and_wait(
+        executor, &scope, &iree_task_dispatch_benchmark_foreground_params);
+    samples[dispatch_count % IREE_TASK_DISPATCH_BENCHMARK_MAX_SAMPLES] =
+        iree_time_now() - start_ns;
+    ++dispatch_count;
+  }
+
+  status = iree_task_dispatch_benchmark_load_stop(&load);
+
+  iree_task_dispatch_benchmark_set_latency_label(benchmark_state, samples,
+                                                 dispatch_count);
+  iree_benchmark_set_items_processed(benchmark_state, dispatch_count);
+
+  status = iree_status_join(status, iree_task_scope_consume_status(&scope));
+  iree_task_scope_deinitialize(&scope);
+  iree_allocator_free(host_allocator, samples);
+  iree_task_executor_release(executor);
+  return status;
+}
+
+//===----------------------------------------------------------------------===//
+// Multi-producer submission
+//===----------------------------------------------------------------------===//
+
+// Tiny dispatch such that the cost is dominated by submission and coordination.
+static const iree_task_dispatch_benchmark_params_t
+    iree_task_dispatch_benchmark_producer_params = {{1, 1, 1}, 0};
+
+// Maximum number of producer threads used by the multi-producer benchmark.
+#define IREE_TASK_DISPATCH_BENCHMARK_MAX_PRODUCERS 32
+
+// Submits tiny dispatches from |user_data| threads at the same time, each with
+// its own scope, to measure contention between producers (and the workers
+// coordinating on their behalf). The benchmark thread is one of the producers
+// and reports the p50/p99 latency of its own submissions in the label while
+// the items processed count includes the dispatches of all producers.
+static iree_status_t iree_task_dispatch_benchmark_run_multi_producer(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  const iree_host_size_t producer_count =
+      (iree_host_size_t)(uintptr_t)benchmark_def->user_data;
+  iree_allocator_t host_allocator = benchmark_state->host_allocator;
+
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_physical_cores(
+      IREE_TASK_EXECUTOR_MAX_WORKER_COUNT, &topology);
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  iree_task_executor_t* executor = NULL;
+  iree_status_t status =
+      iree_task_executor_create(options, &topology, host_allocator, &executor);
+  iree_task_topology_deinitialize(&topology);
+  IREE_RETURN_IF_ERROR(status);
+
+  int64_t* samples = NULL;
+  status = iree_allocator_malloc(
+      host_allocator,
+      IREE_TASK_DISPATCH_BENCHMARK_MAX_SAMPLES * sizeof(*samples),
+      (void**)&samples);
+  if (!iree_status_is_ok(status)) {
+    iree_task_executor_release(executor);
+    return status;
+  }
+
+  // All producers other than the benchmark thread.
+  iree_task_dispatch_benchmark_load_t
+      loads[IREE_TASK_DISPATCH_BENCHMARK_MAX_PRODUCERS - 1];
+  const iree_host_size_t load_count = producer_count - 1;
+  for (iree_host_size_t i = 0; i < load_count; ++i) {
+    iree_task_dispatch_benchmark_load_start(
+        executor, &iree_task_dispatch_benchmark_producer_params,
+        IREE_TASK_PRIORITY_DEFAULT, host_allocator, &loads[i]);
+  }
+
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("producer"), &scope);
+
+  int64_t load_dispatch_count_start = 0;
+  for (iree_host_size_t i = 0; i < load_count; ++i) {
+    load_dispatch_count_start += iree_atomic_load_int64(
+        &loads[i].dispatch_count, iree_memory_order_relaxed);
+  }
+  int64_t dispatch_count = 0;
+  while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    iree_time_t start_ns = iree_time_now();
+    iree_task_dispatch_benchmark_submit_and_wait(
+        executor, &scope, &iree_task_dispatch_benchmark_producer_params);
+    samples[dispatch_count % IREE_TASK_DISPATCH_BENCHMARK_MAX_SAMPLES] =
+        iree_time_now() - start_ns;
+    ++dispatch_count;
+  }
+  int64_t load_dispatch_count_end = 0;
+  for (iree_host_size_t i = 0; i < load_count; ++i) {
+    load_dispatch_count_end += iree_atomic_load_int64(
+        &loads[i].dispatch_count, iree_memory_order_relaxed);
+  }
+
+  status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < load_count; ++i) {
+    status = iree_status_join(
+        status, iree_task_dispatch_benchmark_load_stop(&loads[i]));
+  }
+
+  iree_task_dispatch_benchmark_set_latency_label(benchmark_state, samples,
+                                                 dispatch_count);
+  iree_benchmark_set_items_processed(
+      benchmark_state, dispatch_count + load_dispatch_count_end -
+                           load_dispatch_count_start);
+
+  status = iree_status_join(status, iree_task_scope_consume_status(&scope));
+  iree_task_scope_deinitialize(&scope);
+  iree_allocator_free(host_allocator, samples);
+  iree_task_executor_release(executor);
+  return status;
+}
+
+//===----------------------------------------------------------------------===//
+// Worker idle policies
+//===----------------------------------------------------------------------===//
+
+// Worker idle policy and submission pattern used by a benchmark case.
+typedef struct iree_task_dispatch_benchmark_idle_params_t {
+  const char* name;
+  iree_task_worker_idle_mode_t idle_mode;
+  iree_duration_t spin_ns;
+  iree_duration_t yield_ns;
+  // Time the submitting thread sleeps between dispatches. Workers run out of
+  // work and go idle during the gap.
+  iree_duration_t gap_ns;
+} iree_task_dispatch_benchmark_idle_params_t;
+
+// Issues small dispatches back-to-back with an optional gap between them and
+// reports their p50/p99 latency in the label. The process CPU time reported
+// includes any time workers spent spinning or yielding while idle, such that
+// the latency improvements of each policy can be weighed against the CPU it
+// burns.
+static iree_status_t iree_task_dispatch_benchmark_run_idle(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  const iree_task_dispatch_benchmark_idle_params_t* params =
+      (const iree_task_dispatch_benchmark_idle_params_t*)
+          benchmark_def->user_data;
+  iree_allocator_t host_allocator = benchmark_state->host_allocator;
+
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_physical_cores(
+      IREE_TASK_EXECUTOR_MAX_WORKER_COUNT, &topology);
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  options.worker_idle_mode = params->idle_mode;
+  options.worker_spin_ns = params->spin_ns;
+  options.worker_yield_ns = params->yield_ns;
+  iree_task_executor_t* executor = NULL;
+  iree_status_t status =
+      iree_task_executor_create(options, &topology, host_allocator, &executor);
+  iree_task_topology_deinitialize(&topology);
+  IREE_RETURN_IF_ERROR(status);
+
+  int64_t* samples = NULL;
+  status = iree_allocator_malloc(
+      host_allocator,
+      IREE_TASK_DISPATCH_BENCHMARK_MAX_SAMPLES * sizeof(*samples),
+      (void**)&samples);
+  if (!iree_status_is_ok(status)) {
+    iree_task_executor_release(executor);
+    return status;
+  }
+
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("benchmark"), &scope);
+
+  int64_t dispatch_count = 0;
+  while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    if (params->gap_ns) iree_wait_until(iree_time_now() + params->gap_ns);
+    iree_time_t start_ns = iree_time_now();
+    iree_task_dispatch_benchmark_submit_and_wait(
+        executor, &scope, &iree_task_dispatch_benchmark_foreground_params);
+    samples[dispatch_count % IREE_TASK_DISPATCH_BENCHMARK_MAX_SAMPLES] =
+        iree_time_now() - start_ns;
+    ++dispatch_count;
+  }
+  iree_task_dispatch_benchmark_set_latency_label(benchmark_state, samples,
+                                                 dispatch_count);
+  iree_benchmark_set_items_processed(benchmark_state, dispatch_count);
+
+  status = iree_task_scope_consume_status(&scope);
+  iree_task_scope_deinitialize(&scope);
+  iree_allocator_free(host_allocator, samples);
+  iree_task_executor_release(executor);
+  return status;
+}
+
+int main(int argc, char** argv) {
+  iree_benchmark_initialize(&argc, argv);
+
+  // Sweeps from a single workgroup (pure overhead) to grids of many tiny
+  // workgroups (reservation atomics dominate) and few large ones (balance
+  // dominates).
+  static const iree_task_dispatch_benchmark_params_t params[] = {
+      {{1, 1, 1}, 0},       {{64, 1, 1}, 0},      {{4096, 1, 1}, 0},
+      {{65536, 1, 1}, 0},   {{64, 64, 16}, 0},    {{8, 1, 1}, 100000},
+      {{64, 1, 1}, 10000},  {{4096, 1, 1}, 100},  {{65536, 1, 1}, 10},
+      {{64, 64, 16}, 10},
+  };
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(params); ++i) {
+    iree_benchmark_def_t benchmark_def = {
+        .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+                 IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+        .time_unit = IREE_BENCHMARK_UNIT_MICROSECOND,
+        .minimum_duration_ns = 0,
+        .iteration_count = 0,
+        .run = iree_task_dispatch_benchmark_run,
+        .user_data = &params[i],
+    };
+    char name[64];
+    snprintf(name, IREE_ARRAYSIZE(name), "dispatch_%ux%ux%u_work_%u",
+             params[i].workgroup_count[0], params[i].workgroup_count[1],
+             params[i].workgroup_count[2], params[i].work_per_workgroup);
+    iree_benchmark_register(iree_make_cstring_view(name), &benchmark_def);
+  }
+
+  // Foreground latency under a saturating LOW priority background load with
+  // the foreground at the same (DEFAULT) priority as any other work vs HIGH.
+  static const struct {
+    const char* name;
+    iree_task_priority_t priority;
+  } mixed_priorities[] = {
+      {"mixed_priority_foreground_default", IREE_TASK_PRIORITY_DEFAULT},
+      {"mixed_priority_foreground_high", IREE_TASK_PRIORITY_HIGH},
+  };
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(mixed_priorities); ++i) {
+    iree_benchmark_def_t benchmark_def = {
+        .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+                 IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+        .time_unit = IREE_BENCHMARK_UNIT_MICROSECOND,
+        .minimum_duration_ns = 0,
+        .iteration_count = 0,
+        .run = iree_task_dispatch_benchmark_run_mixed_priority,
+        .user_data = (void*)(uintptr_t)mixed_priorities[i].priority,
+    };
+    iree_benchmark_register(iree_make_cstring_view(mixed_priorities[i].name),
+                            &benchmark_def);
+  }
+
+  // Tiny dispatches submitted concurrently by an increasing number of
+  // producers. Throughput (items/s) should scale with the producer count until
+  // the workers saturate instead of collapsing due to coordination contention.
+  static const iree_host_size_t producer_counts[] = {1, 2, 4, 8, 16};
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(producer_counts); ++i) {
+    iree_benchmark_def_t benchmark_def = {
+        .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+                 IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+        .time_unit = IREE_BENCHMARK_UNIT_MICROSECOND,
+        .minimum_duration_ns = 0,
+        .iteration_count = 0,
+        .run = iree_task_dispatch_benchmark_run_multi_producer,
+        .user_data = (void*)(uintptr_t)producer_counts[i],
+    };
+    char name[64];
+    snprintf(name, IREE_ARRAYSIZE(name), "submit_producers_%" PRIhsz,
+             producer_counts[i]);
+    iree_benchmark_register(iree_make_cstring_view(name), &benchmark_def);
+  }
+
+  // Back-to-back small dispatches with each worker idle policy. Without a gap
+  // new work arrives immediately and spinning workers never park; with a short
+  // gap the adaptive policy should approach the latency of spinning; with a
+  // long gap it should approach the CPU time of parking.
+  static const iree_task_dispatch_benchmark_idle_params_t idle_params[] = {
+      {"idle_park_gap_0us", IREE_TASK_WORKER_IDLE_MODE_FIXED, 0, 0, 0},
+      {"idle_spin_gap_0us", IREE_TASK_WORKER_IDLE_MODE_FIXED, 100000, 0, 0},
+      {"idle_adaptive_gap_0us", IREE_TASK_WORKER_IDLE_MODE_ADAPTIVE, 100000,
+       100000, 0},
+      {"idle_park_gap_20us", IREE_TASK_WORKER_IDLE_MODE_FIXED, 0, 0, 20000},
+      {"idle_spin_gap_20us", IREE_TASK_WORKER_IDLE_MODE_FIXED, 100000, 0,
+       20000},
+      {"idle_adaptive_gap_20us", IREE_TASK_WORKER_IDLE_MODE_ADAPTIVE, 100000,
+       100000, 20000},
+      {"idle_park_gap_1000us", IREE_TASK_WORKER_IDLE_MODE_FIXED, 0, 0, 1000000},
+      {"idle_spin_gap_1000us", IREE_TASK_WORKER_IDLE_MODE_FIXED, 100000, 0,
+       1000000},
+      {"idle_adaptive_gap_1000us", IREE_TASK_WORKER_IDLE_MODE_ADAPTIVE, 100000,
+       100000, 1000000},
+  };
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(idle_params); ++i) {
+    iree_benchmark_def_t benchmark_def = {
+        .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+                 IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+        .time_unit = IREE_BENCHMARK_UNIT_MICROSECOND,
+        .minimum_duration_ns = 0,
+        .iteration_count = 0,
+        .run = iree_task_dispatch_benchmark_run_idle,
+        .user_data = &idle_params[i],
+    };
+    iree_benchmark_register(iree_make_cstring_view(idle_params[i].name),
+                            &benchmark_def);
+  }
+
+  iree_benchmark_run_specified();
+  return 0;
+}
@@ -60,6 +60,8 @@ iree_status_t iree_task_executor_create(iree_task_executor_options_t options,
       iree_host_align(options.worker_local_memory_size,
                       iree_hardware_destructive_interference_size);
   IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)options.worker_local_memory_size);
+  options.worker_local_memory_limit = iree_max(
+      options.worker_local_memory_limit, options.worker_local_memory_size);
   iree_host_size_t executor_base_size =
       iree_host_align(sizeof(iree_task_executor_t),
                       iree_hardware_destructive_interference_size);
@@ -78,8 +80,15 @@ iree_status_t iree_task_executor_create(iree_task_executor_options_t options,
   executor->allocator = allocator;
   executor->scheduling_mode = options.scheduling_mode;
   executor->worker_spin_ns = options.worker_spin_ns;
-  iree_atomic_task_slist_initialize(&executor->incoming_ready_slist);
-  iree_slim_mutex_initialize(&executor->coordinator_mutex);
+  executor->worker_idle_mode = options.worker_idle_mode;
+  executor->worker_yield_ns = options.worker_yield_ns;
+  executor->worker_local_memory_limit = options.worker_local_memory_limit;
+  iree_atomic_store_int32(&executor->incoming_ready_mask, 0,
+                          iree_memory_order_relaxed);
+  for (iree_host_size_t i = 0; i < IREE_TASK_EXECUTOR_INCOMING_SHARD_COUNT;
+       ++i) {
+    iree_atomic_task_slist_initialize(&executor->incoming_ready_slists[i]);
+  }
 
   // Simple PRNG used to generate seeds for the per-worker PRNGs used to
   // distribute work. This isn't strong (and doesn't need to be); it's just
@@ -206,8 +215,10 @@ static void iree_task_executor_destroy(iree_task_executor_t* executor) {
   iree_task_poller_deinitialize(&executor->poller);
 
   iree_event_pool_free(executor->event_pool);
-  iree_slim_mutex_deinitialize(&executor->coordinator_mutex);
-  iree_atomic_task_slist_deinitialize(&executor->incoming_ready_slist);
+  for (iree_host_size_t i = 0; i < IREE_TASK_EXECUTOR_INCOMING_SHARD_COUNT;
+       ++i) {
+    iree_atomic_task_slist_deinitialize(&executor->incoming_ready_slists[i]);
+  }
   iree_task_pool_deinitialize(&executor->transient_task_pool);
   iree_allocator_free(executor->allocator, executor);
 
@@ -240,6 +251,37 @@ iree_host_size_t iree_task_executor_worker_count(
   return executor->worker_count;
 }
 
+bool iree_task_executor_is_worker_thread(iree_task_executor_t* executor) {
+  const uintptr_t current_id = iree_thread_current_id();
+  for (iree_host_size_t i = 0; i < executor->worker_count; ++i) {
+    iree_thread_t* thread = executor->workers[i].thread;
+    if (thread && iree_thread_id(thread) == current_id) return true;
+  }
+  return false;
+}
+
+iree_host_size_t iree_task_executor_peak_worker_local_memory_size(
+    iree_task_executor_t* executor) {
+  iree_host_size_t peak_size = 0;
+  for (iree_host_size_t i = 0; i < executor->worker_count; ++i) {
+    iree_task_worker_t* worker = &executor->workers[i];
+    peak_size = iree_max(peak_size, (iree_host_size_t)iree_atomic_load_int64(
+                                        &worker->local_memory_peak_size,
+                                        iree_memory_order_relaxed));
+  }
+  return peak_size;
+}
+
+iree_duration_t iree_task_executor_max_worker_idle_estimate(
+    iree_task_executor_t* executor) {
+  iree_duration_t max_estimate_ns = 0;
+  for (iree_host_size_t i = 0; i < executor->worker_count; ++i) {
+    max_estimate_ns =
+        iree_max(max_estimate_ns, executor->workers[i].idle_estimate_ns);
+  }
+  return max_estimate_ns;
+}
+
 iree_event_pool_t* iree_task_executor_event_pool(
     iree_task_executor_t* executor) {
   return executor->event_pool;
@@ -264,7 +306,7 @@ iree_status_t iree_task_executor_acquire_fence(iree_task_executor_t* executor,
 // The task will be posted to the worker mailbox and available for the worker to
 // begin processing as soon as the |post_batch| is submitted.
 //
-// Only called during coordination and expects the coordinator lock to be held.
+// Only called during coordination.
 static void iree_task_executor_relay_to_worker(
     iree_task_executor_t* executor, iree_task_post_batch_t* post_batch,
     iree_task_t* task) {
@@ -273,6 +315,76 @@ static void iree_task_executor_relay_to_worker(
   iree_task_post_batch_enqueue(post_batch, worker_index, task);
 }
 
+// Schedules a single ready |task| by either retiring it inline or routing it
+// to workers via |post_batch|.
+//
+// Only called during coordination.
+static void iree_task_executor_schedule_ready_task(
+    iree_task_executor_t* executor, iree_task_t* task,
+    iree_task_submission_t* pending_submission,
+    iree_task_post_batch_t* post_batch) {
+  // If the scope has been marked as failing then we abort the task.
+  // This needs to happen as a poll here because one or more of the tasks we
+  // are joining may have failed.
+  if (IREE_UNLIKELY(!task->scope || iree_task_scope_has_failed(task->scope))) {
+    iree_task_list_t discard_worklist;
+    iree_task_list_initialize(&discard_worklist);
+    iree_task_discard(task, &discard_worklist);
+    iree_task_list_discard(&discard_worklist);
+    return;
+  }
+
+  switch (task->type) {
+    case IREE_TASK_TYPE_NOP:
+      // Doesn't do anything; just retire and continue on to any dependents.
+      iree_task_nop_retire((iree_task_nop_t*)task, pending_submission);
+      break;
+    case IREE_TASK_TYPE_CALL: {
+      // Generic routing to workers for tasks that should always run there.
+      iree_task_executor_relay_to_worker(executor, post_batch, task);
+      break;
+    }
+    case IREE_TASK_TYPE_BARRIER: {
+      // Retire the barrier to (possibly) ready up all dependent tasks.
+      // This acts as a fan-out in cases where the dependent task count >1.
+      iree_task_barrier_retire((iree_task_barrier_t*)task,
+                               pending_submission);
+      break;
+    }
+    case IREE_TASK_TYPE_FENCE: {
+      // Scope fence hit; notifies the scope so that anyone waiting on the
+      // fence can be notified without us having to do so explicitly.
+      iree_task_fence_retire((iree_task_fence_t*)task, pending_submission);
+      break;
+    }
+    case IREE_TASK_TYPE_WAIT: {
+      // We should only ever see completed waits here; ones that have yet to
+      // resolve are sent to the poller.
+      iree_task_wait_retire(
+          (iree_task_wait_t*)task, pending_submission,
+          iree_all_bits_set(task->flags, IREE_TASK_FLAG_WAIT_COMPLETED)
+              ? iree_ok_status()
+              : iree_make_status(IREE_STATUS_INTERNAL,
+                                 "unresolved wait task ended up in the "
+                                 "executor run queue"));
+      break;
+    }
+    case IREE_TASK_TYPE_DISPATCH: {
+      // Dispatches may need to be issued (fanning out the tiles to workers)
+      // or retired (after all tiles have completed).
+      if (task->flags & IREE_TASK_FLAG_DISPATCH_RETIRE) {
+        iree_task_dispatch_retire((iree_task_dispatch_t*)task,
+                                  pending_submission);
+      } else {
+        iree_task_dispatch_issue((iree_task_dispatch_t*)task,
+                                 &executor->transient_task_pool,
+                                 pending_submission, post_batch);
+      }
+      break;
+    }
+  }
+}
+
 // Schedules all ready tasks in the |pending_submission| list.
 // Task may enqueue zero or more new tasks (or newly-ready/waiting tasks) to
 // |pending_submission| or queue work for posting to workers via the
@@ -283,87 +395,54 @@ static void iree_task_executor_relay_to_worker(
 // least recently added tasks from the submission (nice in-order traversal) we
 // are pushing them as what will become the least recent tasks in the batch.
 //
-// Only called during coordination and expects the coordinator lock to be held.
+// Only called during coordination.
 void iree_task_executor_schedule_ready_tasks(
     iree_task_executor_t* executor, iree_task_submission_t* pending_submission,
     iree_task_post_batch_t* post_batch) {
   IREE_TRACE_ZONE_BEGIN(z0);
-  iree_task_t* task = NULL;
-  while ((task = iree_task_list_pop_front(&pending_submission->ready_list))) {
-    // If the scope has been marked as failing then we abort the task.
-    // This needs to happen as a poll here because one or more of the tasks we
-    // are joining may have failed.
-    if (IREE_UNLIKELY(!task->scope ||
-                      iree_task_scope_has_failed(task->scope))) {
-      iree_task_list_t discard_worklist;
-      iree_task_list_initialize(&discard_worklist);
-      iree_task_discard(task, &discard_worklist);
-      iree_task_list_discard(&discard_worklist);
-      continue;
-    }
 
-    switch (task->type) {
-      case IREE_TASK_TYPE_NOP:
-        // Doesn't do anything; just retire and continue on to any dependents.
-        iree_task_nop_retire((iree_task_nop_t*)task, pending_submission);
-        break;
-      case IREE_TASK_TYPE_CALL: {
-        // Generic routing to workers for tasks that should always run there.
-        iree_task_executor_relay_to_worker(executor, post_batch, task);
-        break;
-      }
-      case IREE_TASK_TYPE_BARRIER: {
-        // Retire the barrier to (possibly) ready up all dependent tasks.
-        // This acts as a fan-out in cases where the dependent task count >1.
-        iree_task_barrier_retire((iree_task_barrier_t*)task,
-                                 pending_submission);
-        break;
-      }
-      case IREE_TASK_TYPE_FENCE: {
-        // Scope fence hit; notifies the scope so that anyone waiting on the
-        // fence can be notified without us having to do so explicitly.
-        iree_task_fence_retire((iree_task_fence_t*)task, pending_submission);
-        break;
-      }
-      case IREE_TASK_TYPE_WAIT: {
-        // We should only ever see completed waits here; ones that have yet to
-        // resolve are sent to the poller.
-        iree_task_wait_retire(
-            (iree_task_wait_t*)task, pending_submission,
-            iree_all_bits_set(task->flags, IREE_TASK_FLAG_WAIT_COMPLETED)
-                ? iree_ok_status()
-                : iree_make_status(IREE_STATUS_INTERNAL,
-                                   "unresolved wait task ended up in the "
-                                   "executor run queue"));
-        break;
-      }
-      case IREE_TASK_TYPE_DISPATCH: {
-        // Dispatches may need to be issued (fanning out the tiles to workers)
-        // or retired (after all tiles have completed).
-        if (task->flags & IREE_TASK_FLAG_DISPATCH_RETIRE) {
-          iree_task_dispatch_retire((iree_task_dispatch_t*)task,
-                                    pending_submission);
-        } else {
-          iree_task_dispatch_issue((iree_task_dispatch_t*)task,
-                                   &executor->transient_task_pool,
-                                   pending_submission, post_batch);
-        }
-        break;
+  // Ready tasks are scheduled in priority order so that higher priority work
+  // is issued (and reaches the workers) first. Scheduling may ready more tasks
+  // (such as when retiring barriers) and those are picked up on the next pass
+  // in their own priority order.
+  while (!iree_task_list_is_empty(&pending_submission->ready_list)) {
+    iree_task_list_t priority_lists[IREE_TASK_PRIORITY_COUNT];
+    for (iree_host_size_t i = 0; i < IREE_TASK_PRIORITY_COUNT; ++i) {
+      iree_task_list_initialize(&priority_lists[i]);
+    }
+    iree_task_t* task = NULL;
+    while ((task = iree_task_list_pop_front(&pending_submission->ready_list))) {
+      iree_task_list_push_back(&priority_lists[task->priority], task);
+    }
+    for (iree_host_size_t i = 0; i < IREE_TASK_PRIORITY_COUNT; ++i) {
+      while ((task = iree_task_list_pop_front(&priority_lists[i]))) {
+        iree_task_executor_schedule_ready_task(executor, task,
+                                               pending_submission, post_batch);
       }
     }
   }
+
   IREE_TRACE_ZONE_END(z0);
 }
 
 void iree_task_executor_merge_submission(iree_task_executor_t* executor,
                                          iree_task_submission_t* submission) {
-  // Concatenate all of the incoming tasks into the submission list.
-  // Note that the submission stores tasks in LIFO order such that when they are
-  // put into the LIFO atomic slist they match the order across all concats
-  // (earlier concats are later in the LIFO list).
-  iree_atomic_task_slist_concat(&executor->incoming_ready_slist,
-                                submission->ready_list.head,
-                                submission->ready_list.tail);
+  // Concatenate all of the incoming tasks into the submission list of the
+  // shard for the processor we are running on. Note that the submission stores
+  // tasks in LIFO order such that when they are put into the LIFO atomic slist
+  // they match the order across all concats (earlier concats are later in the
+  // LIFO list).
+  if (!iree_task_list_is_empty(&submission->ready_list)) {
+    iree_host_size_t shard_index = iree_cpu_query_processor_id() %
+                                   IREE_TASK_EXECUTOR_INCOMING_SHARD_COUNT;
+    iree_atomic_task_slist_concat(&executor->incoming_ready_slists[shard_index],
+                                  submission->ready_list.head,
+                                  submission->ready_list.tail);
+    // NOTE: set after the concat so that a coordinator observing the bit will
+    // find the tasks when it flushes the shard.
+    iree_atomic_fetch_or_int32(&executor->incoming_ready_mask,
+                               1u << shard_index, iree_memory_order_release);
+  }
 
   // Enqueue waiting tasks with the poller immediately: this may issue a
   // syscall to kick the poller. If we see bad context switches here then we
@@ -397,14 +476,43 @@ void iree_task_executor_flush(iree_task_executor_t* executor) {
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Flushes all incoming ready tasks from the shards into |out_submission|.
+// The caller takes ownership of the flushed tasks and no other coordinator will
+// see them.
+static void iree_task_executor_flush_incoming(
+    iree_task_executor_t* executor, iree_task_submission_t* out_submission) {
+  iree_task_submission_initialize(out_submission);
+
+  // Clear the mask prior to flushing: any merge racing with us will either have
+  // its tasks flushed now or set the mask again for the next coordinator.
+  uint32_t shard_mask = (uint32_t)iree_atomic_exchange_int32(
+      &executor->incoming_ready_mask, 0, iree_memory_order_acq_rel);
+  while (shard_mask) {
+    int shard_index = iree_math_count_trailing_zeros_u32(shard_mask);
+    shard_mask &= shard_mask - 1;
+    iree_task_list_t shard_list;
+    iree_task_list_initialize(&shard_list);
+    if (iree_atomic_task_slist_flush(
+            &executor->incoming_ready_slists[shard_index],
+            IREE_ATOMIC_SLIST_FLUSH_ORDER_APPROXIMATE_LIFO, &shard_list.head,
+            &shard_list.tail)) {
+      iree_task_list_append(&out_submission->ready_list, &shard_list);
+    }
+  }
+}
+
 // Dispatches tasks in the global submission queue to workers.
 // This is called by users upon submission of new tasks or by workers when they
 // run out of tasks to process. If |current_worker| is provided then tasks will
 // prefer to be routed back to it for immediate processing.
 //
-// If a coordination run ends up with no ready tasks and |current_worker| is
-// provided the calling thread will enter a wait until the worker has more tasks
-// posted to it.
+// Multiple threads may coordinate concurrently: each flushes a disjoint set of
+// incoming tasks and schedules only those. All of the state touched while
+// scheduling is either owned by the flushed tasks or is itself thread-safe
+// (task pools, the poller mailbox, worker mailboxes) and tasks are retired with
+// the same atomic dependency tracking workers use when retiring tasks
+// concurrently. This keeps workers that go idle at the same time (and external
+// submitters) from serializing on one another.
 void iree_task_executor_coordinate(iree_task_executor_t* executor,
                                    iree_task_worker_t* current_worker) {
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -414,11 +522,14 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
   // until there's nothing left to coordinate.
   bool schedule_dirty = true;
   do {
+    // Fast-path for when there's no incoming work at all (such as when all
+    // workers go idle together).
+    if (!iree_atomic_load_int32(&executor->incoming_ready_mask,
+                                iree_memory_order_acquire)) {
+      break;
+    }
+
     IREE_TRACE_ZONE_BEGIN_NAMED(z1, "iree_task_executor_coordinate_try");
-    // TODO(#10212): remove this lock or do something more clever to avoid
-    // contention when many workers try to coordinate at the same time. This can
-    // create very long serialized lock chains that slow down worker wakes.
-    iree_slim_mutex_lock(&executor->coordinator_mutex);
 
     // Check for incoming submissions and move their posted tasks into our
     // local lists. Any of the tasks here are ready to execute immediately and
@@ -437,10 +548,8 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
     // various places and have no relation - hopefully leading to better average
     // latency.
     iree_task_submission_t pending_submission;
-    iree_task_submission_initialize_from_lifo_slist(
-        &executor->incoming_ready_slist, &pending_submission);
+    iree_task_executor_flush_incoming(executor, &pending_submission);
     if (iree_task_list_is_empty(&pending_submission.ready_list)) {
-      iree_slim_mutex_unlock(&executor->coordinator_mutex);
       IREE_TRACE_ZONE_END(z1);
       break;
     }
@@ -465,7 +574,6 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
     iree_task_poller_enqueue(&executor->poller,
                              &pending_submission.waiting_list);
 
-    iree_slim_mutex_unlock(&executor->coordinator_mutex);
     IREE_TRACE_ZONE_END(z1);
 
     // Post all new work to workers; they may wake and begin executing
@@ -477,9 +585,10 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
 }
 
 static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
-    iree_task_executor_t* executor, iree_task_affinity_set_t victim_mask,
-    uint32_t max_theft_attempts, int rotation_offset,
-    iree_task_queue_t* local_task_queue) {
+    iree_task_executor_t* executor, iree_task_affinity_set_t thief_worker_bit,
+    iree_task_affinity_set_t victim_mask, uint32_t max_theft_attempts,
+    int rotation_offset,
+    iree_task_queue_t local_task_queues[IREE_TASK_PRIORITY_COUNT]) {
   if (!victim_mask) return NULL;
   max_theft_attempts = iree_min(max_theft_attempts,
                                 iree_task_affinity_set_count_ones(victim_mask));
@@ -518,7 +627,7 @@ static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
     // thievery taking ~half of the tasks each time (across all queues) will
     // lead to a relatively even distribution.
     iree_task_t* task = iree_task_worker_try_steal_task(
-        victim_worker, local_task_queue,
+        victim_worker, local_task_queues, thief_worker_bit,
         /*max_tasks=*/IREE_TASK_EXECUTOR_MAX_THEFT_TASK_COUNT);
     if (task) return task;
   }
@@ -529,7 +638,8 @@ static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
 
 // Tries to steal an entire task from a sibling worker (based on topology).
 // Returns a task that is available (has not yet begun processing at all).
-// May steal multiple tasks and add them to the |local_task_queue|.
+// May steal multiple tasks and add them to the |local_task_queues| entry
+// matching their priority.
 //
 // We do a scan through ideal victims indicated by the
 // |constructive_sharing_mask|; these are the workers most likely to have some
@@ -542,10 +652,10 @@ static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
 // instead of bouncing around at random we just select the starting point in
 // our search and then go in-order.
 iree_task_t* iree_task_executor_try_steal_task(
-    iree_task_executor_t* executor,
+    iree_task_executor_t* executor, iree_task_affinity_set_t thief_worker_bit,
     iree_task_affinity_set_t constructive_sharing_mask,
     uint32_t max_theft_attempts, iree_prng_minilcg128_state_t* theft_prng,
-    iree_task_queue_t* local_task_queue) {
+    iree_task_queue_t local_task_queues[IREE_TASK_PRIORITY_COUNT]) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
   // The masks are accessed with 'relaxed' order because they are just hints.
@@ -572,14 +682,14 @@ iree_task_t* iree_task_executor_try_steal_task(
   // that we won't need to go back to main memory (or higher cache tiers) in the
   // event that the thief and victim are running close to each other in time.
   iree_task_t* task = iree_task_executor_try_steal_task_from_affinity_set(
-      executor, victim_mask & constructive_sharing_mask, max_theft_attempts,
-      rotation_offset, local_task_queue);
+      executor, thief_worker_bit, victim_mask & constructive_sharing_mask,
+      max_theft_attempts, rotation_offset, local_task_queues);
   if (task) {
     IREE_TRACE_ZONE_APPEND_TEXT(z0, "local");
   } else {
     task = iree_task_executor_try_steal_task_from_affinity_set(
-        executor, victim_mask & ~constructive_sharing_mask, max_theft_attempts,
-        rotation_offset, local_task_queue);
+        executor, thief_worker_bit, victim_mask & ~constructive_sharing_mask,
+        max_theft_attempts, rotation_offset, local_task_queues);
     if (task) {
       IREE_TRACE_ZONE_APPEND_TEXT(z0, "non-local");
     }
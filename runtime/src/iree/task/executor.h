@@ -113,18 +113,19 @@ extern "C" {
 //      as iree_wait_handle_t then it is placed into the waiting_list.
 //
 // 2. iree_task_executor_submit (LIFO, atomic slist)
-//    Submissions have their task thread-local lists concatenated into a LIFO
-//    incoming_ready_slist or the wait poller shared by the executor.
+//    Submissions have their task thread-local lists concatenated into one of
+//    the LIFO incoming_ready_slists shards (selected by the processor the
+//    submitter is running on) or the wait poller shared by the executor.
 //
 // 3. iree_task_executor_flush (or a worker puts on its coordinator hat 🎩)
 //
-//   a. Tasks are flushed from the incoming_ready_slist into a coordinator-local
-//      FIFO task queue. This centralizes enqueuing from all threads into a
-//      single ordered list.
+//   a. Tasks are flushed from the incoming_ready_slists into a
+//      coordinator-local FIFO task queue. Any number of threads may coordinate
+//      at the same time and each only schedules the tasks it flushed.
 //
-//   b. iree_task_executor_schedule_ready_tasks: walks the FIFO task queue and
-//      builds a iree_task_post_batch_t containing the per-worker tasks
-//      in LIFO order.
+//   b. iree_task_executor_schedule_ready_tasks: walks the FIFO task queue in
+//      priority order and builds a iree_task_post_batch_t containing the
+//      per-worker tasks in LIFO order.
 //
 //   c. iree_task_post_batch_submit: per-worker tasks are pushed to their
 //      respective iree_task_worker_t mailbox_slist and the workers with new
@@ -135,24 +136,28 @@ extern "C" {
 //    each worker will check its mailbox_slist to see if any tasks have been
 //    posted.
 //
-//    a. Tasks are flushed from the LIFO mailbox into the local_task_queue FIFO
-//       for the particular worker.
+//    a. Tasks are flushed from the LIFO mailbox into the local_task_queues
+//       FIFOs (one per task priority) for the particular worker. Dispatch
+//       shards of a lower priority check for newly posted higher priority
+//       tasks at each tile reservation and yield to them if found.
 //
 //    b. If the mailbox is empty the worker *may* attempt to steal work from
 //       another nearby worker in the topology.
 //
-//    c. Any tasks in the local_task_queue are executed until empty.
+//    c. Any tasks in the local_task_queues are executed highest priority first
+//       until empty.
 //       Tasks are retired and dependent tasks (via completion_task or barriers)
-//       are made ready and placed in the executor incoming_ready_slist as with
-//       iree_task_executor_submit.
+//       are made ready and placed in one of the executor incoming_ready_slists
+//       shards as with iree_task_executor_submit.
 //
 //    d. If no more thread-local work is available and the mailbox_slist is
-//       empty the worker will self-nominate for coordination and attempt to don
-//       the coordinator hat with iree_task_executor_coordinate. If new work
+//       empty the worker will self-nominate for coordination and don the
+//       coordinator hat with iree_task_executor_coordinate. If new work
 //       becomes available after coordination step 5 repeats.
 //
-//    e. If another worker (or iree_task_executor_flush) is already wearing the
-//       coordinator hat then the worker will go to sleep.
+//    e. If coordination found no new work (possibly because another worker or
+//       iree_task_executor_flush flushed it first) then the worker will go to
+//       sleep.
 //
 //==============================================================================
 // Scaling Down
@@ -268,6 +273,20 @@ enum iree_task_scheduling_mode_bits_t {
 };
 typedef uint32_t iree_task_scheduling_mode_t;
 
+// Specifies how workers behave when they run out of work.
+enum iree_task_worker_idle_mode_e {
+  // Workers spin for up to worker_spin_ns and then park until woken.
+  IREE_TASK_WORKER_IDLE_MODE_FIXED = 0u,
+  // Workers spin, then yield their timeslice, and then park. Each worker
+  // tracks how long it usually waits for new work to arrive and only spends
+  // its spin (up to worker_spin_ns) and yield (up to worker_yield_ns) budgets
+  // when new work is expected to arrive within them. Bursts of back-to-back
+  // work avoid the wake latency of parking while workers that are idle for
+  // long periods park immediately instead of burning CPU.
+  IREE_TASK_WORKER_IDLE_MODE_ADAPTIVE = 1u,
+};
+typedef uint32_t iree_task_worker_idle_mode_t;
+
 // Options controlling task executor behavior.
 typedef struct iree_task_executor_options_t {
   // Specifies the schedule mode used for worker and workload balancing.
@@ -280,15 +299,33 @@ typedef struct iree_task_executor_options_t {
   // additional work. In almost all cases this should be IREE_DURATION_ZERO as
   // spinning is often extremely harmful to system health. Only set to non-zero
   // values when latency is the #1 priority (over thermals, system-wide
-  // scheduling, and the environment).
+  // scheduling, and the environment). With IREE_TASK_WORKER_IDLE_MODE_ADAPTIVE
+  // this is an upper bound and workers may spin for less.
   iree_duration_t worker_spin_ns;
 
+  // Specifies how workers wait for more work when they run out.
+  iree_task_worker_idle_mode_t worker_idle_mode;
+
+  // Maximum duration in nanoseconds each worker should spend yielding its
+  // timeslice after spinning and before parking when using
+  // IREE_TASK_WORKER_IDLE_MODE_ADAPTIVE. Yielding has a lower wake latency than
+  // parking but unlike spinning allows other threads to use the processor.
+  iree_duration_t worker_yield_ns;
+
   // Defines the bytes to be allocated and reserved by each worker to use for
   // local memory operations. Will be rounded up to the next power of two.
   // Dispatches performed will be able to request up to this amount of memory
-  // for their invocations and no more. May be 0 if no worker local memory is
-  // required.
+  // for their invocations without any additional allocations. May be 0 if no
+  // worker local memory is required up-front.
   iree_host_size_t worker_local_memory_size;
+
+  // Maximum bytes of local memory each worker may lazily grow to when a
+  // dispatch requests more than worker_local_memory_size. Growth happens on
+  // the worker the first time it executes such a dispatch and the memory is
+  // retained for reuse by subsequent dispatches. Dispatches requesting more
+  // than this will fail. Values less than worker_local_memory_size disable
+  // growth.
+  iree_host_size_t worker_local_memory_limit;
 } iree_task_executor_options_t;
 
 // Initializes |out_options| to default values.
@@ -322,6 +359,24 @@ void iree_task_executor_trim(iree_task_executor_t* executor);
 iree_host_size_t iree_task_executor_worker_count(
     iree_task_executor_t* executor);
 
+// Returns true if the calling thread is one of the |executor| workers.
+// Callers that would block waiting on the executor must not do so from a
+// worker as the wait may deadlock if the work is queued behind the caller.
+bool iree_task_executor_is_worker_thread(iree_task_executor_t* executor);
+
+// Returns the largest amount of local memory in bytes requested by any dispatch
+// executed on any worker. Useful for sizing worker_local_memory_size such that
+// no workers need to grow their local memory at runtime.
+iree_host_size_t iree_task_executor_peak_worker_local_memory_size(
+    iree_task_executor_t* executor);
+
+// Returns the largest estimate held by any worker of how long it waits for new
+// work to arrive when using IREE_TASK_WORKER_IDLE_MODE_ADAPTIVE. Useful for
+// diagnosing idle behavior; workers update their estimates as they pick up new
+// work so callers must only query this once all submitted work has completed.
+iree_duration_t iree_task_executor_max_worker_idle_estimate(
+    iree_task_executor_t* executor);
+
 // Returns an iree_event_t pool managed by the executor.
 // Users of the task system should acquire their transient events from this.
 // Long-lived events should be allocated on their own in order to avoid
@@ -38,6 +38,14 @@ struct iree_task_executor_t {
   // IREE_DURATION_ZERO is used to disable spinning.
   iree_duration_t worker_spin_ns;
 
+  // Policy and budget used by workers when they run out of work.
+  // See iree_task_executor_options_t for details.
+  iree_task_worker_idle_mode_t worker_idle_mode;
+  iree_duration_t worker_yield_ns;
+
+  // Maximum size in bytes each worker may grow its local memory to.
+  iree_host_size_t worker_local_memory_limit;
+
   // State used by the work-stealing operations performed by donated threads.
   // This is **NOT SYNCHRONIZED** and relies on the fact that we actually don't
   // much care about the precise selection of workers enough to mind any tears
@@ -56,8 +64,20 @@ struct iree_task_executor_t {
   // Increasing the size larger than these will waste memory.
   iree_task_pool_t transient_task_pool;
 
-  // A list of incoming tasks that are ready to execute immediately.
-  // The list is LIFO and we require that task lists are reversed by the
+  // Bitmask of incoming_ready_slists shards that may have tasks in them.
+  // Submitters set the bit of the shard after concatenating their tasks and
+  // coordinators clear the bits of the shards before flushing them. Lets
+  // coordinators skip the shards (and their locks) entirely when there is no
+  // incoming work, as is the case for most coordination attempts made by
+  // workers as they go idle.
+  iree_atomic_int32_t incoming_ready_mask;
+
+  // Lists of incoming tasks that are ready to execute immediately, sharded by
+  // the processor the submitter was running on to avoid contention between
+  // producers (see IREE_TASK_EXECUTOR_INCOMING_SHARD_COUNT). Ordering is only
+  // maintained within a shard.
+  //
+  // The lists are LIFO and we require that task lists are reversed by the
   // submitter so we can use iree_atomic_slist_concat to quickly prepend the
   // LIFO list to the atomic slist. By doing this we can construct the task
   // lists in LIFO order prior to submission, concat with a pointer swap into
@@ -70,7 +90,8 @@ struct iree_task_executor_t {
   //   existing tasks: C B A
   //        new tasks: 1 2 3
   //    updated tasks: 3 2 1 C B A
-  iree_atomic_task_slist_t incoming_ready_slist;
+  iree_atomic_task_slist_t
+      incoming_ready_slists[IREE_TASK_EXECUTOR_INCOMING_SHARD_COUNT];
 
   // iree_event_t pool used to acquire system wait handles.
   // Many subsystems interacting with the executor will need events to park
@@ -79,10 +100,6 @@ struct iree_task_executor_t {
   // them.
   iree_event_pool_t* event_pool;
 
-  // Guards coordination logic; only one thread at a time may be acting as the
-  // coordinator.
-  iree_slim_mutex_t coordinator_mutex;
-
   // Wait task polling and wait thread manager.
   // This handles all system waits so that we can keep the syscalls off the
   // worker threads and lower wake latencies (the wait thread can enqueue
@@ -119,6 +136,9 @@ struct iree_task_executor_t {
   iree_task_worker_t* workers;  // [worker_count]
 };
 
+static_assert(IREE_TASK_EXECUTOR_INCOMING_SHARD_COUNT <= 31,
+              "incoming_ready_mask must have a non-sign bit for each shard");
+
 // Merges a submission into the primary FIFO queues.
 // Coordinators will fetch items from here as workers demand them but otherwise
 // not be notified of the changes (waiting until coordination runs again).
@@ -128,7 +148,8 @@ void iree_task_executor_merge_submission(iree_task_executor_t* executor,
                                          iree_task_submission_t* submission);
 
 // Schedules all ready tasks in the |pending_submission| list.
-// Only called during coordination and expects the coordinator lock to be held.
+// Only called during coordination with the tasks the coordinator flushed.
+// Multiple coordinators may schedule their own tasks concurrently.
 void iree_task_executor_schedule_ready_tasks(
     iree_task_executor_t* executor, iree_task_submission_t* pending_submission,
     iree_task_post_batch_t* post_batch);
@@ -147,12 +168,15 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
 
 // Tries to steal an entire task from a sibling worker (based on topology).
 // Returns a task that is available (has not yet begun processing at all).
-// May steal multiple tasks and add them to the |local_task_queue|.
+// May steal multiple tasks and add them to the |local_task_queues| entry
+// matching their priority.
+// Only tasks with affinity for the thief indicated by |thief_worker_bit| are
+// stolen.
 iree_task_t* iree_task_executor_try_steal_task(
-    iree_task_executor_t* executor,
+    iree_task_executor_t* executor, iree_task_affinity_set_t thief_worker_bit,
     iree_task_affinity_set_t constructive_sharing_mask,
     uint32_t max_theft_attempts, iree_prng_minilcg128_state_t* theft_prng,
-    iree_task_queue_t* local_task_queue);
+    iree_task_queue_t local_task_queues[IREE_TASK_PRIORITY_COUNT]);
 
 #ifdef __cplusplus
 }  // extern "C"
@@ -6,7 +6,10 @@
 
 #include "iree/task/executor.h"
 
+#include <atomic>
 #include <cstddef>
+#include <thread>
+#include <vector>
 
 #include "iree/testing/gtest.h"
 #include "iree/testing/status_matchers.h"
@@ -85,6 +88,101 @@ TEST(ExecutorTest, LifetimeStress) {
   iree_task_topology_deinitialize(&topology);
 }
 
+// Tests that worker threads are distinguished from the submitting thread.
+TEST(ExecutorTest, IsWorkerThread) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/2, &topology);
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  iree_task_executor_t* executor = NULL;
+  IREE_ASSERT_OK(iree_task_executor_create(options, &topology,
+                                           iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  EXPECT_FALSE(iree_task_executor_is_worker_thread(executor));
+
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("scope"), &scope);
+  static std::atomic<bool> is_worker_thread = {false};
+  iree_task_call_t call;
+  iree_task_call_initialize(
+      &scope,
+      iree_task_make_call_closure(
+          [](void* user_context, iree_task_t* task,
+             iree_task_submission_t* pending_submission) {
+            is_worker_thread = iree_task_executor_is_worker_thread(
+                (iree_task_executor_t*)user_context);
+            return iree_ok_status();
+          },
+          executor),
+      &call);
+  iree_task_fence_t* fence = NULL;
+  IREE_ASSERT_OK(iree_task_executor_acquire_fence(executor, &scope, &fence));
+  iree_task_set_completion_task(&call.header, &fence->header);
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  iree_task_submission_enqueue(&submission, &call.header);
+  iree_task_executor_submit(executor, &submission);
+  iree_task_executor_flush(executor);
+  IREE_ASSERT_OK(iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE));
+  EXPECT_TRUE(is_worker_thread);
+
+  iree_task_scope_deinitialize(&scope);
+  iree_task_executor_release(executor);
+}
+
+// Tests that adaptive workers only count the time spent waiting for work in
+// their idle estimate: back-to-back calls that each keep the worker busy for
+// much longer than the gap between them must leave the estimate near the gap.
+TEST(ExecutorTest, AdaptiveIdleEstimateExcludesBusyTime) {
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  options.worker_idle_mode = IREE_TASK_WORKER_IDLE_MODE_ADAPTIVE;
+  options.worker_spin_ns = 20 * 1000000;
+  options.worker_yield_ns = 20 * 1000000;
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/1, &topology);
+  iree_task_executor_t* executor = NULL;
+  IREE_ASSERT_OK(iree_task_executor_create(options, &topology,
+                                           iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+  iree_task_scope_t scope;
+  iree_task_scope_initialize(iree_make_cstring_view("scope"), &scope);
+
+  static const iree_duration_t kBusyNs = 10 * 1000000;
+  for (int i = 0; i < 50; ++i) {
+    iree_task_call_t call;
+    iree_task_call_initialize(
+        &scope,
+        iree_task_make_call_closure(
+            [](void* user_context, iree_task_t* task,
+               iree_task_submission_t* pending_submission) {
+              iree_time_t end_ns = iree_time_now() + kBusyNs;
+              while (iree_time_now() < end_ns) {
+              }
+              return iree_ok_status();
+            },
+            NULL),
+        &call);
+    iree_task_fence_t* fence = NULL;
+    IREE_ASSERT_OK(iree_task_executor_acquire_fence(executor, &scope, &fence));
+    iree_task_set_completion_task(&call.header, &fence->header);
+    iree_task_submission_t submission;
+    iree_task_submission_initialize(&submission);
+    iree_task_submission_enqueue(&submission, &call.header);
+    iree_task_executor_submit(executor, &submission);
+    iree_task_executor_flush(executor);
+    IREE_ASSERT_OK(
+        iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE));
+  }
+
+  EXPECT_LT(iree_task_executor_max_worker_idle_estimate(executor),
+            kBusyNs / 2);
+
+  iree_task_scope_deinitialize(&scope);
+  iree_task_executor_release(executor);
+}
+
 // Tests heavily serialized submission to an executor.
 // This puts pressure on the overheads involved in spilling up threads.
 TEST(ExecutorTest, SubmissionStress) {
@@ -133,4 +231,71 @@ TEST(ExecutorTest, SubmissionStress) {
   iree_task_topology_deinitialize(&topology);
 }
 
+// Tests many threads submitting and flushing concurrently. Each submitter
+// flushes and coordinates the tasks it submitted while workers coordinate
+// those they ready so every task must be scheduled exactly once and every
+// fence must retire into its scope.
+TEST(ExecutorTest, ConcurrentSubmissionStress) {
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  options.worker_local_memory_size = 64 * 1024;
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/4, &topology);
+  iree_task_executor_t* executor = NULL;
+  IREE_ASSERT_OK(iree_task_executor_create(options, &topology,
+                                           iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  static constexpr int kThreadCount = 8;
+  static constexpr int kBatchCount = 64;
+  static constexpr int kCallsPerBatch = 8;
+  static constexpr int kCallsPerThread = kBatchCount * kCallsPerBatch;
+  std::vector<std::atomic<int>> run_counts(kThreadCount * kCallsPerThread);
+  for (auto& run_count : run_counts) run_count = 0;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreadCount; ++t) {
+    threads.emplace_back([&, t]() {
+      iree_task_scope_t scope;
+      iree_task_scope_initialize(iree_make_cstring_view("scope"), &scope);
+      std::vector<iree_task_call_t> calls(kCallsPerThread);
+      for (int b = 0; b < kBatchCount; ++b) {
+        iree_task_submission_t submission;
+        iree_task_submission_initialize(&submission);
+        for (int c = 0; c < kCallsPerBatch; ++c) {
+          int i = b * kCallsPerBatch + c;
+          iree_task_call_initialize(
+              &scope,
+              iree_task_make_call_closure(
+                  [](void* user_context, iree_task_t* task,
+                     iree_task_submission_t* pending_submission) {
+                    ++*(std::atomic<int>*)user_context;
+                    return iree_ok_status();
+                  },
+                  &run_counts[t * kCallsPerThread + i]),
+              &calls[i]);
+          iree_task_fence_t* fence = NULL;
+          IREE_ASSERT_OK(
+              iree_task_executor_acquire_fence(executor, &scope, &fence));
+          iree_task_set_completion_task(&calls[i].header, &fence->header);
+          iree_task_submission_enqueue(&submission, &calls[i].header);
+        }
+        iree_task_executor_submit(executor, &submission);
+        iree_task_executor_flush(executor);
+      }
+      IREE_ASSERT_OK(
+          iree_task_scope_wait_idle(&scope, IREE_TIME_INFINITE_FUTURE));
+      EXPECT_TRUE(iree_task_scope_is_idle(&scope));
+      iree_task_scope_deinitialize(&scope);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  for (size_t i = 0; i < run_counts.size(); ++i) {
+    EXPECT_EQ(1, run_counts[i].load()) << "task " << i;
+  }
+
+  iree_task_executor_release(executor);
+}
+
 }  // namespace
@@ -89,3 +89,36 @@ iree_task_t* iree_task_queue_try_steal(iree_task_queue_t* source_queue,
   }
   return next_task;
 }
+
+iree_task_t* iree_task_queue_try_steal_with_affinity(
+    iree_task_queue_t* source_queue, iree_task_queue_t* target_queue,
+    iree_task_affinity_set_t target_affinity_set, iree_host_size_t max_tasks) {
+  // First attempt to steal up to max_tasks from the source queue. Any of the
+  // stolen tasks that cannot run on the target are returned to the tail of the
+  // source queue in their original order before we release the lock.
+  iree_task_list_t stolen_tasks;
+  iree_task_list_initialize(&stolen_tasks);
+  if (iree_slim_mutex_try_lock(&source_queue->mutex)) {
+    iree_task_list_t candidate_tasks;
+    iree_task_list_split(&source_queue->list, max_tasks, &candidate_tasks);
+    iree_task_t* task = NULL;
+    while ((task = iree_task_list_pop_front(&candidate_tasks))) {
+      if (task->affinity_set & target_affinity_set) {
+        iree_task_list_push_back(&stolen_tasks, task);
+      } else {
+        iree_task_list_push_back(&source_queue->list, task);
+      }
+    }
+    iree_slim_mutex_unlock(&source_queue->mutex);
+  }
+
+  // Add any stolen tasks to the target queue and pop off the head for return.
+  iree_task_t* next_task = NULL;
+  if (!iree_task_list_is_empty(&stolen_tasks)) {
+    iree_slim_mutex_lock(&target_queue->mutex);
+    iree_task_list_append(&target_queue->list, &stolen_tasks);
+    next_task = iree_task_list_pop_front(&target_queue->list);
+    iree_slim_mutex_unlock(&target_queue->mutex);
+  }
+  return next_task;
+}
@@ -159,6 +159,14 @@ iree_task_t* iree_task_queue_try_steal(iree_task_queue_t* source_queue,
                                        iree_task_queue_t* target_queue,
                                        iree_host_size_t max_tasks);
 
+// Tries to steal up to |max_tasks| from the back of the queue like
+// iree_task_queue_try_steal but only takes the tasks that have affinity for
+// one or more of the workers in |target_affinity_set|. Tasks that would have
+// been stolen but cannot run on the target are left in the |source_queue|.
+iree_task_t* iree_task_queue_try_steal_with_affinity(
+    iree_task_queue_t* source_queue, iree_task_queue_t* target_queue,
+    iree_task_affinity_set_t target_affinity_set, iree_host_size_t max_tasks);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
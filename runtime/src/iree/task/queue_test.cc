@@ -319,4 +319,64 @@ TEST(QueueTest, TryStealAll) {
   iree_task_queue_deinitialize(&target_queue);
 }
 
+TEST(QueueTest, TryStealWithAffinity) {
+  iree_task_queue_t source_queue;
+  iree_task_queue_initialize(&source_queue);
+  iree_task_queue_t target_queue;
+  iree_task_queue_initialize(&target_queue);
+
+  iree_task_t task_a = {0};
+  task_a.affinity_set = iree_task_affinity_for_any_worker();
+  iree_task_t task_b = {0};
+  task_b.affinity_set = iree_task_affinity_for_worker(0);
+  iree_task_t task_c = {0};
+  task_c.affinity_set = iree_task_affinity_for_worker(1);
+  iree_task_t task_d = {0};
+  task_d.affinity_set = iree_task_affinity_for_worker_range(1, 3);
+  iree_task_queue_push_front(&source_queue, &task_d);
+  iree_task_queue_push_front(&source_queue, &task_c);
+  iree_task_queue_push_front(&source_queue, &task_b);
+  iree_task_queue_push_front(&source_queue, &task_a);
+
+  // task_c cannot run on worker 2 and is returned to the source in order.
+  EXPECT_EQ(&task_d, iree_task_queue_try_steal_with_affinity(
+                         &source_queue, &target_queue,
+                         iree_task_affinity_for_worker(2), 1000));
+  EXPECT_TRUE(iree_task_queue_is_empty(&target_queue));
+
+  EXPECT_EQ(&task_a, iree_task_queue_pop_front(&source_queue));
+  EXPECT_EQ(&task_b, iree_task_queue_pop_front(&source_queue));
+  EXPECT_EQ(&task_c, iree_task_queue_pop_front(&source_queue));
+  EXPECT_TRUE(iree_task_queue_is_empty(&source_queue));
+
+  iree_task_queue_deinitialize(&source_queue);
+  iree_task_queue_deinitialize(&target_queue);
+}
+
+TEST(QueueTest, TryStealWithAffinityNoneAllowed) {
+  iree_task_queue_t source_queue;
+  iree_task_queue_initialize(&source_queue);
+  iree_task_queue_t target_queue;
+  iree_task_queue_initialize(&target_queue);
+
+  iree_task_t task_a = {0};
+  task_a.affinity_set = iree_task_affinity_for_worker(0);
+  iree_task_t task_b = {0};
+  task_b.affinity_set = iree_task_affinity_for_worker(0);
+  iree_task_queue_push_front(&source_queue, &task_b);
+  iree_task_queue_push_front(&source_queue, &task_a);
+
+  EXPECT_EQ(nullptr, iree_task_queue_try_steal_with_affinity(
+                         &source_queue, &target_queue,
+                         iree_task_affinity_for_worker(1), 1000));
+  EXPECT_TRUE(iree_task_queue_is_empty(&target_queue));
+
+  EXPECT_EQ(&task_a, iree_task_queue_pop_front(&source_queue));
+  EXPECT_EQ(&task_b, iree_task_queue_pop_front(&source_queue));
+  EXPECT_TRUE(iree_task_queue_is_empty(&source_queue));
+
+  iree_task_queue_deinitialize(&source_queue);
+  iree_task_queue_deinitialize(&target_queue);
+}
+
 }  // namespace
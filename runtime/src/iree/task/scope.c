@@ -29,9 +29,22 @@ void iree_task_scope_initialize(iree_string_view_t name,
 
   iree_notification_initialize(&out_scope->idle_notification);
 
+  out_scope->worker_affinity = iree_task_affinity_for_any_worker();
+  out_scope->priority = IREE_TASK_PRIORITY_DEFAULT;
+
   IREE_TRACE_ZONE_END(z0);
 }
 
+void iree_task_scope_set_worker_affinity(
+    iree_task_scope_t* scope, iree_task_affinity_set_t worker_affinity) {
+  scope->worker_affinity = worker_affinity;
+}
+
+void iree_task_scope_set_priority(iree_task_scope_t* scope,
+                                  iree_task_priority_t priority) {
+  scope->priority = priority;
+}
+
 void iree_task_scope_deinitialize(iree_task_scope_t* scope) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
@@ -73,6 +73,14 @@ typedef struct iree_task_scope_t {
   // tasks or completes all pending tasks after a failure.
   iree_notification_t idle_notification;
   iree_atomic_int32_t pending_idle_notification_posts;
+
+  // Default affinity of tasks initialized within the scope.
+  // Producers can use this to confine all of their work to a subset of the
+  // executor workers such that it does not contend with other producers.
+  iree_task_affinity_set_t worker_affinity;
+
+  // Default priority of tasks initialized within the scope.
+  iree_task_priority_t priority;
 } iree_task_scope_t;
 
 // Initializes a caller-allocated scope.
@@ -81,6 +89,16 @@ typedef struct iree_task_scope_t {
 void iree_task_scope_initialize(iree_string_view_t name,
                                 iree_task_scope_t* out_scope);
 
+// Sets the default worker affinity of all tasks initialized within |scope|.
+// Must be called prior to initializing any tasks with the scope.
+void iree_task_scope_set_worker_affinity(
+    iree_task_scope_t* scope, iree_task_affinity_set_t worker_affinity);
+
+// Sets the scheduling priority of all tasks initialized within |scope|.
+// Must be called prior to initializing any tasks with the scope.
+void iree_task_scope_set_priority(iree_task_scope_t* scope,
+                                  iree_task_priority_t priority);
+
 // Deinitializes an task scope.
 // No tasks may be pending and the scope must be idle.
 void iree_task_scope_deinitialize(iree_task_scope_t* scope);
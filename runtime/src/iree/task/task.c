@@ -27,8 +27,10 @@ void iree_task_initialize(iree_task_type_t type, iree_task_scope_t* scope,
   // NOTE: only clears the header, not the task body.
   memset(out_task, 0, sizeof(*out_task));
   out_task->scope = scope;
-  out_task->affinity_set = iree_task_affinity_for_any_worker();
+  out_task->affinity_set =
+      scope ? scope->worker_affinity : iree_task_affinity_for_any_worker();
   out_task->type = type;
+  out_task->priority = scope ? scope->priority : IREE_TASK_PRIORITY_DEFAULT;
 }
 
 void iree_task_set_cleanup_fn(iree_task_t* task,
@@ -600,38 +602,52 @@ void iree_task_dispatch_issue(iree_task_dispatch_t* dispatch_task,
   dispatch_task->tile_count =
       workgroup_count[0] * workgroup_count[1] * workgroup_count[2];
 
-  // Compute shard count - almost always worker_count unless we are a very small
-  // dispatch (1x1x1, etc).
+  // Shards are only issued to the workers the dispatch has affinity for. If
+  // none of them exist (more bits set than workers) we fall back to all
+  // workers so that the dispatch can still make progress.
   iree_host_size_t worker_count = iree_task_post_batch_worker_count(post_batch);
+  iree_task_affinity_set_t all_worker_mask =
+      iree_task_affinity_for_worker_range(0, (uint8_t)worker_count);
+  iree_task_affinity_set_t worker_mask =
+      dispatch_task->header.affinity_set & all_worker_mask;
+  if (!worker_mask) worker_mask = all_worker_mask;
+
+  // Compute shard count - almost always the worker count unless we are a very
+  // small dispatch (1x1x1, etc).
   iree_host_size_t shard_count =
-      iree_min(dispatch_task->tile_count, worker_count);
+      iree_min(dispatch_task->tile_count,
+               iree_task_affinity_set_count_ones(worker_mask));
 
   // Compute how many tiles we want each shard to reserve at a time from the
   // larger grid. A higher number reduces overhead and improves locality while
   // a lower number reduces maximum worst-case latency (coarser work stealing).
-  if (dispatch_task->tile_count <
-      worker_count * IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION) {
-    // Grid is small - allow it to be eagerly sliced up.
-    dispatch_task->tiles_per_reservation = 1;
-  } else {
-    dispatch_task->tiles_per_reservation =
-        IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION;
-  }
-
-  // Randomize starting worker.
-  iree_host_size_t worker_offset = iree_task_post_batch_select_worker(
-      post_batch, dispatch_task->header.affinity_set);
-  iree_host_size_t worker_index = worker_offset;
+  // Shards size each reservation based on the tiles remaining so that the
+  // bulk of the grid is taken in large slices and the tail in small ones.
+  dispatch_task->max_tiles_per_reservation =
+      IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION;
+  dispatch_task->reservation_divisor = (uint32_t)iree_max(
+      1, shard_count * IREE_TASK_DISPATCH_RESERVATION_SHARD_FACTOR);
+
+  // Randomize starting worker and then walk the allowed workers in order from
+  // there, wrapping around, so that each gets at most one shard.
+  iree_host_size_t worker_offset =
+      iree_task_post_batch_select_worker(post_batch, worker_mask);
+  iree_task_affinity_set_t pending_worker_mask =
+      worker_mask & ~((1ull << worker_offset) - 1);
 
   for (iree_host_size_t i = 0; i < shard_count; ++i) {
+    if (!pending_worker_mask) pending_worker_mask = worker_mask;
+    int worker_index =
+        iree_task_affinity_set_count_trailing_zeros(pending_worker_mask);
+    pending_worker_mask &= pending_worker_mask - 1;
+
     // Allocate and initialize the shard.
     iree_task_dispatch_shard_t* shard_task =
         iree_task_dispatch_shard_allocate(dispatch_task, shard_task_pool);
 
     // Enqueue on the worker selected for the task.
-    iree_task_post_batch_enqueue(post_batch, worker_index % worker_count,
+    iree_task_post_batch_enqueue(post_batch, worker_index,
                                  &shard_task->header);
-    ++worker_index;
   }
 
   // NOTE: the dispatch is not retired until all shards complete. Upon the last
@@ -690,6 +706,8 @@ void iree_task_dispatch_shard_initialize(iree_task_dispatch_t* dispatch_task,
                                          iree_task_dispatch_shard_t* out_task) {
   iree_task_initialize(IREE_TASK_TYPE_DISPATCH_SHARD,
                        dispatch_task->header.scope, &out_task->header);
+  out_task->header.affinity_set = dispatch_task->header.affinity_set;
+  out_task->header.priority = dispatch_task->header.priority;
   iree_task_set_completion_task(&out_task->header, &dispatch_task->header);
 }
 
@@ -707,9 +725,56 @@ iree_task_dispatch_shard_t* iree_task_dispatch_shard_allocate(
   return shard_task;
 }
 
-void iree_task_dispatch_shard_execute(
+// Reserves the next slice of tiles from the dispatch grid.
+// Returns false if all tiles have been reserved. Otherwise the tiles in
+// [|out_tile_base|, |out_tile_end|) are owned by the caller.
+//
+// Reservations are sized by guided self-scheduling: each takes a fraction of
+// the tiles remaining such that early reservations are large (fewer atomics,
+// better locality) and late ones are small (better balance across shards).
+static bool iree_task_dispatch_reserve_tiles(iree_task_dispatch_t* dispatch_task,
+                                             uint32_t* out_tile_base,
+                                             uint32_t* out_tile_end) {
+  const uint32_t tile_count = dispatch_task->tile_count;
+
+  // The current index is only a hint used for sizing: racing with other shards
+  // at worst makes this reservation slightly larger than ideal.
+  uint32_t tile_index_hint = (uint32_t)iree_atomic_load_int32(
+      &dispatch_task->tile_index, iree_memory_order_relaxed);
+  if (tile_index_hint >= tile_count) return false;
+  uint32_t tile_reservation =
+      (tile_count - tile_index_hint) / dispatch_task->reservation_divisor;
+  tile_reservation = iree_min(tile_reservation,
+                              dispatch_task->max_tiles_per_reservation);
+  tile_reservation = iree_max(tile_reservation, 1u);
+
+  // relaxed order because we only care about atomic increments, not about
+  // ordering of tile_index accesses w.r.t. other memory accesses.
+  uint32_t tile_base = (uint32_t)iree_atomic_fetch_add_int32(
+      &dispatch_task->tile_index, (int32_t)tile_reservation,
+      iree_memory_order_relaxed);
+  if (tile_base >= tile_count) return false;
+  *out_tile_base = tile_base;
+  *out_tile_end = iree_min(tile_base + tile_reservation, tile_count);
+  return true;
+}
+
+// Returns true if |pending_priority_mask| indicates that work with a higher
+// priority than |priority| is pending and the caller should yield.
+static inline bool iree_task_dispatch_shard_should_yield(
+    iree_atomic_int32_t* pending_priority_mask, iree_task_priority_t priority) {
+  if (!pending_priority_mask) return false;
+  // relaxed order because this is only a hint; the worker flushes its mailbox
+  // with the appropriate barriers after we yield.
+  int32_t mask =
+      iree_atomic_load_int32(pending_priority_mask, iree_memory_order_relaxed);
+  return (mask & ((1 << priority) - 1)) != 0;
+}
+
+bool iree_task_dispatch_shard_execute(
     iree_task_dispatch_shard_t* task, iree_cpu_processor_id_t processor_id,
     uint32_t worker_id, iree_byte_span_t worker_local_memory,
+    iree_atomic_int32_t* pending_priority_mask,
     iree_task_submission_t* pending_submission) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
@@ -732,7 +797,7 @@ void iree_task_dispatch_shard_execute(
                          worker_local_memory.data_length));
     iree_task_retire(&task->header, pending_submission, iree_ok_status());
     IREE_TRACE_ZONE_END(z0);
-    return;
+    return true;
   }
   iree_byte_span_t local_memory = iree_make_byte_span(
       worker_local_memory.data, dispatch_task->local_memory_size);
@@ -758,27 +823,37 @@ void iree_task_dispatch_shard_execute(
   // Hint as to which processor we are running on.
   tile_context.processor_id = processor_id;
 
-  // Loop over all tiles until they are all processed.
-  const uint32_t tile_count = dispatch_task->tile_count;
-  const uint32_t tiles_per_reservation = dispatch_task->tiles_per_reservation;
-  // relaxed order because we only care about atomic increments, not about
-  // ordering of tile_index accesses w.r.t. other memory accesses.
-  uint32_t tile_base = iree_atomic_fetch_add_int32(&dispatch_task->tile_index,
-                                                   tiles_per_reservation,
-                                                   iree_memory_order_relaxed);
-  while (tile_base < tile_count) {
-    const uint32_t tile_range =
-        iree_min(tile_base + tiles_per_reservation, tile_count);
-    for (uint32_t tile_index = tile_base; tile_index < tile_range;
+  // Loop over all tiles until they are all processed. Reservation boundaries
+  // are the preemption points: if higher priority work arrives for the worker
+  // we stop reserving and let the worker requeue us so that the new work can
+  // run. Any tiles we don't reserve remain available to the other shards.
+  const iree_task_priority_t priority = task->header.priority;
+  bool preempted = false;
+  uint32_t tile_base = 0;
+  uint32_t tile_end = 0;
+  while (true) {
+    if (IREE_UNLIKELY(iree_task_dispatch_shard_should_yield(
+            pending_priority_mask, priority))) {
+      preempted = true;
+      break;
+    }
+    if (!iree_task_dispatch_reserve_tiles(dispatch_task, &tile_base,
+                                          &tile_end)) {
+      break;
+    }
+    // Tiles within a reservation are sequential so we only need to compute
+    // the grid location of the first and can then step through the slice.
+    uint32_t tile_i = tile_base;
+    uint32_t workgroup_x = tile_i % workgroup_count_x;
+    tile_i /= workgroup_count_x;
+    uint32_t workgroup_y = tile_i % workgroup_count_y;
+    tile_i /= workgroup_count_y;
+    uint32_t workgroup_z = tile_i;
+    for (uint32_t tile_index = tile_base; tile_index < tile_end;
          ++tile_index) {
-      // TODO(benvanik): faster math here, especially knowing we pull off N
-      // sequential indices per reservation.
-      uint32_t tile_i = tile_index;
-      tile_context.workgroup_xyz[0] = tile_i % workgroup_count_x;
-      tile_i /= workgroup_count_x;
-      tile_context.workgroup_xyz[1] = tile_i % workgroup_count_y;
-      tile_i /= workgroup_count_y;
-      tile_context.workgroup_xyz[2] = tile_i;
+      tile_context.workgroup_xyz[0] = workgroup_x;
+      tile_context.workgroup_xyz[1] = workgroup_y;
+      tile_context.workgroup_xyz[2] = workgroup_z;
 
       IREE_TRACE_ZONE_BEGIN_NAMED(z_tile,
                                   "iree_task_dispatch_shard_execute_tile");
@@ -808,12 +883,16 @@ void iree_task_dispatch_shard_execute(
         iree_task_try_set_status(&dispatch_task->status, status);
         goto abort_shard;  // out of the while-for nest
       }
-    }
 
-    // Try to grab the next slice of tiles.
-    tile_base = iree_atomic_fetch_add_int32(&dispatch_task->tile_index,
-                                            tiles_per_reservation,
-                                            iree_memory_order_relaxed);
+      // Step to the next tile in x, y, z order.
+      if (++workgroup_x == workgroup_count_x) {
+        workgroup_x = 0;
+        if (++workgroup_y == workgroup_count_y) {
+          workgroup_y = 0;
+          ++workgroup_z;
+        }
+      }
+    }
   }
 abort_shard:
 
@@ -823,8 +902,15 @@ abort_shard:
   iree_task_dispatch_statistics_merge(&shard_statistics,
                                       &dispatch_task->statistics);
 
+  // Preempted shards stay alive until they are resumed and find no more tiles.
+  if (preempted) {
+    IREE_TRACE_ZONE_END(z0);
+    return false;
+  }
+
   // NOTE: even if an error was hit we retire OK - the error has already been
   // propagated to the dispatch and it'll clean up after all shards are joined.
   iree_task_retire(&task->header, pending_submission, iree_ok_status());
   IREE_TRACE_ZONE_END(z0);
+  return true;
 }
@@ -75,6 +75,25 @@ enum iree_task_type_bits_t {
 };
 typedef uint8_t iree_task_type_t;
 
+// Scheduling priority of a task.
+// Workers always run ready tasks of a higher priority before those of a lower
+// priority and dispatch shards of a lower priority yield to newly posted higher
+// priority work at tile reservation boundaries. Priorities only order ready
+// work and do not change dependency ordering: a high priority task waiting on
+// a low priority one will still wait for it to complete.
+enum iree_task_priority_e {
+  // Latency-sensitive work that should run as soon as possible.
+  IREE_TASK_PRIORITY_HIGH = 0u,
+  // Default priority of all tasks.
+  IREE_TASK_PRIORITY_DEFAULT = 1u,
+  // Throughput-oriented background work that yields to all other work.
+  IREE_TASK_PRIORITY_LOW = 2u,
+};
+typedef uint8_t iree_task_priority_t;
+
+// Total number of task priorities.
+#define IREE_TASK_PRIORITY_COUNT 3
+
 enum iree_task_flag_bits_t {
   IREE_TASK_FLAG_NONE = 0u,
 
@@ -178,6 +197,10 @@ struct iree_alignas(iree_max_align_t) iree_task_t {
   // Specifies the type of the task and how the executor handles it.
   iree_task_type_t type;
 
+  // Scheduling priority of the task (iree_task_priority_t).
+  // Inherited from the scope the task is initialized in.
+  iree_task_priority_t priority;
+
   // Task-specific flag bits.
   iree_task_flags_t flags;
 };
@@ -642,9 +665,13 @@ typedef iree_alignas(iree_max_align_t) struct iree_task_dispatch_t {
   uint32_t tile_count;
 
   // Maximum number of tiles to fetch per tile reservation from the grid.
-  // Bounded by IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION and a
-  // reasonable number chosen based on the tile and shard counts.
-  uint32_t tiles_per_reservation;
+  // Bounded by IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION.
+  uint32_t max_tiles_per_reservation;
+
+  // Divisor applied to the number of remaining tiles to size each reservation.
+  // Derived from the shard count such that reservations shrink as the grid is
+  // drained and the final tiles are spread across all shards.
+  uint32_t reservation_divisor;
 
   // The tail tile index; the next reservation will start from here.
   // This is used by shards to slice off the work to perform in their inner
@@ -46,7 +46,9 @@ void iree_task_call_execute(iree_task_call_t* task,
 // Retires a barrier task by notifying all dependent tasks.
 // May add zero or more tasks to the |pending_submission| if they are ready.
 //
-// Only called during coordination and expects the coordinator lock to be held.
+// Only called by the coordinator that flushed |task|. Other coordinators may be
+// running concurrently and dependents are released with atomic dependency
+// tracking so no lock is required.
 void iree_task_barrier_retire(iree_task_barrier_t* task,
                               iree_task_submission_t* pending_submission);
 
@@ -56,7 +58,8 @@ void iree_task_barrier_retire(iree_task_barrier_t* task,
 
 // Retires a fence task by updating the scope state.
 //
-// Only called during coordination and expects the coordinator lock to be held.
+// Only called by the coordinator that flushed |task|; may run concurrently with
+// other coordinators.
 void iree_task_fence_retire(iree_task_fence_t* task,
                             iree_task_submission_t* pending_submission);
 
@@ -66,12 +69,13 @@ void iree_task_fence_retire(iree_task_fence_t* task,
 
 // Returns true if the user-specified condition on the task is true.
 //
-// Only called during coordination and expects the coordinator lock to be held.
+// Only called by the thread that owns |task| (its coordinator or the poller).
 bool iree_task_wait_check_condition(iree_task_wait_t* task);
 
 // Retires a wait when it has completed waiting (successfully or not).
 //
-// Only called during coordination and expects the coordinator lock to be held.
+// Only called by the thread that owns |task| (its coordinator or the poller);
+// may run concurrently with coordination of other tasks.
 void iree_task_wait_retire(iree_task_wait_t* task,
                            iree_task_submission_t* pending_submission,
                            iree_status_t status);
@@ -86,7 +90,8 @@ void iree_task_wait_retire(iree_task_wait_t* task,
 // execution prior to the shards and end execution after the last shard
 // finishes.
 //
-// Only called during coordination and expects the coordinator lock to be held.
+// Only called by the coordinator that flushed |dispatch_task|; may run
+// concurrently with other coordinators.
 void iree_task_dispatch_issue(iree_task_dispatch_t* dispatch_task,
                               iree_task_pool_t* shard_task_pool,
                               iree_task_submission_t* pending_submission,
@@ -94,7 +99,8 @@ void iree_task_dispatch_issue(iree_task_dispatch_t* dispatch_task,
 
 // Retires a dispatch when all issued shards have completed executing.
 //
-// Only called during coordination and expects the coordinator lock to be held.
+// Called by the coordinator that flushed |dispatch_task| if no shards were
+// issued or by the worker that completed the last shard otherwise.
 void iree_task_dispatch_retire(iree_task_dispatch_t* dispatch_task,
                                iree_task_submission_t* pending_submission);
 
@@ -118,11 +124,19 @@ iree_task_dispatch_shard_t* iree_task_dispatch_shard_allocate(
 // |worker_local_memory| is a block of memory exclusively available to the shard
 // during execution. Contents are undefined both before and after execution.
 //
+// |pending_priority_mask| is an optional bitmask of task priorities (bit N
+// indicating priority N) that have work pending for the executing worker. If
+// any bit for a priority higher than the shard's is set when the shard goes to
+// reserve more tiles the shard is preempted: it returns false without retiring
+// and must be requeued by the caller to resume processing the remaining tiles
+// later. Returns true if the shard ran to completion and has been retired.
+//
 // Errors are propagated to the parent scope and the dispatch will fail once
 // all shards have completed.
-void iree_task_dispatch_shard_execute(
+bool iree_task_dispatch_shard_execute(
     iree_task_dispatch_shard_t* task, iree_cpu_processor_id_t processor_id,
     uint32_t worker_id, iree_byte_span_t worker_local_memory,
+    iree_atomic_int32_t* pending_priority_mask,
     iree_task_submission_t* pending_submission);
 
 #ifdef __cplusplus
@@ -4,11 +4,17 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <algorithm>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include "iree/base/api.h"
+#include "iree/task/executor_impl.h"
 #include "iree/task/submission.h"
 #include "iree/task/task.h"
 #include "iree/task/testing/task_test.h"
@@ -67,8 +73,139 @@ class GridCoverage {
   std::unique_ptr<iree_atomic_int32_t[]> storage_;
 };
 
+// Records the order in which the tiles of a LOW priority and a HIGH priority
+// dispatch run. The LOW priority tile |gate_tile| blocks until the gate is
+// opened so that the HIGH priority dispatch can be submitted while the LOW
+// priority one is known to be holding its worker.
+class PreemptionLog {
+ public:
+  // Entry recorded for every HIGH priority tile.
+  static constexpr int32_t kHighTile = -1;
+
+  explicit PreemptionLog(uint32_t gate_tile) : gate_tile_(gate_tile) {
+    iree_atomic_store_int32(&gate_reached_, 0, iree_memory_order_relaxed);
+    iree_atomic_store_int32(&gate_open_, 0, iree_memory_order_relaxed);
+  }
+
+  void WaitForGate() {
+    while (!iree_atomic_load_int32(&gate_reached_, iree_memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+  }
+
+  void OpenGate() {
+    iree_atomic_store_int32(&gate_open_, 1, iree_memory_order_release);
+  }
+
+  std::vector<int32_t> entries() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_;
+  }
+
+  static iree_status_t LowTile(void* user_context,
+                               const iree_task_tile_context_t* tile_context,
+                               iree_task_submission_t* pending_submission) {
+    PreemptionLog* log = reinterpret_cast<PreemptionLog*>(user_context);
+    if (tile_context->workgroup_xyz[0] == log->gate_tile_) {
+      iree_atomic_store_int32(&log->gate_reached_, 1,
+                              iree_memory_order_release);
+      while (!iree_atomic_load_int32(&log->gate_open_,
+                                     iree_memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+    }
+    log->Append((int32_t)tile_context->workgroup_xyz[0]);
+    return iree_ok_status();
+  }
+
+  static iree_status_t HighTile(void* user_context,
+                                const iree_task_tile_context_t* tile_context,
+                                iree_task_submission_t* pending_submission) {
+    reinterpret_cast<PreemptionLog*>(user_context)->Append(kHighTile);
+    return iree_ok_status();
+  }
+
+ private:
+  void Append(int32_t entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.push_back(entry);
+  }
+
+  uint32_t gate_tile_;
+  iree_atomic_int32_t gate_reached_;
+  iree_atomic_int32_t gate_open_;
+  std::mutex mutex_;
+  std::vector<int32_t> entries_;
+};
+
 class TaskDispatchTest : public TaskTest {
  public:
+  // Submits |task| with a fence in its scope without waiting for it.
+  void SubmitWithFence(iree_task_scope_t* scope, iree_task_t* task) {
+    iree_task_fence_t* fence = NULL;
+    IREE_ASSERT_OK(iree_task_executor_acquire_fence(executor_, scope, &fence));
+    iree_task_set_completion_task(task, &fence->header);
+    iree_task_submission_t submission;
+    iree_task_submission_initialize(&submission);
+    iree_task_submission_enqueue(&submission, task);
+    iree_task_executor_submit(executor_, &submission);
+    iree_task_executor_flush(executor_);
+  }
+
+  // Runs a 1D LOW priority dispatch of |low_tile_count| tiles and, once it is
+  // blocked in |gate_tile|, a HIGH priority dispatch of |high_tile_count|
+  // tiles. Both are confined to worker 0 so that the HIGH priority dispatch
+  // can only run by preempting the LOW priority one and all tiles of each run
+  // in order. Returns the log of the tiles in the order they ran.
+  void RunPreemption(uint32_t low_tile_count, uint32_t gate_tile,
+                     uint32_t high_tile_count,
+                     std::vector<int32_t>* out_entries) {
+    const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+    const uint32_t kLowWorkgroupCount[3] = {low_tile_count, 1, 1};
+    const uint32_t kHighWorkgroupCount[3] = {high_tile_count, 1, 1};
+    const iree_task_affinity_set_t kWorkerAffinity =
+        iree_task_affinity_for_worker(0);
+    iree_task_scope_set_priority(&scope_, IREE_TASK_PRIORITY_LOW);
+    iree_task_scope_set_worker_affinity(&scope_, kWorkerAffinity);
+    iree_task_scope_t high_scope;
+    iree_task_scope_initialize(iree_make_cstring_view("high"), &high_scope);
+    iree_task_scope_set_priority(&high_scope, IREE_TASK_PRIORITY_HIGH);
+    iree_task_scope_set_worker_affinity(&high_scope, kWorkerAffinity);
+
+    PreemptionLog log(gate_tile);
+    iree_task_dispatch_t low_task;
+    iree_task_dispatch_initialize(
+        &scope_, iree_task_make_dispatch_closure(PreemptionLog::LowTile, &log),
+        kWorkgroupSize, kLowWorkgroupCount, &low_task);
+    SubmitWithFence(&scope_, &low_task.header);
+    log.WaitForGate();
+
+    iree_task_dispatch_t high_task;
+    iree_task_dispatch_initialize(
+        &high_scope,
+        iree_task_make_dispatch_closure(PreemptionLog::HighTile, &log),
+        kWorkgroupSize, kHighWorkgroupCount, &high_task);
+    SubmitWithFence(&high_scope, &high_task.header);
+
+    // Another worker may be the one coordinating the HIGH priority dispatch so
+    // wait until it has been posted to worker 0 before letting it continue.
+    iree_task_worker_t* worker = &executor_->workers[0];
+    while (!(iree_atomic_load_int32(&worker->mailbox_priority_mask,
+                                    iree_memory_order_acquire) &
+             (1 << IREE_TASK_PRIORITY_HIGH))) {
+      std::this_thread::yield();
+    }
+    log.OpenGate();
+
+    IREE_ASSERT_OK(
+        iree_task_scope_wait_idle(&high_scope, IREE_TIME_INFINITE_FUTURE));
+    IREE_ASSERT_OK(
+        iree_task_scope_wait_idle(&scope_, IREE_TIME_INFINITE_FUTURE));
+    IREE_EXPECT_OK(iree_task_scope_consume_status(&high_scope));
+    iree_task_scope_deinitialize(&high_scope);
+    *out_entries = log.entries();
+  }
+
   void DispatchAndVerifyGrid(const uint32_t workgroup_size[3],
                              const uint32_t workgroup_count[3],
                              uint32_t dispatch_flags) {
@@ -113,6 +250,171 @@ TEST_F(TaskDispatchTest, Issue345) {
   DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount, IREE_TASK_FLAG_NONE);
 }
 
+// Large enough to take multi-tile reservations that span row and slice
+// boundaries of the grid.
+TEST_F(TaskDispatchTest, IssueLarge) {
+  IREE_TRACE_SCOPE();
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {37, 13, 29};
+  DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount, IREE_TASK_FLAG_NONE);
+}
+
+// Dispatches in a scope confined to a subset of the workers must only run
+// tiles on those workers, including any shards stolen between them.
+TEST_F(TaskDispatchTest, IssueWithAffinity) {
+  IREE_TRACE_SCOPE();
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {37, 13, 29};
+  const iree_task_affinity_set_t kWorkerAffinity =
+      iree_task_affinity_for_worker_range(2, 5);
+  iree_task_scope_set_worker_affinity(&scope_, kWorkerAffinity);
+
+  struct TileState {
+    GridCoverage coverage;
+    iree_atomic_int64_t worker_mask;
+  } state = {GridCoverage(kWorkgroupCount), IREE_ATOMIC_VAR_INIT(0)};
+  auto tile = [](void* user_context,
+                 const iree_task_tile_context_t* tile_context,
+                 iree_task_submission_t* pending_submission) -> iree_status_t {
+    TileState* state = reinterpret_cast<TileState*>(user_context);
+    iree_task_affinity_set_t worker_bit =
+        iree_task_affinity_for_worker((uint8_t)tile_context->worker_id);
+    iree_atomic_fetch_or_int64(&state->worker_mask, (int64_t)worker_bit,
+                               iree_memory_order_relaxed);
+    return GridCoverage::Tile(&state->coverage, tile_context,
+                              pending_submission);
+  };
+
+  iree_task_dispatch_t task;
+  iree_task_dispatch_initialize(&scope_,
+                                iree_task_make_dispatch_closure(tile, &state),
+                                kWorkgroupSize, kWorkgroupCount, &task);
+  EXPECT_EQ(kWorkerAffinity, task.header.affinity_set);
+  IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+  EXPECT_TRUE(state.coverage.Verify());
+  iree_task_affinity_set_t worker_mask = (iree_task_affinity_set_t)
+      iree_atomic_load_int64(&state.worker_mask, iree_memory_order_relaxed);
+  EXPECT_NE(0ull, worker_mask);
+  EXPECT_EQ(0ull, worker_mask & ~kWorkerAffinity);
+}
+
+// Issues a large LOW priority dispatch and then a HIGH priority one while it
+// is running. The LOW priority shards are preempted when the HIGH priority
+// shards arrive and must resume afterward without dropping or repeating tiles.
+TEST_F(TaskDispatchTest, IssueMixedPriority) {
+  IREE_TRACE_SCOPE();
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kLowWorkgroupCount[3] = {64, 64, 16};
+  const uint32_t kHighWorkgroupCount[3] = {17, 3, 1};
+  iree_task_scope_set_priority(&scope_, IREE_TASK_PRIORITY_LOW);
+  iree_task_scope_t high_scope;
+  iree_task_scope_initialize(iree_make_cstring_view("high"), &high_scope);
+  iree_task_scope_set_priority(&high_scope, IREE_TASK_PRIORITY_HIGH);
+
+  GridCoverage low_coverage(kLowWorkgroupCount);
+  iree_task_dispatch_t low_task;
+  iree_task_dispatch_initialize(
+      &scope_,
+      iree_task_make_dispatch_closure(GridCoverage::Tile,
+                                      (void*)&low_coverage),
+      kWorkgroupSize, kLowWorkgroupCount, &low_task);
+  iree_task_fence_t* low_fence = NULL;
+  IREE_ASSERT_OK(
+      iree_task_executor_acquire_fence(executor_, &scope_, &low_fence));
+  iree_task_set_completion_task(&low_task.header, &low_fence->header);
+  iree_task_submission_t low_submission;
+  iree_task_submission_initialize(&low_submission);
+  iree_task_submission_enqueue(&low_submission, &low_task.header);
+  iree_task_executor_submit(executor_, &low_submission);
+  iree_task_executor_flush(executor_);
+
+  GridCoverage high_coverage(kHighWorkgroupCount);
+  iree_task_dispatch_t high_task;
+  iree_task_dispatch_initialize(
+      &high_scope,
+      iree_task_make_dispatch_closure(GridCoverage::Tile,
+                                      (void*)&high_coverage),
+      kWorkgroupSize, kHighWorkgroupCount, &high_task);
+  iree_task_fence_t* high_fence = NULL;
+  IREE_ASSERT_OK(
+      iree_task_executor_acquire_fence(executor_, &high_scope, &high_fence));
+  iree_task_set_completion_task(&high_task.header, &high_fence->header);
+  iree_task_submission_t high_submission;
+  iree_task_submission_initialize(&high_submission);
+  iree_task_submission_enqueue(&high_submission, &high_task.header);
+  iree_task_executor_submit(executor_, &high_submission);
+  iree_task_executor_flush(executor_);
+
+  IREE_ASSERT_OK(
+      iree_task_scope_wait_idle(&high_scope, IREE_TIME_INFINITE_FUTURE));
+  IREE_ASSERT_OK(iree_task_scope_wait_idle(&scope_, IREE_TIME_INFINITE_FUTURE));
+  EXPECT_TRUE(high_coverage.Verify());
+  EXPECT_TRUE(low_coverage.Verify());
+  iree_task_scope_deinitialize(&high_scope);
+}
+
+// A HIGH priority dispatch submitted while a LOW priority dispatch is holding
+// the only worker both may run on completes before the LOW priority one does.
+TEST_F(TaskDispatchTest, IssueHighPriorityPreemptsLow) {
+  IREE_TRACE_SCOPE();
+  const uint32_t kLowTileCount = 1024;
+  const uint32_t kHighTileCount = 4;
+  std::vector<int32_t> entries;
+  ASSERT_NO_FATAL_FAILURE(
+      RunPreemption(kLowTileCount, /*gate_tile=*/0, kHighTileCount, &entries));
+  ASSERT_EQ(kLowTileCount + kHighTileCount, entries.size());
+
+  // All HIGH priority tiles run back to back ahead of the remaining LOW
+  // priority tiles. The LOW priority shard may only finish the tiles it had
+  // already reserved when the HIGH priority dispatch arrived.
+  auto first_high =
+      std::find(entries.begin(), entries.end(), PreemptionLog::kHighTile);
+  ASSERT_NE(entries.end(), first_high);
+  EXPECT_LE(first_high - entries.begin(),
+            IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION);
+  for (uint32_t i = 0; i < kHighTileCount; ++i) {
+    ASSERT_NE(entries.end(), first_high + i);
+    EXPECT_EQ(PreemptionLog::kHighTile, first_high[i]);
+  }
+  EXPECT_NE(PreemptionLog::kHighTile, entries.back());
+}
+
+// A LOW priority shard preempted part way through its tiles resumes where it
+// left off once the HIGH priority dispatch completes: every tile runs exactly
+// once and in order.
+TEST_F(TaskDispatchTest, IssuePreemptedShardResumes) {
+  IREE_TRACE_SCOPE();
+  const uint32_t kLowTileCount = 1024;
+  const uint32_t kGateTile = 100;
+  const uint32_t kHighTileCount = 4;
+  std::vector<int32_t> entries;
+  ASSERT_NO_FATAL_FAILURE(
+      RunPreemption(kLowTileCount, kGateTile, kHighTileCount, &entries));
+  ASSERT_EQ(kLowTileCount + kHighTileCount, entries.size());
+
+  std::vector<int32_t> low_entries;
+  std::vector<size_t> high_positions;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (entries[i] == PreemptionLog::kHighTile) {
+      high_positions.push_back(i);
+    } else {
+      low_entries.push_back(entries[i]);
+    }
+  }
+  ASSERT_EQ(kLowTileCount, low_entries.size());
+  for (uint32_t i = 0; i < kLowTileCount; ++i) {
+    EXPECT_EQ((int32_t)i, low_entries[i]);
+  }
+
+  // The HIGH priority tiles run back to back after the gate tile and before
+  // the LOW priority dispatch completes.
+  ASSERT_EQ(kHighTileCount, high_positions.size());
+  EXPECT_GT(high_positions.front(), (size_t)kGateTile);
+  EXPECT_EQ(high_positions.front() + kHighTileCount - 1,
+            high_positions.back());
+  EXPECT_LT(high_positions.back(), entries.size() - 1);
+}
+
 TEST_F(TaskDispatchTest, IssueIndirect) {
   IREE_TRACE_SCOPE();
 
@@ -214,4 +516,60 @@ TEST_F(TaskDispatchTest, IssueFailureChained) {
               StatusIs(StatusCode::kDataLoss));
 }
 
+TEST_F(TaskDispatchTest, IssueLocalMemory) {
+  IREE_TRACE_SCOPE();
+
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {64, 1, 1};
+
+  // Requests more than the initial worker reservation (64KB) but less than the
+  // limit (1MB) such that workers must grow their local memory.
+  static const uint32_t kLocalMemorySize = 256 * 1024;
+  auto tile = [](void* user_context,
+                 const iree_task_tile_context_t* tile_context,
+                 iree_task_submission_t* pending_submission) -> iree_status_t {
+    IREE_TRACE_SCOPE();
+    if (tile_context->local_memory.data_length != kLocalMemorySize) {
+      return iree_make_status(IREE_STATUS_INTERNAL,
+                              "local memory not sized as requested");
+    }
+    memset(tile_context->local_memory.data, 0xCD,
+           tile_context->local_memory.data_length);
+    return iree_ok_status();
+  };
+
+  iree_task_dispatch_t task;
+  iree_task_dispatch_initialize(&scope_,
+                                iree_task_make_dispatch_closure(tile, NULL),
+                                kWorkgroupSize, kWorkgroupCount, &task);
+  task.local_memory_size = kLocalMemorySize;
+  IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+  IREE_EXPECT_OK(iree_task_scope_consume_status(&scope_));
+  EXPECT_EQ(kLocalMemorySize,
+            iree_task_executor_peak_worker_local_memory_size(executor_));
+}
+
+TEST_F(TaskDispatchTest, IssueLocalMemoryExhausted) {
+  IREE_TRACE_SCOPE();
+
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {4, 1, 1};
+
+  auto tile = [](void* user_context,
+                 const iree_task_tile_context_t* tile_context,
+                 iree_task_submission_t* pending_submission) -> iree_status_t {
+    return iree_ok_status();
+  };
+
+  // Requests more than the worker local memory limit (1MB).
+  iree_task_dispatch_t task;
+  iree_task_dispatch_initialize(&scope_,
+                                iree_task_make_dispatch_closure(tile, NULL),
+                                kWorkgroupSize, kWorkgroupCount, &task);
+  task.local_memory_size = 2 * 1024 * 1024;
+  IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+  EXPECT_THAT(Status(iree_task_scope_consume_status(&scope_)),
+              StatusIs(StatusCode::kResourceExhausted));
+}
+
 }  // namespace
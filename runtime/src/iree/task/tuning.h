@@ -80,9 +80,16 @@ extern "C" {
 #define IREE_TASK_EXECUTOR_MAX_THEFT_TASK_COUNT \
   IREE_TASK_EXECUTOR_MAX_WORKER_COUNT
 
-// Number of tiles that will be batched into a single reservation from the grid.
-// This is a maximum; if there are fewer tiles that would otherwise allow for
-// maximum parallelism then this may be ignored.
+// Alignment of worker local memory allocations made when growing beyond the
+// initial executor reservation. Allocations at least this large are aligned to
+// it so that the OS is able to back them with large/huge pages (such as Linux
+// transparent huge pages) and reduce TLB pressure in tiles using the memory.
+#define IREE_TASK_WORKER_LOCAL_MEMORY_LARGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// Maximum number of tiles that will be batched into a single reservation from
+// the grid. Reservations are sized dynamically based on the number of tiles
+// remaining (see IREE_TASK_DISPATCH_RESERVATION_SHARD_FACTOR) and this only
+// bounds the largest reservation taken early on in large dispatches.
 //
 // The more tiles reserved at a time the higher the chance for latency to
 // increase as many reserved tiles are held up on one worker while another may
@@ -91,8 +98,37 @@ extern "C" {
 // The fewer tiles reserved at a time the higher the chance for cache-locality
 // destroying behavior where multiple workers all stomp on the same cache lines
 // (as say worker 0 and worker 1 both fight over sequential tiles adjacent in
-// memory).
-#define IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION (8)
+// memory) and the more time is spent in atomics on the shared tile index.
+#define IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION (64)
+
+// Controls how quickly reservations shrink as a dispatch drains. Each
+// reservation takes 1/(factor * shard_count) of the tiles remaining in the grid
+// (guided self-scheduling) such that dispatches with many small tiles take few
+// large reservations while the tail of every dispatch is handed out one tile at
+// a time to balance out across shards. Higher values produce smaller
+// reservations and better balance at the cost of more atomic operations.
+#define IREE_TASK_DISPATCH_RESERVATION_SHARD_FACTOR (2)
+
+// Number of shards the executor incoming ready list is split into. Submitters
+// (both external threads and workers merging the tasks they readied) push to
+// the shard selected by the processor they are running on such that producers
+// running on different processors do not contend on the same list. Must be
+// <= 31 so that each shard has a bit in the int32 incoming ready mask without
+// using the sign bit.
+#define IREE_TASK_EXECUTOR_INCOMING_SHARD_COUNT (8)
+
+// Weight of the most recent idle period when workers update their estimate of
+// how long they wait for new work with IREE_TASK_WORKER_IDLE_MODE_ADAPTIVE as
+// a power of two: each new sample contributes 1/(1 << shift) of the estimate.
+// Lower values adapt faster to changes in the arrival rate while higher values
+// are less sensitive to outliers.
+#define IREE_TASK_WORKER_IDLE_ESTIMATE_SHIFT (2)
+
+// Multiple of the expected idle period that adaptive workers are willing to
+// spin for. Arrivals jitter and spinning slightly longer than the average
+// catches most of the arrivals that come in just after the average would have
+// had the worker park.
+#define IREE_TASK_WORKER_IDLE_SPIN_FACTOR (2)
 
 // Whether to enable per-tile colors for each tile tracing zone based on the
 // tile grid xyz. Not cheap and can be disabled to reduce tracing overhead.
@@ -37,13 +37,22 @@ iree_status_t iree_task_worker_initialize(
   iree_prng_minilcg128_initialize(iree_prng_splitmix64_next(seed_prng),
                                   &out_worker->theft_prng);
   out_worker->local_memory = local_memory;
+  out_worker->local_memory_heap = NULL;
+  iree_atomic_store_int64(&out_worker->local_memory_peak_size, 0,
+                          iree_memory_order_relaxed);
   out_worker->processor_id = 0;
   out_worker->processor_tag = 0;
+  out_worker->idle_start_ns = 0;
+  out_worker->idle_estimate_ns = 0;
 
   iree_notification_initialize(&out_worker->wake_notification);
   iree_notification_initialize(&out_worker->state_notification);
   iree_atomic_task_slist_initialize(&out_worker->mailbox_slist);
-  iree_task_queue_initialize(&out_worker->local_task_queue);
+  iree_atomic_store_int32(&out_worker->mailbox_priority_mask, 0,
+                          iree_memory_order_relaxed);
+  for (iree_host_size_t i = 0; i < IREE_TASK_PRIORITY_COUNT; ++i) {
+    iree_task_queue_initialize(&out_worker->local_task_queues[i]);
+  }
 
   iree_task_worker_state_t initial_state = IREE_TASK_WORKER_STATE_RUNNING;
   iree_atomic_store_int32(&out_worker->state, initial_state,
@@ -126,38 +135,188 @@ void iree_task_worker_deinitialize(iree_task_worker_t* worker) {
   // get anything more posted to it) and then discarding everything we still
   // have a reference to.
   iree_atomic_task_slist_discard(&worker->mailbox_slist);
-  iree_task_list_discard(&worker->local_task_queue.list);
+  for (iree_host_size_t i = 0; i < IREE_TASK_PRIORITY_COUNT; ++i) {
+    iree_task_list_discard(&worker->local_task_queues[i].list);
+  }
 
   iree_notification_deinitialize(&worker->wake_notification);
   iree_notification_deinitialize(&worker->state_notification);
   iree_atomic_task_slist_deinitialize(&worker->mailbox_slist);
-  iree_task_queue_deinitialize(&worker->local_task_queue);
+  for (iree_host_size_t i = 0; i < IREE_TASK_PRIORITY_COUNT; ++i) {
+    iree_task_queue_deinitialize(&worker->local_task_queues[i]);
+  }
+
+  if (worker->local_memory_heap) {
+    iree_allocator_free_aligned(worker->executor->allocator,
+                                worker->local_memory_heap);
+    worker->local_memory_heap = NULL;
+  }
+  worker->local_memory = iree_make_byte_span(NULL, 0);
 
   IREE_TRACE_ZONE_END(z0);
 }
 
 void iree_task_worker_post_tasks(iree_task_worker_t* worker,
                                  iree_task_list_t* list) {
+  // Gather the priorities being posted so that the worker knows to preempt any
+  // lower priority work it is running. Lists are short (bounded by what the
+  // coordinator issued in one pass) so the walk is cheap.
+  int32_t priority_mask = 0;
+  for (iree_task_t* task = list->head; task; task = task->next_task) {
+    priority_mask |= 1 << task->priority;
+  }
+
   // Move the list into the mailbox. Note that the mailbox is LIFO and this list
   // is concatenated with its current order preserved (which should be LIFO).
   iree_atomic_task_slist_concat(&worker->mailbox_slist, list->head, list->tail);
   memset(list, 0, sizeof(*list));
+
+  // NOTE: set after the concat so that a worker observing the bit will find the
+  // tasks when it flushes the mailbox.
+  iree_atomic_fetch_or_int32(&worker->mailbox_priority_mask, priority_mask,
+                             iree_memory_order_release);
+}
+
+void iree_task_worker_enqueue_local_tasks(iree_task_worker_t* worker,
+                                          iree_task_list_t* list) {
+  // Split the LIFO list into LIFO lists per priority; appending each reverses
+  // it back into FIFO order.
+  iree_task_list_t priority_lists[IREE_TASK_PRIORITY_COUNT];
+  for (iree_host_size_t i = 0; i < IREE_TASK_PRIORITY_COUNT; ++i) {
+    iree_task_list_initialize(&priority_lists[i]);
+  }
+  iree_task_t* task = NULL;
+  while ((task = iree_task_list_pop_front(list))) {
+    iree_task_list_push_back(&priority_lists[task->priority], task);
+  }
+  for (iree_host_size_t i = 0; i < IREE_TASK_PRIORITY_COUNT; ++i) {
+    if (iree_task_list_is_empty(&priority_lists[i])) continue;
+    iree_task_queue_append_from_lifo_list_unsafe(&worker->local_task_queues[i],
+                                                 &priority_lists[i]);
+  }
+}
+
+// Flushes all tasks posted to the worker mailbox into the local queues.
+static void iree_task_worker_flush_mailbox(iree_task_worker_t* worker) {
+  // Clear the mask prior to the flush: any post racing with us will either
+  // have its tasks flushed now or set the mask again for the next flush.
+  iree_atomic_exchange_int32(&worker->mailbox_priority_mask, 0,
+                             iree_memory_order_acq_rel);
+  iree_task_list_t list;
+  iree_task_list_initialize(&list);
+  if (iree_atomic_task_slist_flush(
+          &worker->mailbox_slist, IREE_ATOMIC_SLIST_FLUSH_ORDER_APPROXIMATE_LIFO,
+          &list.head, &list.tail)) {
+    iree_task_worker_enqueue_local_tasks(worker, &list);
+  }
+}
+
+// Pops the next task from the highest priority non-empty local queue.
+static iree_task_t* iree_task_worker_pop_local_task(
+    iree_task_worker_t* worker) {
+  for (iree_host_size_t i = 0; i < IREE_TASK_PRIORITY_COUNT; ++i) {
+    iree_task_t* task =
+        iree_task_queue_pop_front(&worker->local_task_queues[i]);
+    if (task) return task;
+  }
+  return NULL;
+}
+
+// Returns true if all of the worker local queues are empty.
+static bool iree_task_worker_local_queues_are_empty(
+    iree_task_worker_t* worker) {
+  for (iree_host_size_t i = 0; i < IREE_TASK_PRIORITY_COUNT; ++i) {
+    if (!iree_task_queue_is_empty(&worker->local_task_queues[i])) return false;
+  }
+  return true;
 }
 
-iree_task_t* iree_task_worker_try_steal_task(iree_task_worker_t* worker,
-                                             iree_task_queue_t* target_queue,
-                                             iree_host_size_t max_tasks) {
-  // Try to grab tasks from the worker; if more than one task is stolen then the
-  // first will be returned and the remaining will be added to the target queue.
-  iree_task_t* task = iree_task_queue_try_steal(&worker->local_task_queue,
-                                                target_queue, max_tasks);
+iree_task_t* iree_task_worker_try_steal_task(
+    iree_task_worker_t* worker,
+    iree_task_queue_t target_queues[IREE_TASK_PRIORITY_COUNT],
+    iree_task_affinity_set_t target_affinity_set, iree_host_size_t max_tasks) {
+  // Try to grab tasks from the worker starting with its highest priority work;
+  // if more than one task is stolen then the first will be returned and the
+  // remaining will be added to the target queue of the same priority.
+  iree_task_t* task = NULL;
+  for (iree_host_size_t i = 0; i < IREE_TASK_PRIORITY_COUNT && !task; ++i) {
+    task = iree_task_queue_try_steal_with_affinity(
+        &worker->local_task_queues[i], &target_queues[i], target_affinity_set,
+        max_tasks);
+  }
   if (task) return task;
 
   // If we still didn't steal any tasks then let's try the slist instead.
   task = iree_atomic_task_slist_pop(&worker->mailbox_slist);
-  if (task) return task;
+  if (task && !(task->affinity_set & target_affinity_set)) {
+    // The target cannot run the task so it is posted back to the worker. This
+    // may land it ahead of or behind tasks posted while we held it but the
+    // mailbox has no ordering to preserve: posts from multiple threads are
+    // concatenated in any order, every task in it is already ready to run, and
+    // the owner flushes it in approximate LIFO order before re-sorting by
+    // priority. Posting (instead of a bare push) sets the priority mask and we
+    // wake the owner as it may have flushed an empty mailbox and gone idle
+    // while the task was out of it.
+    iree_task_list_t list;
+    iree_task_list_initialize(&list);
+    iree_task_list_push_back(&list, task);
+    iree_task_worker_post_tasks(worker, &list);
+    iree_notification_post(&worker->wake_notification, 1);
+    task = NULL;
+  }
+  return task;
+}
 
-  return NULL;
+// Ensures that the worker local memory is at least |required_size| bytes by
+// growing it up to the executor limit. The grown memory is retained by the
+// worker for reuse by future dispatches. If the memory cannot be grown the
+// existing local memory is left as-is and the dispatch will fail when it finds
+// the memory insufficient.
+static void iree_task_worker_reserve_local_memory(
+    iree_task_worker_t* worker, iree_host_size_t required_size) {
+  // Track the peak request even if we fail to satisfy it so that users can
+  // find out how much they should be reserving.
+  if (required_size > (iree_host_size_t)iree_atomic_load_int64(
+                          &worker->local_memory_peak_size,
+                          iree_memory_order_relaxed)) {
+    iree_atomic_store_int64(&worker->local_memory_peak_size,
+                            (int64_t)required_size, iree_memory_order_relaxed);
+  }
+
+  if (IREE_LIKELY(required_size <= worker->local_memory.data_length)) return;
+  iree_task_executor_t* executor = worker->executor;
+  if (required_size > executor->worker_local_memory_limit) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Round up so that a sequence of slightly increasing requests doesn't cause
+  // repeated reallocations.
+  iree_host_size_t new_size = iree_min(
+      (iree_host_size_t)iree_math_round_up_to_pow2_u64(required_size),
+      executor->worker_local_memory_limit);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)new_size);
+  iree_host_size_t alignment =
+      new_size >= IREE_TASK_WORKER_LOCAL_MEMORY_LARGE_PAGE_SIZE
+          ? IREE_TASK_WORKER_LOCAL_MEMORY_LARGE_PAGE_SIZE
+          : iree_hardware_destructive_interference_size;
+
+  // Contents are not preserved across dispatches so there's no need to
+  // realloc. If allocation fails we keep whatever we already had and the
+  // dispatch will report the exhaustion.
+  void* new_heap = NULL;
+  iree_status_t status = iree_allocator_malloc_aligned(
+      executor->allocator, new_size, alignment, /*offset=*/0, &new_heap);
+  if (iree_status_is_ok(status)) {
+    if (worker->local_memory_heap) {
+      iree_allocator_free_aligned(executor->allocator,
+                                  worker->local_memory_heap);
+    }
+    worker->local_memory_heap = new_heap;
+    worker->local_memory = iree_make_byte_span(new_heap, new_size);
+  } else {
+    iree_status_ignore(status);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
 }
 
 // Executes a task on a worker.
@@ -180,10 +339,22 @@ static void iree_task_worker_execute(
       break;
     }
     case IREE_TASK_TYPE_DISPATCH_SHARD: {
-      iree_task_dispatch_shard_execute(
-          (iree_task_dispatch_shard_t*)task, worker->processor_id,
-          iree_task_affinity_set_count_trailing_zeros(worker->worker_bit),
-          worker->local_memory, pending_submission);
+      // NOTE: the parent dispatch task is the shard completion task.
+      const iree_task_dispatch_t* dispatch_task =
+          (const iree_task_dispatch_t*)task->completion_task;
+      iree_task_worker_reserve_local_memory(worker,
+                                            dispatch_task->local_memory_size);
+      if (!iree_task_dispatch_shard_execute(
+              (iree_task_dispatch_shard_t*)task, worker->processor_id,
+              iree_task_affinity_set_count_trailing_zeros(worker->worker_bit),
+              worker->local_memory, &worker->mailbox_priority_mask,
+              pending_submission)) {
+        // Preempted by higher priority work; put the shard back at the front
+        // of its queue so that it resumes once the new work has run (or is
+        // stolen by a worker with nothing better to do).
+        iree_task_queue_push_front(&worker->local_task_queues[task->priority],
+                                   task);
+      }
       break;
     }
     default:
@@ -195,6 +366,26 @@ static void iree_task_worker_execute(
   task = NULL;
 }
 
+// Records that the worker found new work after having been idle and updates its
+// estimate of how long it usually waits for work to arrive.
+static void iree_task_worker_end_idle(iree_task_worker_t* worker) {
+  if (!worker->idle_start_ns) return;
+  iree_duration_t idle_ns = iree_time_now() - worker->idle_start_ns;
+  worker->idle_start_ns = 0;
+
+  // Clamp the sample so that a single long sleep doesn't take many bursts of
+  // work to recover from: anything longer than the budgets is equally
+  // uninteresting as the worker would have parked anyway.
+  const iree_task_executor_t* executor = worker->executor;
+  iree_duration_t max_idle_ns =
+      IREE_TASK_WORKER_IDLE_SPIN_FACTOR *
+      (executor->worker_spin_ns + executor->worker_yield_ns);
+  idle_ns = iree_min(idle_ns, max_idle_ns);
+  worker->idle_estimate_ns +=
+      (idle_ns - worker->idle_estimate_ns) >>
+      IREE_TASK_WORKER_IDLE_ESTIMATE_SHIFT;
+}
+
 // Pumps the worker thread once, processing a single task.
 // Returns true if pumping should continue as there are more tasks remaining or
 // false if the caller should wait for more tasks to be posted.
@@ -202,10 +393,19 @@ static bool iree_task_worker_pump_once(
     iree_task_worker_t* worker, iree_task_submission_t* pending_submission) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  // Check the local work queue for any work we know we should start
+  // If new work has been posted to the mailbox move it into the local queues
+  // immediately so that it is ordered by priority with the work we already
+  // have. This is also what allows higher priority work to run ahead of any
+  // lower priority shard that yielded to it.
+  if (iree_atomic_load_int32(&worker->mailbox_priority_mask,
+                             iree_memory_order_acquire)) {
+    iree_task_worker_flush_mailbox(worker);
+  }
+
+  // Check the local work queues for any work we know we should start
   // processing immediately. Other workers may try to steal some of this work
   // if we take too long.
-  iree_task_t* task = iree_task_queue_pop_front(&worker->local_task_queue);
+  iree_task_t* task = iree_task_worker_pop_local_task(worker);
 
   // Check the mailbox to see if we have incoming work that has been posted.
   // We try to greedily move it to our local work list so that we can work
@@ -217,8 +417,8 @@ static bool iree_task_worker_pump_once(
     // first place (large uneven workloads for various workers, bad distribution
     // in the face of heterogenous multi-core architectures where some workers
     // complete tasks faster than others, etc).
-    task = iree_task_queue_flush_from_lifo_slist(&worker->local_task_queue,
-                                                 &worker->mailbox_slist);
+    iree_task_worker_flush_mailbox(worker);
+    task = iree_task_worker_pop_local_task(worker);
   }
 
 #if IREE_TASK_EXECUTOR_MAX_THEFT_ATTEMPTS_DIVISOR > 0
@@ -228,9 +428,9 @@ static bool iree_task_worker_pump_once(
   // the first task in the queue is popped off and returned.
   if (!task) {
     task = iree_task_executor_try_steal_task(
-        worker->executor, worker->constructive_sharing_mask,
-        worker->max_theft_attempts, &worker->theft_prng,
-        &worker->local_task_queue);
+        worker->executor, worker->worker_bit,
+        worker->constructive_sharing_mask, worker->max_theft_attempts,
+        &worker->theft_prng, worker->local_task_queues);
   }
 #endif  // IREE_TASK_EXECUTOR_MAX_THEFT_ATTEMPTS_DIVISOR > 0
 
@@ -240,6 +440,10 @@ static bool iree_task_worker_pump_once(
     return false;
   }
 
+  // Work has arrived: close out the idle period (if any) before executing so
+  // that the time spent running the task doesn't count as waiting.
+  iree_task_worker_end_idle(worker);
+
   // Execute the task (may call out to arbitrary user code and may submit more
   // tasks for execution).
   iree_task_worker_execute(worker, task, pending_submission);
@@ -253,6 +457,61 @@ static void iree_task_worker_update_processor_id(iree_task_worker_t* worker) {
   iree_cpu_requery_processor_id(&worker->processor_tag, &worker->processor_id);
 }
 
+// Waits for new work to be posted to the worker using the
+// IREE_TASK_WORKER_IDLE_MODE_ADAPTIVE policy. Callers must loop around and
+// check for work as this may return before any has arrived.
+//
+// The worker spins while new work is expected to arrive soon, then yields its
+// timeslice to other threads, and finally parks in the kernel. The spin and
+// yield budgets are only spent if the worker's recent history indicates that
+// new work usually arrives within them: workers that are idle for long
+// stretches park immediately.
+static void iree_task_worker_wait_adaptive(iree_task_worker_t* worker,
+                                           iree_wait_token_t wait_token) {
+  const iree_task_executor_t* executor = worker->executor;
+  iree_time_t now_ns = iree_time_now();
+  if (!worker->idle_start_ns) worker->idle_start_ns = now_ns;
+  iree_duration_t idle_ns = now_ns - worker->idle_start_ns;
+
+  iree_duration_t spin_ns = 0;
+  iree_duration_t yield_ns = 0;
+  if (worker->idle_estimate_ns <= executor->worker_spin_ns) {
+    spin_ns = iree_min(executor->worker_spin_ns,
+                       IREE_TASK_WORKER_IDLE_SPIN_FACTOR *
+                           iree_max(worker->idle_estimate_ns, 1));
+  }
+  if (worker->idle_estimate_ns <=
+      executor->worker_spin_ns + executor->worker_yield_ns) {
+    yield_ns = executor->worker_yield_ns;
+  }
+
+  if (idle_ns < spin_ns) {
+    // Spin on the notification for the remainder of the budget but don't park;
+    // we'll loop around and come back here once the budget is exhausted.
+    IREE_TRACE_ZONE_BEGIN_NAMED(z_wait,
+                                "iree_task_worker_main_pump_wake_spin");
+    iree_notification_commit_wait(&worker->wake_notification, wait_token,
+                                  /*spin_ns=*/spin_ns - idle_ns,
+                                  /*deadline_ns=*/IREE_TIME_INFINITE_PAST);
+    IREE_TRACE_ZONE_END(z_wait);
+  } else if (idle_ns < spin_ns + yield_ns) {
+    // Let other threads run and then loop around to check for work again.
+    iree_notification_cancel_wait(&worker->wake_notification);
+    iree_thread_yield();
+  } else {
+    IREE_TRACE_ZONE_BEGIN_NAMED(z_wait,
+                                "iree_task_worker_main_pump_wake_wait");
+    iree_notification_commit_wait(&worker->wake_notification, wait_token,
+                                  /*spin_ns=*/IREE_DURATION_ZERO,
+                                  /*deadline_ns=*/IREE_TIME_INFINITE_FUTURE);
+    IREE_TRACE_ZONE_END(z_wait);
+
+    // Woke from a wait - query the processor ID in case we migrated during
+    // the sleep.
+    iree_task_worker_update_processor_id(worker);
+  }
+}
+
 // Alternates between pumping ready tasks in the worker queue and waiting
 // for more tasks to arrive. Only returns when the worker has been asked by
 // the executor to exit.
@@ -310,22 +569,23 @@ static void iree_task_worker_pump_until_exit(iree_task_worker_t* worker) {
                                            iree_memory_order_relaxed);
 
     // When we encounter a complete lack of work we can self-nominate to check
-    // the global work queue and distribute work to other threads. Only one
-    // coordinator can be running at a time so we also ensure that if another
-    // is doing its work we gracefully wait for it. It's fine to block in here
-    // as the next thing we'd have done is go idle anyway.
+    // the global work queue and distribute work to other threads. Multiple
+    // coordinators may run at the same time and each distributes only the
+    // incoming work it flushed.
 
-    // First self-nominate; this *may* do something or just be ignored (if
-    // another worker is already coordinating).
+    // First self-nominate; this *may* do something or find nothing (if there
+    // is no incoming work or another coordinator flushed it first).
     iree_task_executor_coordinate(worker->executor, worker);
 
     // If nothing has been enqueued since we started this loop (so even
     // coordination didn't find anything) we go idle. Otherwise we fall
     // through and try the loop again.
-    if (schedule_dirty ||
-        !iree_task_queue_is_empty(&worker->local_task_queue)) {
+    if (schedule_dirty || !iree_task_worker_local_queues_are_empty(worker)) {
       // Have more work to do; loop around to try another pump.
       iree_notification_cancel_wait(&worker->wake_notification);
+    } else if (worker->executor->worker_idle_mode ==
+               IREE_TASK_WORKER_IDLE_MODE_ADAPTIVE) {
+      iree_task_worker_wait_adaptive(worker, wait_token);
     } else {
       // Spin/wait in the kernel. We don't care if the condition fails as we're
       // just using it as a pulse.
@@ -61,9 +61,15 @@ typedef struct iree_task_worker_t {
   // them based on the work distribution policy. When workers go to look for
   // more work after their local queue empties they will flush this list and
   // move all of the tasks into their local queue and restart processing.
-  // LAYOUT: must be 64b away from local_task_queue.
+  // LAYOUT: must be 64b away from local_task_queues.
   iree_atomic_task_slist_t mailbox_slist;
 
+  // Bitmask of task priorities (bit N indicating priority N) that have been
+  // posted to the mailbox since the worker last flushed it. Running dispatch
+  // shards poll this to yield to higher priority work.
+  // LAYOUT: next to mailbox_slist as posters touch both.
+  iree_atomic_int32_t mailbox_priority_mask;
+
   // Current state of the worker (iree_task_worker_state_t).
   // LAYOUT: frequent access; next to wake_notification as they are always
   //         accessed together.
@@ -117,6 +123,15 @@ typedef struct iree_task_worker_t {
   // An opaque tag used to reduce the cost of processor ID queries.
   iree_cpu_processor_tag_t processor_tag;
 
+  // Time the worker ran out of work or 0 if it is busy. Only touched by the
+  // worker thread and used to measure how long it waits for new work.
+  iree_time_t idle_start_ns;
+
+  // Moving average of how long the worker has been waiting for new work to
+  // arrive. Used to size the spin and yield budgets with
+  // IREE_TASK_WORKER_IDLE_MODE_ADAPTIVE. Only touched by the worker thread.
+  iree_duration_t idle_estimate_ns;
+
   // Destructive interference padding between the mailbox and local task queue
   // to ensure that the worker - who is pounding on local_task_queue - doesn't
   // contend with submissions or coordinators dropping new tasks in the mailbox.
@@ -131,22 +146,33 @@ typedef struct iree_task_worker_t {
 
   // Pointer to local memory available for use exclusively by the worker.
   // The base address should be aligned to avoid false sharing with other
-  // workers.
+  // workers. Initially the reservation made by the executor and replaced with
+  // local_memory_heap if a dispatch requires more.
   iree_byte_span_t local_memory;
 
-  // Worker-local FIFO queue containing the tasks that will be processed by the
-  // worker. This queue supports work-stealing by other workers if they run out
-  // of work of their own.
+  // Heap allocation backing local_memory after it has been grown beyond the
+  // initial executor reservation or NULL if it has not been grown. Owned by
+  // the worker and only touched by the worker thread until it exits.
+  void* local_memory_heap;
+
+  // Largest local memory size in bytes requested by any dispatch executed by
+  // the worker. Written by the worker and read by the executor for reporting.
+  iree_atomic_int64_t local_memory_peak_size;
+
+  // Worker-local FIFO queues containing the tasks that will be processed by the
+  // worker, one per iree_task_priority_t. Higher priority queues are always
+  // drained before lower priority ones. These queues support work-stealing by
+  // other workers if they run out of work of their own.
   // LAYOUT: must be 64b away from mailbox_slist.
-  iree_task_queue_t local_task_queue;
+  iree_task_queue_t local_task_queues[IREE_TASK_PRIORITY_COUNT];
 } iree_task_worker_t;
 static_assert(offsetof(iree_task_worker_t, mailbox_slist) +
                       sizeof(iree_atomic_task_slist_t) <
                   iree_hardware_constructive_interference_size,
               "mailbox_slist must be in the first cache line");
-static_assert(offsetof(iree_task_worker_t, local_task_queue) >=
+static_assert(offsetof(iree_task_worker_t, local_task_queues) >=
                   iree_hardware_constructive_interference_size,
-              "local_task_queue must be separated from mailbox_slist by "
+              "local_task_queues must be separated from mailbox_slist by "
               "at least a cache line");
 
 // Initializes a worker by creating its thread and configuring it for receiving
@@ -187,14 +213,24 @@ void iree_task_worker_deinitialize(iree_task_worker_t* worker);
 void iree_task_worker_post_tasks(iree_task_worker_t* worker,
                                  iree_task_list_t* list);
 
-// Tries to steal up to |max_tasks| from the back of the queue.
+// Appends a LIFO list of tasks directly to the worker local queues matching
+// their priorities, bypassing the mailbox.
+//
+// Must only be called from the worker thread.
+void iree_task_worker_enqueue_local_tasks(iree_task_worker_t* worker,
+                                          iree_task_list_t* list);
+
+// Tries to steal up to |max_tasks| from the back of the queues.
 // Returns NULL if no tasks are available and otherwise up to |max_tasks| tasks
-// that were at the tail of the worker FIFO will be moved to the |target_queue|
-// and the first of the stolen tasks is returned. While tasks from the FIFO
-// are preferred this may also steal tasks from the mailbox.
-iree_task_t* iree_task_worker_try_steal_task(iree_task_worker_t* worker,
-                                             iree_task_queue_t* target_queue,
-                                             iree_host_size_t max_tasks);
+// that were at the tail of the highest priority non-empty worker FIFO will be
+// moved to the |target_queues| entry of the same priority and the first of the
+// stolen tasks is returned. While tasks from the FIFOs are preferred this may
+// also steal tasks from the mailbox. Only tasks with affinity for one or more
+// workers in |target_affinity_set| are stolen.
+iree_task_t* iree_task_worker_try_steal_task(
+    iree_task_worker_t* worker,
+    iree_task_queue_t target_queues[IREE_TASK_PRIORITY_COUNT],
+    iree_task_affinity_set_t target_affinity_set, iree_host_size_t max_tasks);
 
 #ifdef __cplusplus
 }  // extern "C"
@@ -1016,6 +1016,141 @@ static void iree_vm_bytecode_module_free_state(
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Forks the object referenced by |parent_ref| from |parent_state| into a new
+// reference in |state|:
+// - rodata buffers are owned by each state and reference the new state's copy
+// - mutable VM buffers are cloned
+// - VM lists are copied with their elements forked recursively
+// - all other objects are retained and shared; the VM cannot copy them (HAL
+//   buffers, executables, etc) and treats them as immutable once initialized
+static iree_status_t iree_vm_bytecode_module_fork_ref(
+    iree_vm_bytecode_module_state_t* parent_state,
+    iree_vm_bytecode_module_state_t* state, const iree_vm_ref_t* parent_ref,
+    iree_allocator_t allocator, iree_vm_ref_t* out_ref) {
+  *out_ref = iree_vm_ref_null();
+  if (!parent_ref->ptr) return iree_ok_status();
+
+  if (iree_vm_buffer_isa(*parent_ref)) {
+    iree_vm_buffer_t* buffer = iree_vm_buffer_deref(*parent_ref);
+    iree_vm_buffer_t* parent_rodata = parent_state->rodata_ref_table;
+    if (buffer >= parent_rodata &&
+        buffer < parent_rodata + parent_state->rodata_ref_count) {
+      *out_ref = iree_vm_buffer_retain_ref(
+          &state->rodata_ref_table[buffer - parent_rodata]);
+      return iree_ok_status();
+    } else if (iree_all_bits_set(buffer->access,
+                                 IREE_VM_BUFFER_ACCESS_MUTABLE)) {
+      iree_vm_buffer_t* clone = NULL;
+      IREE_RETURN_IF_ERROR(iree_vm_buffer_clone(
+          IREE_VM_BUFFER_ACCESS_MUTABLE | IREE_VM_BUFFER_ACCESS_ORIGIN_GUEST,
+          buffer, 0, iree_vm_buffer_length(buffer), allocator, &clone));
+      *out_ref = iree_vm_buffer_move_ref(clone);
+      return iree_ok_status();
+    }
+  } else if (iree_vm_list_isa(*parent_ref)) {
+    iree_vm_list_t* list = iree_vm_list_deref(*parent_ref);
+    iree_vm_type_def_t element_type;
+    IREE_RETURN_IF_ERROR(iree_vm_list_element_type(list, &element_type));
+    iree_host_size_t size = iree_vm_list_size(list);
+    iree_vm_list_t* clone = NULL;
+    IREE_RETURN_IF_ERROR(
+        iree_vm_list_create(&element_type, size, allocator, &clone));
+    iree_status_t status = iree_vm_list_resize(clone, size);
+    for (iree_host_size_t i = 0; i < size && iree_status_is_ok(status); ++i) {
+      iree_vm_value_t value;
+      iree_vm_ref_t element_ref = iree_vm_ref_null();
+      if (iree_vm_type_def_is_value(&element_type)) {
+        status = iree_vm_list_get_value(list, i, &value);
+        if (iree_status_is_ok(status)) {
+          status = iree_vm_list_set_value(clone, i, &value);
+        }
+        continue;
+      } else if (iree_vm_type_def_is_variant(&element_type)) {
+        iree_vm_variant_t element = iree_vm_variant_empty();
+        status = iree_vm_list_get_variant(list, i, &element);
+        if (!iree_status_is_ok(status) || iree_vm_variant_is_empty(element)) {
+          continue;
+        } else if (!iree_vm_variant_is_ref(element)) {
+          value.type = element.type.value_type;
+          memcpy(value.value_storage, element.value_storage,
+                 sizeof(value.value_storage));
+          status = iree_vm_list_set_value(clone, i, &value);
+          continue;
+        }
+        element_ref = element.ref;
+      } else {
+        status = iree_vm_list_get_ref_assign(list, i, &element_ref);
+        if (!iree_status_is_ok(status)) break;
+      }
+      iree_vm_ref_t forked_ref = iree_vm_ref_null();
+      status = iree_vm_bytecode_module_fork_ref(parent_state, state,
+                                                &element_ref, allocator,
+                                                &forked_ref);
+      if (iree_status_is_ok(status) && forked_ref.ptr) {
+        status = iree_vm_list_set_ref_move(clone, i, &forked_ref);
+      }
+      iree_vm_ref_release(&forked_ref);
+    }
+    if (!iree_status_is_ok(status)) {
+      iree_vm_list_release(clone);
+      return status;
+    }
+    *out_ref = iree_vm_list_move_ref(clone);
+    return iree_ok_status();
+  }
+
+  iree_vm_ref_retain((iree_vm_ref_t*)parent_ref, out_ref);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_vm_bytecode_module_fork_state(
+    void* self, iree_vm_module_state_t* parent_module_state,
+    iree_allocator_t allocator, iree_vm_module_state_t** out_module_state) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_ASSERT_ARGUMENT(parent_module_state);
+  IREE_ASSERT_ARGUMENT(out_module_state);
+  *out_module_state = NULL;
+
+  iree_vm_bytecode_module_state_t* parent_state =
+      (iree_vm_bytecode_module_state_t*)parent_module_state;
+
+  // Allocation also sets up the rodata references owned by each state.
+  iree_vm_module_state_t* module_state = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_bytecode_module_alloc_state(self, allocator, &module_state));
+  iree_vm_bytecode_module_state_t* state =
+      (iree_vm_bytecode_module_state_t*)module_state;
+
+  // Primitive globals are small and copied so that stores from either state
+  // are not observed by the other.
+  memcpy(state->rwdata_storage.data, parent_state->rwdata_storage.data,
+         state->rwdata_storage.data_length);
+
+  // Ref globals are forked such that writes made through objects the VM owns
+  // in one state are not observed by the other.
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < state->global_ref_count; ++i) {
+    status = iree_vm_bytecode_module_fork_ref(
+        parent_state, state, &parent_state->global_ref_table[i], allocator,
+        &state->global_ref_table[i]);
+    if (!iree_status_is_ok(status)) break;
+  }
+  if (!iree_status_is_ok(status)) {
+    iree_vm_bytecode_module_free_state(self, module_state);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  // Imports only reference functions and the forked context has the same
+  // modules registered so the resolved imports are valid as-is.
+  memcpy(state->import_table, parent_state->import_table,
+         state->import_count * sizeof(*state->import_table));
+
+  *out_module_state = module_state;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
 static iree_status_t iree_vm_bytecode_module_resolve_import(
     void* self, iree_vm_module_state_t* module_state, iree_host_size_t ordinal,
     const iree_vm_function_t* function,
@@ -1205,6 +1340,7 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
 #endif  // IREE_VM_BACKTRACE_ENABLE
   module->interface.alloc_state = iree_vm_bytecode_module_alloc_state;
   module->interface.free_state = iree_vm_bytecode_module_free_state;
+  module->interface.fork_state = iree_vm_bytecode_module_fork_state;
   module->interface.resolve_import = iree_vm_bytecode_module_resolve_import;
   module->interface.notify = iree_vm_bytecode_module_notify;
   module->interface.begin_call = iree_vm_bytecode_module_begin_call;
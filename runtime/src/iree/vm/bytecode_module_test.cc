@@ -10,10 +10,321 @@
 
 #include "iree/vm/bytecode_module.h"
 
+#include <utility>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/base/status_cc.h"
 #include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+#include "iree/vm/api.h"
+#include "iree/vm/native_module_test.h"
+#include "iree/vm/ref_cc.h"
+#include "iree/vm/test/fork_bytecode_modules.h"
 
+namespace iree {
 namespace {
 
 // TODO(benvanik): bytecode_module_test.cc for FlatBuffer/module implementation.
 
+// Tests iree_vm_context_fork with the fork_ops bytecode module importing from
+// module_a and the non-forkable module_c defined in native_module_test.h.
+class VMBytecodeModuleForkTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    IREE_CHECK_OK(iree_vm_instance_create(iree_allocator_system(), &instance_));
+
+    IREE_CHECK_OK(
+        module_a_create(instance_, iree_allocator_system(), &module_a_));
+    IREE_CHECK_OK(
+        module_c_create(instance_, iree_allocator_system(), &module_c_));
+
+    const iree_file_toc_t* file = fork_bytecode_modules_c_create();
+    IREE_CHECK_OK(iree_vm_bytecode_module_create(
+        instance_,
+        iree_const_byte_span_t{reinterpret_cast<const uint8_t*>(file->data),
+                               file->size},
+        iree_allocator_null(), iree_allocator_system(), &bytecode_module_));
+  }
+
+  virtual void TearDown() {
+    iree_vm_module_release(bytecode_module_);
+    iree_vm_module_release(module_c_);
+    iree_vm_module_release(module_a_);
+    iree_vm_instance_release(instance_);
+  }
+
+  // Creates a frozen context with all modules; this runs the fork_ops and
+  // module_c initializers and leaves both counters at 42.
+  void CreateParentContext(iree_vm_context_t** out_context) {
+    std::vector<iree_vm_module_t*> modules = {module_a_, module_c_,
+                                              bytecode_module_};
+    IREE_CHECK_OK(iree_vm_context_create_with_modules(
+        instance_, IREE_VM_CONTEXT_FLAG_NONE, modules.size(), modules.data(),
+        iree_allocator_system(), out_context));
+    IREE_CHECK_OK(iree_vm_context_freeze(*out_context));
+  }
+
+  // Invokes |module|.|function_name| in |context| with the optional |inputs|
+  // and returns the output list.
+  StatusOr<vm::ref<iree_vm_list_t>> Invoke(iree_vm_context_t* context,
+                                           iree_vm_module_t* module,
+                                           const char* function_name,
+                                           iree_vm_list_t* inputs = nullptr) {
+    iree_vm_function_t function;
+    IREE_RETURN_IF_ERROR(iree_vm_module_lookup_function_by_name(
+        module, IREE_VM_FUNCTION_LINKAGE_EXPORT,
+        iree_make_cstring_view(function_name), &function));
+    vm::ref<iree_vm_list_t> output_list;
+    IREE_RETURN_IF_ERROR(iree_vm_list_create(
+        /*element_type=*/nullptr, 1, iree_allocator_system(), &output_list));
+    IREE_RETURN_IF_ERROR(iree_vm_invoke(
+        context, function, IREE_VM_INVOCATION_FLAG_NONE, /*policy=*/nullptr,
+        inputs, output_list.get(), iree_allocator_system()));
+    return std::move(output_list);
+  }
+
+  StatusOr<int32_t> InvokeI32(iree_vm_context_t* context,
+                              iree_vm_module_t* module,
+                              const char* function_name) {
+    IREE_ASSIGN_OR_RETURN(auto output_list,
+                          Invoke(context, module, function_name));
+    iree_vm_value_t value;
+    IREE_RETURN_IF_ERROR(iree_vm_list_get_value(output_list.get(), 0, &value));
+    return value.i32;
+  }
+
+  StatusOr<int32_t> InvokeI32(iree_vm_context_t* context,
+                              const char* function_name) {
+    return InvokeI32(context, bytecode_module_, function_name);
+  }
+
+  // Invokes fork_ops.|function_name| and returns its ref result of type T.
+  template <typename T>
+  StatusOr<vm::ref<T>> InvokeRef(iree_vm_context_t* context,
+                                 const char* function_name) {
+    IREE_ASSIGN_OR_RETURN(auto output_list,
+                          Invoke(context, bytecode_module_, function_name));
+    T* value = (T*)iree_vm_list_get_ref_deref(
+        output_list.get(), 0, vm::ref_type_descriptor<T>::get());
+    if (!value) {
+      return iree_make_status(IREE_STATUS_INTERNAL,
+                              "expected a ref result of the requested type");
+    }
+    return vm::retain_ref(value);
+  }
+
+  Status SetBuffer(iree_vm_context_t* context, iree_vm_buffer_t* buffer) {
+    vm::ref<iree_vm_list_t> input_list;
+    IREE_RETURN_IF_ERROR(iree_vm_list_create(
+        /*element_type=*/nullptr, 1, iree_allocator_system(), &input_list));
+    iree_vm_ref_t buffer_ref = iree_vm_buffer_retain_ref(buffer);
+    IREE_RETURN_IF_ERROR(
+        iree_vm_list_push_ref_move(input_list.get(), &buffer_ref));
+    return Invoke(context, bytecode_module_, "set_buffer", input_list.get())
+        .status();
+  }
+
+  iree_vm_instance_t* instance_ = nullptr;
+  iree_vm_module_t* module_a_ = nullptr;
+  iree_vm_module_t* module_c_ = nullptr;
+  iree_vm_module_t* bytecode_module_ = nullptr;
+};
+
+TEST_F(VMBytecodeModuleForkTest, RequiresFrozenParent) {
+  std::vector<iree_vm_module_t*> modules = {module_a_, module_c_,
+                                            bytecode_module_};
+  iree_vm_context_t* parent = nullptr;
+  IREE_ASSERT_OK(iree_vm_context_create_with_modules(
+      instance_, IREE_VM_CONTEXT_FLAG_NONE, modules.size(), modules.data(),
+      iree_allocator_system(), &parent));
+  iree_vm_context_t* fork = nullptr;
+  EXPECT_THAT(Status(iree_vm_context_fork(parent, iree_allocator_system(),
+                                          &fork)),
+              testing::status::StatusIs(StatusCode::kFailedPrecondition));
+  EXPECT_EQ(nullptr, fork);
+  iree_vm_context_release(parent);
+}
+
+// Primitive globals are copied into the fork and diverge afterward.
+TEST_F(VMBytecodeModuleForkTest, GlobalsDivergeAfterFork) {
+  iree_vm_context_t* parent = nullptr;
+  CreateParentContext(&parent);
+  IREE_ASSERT_OK_AND_ASSIGN(int32_t v0, InvokeI32(parent, "get_counter"));
+  EXPECT_EQ(42, v0);
+  IREE_ASSERT_OK_AND_ASSIGN(int32_t v1, InvokeI32(parent, "increment_counter"));
+  EXPECT_EQ(43, v1);
+
+  // The fork starts from the parent value and does not rerun __init.
+  iree_vm_context_t* fork = nullptr;
+  IREE_ASSERT_OK(iree_vm_context_fork(parent, iree_allocator_system(), &fork));
+  IREE_ASSERT_OK_AND_ASSIGN(int32_t v2, InvokeI32(fork, "get_counter"));
+  EXPECT_EQ(43, v2);
+
+  // Imports remain resolved in the fork and stores are private to it.
+  IREE_ASSERT_OK_AND_ASSIGN(int32_t v3, InvokeI32(fork, "increment_counter"));
+  EXPECT_EQ(44, v3);
+  IREE_ASSERT_OK_AND_ASSIGN(int32_t v4, InvokeI32(fork, "increment_counter"));
+  EXPECT_EQ(45, v4);
+  IREE_ASSERT_OK_AND_ASSIGN(int32_t v5, InvokeI32(parent, "get_counter"));
+  EXPECT_EQ(43, v5);
+  IREE_ASSERT_OK_AND_ASSIGN(int32_t v6, InvokeI32(parent, "increment_counter"));
+  EXPECT_EQ(44, v6);
+  IREE_ASSERT_OK_AND_ASSIGN(int32_t v7, InvokeI32(fork, "get_counter"));
+  EXPECT_EQ(45, v7);
+
+  iree_vm_context_release(fork);
+  iree_vm_context_release(parent);
+}
+
+// Lists referenced by globals are copied into the fork so that in-place writes
+// in either context are not observed by the other.
+TEST_F(VMBytecodeModuleForkTest, ListGlobalsCopiedOnFork) {
+  iree_vm_context_t* parent = nullptr;
+  CreateParentContext(&parent);
+  IREE_ASSERT_OK_AND_ASSIGN(auto parent_list,
+                            InvokeRef<iree_vm_list_t>(parent, "get_list"));
+  const int32_t values[] = {1, 2, 3};
+  IREE_ASSERT_OK(iree_vm_list_resize(parent_list.get(), 3));
+  IREE_ASSERT_OK(iree_vm_list_set_values(
+      parent_list.get(), 0, IREE_VM_VALUE_TYPE_I32,
+      iree_make_const_byte_span(values, sizeof(values))));
+
+  iree_vm_context_t* fork = nullptr;
+  IREE_ASSERT_OK(iree_vm_context_fork(parent, iree_allocator_system(), &fork));
+  IREE_ASSERT_OK_AND_ASSIGN(auto fork_list,
+                            InvokeRef<iree_vm_list_t>(fork, "get_list"));
+  EXPECT_NE(parent_list.get(), fork_list.get());
+  ASSERT_EQ(3u, iree_vm_list_size(fork_list.get()));
+  int32_t fork_values[3] = {0};
+  IREE_ASSERT_OK(iree_vm_list_get_values(
+      fork_list.get(), 0, IREE_VM_VALUE_TYPE_I32,
+      iree_make_byte_span(fork_values, sizeof(fork_values))));
+  EXPECT_EQ(1, fork_values[0]);
+  EXPECT_EQ(2, fork_values[1]);
+  EXPECT_EQ(3, fork_values[2]);
+
+  // Writes to the fork copy are not observed by the parent.
+  iree_vm_value_t value = iree_vm_value_make_i32(100);
+  IREE_ASSERT_OK(iree_vm_list_set_value(fork_list.get(), 0, &value));
+  IREE_ASSERT_OK(iree_vm_list_resize(fork_list.get(), 4));
+  IREE_ASSERT_OK(iree_vm_list_get_value(parent_list.get(), 0, &value));
+  EXPECT_EQ(1, value.i32);
+  EXPECT_EQ(3u, iree_vm_list_size(parent_list.get()));
+
+  // Replacing the global in the fork leaves the parent global untouched.
+  IREE_ASSERT_OK(Invoke(fork, bytecode_module_, "reset_list").status());
+  IREE_ASSERT_OK_AND_ASSIGN(auto parent_list_again,
+                            InvokeRef<iree_vm_list_t>(parent, "get_list"));
+  EXPECT_EQ(parent_list.get(), parent_list_again.get());
+
+  iree_vm_context_release(fork);
+  iree_vm_context_release(parent);
+}
+
+// Mutable buffers referenced by globals are cloned while read-only buffers are
+// shared with the parent and retained by the fork.
+TEST_F(VMBytecodeModuleForkTest, BufferGlobalsForkedByAccess) {
+  iree_vm_context_t* parent = nullptr;
+  CreateParentContext(&parent);
+
+  vm::ref<iree_vm_buffer_t> mutable_buffer;
+  IREE_ASSERT_OK(iree_vm_buffer_create(
+      IREE_VM_BUFFER_ACCESS_MUTABLE | IREE_VM_BUFFER_ACCESS_ORIGIN_HOST, 16,
+      iree_allocator_system(), &mutable_buffer));
+  IREE_ASSERT_OK(iree_vm_buffer_fill_bytes(mutable_buffer.get(), 0, 16, 0xAB));
+  IREE_ASSERT_OK(SetBuffer(parent, mutable_buffer.get()));
+
+  iree_vm_context_t* fork = nullptr;
+  IREE_ASSERT_OK(iree_vm_context_fork(parent, iree_allocator_system(), &fork));
+  IREE_ASSERT_OK_AND_ASSIGN(auto fork_buffer,
+                            InvokeRef<iree_vm_buffer_t>(fork, "get_buffer"));
+  EXPECT_NE(mutable_buffer.get(), fork_buffer.get());
+  bool equal = false;
+  IREE_ASSERT_OK(iree_vm_buffer_compare_bytes(
+      mutable_buffer.get(), 0, fork_buffer.get(), 0, 16, &equal));
+  EXPECT_TRUE(equal);
+  IREE_ASSERT_OK(iree_vm_buffer_fill_bytes(fork_buffer.get(), 0, 16, 0xCD));
+  uint8_t parent_byte = 0;
+  IREE_ASSERT_OK(iree_vm_buffer_read_elements(mutable_buffer.get(), 0,
+                                              &parent_byte, 1, 1));
+  EXPECT_EQ(0xAB, parent_byte);
+  fork_buffer.reset();
+  iree_vm_context_release(fork);
+
+  vm::ref<iree_vm_buffer_t> readonly_buffer;
+  IREE_ASSERT_OK(iree_vm_buffer_create(IREE_VM_BUFFER_ACCESS_ORIGIN_HOST, 16,
+                                       iree_allocator_system(),
+                                       &readonly_buffer));
+  IREE_ASSERT_OK(SetBuffer(parent, readonly_buffer.get()));
+  IREE_ASSERT_OK(iree_vm_context_fork(parent, iree_allocator_system(), &fork));
+
+  // The fork keeps the shared buffer alive after the parent and all other
+  // references to it have been released.
+  iree_vm_buffer_t* shared_buffer = readonly_buffer.get();
+  readonly_buffer.reset();
+  iree_vm_context_release(parent);
+  IREE_ASSERT_OK_AND_ASSIGN(fork_buffer,
+                            InvokeRef<iree_vm_buffer_t>(fork, "get_buffer"));
+  EXPECT_EQ(shared_buffer, fork_buffer.get());
+  EXPECT_EQ(16u, iree_vm_buffer_length(fork_buffer.get()));
+  fork_buffer.reset();
+  iree_vm_context_release(fork);
+}
+
+// Rodata buffers stored in globals are owned by each module state and remain
+// valid in the fork after the parent is released.
+TEST_F(VMBytecodeModuleForkTest, RodataGlobalsOwnedByFork) {
+  iree_vm_context_t* parent = nullptr;
+  CreateParentContext(&parent);
+  iree_vm_context_t* fork = nullptr;
+  IREE_ASSERT_OK(iree_vm_context_fork(parent, iree_allocator_system(), &fork));
+  iree_vm_context_release(parent);
+
+  IREE_ASSERT_OK_AND_ASSIGN(
+      auto rodata_buffer,
+      InvokeRef<iree_vm_buffer_t>(fork, "get_rodata_buffer"));
+  int32_t values[3] = {0};
+  IREE_ASSERT_OK(iree_vm_buffer_read_elements(rodata_buffer.get(), 0, values,
+                                              IREE_ARRAYSIZE(values),
+                                              sizeof(values[0])));
+  EXPECT_EQ(1, values[0]);
+  EXPECT_EQ(2, values[1]);
+  EXPECT_EQ(3, values[2]);
+  rodata_buffer.reset();
+  iree_vm_context_release(fork);
+}
+
+// Modules without fork_state (module_c) get new state with resolved imports and
+// run __init just as when they are registered in a new context while forkable
+// modules in the same context keep their parent state.
+TEST_F(VMBytecodeModuleForkTest, ForkWithoutForkState) {
+  ASSERT_EQ(nullptr, module_c_->fork_state);
+  iree_vm_context_t* parent = nullptr;
+  CreateParentContext(&parent);
+  IREE_ASSERT_OK_AND_ASSIGN(
+      int32_t v0, InvokeI32(parent, module_c_, "increment_counter"));
+  EXPECT_EQ(43, v0);
+  IREE_ASSERT_OK_AND_ASSIGN(int32_t v1, InvokeI32(parent, "increment_counter"));
+  EXPECT_EQ(43, v1);
+
+  iree_vm_context_t* fork = nullptr;
+  IREE_ASSERT_OK(iree_vm_context_fork(parent, iree_allocator_system(), &fork));
+  IREE_ASSERT_OK_AND_ASSIGN(int32_t v2,
+                            InvokeI32(fork, module_c_, "get_counter"));
+  EXPECT_EQ(42, v2);
+  IREE_ASSERT_OK_AND_ASSIGN(int32_t v3,
+                            InvokeI32(fork, module_c_, "increment_counter"));
+  EXPECT_EQ(43, v3);
+  IREE_ASSERT_OK_AND_ASSIGN(int32_t v4, InvokeI32(fork, "get_counter"));
+  EXPECT_EQ(43, v4);
+  IREE_ASSERT_OK_AND_ASSIGN(int32_t v5,
+                            InvokeI32(parent, module_c_, "get_counter"));
+  EXPECT_EQ(43, v5);
+
+  iree_vm_context_release(fork);
+  iree_vm_context_release(parent);
+}
+
 }  // namespace
+}  // namespace iree
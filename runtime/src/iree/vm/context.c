@@ -295,21 +295,19 @@ IREE_API_EXPORT iree_status_t iree_vm_context_create(
       out_context);
 }
 
-IREE_API_EXPORT iree_status_t iree_vm_context_create_with_modules(
+// Allocates a context with inline storage for |module_count| modules.
+// The context is frozen if |module_count| is non-zero.
+static iree_status_t iree_vm_context_allocate(
     iree_vm_instance_t* instance, iree_vm_context_flags_t flags,
-    iree_host_size_t module_count, iree_vm_module_t** modules,
-    iree_allocator_t allocator, iree_vm_context_t** out_context) {
-  IREE_TRACE_ZONE_BEGIN(z0);
-  IREE_ASSERT_ARGUMENT(out_context);
-  *out_context = NULL;
-
+    iree_host_size_t module_count, iree_allocator_t allocator,
+    iree_vm_context_t** out_context) {
   iree_host_size_t context_size =
       sizeof(iree_vm_context_t) + sizeof(iree_vm_module_t*) * module_count +
       sizeof(iree_vm_module_state_t*) * module_count;
 
   iree_vm_context_t* context = NULL;
-  IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0, iree_allocator_malloc(allocator, context_size, (void**)&context));
+  IREE_RETURN_IF_ERROR(
+      iree_allocator_malloc(allocator, context_size, (void**)&context));
   iree_atomic_ref_count_init(&context->ref_count);
   context->instance = instance;
   iree_vm_instance_retain(context->instance);
@@ -330,6 +328,23 @@ IREE_API_EXPORT iree_status_t iree_vm_context_create_with_modules(
   context->list.count = 0;
   context->list.capacity = module_count;
 
+  *out_context = context;
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_context_create_with_modules(
+    iree_vm_instance_t* instance, iree_vm_context_flags_t flags,
+    iree_host_size_t module_count, iree_vm_module_t** modules,
+    iree_allocator_t allocator, iree_vm_context_t** out_context) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_ASSERT_ARGUMENT(out_context);
+  *out_context = NULL;
+
+  iree_vm_context_t* context = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_context_allocate(instance, flags, module_count, allocator,
+                                   &context));
+
   iree_status_t register_status =
       iree_vm_context_register_modules(context, module_count, modules);
   if (!iree_status_is_ok(register_status)) {
@@ -343,6 +358,101 @@ IREE_API_EXPORT iree_status_t iree_vm_context_create_with_modules(
   return iree_ok_status();
 }
 
+// Creates the state for |module| in |context| by forking |parent_state|, or
+// when the module does not support forking by allocating new state and
+// resolving its imports. |out_needs_init| is set if the state still needs to
+// have the module __init function run on it.
+static iree_status_t iree_vm_context_fork_module_state(
+    iree_vm_context_t* context, iree_vm_module_t* module,
+    iree_vm_module_state_t* parent_state,
+    iree_vm_module_state_t** out_module_state, bool* out_needs_init) {
+  *out_needs_init = false;
+  if (module->fork_state) {
+    return module->fork_state(module->self, parent_state, context->allocator,
+                              out_module_state);
+  }
+  *out_needs_init = true;
+  IREE_RETURN_IF_ERROR(
+      module->alloc_state(module->self, context->allocator, out_module_state));
+  iree_status_t status =
+      iree_vm_context_resolve_module_imports(context, module, *out_module_state);
+  if (!iree_status_is_ok(status)) {
+    iree_string_view_t module_name = iree_vm_module_name(module);
+    (void)module_name;
+    status = iree_status_annotate_f(status, "resolving module '%.*s' imports",
+                                    (int)module_name.size, module_name.data);
+  }
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_context_fork(
+    const iree_vm_context_t* parent_context, iree_allocator_t allocator,
+    iree_vm_context_t** out_context) {
+  IREE_ASSERT_ARGUMENT(parent_context);
+  IREE_ASSERT_ARGUMENT(out_context);
+  *out_context = NULL;
+  if (!parent_context->is_frozen) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "only frozen contexts can be forked");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_host_size_t module_count = parent_context->list.count;
+  iree_vm_context_t* context = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_context_allocate(parent_context->instance,
+                                   parent_context->flags, module_count,
+                                   allocator, &context));
+  // Forked contexts can never have modules registered as module states are
+  // only valid with the exact module list of the parent.
+  context->is_frozen = 1;
+
+  // VM stack used to call into module __init methods of modules that do not
+  // support forking.
+  IREE_VM_INLINE_STACK_INITIALIZE(
+      stack,
+      context->flags & IREE_VM_CONTEXT_FLAG_TRACE_EXECUTION
+          ? IREE_VM_INVOCATION_FLAG_TRACE_EXECUTION
+          : IREE_VM_INVOCATION_FLAG_NONE,
+      iree_vm_context_state_resolver(context), context->allocator);
+
+  // Fork the module states in registration order so that any module that needs
+  // to be initialized can call into the modules it imports.
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < module_count; ++i) {
+    iree_vm_module_t* module = parent_context->list.modules[i];
+    context->list.modules[i] = module;
+    context->list.module_states[i] = NULL;
+    iree_vm_module_retain(module);
+    ++context->list.count;
+
+    bool needs_init = false;
+    status = iree_vm_context_fork_module_state(
+        context, module, parent_context->list.module_states[i],
+        &context->list.module_states[i], &needs_init);
+    if (!iree_status_is_ok(status)) break;
+
+    if (needs_init) {
+      status = iree_vm_context_run_function(context, stack, module,
+                                            iree_make_cstring_view("__init"));
+      if (!iree_status_is_ok(status)) break;
+    }
+  }
+
+  iree_vm_stack_deinitialize(stack);
+
+  // Any partially forked modules are released along with the context.
+  if (!iree_status_is_ok(status)) {
+    iree_vm_context_destroy(context);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  *out_context = context;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
 static void iree_vm_context_destroy(iree_vm_context_t* context) {
   if (!context) return;
 
@@ -68,6 +68,28 @@ IREE_API_EXPORT iree_status_t iree_vm_context_create_with_modules(
     iree_host_size_t module_count, iree_vm_module_t** modules,
     iree_allocator_t allocator, iree_vm_context_t** out_context);
 
+// Creates a new context by forking the initialized and frozen
+// |parent_context|. The new context has the same instance, flags, and modules
+// as the parent and its module state is forked from the parent state instead of
+// being initialized again: module __init functions are not run and bytecode
+// modules copy primitive globals and the VM objects they may write in place
+// (lists and mutable buffers) while sharing all other ref globals (HAL buffers,
+// executables, etc) with the parent. Modules that do not support forking have
+// new state allocated and initialized as in
+// iree_vm_context_create_with_modules.
+//
+// Storing to a global or writing to a VM list or buffer referenced by a global
+// in either context does not affect the other. Objects of other types
+// referenced by ref globals are shared and must not be modified in place by
+// either context.
+//
+// |parent_context| must not be executing concurrently with the fork. The forked
+// context retains everything it shares and may outlive the parent.
+// |out_context| must be released by the caller.
+IREE_API_EXPORT iree_status_t iree_vm_context_fork(
+    const iree_vm_context_t* parent_context, iree_allocator_t allocator,
+    iree_vm_context_t** out_context);
+
 // Retains the given |context| for the caller.
 IREE_API_EXPORT void iree_vm_context_retain(iree_vm_context_t* context);
 
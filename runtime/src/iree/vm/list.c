@@ -358,21 +358,10 @@ iree_vm_list_get_value(const iree_vm_list_t* list, iree_host_size_t i,
   switch (list->storage_mode) {
     case IREE_VM_LIST_STORAGE_MODE_VALUE: {
       out_value->type = list->element_type.value_type;
-      // TODO(benvanik): #ifdef on LITTLE/BIG_ENDIAN and just memcpy.
-      switch (list->element_size) {
-        case 1:
-          out_value->i8 = *(int8_t*)element_ptr;
-          break;
-        case 2:
-          out_value->i16 = *(int16_t*)element_ptr;
-          break;
-        case 4:
-          out_value->i32 = *(int32_t*)element_ptr;
-          break;
-        case 8:
-          out_value->i64 = *(int64_t*)element_ptr;
-          break;
-      }
+      // All union members start at the base of the value storage so this is
+      // independent of endianness.
+      memcpy(out_value->value_storage, (const void*)element_ptr,
+             list->element_size);
       break;
     }
     case IREE_VM_LIST_STORAGE_MODE_VARIANT: {
@@ -405,21 +394,7 @@ IREE_API_EXPORT iree_status_t iree_vm_list_get_value_as(
   switch (list->storage_mode) {
     case IREE_VM_LIST_STORAGE_MODE_VALUE: {
       value.type = list->element_type.value_type;
-      // TODO(benvanik): #ifdef on LITTLE/BIG_ENDIAN and just memcpy.
-      switch (list->element_size) {
-        case 1:
-          value.i8 = *(int8_t*)element_ptr;
-          break;
-        case 2:
-          value.i16 = *(int16_t*)element_ptr;
-          break;
-        case 4:
-          value.i32 = *(int32_t*)element_ptr;
-          break;
-        case 8:
-          value.i64 = *(int64_t*)element_ptr;
-          break;
-      }
+      memcpy(value.value_storage, (const void*)element_ptr, list->element_size);
       break;
     }
     case IREE_VM_LIST_STORAGE_MODE_VARIANT: {
@@ -466,21 +441,8 @@ IREE_API_EXPORT iree_status_t iree_vm_list_set_value(
   uintptr_t element_ptr = (uintptr_t)list->storage + i * list->element_size;
   switch (list->storage_mode) {
     case IREE_VM_LIST_STORAGE_MODE_VALUE: {
-      // TODO(benvanik): #ifdef on LITTLE/BIG_ENDIAN and just memcpy.
-      switch (list->element_size) {
-        case 1:
-          *(int8_t*)element_ptr = converted_value.i8;
-          break;
-        case 2:
-          *(int16_t*)element_ptr = converted_value.i16;
-          break;
-        case 4:
-          *(int32_t*)element_ptr = converted_value.i32;
-          break;
-        case 8:
-          *(int64_t*)element_ptr = converted_value.i64;
-          break;
-      }
+      memcpy((void*)element_ptr, converted_value.value_storage,
+             list->element_size);
       break;
     }
     case IREE_VM_LIST_STORAGE_MODE_VARIANT: {
@@ -508,6 +470,81 @@ iree_vm_list_push_value(iree_vm_list_t* list, const iree_vm_value_t* value) {
   return iree_vm_list_set_value(list, i, value);
 }
 
+// Verifies that |values_length| bytes of |value_type| values can be copied to
+// or from the list starting at element |i| and returns the value count.
+static iree_status_t iree_vm_list_verify_value_range(
+    const iree_vm_list_t* list, iree_host_size_t i,
+    iree_vm_value_type_t value_type, iree_host_size_t values_length,
+    iree_host_size_t* out_count) {
+  *out_count = 0;
+  iree_host_size_t value_size = iree_vm_value_type_size(value_type);
+  if (!value_size) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "value type %d has no storage", (int)value_type);
+  } else if (values_length % value_size != 0) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "value span length %zu is not a multiple of the value size %zu",
+        values_length, value_size);
+  }
+  iree_host_size_t count = values_length / value_size;
+  if (i > list->count || count > list->count - i) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "range [%zu, %zu) out of bounds (%zu)", i,
+                            i + count, list->count);
+  }
+  *out_count = count;
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_list_get_values(
+    const iree_vm_list_t* list, iree_host_size_t i,
+    iree_vm_value_type_t value_type, iree_byte_span_t out_values) {
+  iree_host_size_t count = 0;
+  IREE_RETURN_IF_ERROR(iree_vm_list_verify_value_range(
+      list, i, value_type, out_values.data_length, &count));
+  if (list->storage_mode == IREE_VM_LIST_STORAGE_MODE_VALUE &&
+      list->element_type.value_type == value_type) {
+    // Storage matches the requested type and can be copied directly.
+    memcpy(out_values.data,
+           (const uint8_t*)list->storage + i * list->element_size,
+           out_values.data_length);
+    return iree_ok_status();
+  }
+  iree_host_size_t value_size = iree_vm_value_type_size(value_type);
+  for (iree_host_size_t j = 0; j < count; ++j) {
+    iree_vm_value_t value;
+    IREE_RETURN_IF_ERROR(
+        iree_vm_list_get_value_as(list, i + j, value_type, &value));
+    memcpy(out_values.data + j * value_size, value.value_storage, value_size);
+  }
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_list_set_values(
+    iree_vm_list_t* list, iree_host_size_t i, iree_vm_value_type_t value_type,
+    iree_const_byte_span_t values) {
+  iree_host_size_t count = 0;
+  IREE_RETURN_IF_ERROR(iree_vm_list_verify_value_range(
+      list, i, value_type, values.data_length, &count));
+  if (list->storage_mode == IREE_VM_LIST_STORAGE_MODE_VALUE &&
+      list->element_type.value_type == value_type) {
+    // Storage matches the provided type and can be copied directly.
+    memcpy((uint8_t*)list->storage + i * list->element_size, values.data,
+           values.data_length);
+    return iree_ok_status();
+  }
+  iree_host_size_t value_size = iree_vm_value_type_size(value_type);
+  for (iree_host_size_t j = 0; j < count; ++j) {
+    iree_vm_value_t value;
+    memset(&value, 0, sizeof(value));
+    value.type = value_type;
+    memcpy(value.value_storage, values.data + j * value_size, value_size);
+    IREE_RETURN_IF_ERROR(iree_vm_list_set_value(list, i + j, &value));
+  }
+  return iree_ok_status();
+}
+
 IREE_API_EXPORT void* iree_vm_list_get_ref_deref(
     const iree_vm_list_t* list, iree_host_size_t i,
     const iree_vm_ref_type_descriptor_t* type_descriptor) {
@@ -121,6 +121,25 @@ IREE_API_EXPORT iree_status_t iree_vm_list_set_value(
 IREE_API_EXPORT iree_status_t
 iree_vm_list_push_value(iree_vm_list_t* list, const iree_vm_value_t* value);
 
+// Copies the values of the elements starting at index |i| into |out_values| as
+// a dense array of |value_type| (such as int32_t[] for IREE_VM_VALUE_TYPE_I32).
+// The number of elements copied is determined by the length of |out_values|.
+// Lists storing primitives of |value_type| are copied with a single memcpy and
+// other lists have their values converted as with iree_vm_list_get_value_as.
+IREE_API_EXPORT iree_status_t iree_vm_list_get_values(
+    const iree_vm_list_t* list, iree_host_size_t i,
+    iree_vm_value_type_t value_type, iree_byte_span_t out_values);
+
+// Sets the values of the elements starting at index |i| from |values| stored
+// as a dense array of |value_type| (such as int32_t[] for
+// IREE_VM_VALUE_TYPE_I32). The number of elements set is determined by the
+// length of |values| and the list must already be large enough to hold them.
+// Lists storing primitives of |value_type| are copied with a single memcpy and
+// other lists have the values converted as with iree_vm_list_set_value.
+IREE_API_EXPORT iree_status_t iree_vm_list_set_values(
+    iree_vm_list_t* list, iree_host_size_t i, iree_vm_value_type_t value_type,
+    iree_const_byte_span_t values);
+
 // Returns a dereferenced pointer to the given type if the element at the given
 // index matches the type. Returns NULL on error.
 IREE_API_EXPORT void* iree_vm_list_get_ref_deref(
@@ -388,6 +388,73 @@ TEST_F(VMListTest, ResizeVariant) {
 
 // TODO(benvanik): test value conversion.
 
+// Tests bulk value get/set on a list storing the same primitive type.
+TEST_F(VMListTest, GetSetValuesI32) {
+  iree_vm_type_def_t element_type =
+      iree_vm_type_def_make_value_type(IREE_VM_VALUE_TYPE_I32);
+  iree_vm_list_t* list = nullptr;
+  IREE_ASSERT_OK(
+      iree_vm_list_create(&element_type, 4, iree_allocator_system(), &list));
+  IREE_ASSERT_OK(iree_vm_list_resize(list, 4));
+
+  const int32_t values[3] = {10, 11, 12};
+  IREE_ASSERT_OK(iree_vm_list_set_values(
+      list, 1, IREE_VM_VALUE_TYPE_I32,
+      iree_make_const_byte_span(values, sizeof(values))));
+
+  int32_t read_values[4] = {-1, -1, -1, -1};
+  IREE_ASSERT_OK(iree_vm_list_get_values(
+      list, 0, IREE_VM_VALUE_TYPE_I32,
+      iree_make_byte_span(read_values, sizeof(read_values))));
+  EXPECT_EQ(0, read_values[0]);
+  EXPECT_EQ(10, read_values[1]);
+  EXPECT_EQ(11, read_values[2]);
+  EXPECT_EQ(12, read_values[3]);
+
+  // Ranges must be within the list bounds.
+  EXPECT_THAT(Status(iree_vm_list_set_values(
+                  list, 2, IREE_VM_VALUE_TYPE_I32,
+                  iree_make_const_byte_span(values, sizeof(values)))),
+              StatusIs(iree::StatusCode::kOutOfRange));
+
+  iree_vm_list_release(list);
+}
+
+// Tests bulk value get/set with conversion on lists storing other types.
+TEST_F(VMListTest, GetSetValuesConversion) {
+  iree_vm_type_def_t element_type =
+      iree_vm_type_def_make_value_type(IREE_VM_VALUE_TYPE_I64);
+  iree_vm_list_t* list = nullptr;
+  IREE_ASSERT_OK(
+      iree_vm_list_create(&element_type, 3, iree_allocator_system(), &list));
+  IREE_ASSERT_OK(iree_vm_list_resize(list, 3));
+  iree_vm_list_t* variant_list = nullptr;
+  IREE_ASSERT_OK(iree_vm_list_create(/*element_type=*/nullptr, 3,
+                                     iree_allocator_system(), &variant_list));
+  IREE_ASSERT_OK(iree_vm_list_resize(variant_list, 3));
+
+  const int32_t values[3] = {-1, 2, 3};
+  for (iree_vm_list_t* target_list : {list, variant_list}) {
+    IREE_ASSERT_OK(iree_vm_list_set_values(
+        target_list, 0, IREE_VM_VALUE_TYPE_I32,
+        iree_make_const_byte_span(values, sizeof(values))));
+    int32_t read_values[3] = {0, 0, 0};
+    IREE_ASSERT_OK(iree_vm_list_get_values(
+        target_list, 0, IREE_VM_VALUE_TYPE_I32,
+        iree_make_byte_span(read_values, sizeof(read_values))));
+    EXPECT_EQ(0, memcmp(values, read_values, sizeof(values)));
+  }
+
+  // The i64 list has the values sign extended.
+  iree_vm_value_t value;
+  IREE_ASSERT_OK(iree_vm_list_get_value(list, 0, &value));
+  EXPECT_EQ(IREE_VM_VALUE_TYPE_I64, value.type);
+  EXPECT_EQ(-1, value.i64);
+
+  iree_vm_list_release(variant_list);
+  iree_vm_list_release(list);
+}
+
 // TODO(benvanik): test ref get/set.
 
 // Tests pushing and popping ref objects.
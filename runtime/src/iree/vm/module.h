@@ -414,6 +414,16 @@ typedef struct iree_vm_module_t {
   void(IREE_API_PTR* free_state)(void* self,
                                  iree_vm_module_state_t* module_state);
 
+  // Optional: forks an initialized |parent_state| into a new module state
+  // that behaves as if it had been allocated, had its imports resolved, and
+  // been initialized identically. Immutable and ref-counted contents should be
+  // shared with the parent while any state the module may mutate must be
+  // private to the new state. When NULL contexts fall back to allocating and
+  // initializing new state.
+  iree_status_t(IREE_API_PTR* fork_state)(
+      void* self, iree_vm_module_state_t* parent_state,
+      iree_allocator_t allocator, iree_vm_module_state_t** out_module_state);
+
   // Resolves the import with the given ordinal to |function|.
   // The function is guaranteed to remain valid for the lifetime of the module
   // state.
@@ -196,6 +196,22 @@ module_b_free_state(void* self, iree_vm_module_state_t* module_state) {
   iree_allocator_free(state->allocator, state);
 }
 
+// Forks per-context state from an initialized context. Imports resolve to the
+// same functions in the forked context and the user state is copied.
+static iree_status_t IREE_API_PTR
+module_b_fork_state(void* self, iree_vm_module_state_t* parent_module_state,
+                    iree_allocator_t allocator,
+                    iree_vm_module_state_t** out_module_state) {
+  module_b_state_t* parent_state = (module_b_state_t*)parent_module_state;
+  module_b_state_t* state = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_allocator_malloc(allocator, sizeof(*state), (void**)&state));
+  memcpy(state, parent_state, sizeof(*state));
+  state->allocator = allocator;
+  *out_module_state = (iree_vm_module_state_t*)state;
+  return iree_ok_status();
+}
+
 // Called once per import function so the module can store the function ref.
 static iree_status_t IREE_API_PTR module_b_resolve_import(
     void* self, iree_vm_module_state_t* module_state, iree_host_size_t ordinal,
@@ -307,7 +323,162 @@ static iree_status_t module_b_create(iree_vm_instance_t* instance,
   interface.destroy = module_b_destroy;
   interface.alloc_state = module_b_alloc_state;
   interface.free_state = module_b_free_state;
+  interface.fork_state = module_b_fork_state;
   interface.resolve_import = module_b_resolve_import;
   return iree_vm_native_module_create(&interface, &module_b_descriptor_,
                                       instance, allocator, out_module);
 }
+
+//===----------------------------------------------------------------------===//
+// module_c
+//===----------------------------------------------------------------------===//
+// A module with per-context state that is set by an __init function through an
+// import and that does not implement fork_state: forked contexts must allocate
+// new state, resolve its imports, and run __init again.
+
+typedef struct module_c_t module_c_t;
+typedef struct module_c_state_t module_c_state_t;
+
+typedef iree_status_t (*call_v_v_t)(iree_vm_stack_t* stack, void* module_ptr,
+                                    void* module_state);
+typedef iree_status_t (*call_v_i32_t)(iree_vm_stack_t* stack, void* module_ptr,
+                                      void* module_state, int32_t* out_ret0);
+
+static iree_status_t call_shim_v_v(iree_vm_stack_t* stack,
+                                   iree_vm_native_function_flags_t flags,
+                                   iree_byte_span_t args_storage,
+                                   iree_byte_span_t rets_storage,
+                                   call_v_v_t target_fn, void* module,
+                                   void* module_state) {
+  return target_fn(stack, module, module_state);
+}
+
+static iree_status_t call_shim_v_i32(iree_vm_stack_t* stack,
+                                     iree_vm_native_function_flags_t flags,
+                                     iree_byte_span_t args_storage,
+                                     iree_byte_span_t rets_storage,
+                                     call_v_i32_t target_fn, void* module,
+                                     void* module_state) {
+  typedef struct {
+    int32_t ret0;
+  } results_t;
+  results_t* results = (results_t*)rets_storage.data;
+  return target_fn(stack, module, module_state, &results->ret0);
+}
+
+typedef struct module_c_state_t {
+  iree_allocator_t allocator;
+  // Resolved module_a.add_1 import.
+  iree_vm_function_t imports[1];
+  // Set by __init and incremented by increment_counter.
+  int32_t counter;
+} module_c_state_t;
+
+static iree_status_t IREE_API_PTR
+module_c_alloc_state(void* self, iree_allocator_t allocator,
+                     iree_vm_module_state_t** out_module_state) {
+  module_c_state_t* state = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_allocator_malloc(allocator, sizeof(*state), (void**)&state));
+  memset(state, 0, sizeof(*state));
+  state->allocator = allocator;
+  *out_module_state = (iree_vm_module_state_t*)state;
+  return iree_ok_status();
+}
+
+static void IREE_API_PTR
+module_c_free_state(void* self, iree_vm_module_state_t* module_state) {
+  module_c_state_t* state = (module_c_state_t*)module_state;
+  iree_allocator_free(state->allocator, state);
+}
+
+static iree_status_t IREE_API_PTR module_c_resolve_import(
+    void* self, iree_vm_module_state_t* module_state, iree_host_size_t ordinal,
+    const iree_vm_function_t* function,
+    const iree_vm_function_signature_t* signature) {
+  module_c_state_t* state = (module_c_state_t*)module_state;
+  state->imports[ordinal] = *function;
+  return iree_ok_status();
+}
+
+// vm.func @__init()
+static iree_status_t module_c_init(iree_vm_stack_t* stack, module_c_t* module,
+                                   module_c_state_t* module_state) {
+  return call_import_i32_i32(stack, &module_state->imports[0], 41,
+                             &module_state->counter);
+}
+
+// vm.func @get_counter() -> i32
+static iree_status_t module_c_get_counter(iree_vm_stack_t* stack,
+                                          module_c_t* module,
+                                          module_c_state_t* module_state,
+                                          int32_t* out_ret0) {
+  *out_ret0 = module_state->counter;
+  return iree_ok_status();
+}
+
+// vm.func @increment_counter() -> i32
+static iree_status_t module_c_increment_counter(iree_vm_stack_t* stack,
+                                                module_c_t* module,
+                                                module_c_state_t* module_state,
+                                                int32_t* out_ret0) {
+  IREE_RETURN_IF_ERROR(call_import_i32_i32(stack, &module_state->imports[0],
+                                           module_state->counter,
+                                           &module_state->counter));
+  *out_ret0 = module_state->counter;
+  return iree_ok_status();
+}
+
+static const iree_vm_native_import_descriptor_t module_c_imports_[] = {
+    {IREE_VM_NATIVE_IMPORT_REQUIRED, iree_make_cstring_view("module_a.add_1")},
+};
+static_assert(IREE_ARRAYSIZE(module_c_state_t::imports) ==
+                  IREE_ARRAYSIZE(module_c_imports_),
+              "import storage must be able to hold all imports");
+static const iree_vm_native_export_descriptor_t module_c_exports_[] = {
+    {iree_make_cstring_view("__init"), iree_make_cstring_view("0v_v"), 0,
+     NULL},
+    {iree_make_cstring_view("get_counter"), iree_make_cstring_view("0v_i"), 0,
+     NULL},
+    {iree_make_cstring_view("increment_counter"),
+     iree_make_cstring_view("0v_i"), 0, NULL},
+};
+static const iree_vm_native_function_ptr_t module_c_funcs_[] = {
+    {(iree_vm_native_function_shim_t)call_shim_v_v,
+     (iree_vm_native_function_target_t)module_c_init},
+    {(iree_vm_native_function_shim_t)call_shim_v_i32,
+     (iree_vm_native_function_target_t)module_c_get_counter},
+    {(iree_vm_native_function_shim_t)call_shim_v_i32,
+     (iree_vm_native_function_target_t)module_c_increment_counter},
+};
+static_assert(IREE_ARRAYSIZE(module_c_funcs_) ==
+                  IREE_ARRAYSIZE(module_c_exports_),
+              "function pointer table must be 1:1 with exports");
+static const iree_vm_native_module_descriptor_t module_c_descriptor_ = {
+    /*name=*/iree_make_cstring_view("module_c"),
+    /*version=*/0,
+    /*attr_count=*/0,
+    /*attrs=*/NULL,
+    /*dependency_count=*/0,
+    /*dependencies=*/NULL,
+    /*import_count=*/IREE_ARRAYSIZE(module_c_imports_),
+    /*imports=*/module_c_imports_,
+    /*export_count=*/IREE_ARRAYSIZE(module_c_exports_),
+    /*exports=*/module_c_exports_,
+    /*function_count=*/IREE_ARRAYSIZE(module_c_funcs_),
+    /*functions=*/module_c_funcs_,
+};
+
+static iree_status_t module_c_create(iree_vm_instance_t* instance,
+                                     iree_allocator_t allocator,
+                                     iree_vm_module_t** out_module) {
+  // NOTE: this module has no shared state and intentionally leaves fork_state
+  // unset.
+  iree_vm_module_t interface;
+  IREE_RETURN_IF_ERROR(iree_vm_module_initialize(&interface, NULL));
+  interface.alloc_state = module_c_alloc_state;
+  interface.free_state = module_c_free_state;
+  interface.resolve_import = module_c_resolve_import;
+  return iree_vm_native_module_create(&interface, &module_c_descriptor_,
+                                      instance, allocator, out_module);
+}
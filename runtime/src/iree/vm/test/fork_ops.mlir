@@ -0,0 +1,82 @@
+// Tested by iree/vm/bytecode_module_test.cc.
+//
+// Module state used to verify iree_vm_context_fork: a primitive global and a
+// list global that are expected to diverge between forks, a rodata buffer
+// global that each fork is expected to own, a buffer global whose contents are
+// either copied or shared depending on its mutability, and an import that is
+// expected to remain resolved.
+
+vm.module @fork_ops {
+
+  vm.import @module_a.add_1(%arg0 : i32) -> i32
+
+  vm.global.i32 private mutable @counter : i32
+  vm.global.ref private mutable @list : !vm.list<i32>
+  vm.global.ref private mutable @rodata_buffer : !vm.buffer
+  vm.global.ref private mutable @buffer : !vm.buffer
+
+  vm.rodata private @rodata_3xi32 dense<[1, 2, 3]> : tensor<3xi32>
+
+  // Only runs as part of __init so forks that skip __init start from the
+  // values of their parent.
+  vm.initializer {
+    %c41 = vm.const.i32 41
+    %counter = vm.call @module_a.add_1(%c41) : (i32) -> i32
+    vm.global.store.i32 %counter, @counter : i32
+    %c1 = vm.const.i32 1
+    %list = vm.list.alloc %c1 : (i32) -> !vm.list<i32>
+    vm.global.store.ref %list, @list : !vm.list<i32>
+    %rodata = vm.const.ref.rodata @rodata_3xi32 : !vm.buffer
+    vm.global.store.ref %rodata, @rodata_buffer : !vm.buffer
+    vm.return
+  }
+
+  vm.export @get_counter
+  vm.func @get_counter() -> i32 {
+    %counter = vm.global.load.i32 @counter : i32
+    vm.return %counter : i32
+  }
+
+  // Increments @counter through the module_a.add_1 import.
+  vm.export @increment_counter
+  vm.func @increment_counter() -> i32 {
+    %counter = vm.global.load.i32 @counter : i32
+    %new_counter = vm.call @module_a.add_1(%counter) : (i32) -> i32
+    vm.global.store.i32 %new_counter, @counter : i32
+    vm.return %new_counter : i32
+  }
+
+  vm.export @get_list
+  vm.func @get_list() -> !vm.list<i32> {
+    %list = vm.global.load.ref @list : !vm.list<i32>
+    vm.return %list : !vm.list<i32>
+  }
+
+  // Replaces @list with a new list.
+  vm.export @reset_list
+  vm.func @reset_list() {
+    %c1 = vm.const.i32 1
+    %list = vm.list.alloc %c1 : (i32) -> !vm.list<i32>
+    vm.global.store.ref %list, @list : !vm.list<i32>
+    vm.return
+  }
+
+  vm.export @get_rodata_buffer
+  vm.func @get_rodata_buffer() -> !vm.buffer {
+    %buffer = vm.global.load.ref @rodata_buffer : !vm.buffer
+    vm.return %buffer : !vm.buffer
+  }
+
+  vm.export @set_buffer
+  vm.func @set_buffer(%buffer : !vm.buffer) {
+    vm.global.store.ref %buffer, @buffer : !vm.buffer
+    vm.return
+  }
+
+  vm.export @get_buffer
+  vm.func @get_buffer() -> !vm.buffer {
+    %buffer = vm.global.load.ref @buffer : !vm.buffer
+    vm.return %buffer : !vm.buffer
+  }
+
+}
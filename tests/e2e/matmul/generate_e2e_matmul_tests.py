@@ -34,6 +34,7 @@ class ShapesId(enum.Enum):
   SMALL = "small"
   LARGE = "large"
   GPU_LARGE = "gpu_large"
+  SPLIT_K = "split_k"
 
 
 # Enumerates of the collections of compilation info that we can generate tests
@@ -137,13 +138,22 @@ def get_test_shapes(shapes_id: ShapesId):
     ]
   if shapes_id == ShapesId.GPU_LARGE:
     return [TestShape(m=256, k=128, n=512)]
+  if shapes_id == ShapesId.SPLIT_K:
+    return [
+        # small parallel iteration spaces with large reduction dimensions, as
+        # found in batch-1 decoder layers. The reduction dimensions have
+        # different divisors so that different split ratios are exercised.
+        TestShape(m=1, k=4096, n=64),
+        TestShape(m=16, k=2048, n=16),
+        TestShape(m=7, k=1000, n=13),
+    ]
   raise ValueError(shapes_id)
 
 
 # Returns the list of Dynamicity's to use for the collection of shapes
 # identified by shapes_id.
 def get_dynamicities(shapes_id: ShapesId):
-  if shapes_id == ShapesId.GPU_LARGE:
+  if shapes_id == ShapesId.GPU_LARGE or shapes_id == ShapesId.SPLIT_K:
     return [
         Dynamicity.STATIC,
     ]
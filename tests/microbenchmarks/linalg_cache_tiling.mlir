@@ -0,0 +1,59 @@
+//===----------------------------------------------------------------------===//
+// Linalg ops whose default tile sizes depend on the target cache sizes.
+//===----------------------------------------------------------------------===//
+
+func.func @matmul_128x128x128() -> tensor<128x128xf32> {
+    %lhs = util.unfoldable_constant dense<1.0> : tensor<128x128xf32>
+    %rhs = util.unfoldable_constant dense<1.0> : tensor<128x128xf32>
+    %dst = util.unfoldable_constant dense<1.0> : tensor<128x128xf32>
+    %0 = linalg.matmul ins(%lhs, %rhs : tensor<128x128xf32>, tensor<128x128xf32>) outs(%dst : tensor<128x128xf32>) -> tensor<128x128xf32>
+    return %0 : tensor<128x128xf32>
+}
+
+func.func @matmul_1024x1024x1024() -> tensor<1024x1024xf32> {
+    %lhs = util.unfoldable_constant dense<1.0> : tensor<1024x1024xf32>
+    %rhs = util.unfoldable_constant dense<1.0> : tensor<1024x1024xf32>
+    %dst = util.unfoldable_constant dense<1.0> : tensor<1024x1024xf32>
+    %0 = linalg.matmul ins(%lhs, %rhs : tensor<1024x1024xf32>, tensor<1024x1024xf32>) outs(%dst : tensor<1024x1024xf32>) -> tensor<1024x1024xf32>
+    return %0 : tensor<1024x1024xf32>
+}
+
+func.func @matmul_384x3072x768() -> tensor<384x768xf32> {
+    %lhs = util.unfoldable_constant dense<1.0> : tensor<384x3072xf32>
+    %rhs = util.unfoldable_constant dense<1.0> : tensor<3072x768xf32>
+    %dst = util.unfoldable_constant dense<1.0> : tensor<384x768xf32>
+    %0 = linalg.matmul ins(%lhs, %rhs : tensor<384x3072xf32>, tensor<3072x768xf32>) outs(%dst : tensor<384x768xf32>) -> tensor<384x768xf32>
+    return %0 : tensor<384x768xf32>
+}
+
+func.func @batch_matmul_4x384x384x512() -> tensor<4x384x512xf32> {
+    %lhs = util.unfoldable_constant dense<1.0> : tensor<4x384x384xf32>
+    %rhs = util.unfoldable_constant dense<1.0> : tensor<4x384x512xf32>
+    %dst = util.unfoldable_constant dense<1.0> : tensor<4x384x512xf32>
+    %0 = linalg.batch_matmul ins(%lhs, %rhs : tensor<4x384x384xf32>, tensor<4x384x512xf32>) outs(%dst : tensor<4x384x512xf32>) -> tensor<4x384x512xf32>
+    return %0 : tensor<4x384x512xf32>
+}
+
+func.func @conv_2d_nhwc_hwcf_1x56x56x64_3x3x64x64() -> tensor<1x54x54x64xf32> {
+    %input = util.unfoldable_constant dense<1.0> : tensor<1x56x56x64xf32>
+    %filter = util.unfoldable_constant dense<1.0> : tensor<3x3x64x64xf32>
+    %dst = util.unfoldable_constant dense<1.0> : tensor<1x54x54x64xf32>
+    %0 = linalg.conv_2d_nhwc_hwcf {dilations = dense<1> : tensor<2xi64>, strides = dense<1> : tensor<2xi64>} ins(%input, %filter : tensor<1x56x56x64xf32>, tensor<3x3x64x64xf32>) outs(%dst : tensor<1x54x54x64xf32>) -> tensor<1x54x54x64xf32>
+    return %0 : tensor<1x54x54x64xf32>
+}
+
+func.func @conv_2d_nhwc_hwcf_1x14x14x512_3x3x512x512() -> tensor<1x12x12x512xf32> {
+    %input = util.unfoldable_constant dense<1.0> : tensor<1x14x14x512xf32>
+    %filter = util.unfoldable_constant dense<1.0> : tensor<3x3x512x512xf32>
+    %dst = util.unfoldable_constant dense<1.0> : tensor<1x12x12x512xf32>
+    %0 = linalg.conv_2d_nhwc_hwcf {dilations = dense<1> : tensor<2xi64>, strides = dense<1> : tensor<2xi64>} ins(%input, %filter : tensor<1x14x14x512xf32>, tensor<3x3x512x512xf32>) outs(%dst : tensor<1x12x12x512xf32>) -> tensor<1x12x12x512xf32>
+    return %0 : tensor<1x12x12x512xf32>
+}
+
+func.func @mmt4d_1024x1024x1024_8x1x8() -> tensor<128x128x8x8xf32> {
+    %lhs = util.unfoldable_constant dense<1.0> : tensor<128x1024x8x1xf32>
+    %rhs = util.unfoldable_constant dense<1.0> : tensor<128x1024x8x1xf32>
+    %dst = util.unfoldable_constant dense<1.0> : tensor<128x128x8x8xf32>
+    %0 = linalg.mmt4d ins(%lhs, %rhs : tensor<128x1024x8x1xf32>, tensor<128x1024x8x1xf32>) outs(%dst : tensor<128x128x8x8xf32>) -> tensor<128x128x8x8xf32>
+    return %0 : tensor<128x128x8x8xf32>
+}
@@ -51,7 +51,20 @@
 // how the full program will run, though, and YMMV. Always verify timings with
 // an appropriate device-specific tool before trusting the more generic and
 // higher-level numbers from this tool.
-
+//
+// By default each invocation is made synchronously and back-to-back such that
+// the reported times are the latency of a single call. Real deployments often
+// pipeline requests and --pipeline_depth=N can be used to instead keep N
+// invocations in flight at a time using asynchronous invocation on a loop.
+// Invocations that wait on device work yield to the loop so that other
+// in-flight invocations can make progress while the shared device executes.
+// --pipeline_contexts=M spreads the in-flight invocations across M contexts
+// forked from the initialized one and --pipeline_threads=T runs T host threads
+// each with their own loop and contexts. In this mode the items/s reported is
+// the sustained throughput and per-call latency percentiles are reported as
+// counters along with the average fraction of pipeline slots that were busy.
+
+#include <algorithm>
 #include <array>
 #include <cstdio>
 #include <iostream>
@@ -64,6 +77,7 @@
 #include "benchmark/benchmark.h"
 #include "iree/base/api.h"
 #include "iree/base/internal/flags.h"
+#include "iree/base/loop_sync.h"
 #include "iree/base/status_cc.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
@@ -91,6 +105,21 @@ IREE_FLAG(string, entry_function, "",
 IREE_FLAG(bool, print_statistics, false,
           "Prints runtime statistics to stderr on exit.");
 
+IREE_FLAG(int32_t, pipeline_depth, 0,
+          "Number of invocations of each entry function kept in flight per "
+          "host thread using asynchronous invocation. When 0 the functions "
+          "are invoked synchronously one at a time. Programs must support "
+          "overlapping invocations when --pipeline_contexts is less than the "
+          "depth.");
+
+IREE_FLAG(int32_t, pipeline_contexts, 1,
+          "Number of contexts per host thread that pipelined invocations are "
+          "distributed across. Additional contexts are forked from the "
+          "initialized one and share its device.");
+
+IREE_FLAG(int32_t, pipeline_threads, 1,
+          "Number of host threads issuing pipelined invocations.");
+
 // TODO(benvanik): move --function_input= flag into a util.
 static iree_status_t parse_function_input(iree_string_view_t flag_name,
                                           void* storage,
@@ -226,6 +255,208 @@ void RegisterGenericBenchmark(const std::string& function_name,
                                   : benchmark::kMillisecond);
 }
 
+// Each benchmark iteration of a pipelined benchmark issues this many
+// invocations per pipeline slot so that the ramp up and drain of the pipeline
+// are amortized over enough invocations to measure the sustained throughput.
+constexpr int kPipelineWaveMultiplier = 8;
+
+struct Pipeline;
+
+// A single in-flight invocation within a Pipeline.
+struct PipelineSlot {
+  Pipeline* pipeline = nullptr;
+  iree_vm_context_t* context = nullptr;
+  vm::ref<iree_vm_list_t> outputs;
+  // Time the current invocation was issued; used to compute its latency.
+  iree_time_t issue_time_ns = 0;
+  // Must remain live until the invocation callback is issued.
+  iree_vm_async_invoke_state_t invoke_state;
+};
+
+// Keeps a fixed number of invocations of |function| in flight on a loop.
+// Each slot reissues its invocation from the completion callback until the
+// number of invocations remaining in the current wave reaches zero.
+struct Pipeline {
+  iree_vm_function_t function;
+  iree_vm_list_t* inputs = nullptr;
+  std::vector<PipelineSlot> slots;
+  // Number of invocations left to issue in the current wave.
+  int64_t remaining = 0;
+  // Latency of every completed invocation.
+  std::vector<iree_duration_t> latencies_ns;
+  // First failure reported through the loop scope, if any.
+  iree_status_t status = iree_ok_status();
+};
+
+static iree_status_t OnPipelinedInvocationComplete(void* user_data,
+                                                   iree_loop_t loop,
+                                                   iree_status_t status,
+                                                   iree_vm_list_t* outputs);
+
+static iree_status_t IssuePipelinedInvocation(PipelineSlot* slot,
+                                              iree_loop_t loop) {
+  Pipeline* pipeline = slot->pipeline;
+  --pipeline->remaining;
+  slot->issue_time_ns = iree_time_now();
+  return iree_vm_async_invoke(
+      loop, &slot->invoke_state, slot->context, pipeline->function,
+      IREE_VM_INVOCATION_FLAG_NONE, /*policy=*/nullptr, pipeline->inputs,
+      slot->outputs.get(), iree_allocator_system(),
+      OnPipelinedInvocationComplete, slot);
+}
+
+static iree_status_t OnPipelinedInvocationComplete(void* user_data,
+                                                   iree_loop_t loop,
+                                                   iree_status_t status,
+                                                   iree_vm_list_t* outputs) {
+  auto* slot = (PipelineSlot*)user_data;
+  Pipeline* pipeline = slot->pipeline;
+  iree_duration_t latency_ns = iree_time_now() - slot->issue_time_ns;
+  if (outputs) {
+    // Drop the results so the list can be reused by the next invocation.
+    iree_status_t resize_status = iree_vm_list_resize(outputs, 0);
+    iree_vm_list_release(outputs);
+    if (iree_status_is_ok(status)) {
+      status = resize_status;
+    } else {
+      iree_status_ignore(resize_status);
+    }
+  }
+  IREE_RETURN_IF_ERROR(status);
+  pipeline->latencies_ns.push_back(latency_ns);
+
+  // The invoke state is no longer used once the callback is issued and can be
+  // reused for the next invocation from this slot.
+  if (pipeline->remaining > 0) {
+    return IssuePipelinedInvocation(slot, loop);
+  }
+  return iree_ok_status();
+}
+
+static void OnPipelineError(void* user_data, iree_status_t status) {
+  auto* pipeline = (Pipeline*)user_data;
+  if (iree_status_is_ok(pipeline->status)) {
+    pipeline->status = status;
+  } else {
+    iree_status_ignore(status);
+  }
+}
+
+// Returns the |percentile| (0-100) of the unordered |values|.
+// |values| is partially reordered in the process.
+static iree_duration_t ComputePercentile(std::vector<iree_duration_t>& values,
+                                         double percentile) {
+  if (values.empty()) return 0;
+  size_t index = std::min(values.size() - 1,
+                          (size_t)(percentile / 100.0 * values.size()));
+  std::nth_element(values.begin(), values.begin() + index, values.end());
+  return values[index];
+}
+
+static void BenchmarkPipelinedFunction(
+    const std::string& benchmark_name, int batch_size, int pipeline_depth,
+    int contexts_per_thread, const std::vector<iree_vm_context_t*>& contexts,
+    iree_vm_function_t function, iree_vm_list_t* inputs,
+    benchmark::State& state) {
+  IREE_TRACE_SCOPE_DYNAMIC(benchmark_name.c_str());
+  IREE_TRACE_FRAME_MARK();
+
+  // Slots are assigned round-robin to the contexts owned by this thread.
+  Pipeline pipeline;
+  pipeline.function = function;
+  pipeline.inputs = inputs;
+  pipeline.slots.resize(pipeline_depth);
+  for (int i = 0; i < pipeline_depth; ++i) {
+    PipelineSlot& slot = pipeline.slots[i];
+    slot.pipeline = &pipeline;
+    slot.context = contexts[state.thread_index() * contexts_per_thread +
+                            i % contexts_per_thread];
+    IREE_CHECK_OK(iree_vm_list_create(/*element_type=*/nullptr, 16,
+                                      iree_allocator_system(), &slot.outputs));
+  }
+
+  // Each in-flight invocation has at most one pending operation or wait at a
+  // time; the extra queue capacity covers resumes racing with new calls.
+  iree_loop_sync_options_t loop_options;
+  loop_options.max_queue_depth = pipeline_depth * 2;
+  loop_options.max_wait_count = pipeline_depth;
+  iree_loop_sync_t* loop_sync = nullptr;
+  IREE_CHECK_OK(iree_loop_sync_allocate(loop_options, iree_allocator_system(),
+                                        &loop_sync));
+  iree_loop_sync_scope_t scope;
+  iree_loop_sync_scope_initialize(loop_sync, OnPipelineError, &pipeline,
+                                  &scope);
+  iree_loop_t loop = iree_loop_sync_scope(&scope);
+
+  // Benchmarking loop.
+  int64_t wave_size = (int64_t)pipeline_depth * kPipelineWaveMultiplier;
+  iree_time_t start_time_ns = iree_time_now();
+  while (state.KeepRunningBatch(wave_size * batch_size)) {
+    IREE_TRACE_SCOPE0("BenchmarkIteration");
+    IREE_TRACE_FRAME_MARK_NAMED("Iteration");
+    pipeline.remaining = wave_size;
+    for (auto& slot : pipeline.slots) {
+      IREE_CHECK_OK(IssuePipelinedInvocation(&slot, loop));
+    }
+    IREE_CHECK_OK(iree_loop_drain(loop, iree_infinite_timeout()));
+    IREE_CHECK_OK(pipeline.status);
+  }
+  iree_duration_t wall_time_ns = iree_time_now() - start_time_ns;
+
+  iree_loop_sync_scope_deinitialize(&scope);
+  iree_loop_sync_free(loop_sync);
+
+  state.SetItemsProcessed(state.iterations());
+
+  // Average fraction of the pipeline slots that had an invocation in flight.
+  // Values well below 1 indicate the host is not issuing work fast enough to
+  // keep the pipeline full.
+  iree_duration_t busy_time_ns = 0;
+  for (iree_duration_t latency_ns : pipeline.latencies_ns) {
+    busy_time_ns += latency_ns;
+  }
+  double occupancy =
+      wall_time_ns > 0
+          ? (double)busy_time_ns / ((double)wall_time_ns * pipeline_depth)
+          : 0.0;
+  state.counters["pipeline_occupancy"] =
+      benchmark::Counter(occupancy, benchmark::Counter::kAvgThreads);
+  for (int percentile : {50, 90, 99}) {
+    iree_duration_t latency_ns =
+        ComputePercentile(pipeline.latencies_ns, percentile);
+    state.counters["p" + std::to_string(percentile) + "_latency_us"] =
+        benchmark::Counter(latency_ns / 1000.0,
+                           benchmark::Counter::kAvgThreads);
+  }
+}
+
+void RegisterPipelinedBenchmark(const std::string& function_name,
+                                const std::vector<iree_vm_context_t*>& contexts,
+                                iree_vm_function_t function,
+                                iree_vm_list_t* inputs) {
+  auto benchmark_name = "BM_" + function_name;
+  int batch_size = FLAG_batch_size;
+  int pipeline_depth = FLAG_pipeline_depth;
+  int contexts_per_thread = FLAG_pipeline_contexts;
+  benchmark::RegisterBenchmark(
+      benchmark_name.c_str(),
+      [benchmark_name, batch_size, pipeline_depth, contexts_per_thread,
+       contexts, function, inputs](benchmark::State& state) -> void {
+        BenchmarkPipelinedFunction(benchmark_name, batch_size, pipeline_depth,
+                                   contexts_per_thread, contexts, function,
+                                   inputs, state);
+      })
+      // By default only the main thread is included in CPU time. Include all
+      // the threads instead.
+      ->MeasureProcessCPUTime()
+      // Throughput is derived from the wall time as the pipelined invocations
+      // overlap with each other and with device execution.
+      ->UseRealTime()
+      ->Threads(FLAG_pipeline_threads)
+      ->Unit(FLAG_time_unit.first ? FLAG_time_unit.second
+                                  : benchmark::kMillisecond);
+}
+
 static void BenchmarkDispatchFunction(const std::string& benchmark_name,
                                       iree_vm_context_t* context,
                                       iree_vm_function_t function,
@@ -287,6 +518,9 @@ class IREEBenchmark {
 
     // Order matters. Tear down modules first to release resources.
     inputs_.reset();
+    for (auto* context : pipeline_contexts_) {
+      iree_vm_context_release(context);
+    }
     iree_vm_context_release(context_);
     iree_vm_module_release(main_module_);
     iree_vm_instance_release(instance_);
@@ -333,10 +567,54 @@ class IREEBenchmark {
         /*default_device_uri=*/iree_string_view_empty(), host_allocator,
         &context_, &device_, &device_allocator_));
 
+    if (FLAG_pipeline_depth > 0) {
+      IREE_RETURN_IF_ERROR(CreatePipelineContexts(host_allocator));
+    }
+
     IREE_TRACE_FRAME_MARK_END_NAMED("init");
     return iree_ok_status();
   }
 
+  // Creates the contexts used by pipelined benchmarks: one per pipeline
+  // context per thread forked from the initialized |context_| so that they
+  // all share the same device and loaded executables.
+  iree_status_t CreatePipelineContexts(iree_allocator_t host_allocator) {
+    IREE_TRACE_SCOPE0("IREEBenchmark::CreatePipelineContexts");
+    if (FLAG_pipeline_contexts <= 0 || FLAG_pipeline_threads <= 0) {
+      return iree_make_status(
+          IREE_STATUS_INVALID_ARGUMENT,
+          "--pipeline_contexts and --pipeline_threads must be positive");
+    }
+    iree_host_size_t context_count =
+        (iree_host_size_t)FLAG_pipeline_contexts * FLAG_pipeline_threads;
+    if (context_count == 1) {
+      iree_vm_context_retain(context_);
+      pipeline_contexts_.push_back(context_);
+      return iree_ok_status();
+    }
+    pipeline_contexts_.reserve(context_count);
+    for (iree_host_size_t i = 0; i < context_count; ++i) {
+      iree_vm_context_t* context = nullptr;
+      IREE_RETURN_IF_ERROR(
+          iree_vm_context_fork(context_, host_allocator, &context));
+      pipeline_contexts_.push_back(context);
+    }
+    return iree_ok_status();
+  }
+
+  // Registers a benchmark of an entry |function| that is either invoked
+  // synchronously or pipelined based on flags.
+  void RegisterEntryBenchmark(const std::string& function_name,
+                              iree_vm_function_t function,
+                              iree_vm_list_t* inputs) {
+    if (FLAG_pipeline_depth > 0) {
+      RegisterPipelinedBenchmark(function_name, pipeline_contexts_, function,
+                                 inputs);
+    } else {
+      RegisterGenericBenchmark(function_name, context_, function, inputs);
+    }
+  }
+
   iree_status_t RegisterSpecificFunction(const std::string& function_name) {
     IREE_TRACE_SCOPE0("IREEBenchmark::RegisterSpecificFunction");
 
@@ -351,7 +629,7 @@ class IREEBenchmark {
         iree::span<const std::string>{FLAG_function_inputs.data(),
                                       FLAG_function_inputs.size()},
         iree_vm_instance_allocator(instance_), &inputs_));
-    RegisterGenericBenchmark(function_name, context_, function, inputs_.get());
+    RegisterEntryBenchmark(function_name, function, inputs_.get());
     return iree_ok_status();
   }
 
@@ -374,9 +652,8 @@ class IREEBenchmark {
             std::string(function_name.data, function_name.size), context_,
             function);
       } else if (iree_string_view_equal(benchmark_type, IREE_SV("entry"))) {
-        iree::RegisterGenericBenchmark(
-            std::string(function_name.data, function_name.size), context_,
-            function,
+        RegisterEntryBenchmark(
+            std::string(function_name.data, function_name.size), function,
             /*inputs=*/nullptr);
       } else {
         // Pick up generic () -> () functions.
@@ -400,9 +677,8 @@ class IREEBenchmark {
           continue;
         }
 
-        iree::RegisterGenericBenchmark(
-            std::string(function_name.data, function_name.size), context_,
-            function,
+        RegisterEntryBenchmark(
+            std::string(function_name.data, function_name.size), function,
             /*inputs=*/nullptr);
       }
     }
@@ -415,6 +691,8 @@ class IREEBenchmark {
   iree_hal_allocator_t* device_allocator_ = nullptr;
   iree_vm_module_t* main_module_ = nullptr;
   iree::vm::ref<iree_vm_list_t> inputs_;
+  // Retained contexts used by pipelined benchmarks when --pipeline_depth > 0.
+  std::vector<iree_vm_context_t*> pipeline_contexts_;
 };
 }  // namespace
 }  // namespace iree